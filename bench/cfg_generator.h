@@ -0,0 +1,331 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "pass/domtree.h"
+#include <functional>
+#include <memory>
+#include <random>
+
+namespace compiler::bench
+{
+
+/**
+ * Synthetic CFG with bb_num blocks: every block has one or two successors,
+ * mostly short forward edges (diamonds and chains) with some back edges (loops).
+ * The same seed gives the same graph.
+ */
+inline std::shared_ptr<Graph> generateCfg(size_t bb_num, uint32_t seed = 42)
+{
+    auto graph = std::make_shared<Graph>("synthetic_cfg");
+    std::mt19937 gen(seed);
+
+    std::vector<BasicBlock*> bbs;
+    bbs.reserve(bb_num);
+    for (size_t i = 0; i < bb_num; ++i)
+    {
+        bbs.push_back(graph->createBB(i));
+        graph->addBB(bbs.back());
+    }
+
+    for (size_t i = 0; i + 1 < bb_num; ++i)
+    {
+        graph->addEdge(bbs[i], bbs[i + 1]);
+        if (gen() % 2 == 0)
+            continue;
+
+        size_t succ = 0;
+        if (gen() % 4 == 0 && i > 0)
+            succ = i - gen() % std::min<size_t>(i, 8);
+        else
+            succ = std::min(bb_num - 1, i + 2 + gen() % 4);
+        if (succ != i + 1)
+            graph->addEdge(bbs[i], bbs[succ]);
+    }
+    return graph;
+}
+
+/**
+ * Shapes of synthetic CFGs: the graph is a chain of units of the shape,
+ * the start block and the last block are outside of units
+ */
+enum class CfgShape
+{
+    // forward if-then-else: head -> (left, right) -> merge
+    Diamonds,
+    // loop nests of NESTED_LOOPS_DEPTH: headers, the body, latches with back edges to headers
+    NestedLoops,
+    // two entry loops: head -> (left, right), left <-> right
+    Irreducible,
+    // straight line code
+    Chain,
+    // switch lowered to a chain of compares: every compare goes to its case and the next one
+    FanOut,
+    // chain where every block calls its own small function
+    Calls,
+};
+
+constexpr size_t NESTED_LOOPS_DEPTH = 4;
+constexpr size_t FAN_OUT_WIDTH = 16;
+
+inline const char* getShapeName(CfgShape shape)
+{
+    switch (shape)
+    {
+    case CfgShape::Diamonds:
+        return "diamonds";
+    case CfgShape::NestedLoops:
+        return "nested_loops";
+    case CfgShape::Irreducible:
+        return "irreducible";
+    case CfgShape::Chain:
+        return "chain";
+    case CfgShape::FanOut:
+        return "fan_out";
+    case CfgShape::Calls:
+        return "calls";
+    default:
+        UNREACHABLE();
+    }
+}
+
+/**
+ * CFG of the shape with about bb_num blocks: units are added while the graph is smaller,
+ * so the last one may go over bb_num by the size of a unit
+ */
+inline std::shared_ptr<Graph> generateShapeCfg(CfgShape shape, size_t bb_num)
+{
+    auto graph = std::make_shared<Graph>(std::string("synthetic_") + getShapeName(shape));
+    auto new_bb = [&graph]() {
+        auto* bb = graph->createBB(graph->size());
+        graph->addBB(bb);
+        return bb;
+    };
+
+    // unit gets its entry block and returns its exit block
+    auto* last = new_bb();
+    while (graph->size() + 1 < bb_num)
+    {
+        auto* head = new_bb();
+        graph->addEdge(last, head);
+        switch (shape)
+        {
+        case CfgShape::Diamonds: {
+            auto* left = new_bb();
+            auto* right = new_bb();
+            last = new_bb();
+            graph->addEdge(head, left);
+            graph->addEdge(head, right);
+            graph->addEdge(left, last);
+            graph->addEdge(right, last);
+            break;
+        }
+        case CfgShape::NestedLoops: {
+            std::vector<BasicBlock*> headers{head};
+            for (size_t i = 1; i < NESTED_LOOPS_DEPTH; ++i)
+            {
+                headers.push_back(new_bb());
+                graph->addEdge(headers[i - 1], headers[i]);
+            }
+            last = new_bb();
+            graph->addEdge(headers.back(), last);
+            for (auto it = headers.rbegin(); it != headers.rend(); ++it)
+            {
+                auto* latch = new_bb();
+                graph->addEdge(last, latch);
+                graph->addEdge(latch, *it);
+                last = latch;
+            }
+            break;
+        }
+        case CfgShape::Irreducible: {
+            auto* left = new_bb();
+            auto* right = new_bb();
+            graph->addEdge(head, left);
+            graph->addEdge(head, right);
+            graph->addEdge(left, right);
+            graph->addEdge(right, left);
+            last = new_bb();
+            graph->addEdge(left, last);
+            break;
+        }
+        case CfgShape::Chain:
+        case CfgShape::Calls:
+            last = head;
+            break;
+        case CfgShape::FanOut: {
+            std::vector<BasicBlock*> cases;
+            auto* cmp = head;
+            for (size_t i = 0; i + 2 < FAN_OUT_WIDTH; ++i)
+            {
+                cases.push_back(new_bb());
+                graph->addEdge(cmp, cases.back());
+                auto* next_cmp = new_bb();
+                graph->addEdge(cmp, next_cmp);
+                cmp = next_cmp;
+            }
+            for (size_t i = 0; i < 2; ++i)
+            {
+                cases.push_back(new_bb());
+                graph->addEdge(cmp, cases.back());
+            }
+            last = new_bb();
+            for (auto* case_bb : cases)
+                graph->addEdge(case_bb, last);
+            break;
+        }
+        default:
+            UNREACHABLE();
+        }
+    }
+    graph->addEdge(last, new_bb());
+    return graph;
+}
+
+/**
+ * Fill blocks of the CFG: params and consts_num constants in the start block and insts_per_bb
+ * insts of the given types in every other block. Inputs are taken from the start block,
+ * from the block itself and from its dominators, so every use is dominated by its def.
+ * Blocks of CfgShape::Calls also call functions made by make_callee.
+ */
+inline void fillFunction(Graph* graph, size_t insts_per_bb, size_t params_num, uint32_t seed,
+                         size_t consts_num, const std::vector<InstType>& types,
+                         const std::function<Graph*()>& make_callee = nullptr)
+{
+    constexpr size_t DOM_DEPTH = 4;
+
+    std::mt19937 gen(seed);
+    size_t id = 0;
+
+    auto* start_bb = graph->getFirstBB();
+    std::vector<std::vector<Inst*>> values(graph->size());
+    for (size_t i = 0; i < params_num; ++i)
+    {
+        auto* param = graph->create<ParamInst>(id++, DataType::i64);
+        start_bb->pushBackInst(param);
+        values[start_bb->getId()].push_back(param);
+    }
+    graph->setCurInstId(id);
+    for (size_t i = 0; i < consts_num; ++i)
+        values[start_bb->getId()].push_back(graph->findConstant(static_cast<uint64_t>(i)));
+    id = graph->getCurInstId();
+
+    graph->runPass<DomTree>();
+    for (auto* bb : graph->getRpoBBs())
+    {
+        if (bb == start_bb)
+            continue;
+
+        std::vector<Inst*> inputs = values[start_bb->getId()];
+        auto* dom = bb->getIdom();
+        for (size_t depth = 0; depth < DOM_DEPTH && dom != start_bb; ++depth, dom = dom->getIdom())
+            inputs.insert(inputs.end(), values[dom->getId()].begin(), values[dom->getId()].end());
+
+        auto& bb_values = values[bb->getId()];
+        auto random_input = [&inputs, &gen]() { return inputs[gen() % inputs.size()]; };
+        for (size_t i = 0; i < insts_per_bb; ++i)
+        {
+            auto type = types.size() == 1 ? types[0] : types[gen() % types.size()];
+            if (type == InstType::ZeroCheck)
+            {
+                bb->pushBackInst(graph->create<UnaryInst>(id++, type, random_input()));
+                continue;
+            }
+            auto* inst = graph->create<BinaryInst>(id++, type, random_input(), random_input());
+            bb->pushBackInst(inst);
+            if (type == InstType::BoundsCheck)
+                continue;
+            bb_values.push_back(inst);
+            inputs.push_back(inst);
+        }
+        if (make_callee)
+        {
+            auto* call = graph->create<CallInst>(id++, make_callee(),
+                                                 std::initializer_list<Inst*>{random_input(),
+                                                                              random_input()});
+            bb->pushBackInst(call);
+            bb_values.push_back(call);
+        }
+    }
+    graph->setCurInstId(id);
+}
+
+/**
+ * Synthetic function over generateCfg(bb_num) with Add insts only
+ */
+inline std::shared_ptr<Graph> generateFunction(size_t bb_num, size_t insts_per_bb,
+                                               size_t params_num = 16, uint32_t seed = 42,
+                                               size_t consts_num = 0)
+{
+    auto graph = generateCfg(bb_num, seed);
+    fillFunction(graph.get(), insts_per_bb, params_num, seed, consts_num, {InstType::Add});
+    return graph;
+}
+
+/**
+ * Small callee of CfgShape::Calls: f(x, y) = (x + y) * 2
+ */
+inline std::unique_ptr<Graph> generateCallee(ArenaAllocator* arena)
+{
+    auto callee = std::make_unique<Graph>("callee", arena);
+    auto* start_bb = callee->createBB(0);
+    auto* bb = callee->createBB(1);
+    callee->insertBB(start_bb);
+    callee->insertBB(bb);
+    auto* x = callee->create<ParamInst>(0, DataType::i64, "x");
+    auto* y = callee->create<ParamInst>(1, DataType::i64, "y");
+    start_bb->pushBackInst(x);
+    start_bb->pushBackInst(y);
+    callee->setCurInstId(2);
+    auto* two = callee->findConstant(static_cast<uint64_t>(2));
+    auto* sum = callee->create<BinaryInst>(4, InstType::Add, x, y);
+    auto* mul = callee->create<BinaryInst>(5, InstType::Mul, sum, two);
+    bb->pushBackInst(sum);
+    bb->pushBackInst(mul);
+    bb->pushBackInst(callee->create<UnaryInst>(6, InstType::Return, mul));
+    callee->setCurInstId(7);
+    return callee;
+}
+
+/**
+ * Synthetic function of the shape with a mix of arithmetic, checks and constant operands,
+ * so every optimization finds something to do. Callees of CfgShape::Calls share the arena
+ * of the function (Inline moves their blocks) and live as long as the returned graph.
+ */
+inline std::shared_ptr<Graph> generateShapeFunction(CfgShape shape, size_t bb_num,
+                                                    size_t insts_per_bb = 4, uint32_t seed = 42)
+{
+    struct Unit
+    {
+        std::shared_ptr<Graph> graph;
+        // destroyed first: callees do not own their memory
+        std::vector<std::unique_ptr<Graph>> callees;
+    };
+
+    auto unit = std::make_shared<Unit>();
+    unit->graph = generateShapeCfg(shape, bb_num);
+    std::function<Graph*()> make_callee = nullptr;
+    if (shape == CfgShape::Calls)
+        make_callee = [&unit]() {
+            return unit->callees.emplace_back(generateCallee(unit->graph->getArena())).get();
+        };
+    // constants 0, 1 and powers of two are folded and simplified by peepholes
+    fillFunction(unit->graph.get(), insts_per_bb, 8, seed, 8,
+                 {InstType::Add, InstType::Sub, InstType::Mul, InstType::And, InstType::Or,
+                  InstType::Xor, InstType::AShr, InstType::ZeroCheck, InstType::BoundsCheck},
+                 make_callee);
+    return std::shared_ptr<Graph>(unit, unit->graph.get());
+}
+
+/**
+ * Instructions number of the graph for per instruction counters
+ */
+inline size_t getInstsNum(Graph* graph)
+{
+    size_t num = 0;
+    for (auto* bb : graph->getBBs())
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+            ++num;
+    return num;
+}
+
+} // namespace compiler::bench
\ No newline at end of file
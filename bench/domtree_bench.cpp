@@ -0,0 +1,28 @@
+#include "cfg_generator.h"
+#include "pass/domtree.h"
+#include <benchmark/benchmark.h>
+
+using namespace compiler;
+
+static void BM_DomTree(benchmark::State& state)
+{
+    auto graph = bench::generateCfg(state.range(0));
+    for (auto _ : state)
+    {
+        // drop the cached result to measure the construction
+        graph->invalidateAnalysis<DomTree>();
+        graph->runPass<DomTree>();
+        benchmark::DoNotOptimize(graph->getLastBB()->getIdom());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DomTree)->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+static void BM_DomTreeCached(benchmark::State& state)
+{
+    auto graph = bench::generateCfg(state.range(0));
+    graph->runPass<DomTree>();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(graph->getAnalysis<DomTree>());
+}
+BENCHMARK(BM_DomTreeCached)->Arg(10000);
\ No newline at end of file
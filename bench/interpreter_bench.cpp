@@ -0,0 +1,70 @@
+#include "ir/graph.h"
+#include "runtime/interpreter.h"
+#include <benchmark/benchmark.h>
+
+using namespace compiler;
+
+/**
+ * Loop summing i * i + (i ^ n) for i in [0, n):
+ *    [1] -> [2] <-> [3]
+ *            |
+ *            v
+ *           [4]
+ */
+static std::shared_ptr<Graph> buildSumLoop()
+{
+    auto graph = std::make_shared<Graph>("sum_loop");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addBB(bb4);
+    graph->addEdge(bb3, bb2);
+    graph->addEdge(bb2, bb4);
+
+    auto* n = graph->create<ParamInst>(0, DataType::i64, "n");
+    bb1->pushBackInst(n);
+    auto* zero = graph->findConstant(static_cast<uint64_t>(0));
+    auto* one = graph->findConstant(static_cast<uint64_t>(1));
+
+    auto* i = graph->create<PhiInst>(10);
+    auto* acc = graph->create<PhiInst>(11);
+    bb2->pushBackPhiInst(i);
+    bb2->pushBackPhiInst(acc);
+    bb2->pushBackInst(graph->create<BinaryInst>(12, InstType::Cmp, i, n));
+    bb2->pushBackInst(graph->create<JumpInst>(13, InstType::Jae, bb4));
+
+    auto* square = graph->create<BinaryInst>(14, InstType::Mul, i, i);
+    auto* mask = graph->create<BinaryInst>(15, InstType::Xor, i, n);
+    auto* sum = graph->create<BinaryInst>(16, InstType::Add, square, mask);
+    auto* new_acc = graph->create<BinaryInst>(17, InstType::Add, acc, sum);
+    auto* new_i = graph->create<BinaryInst>(18, InstType::Add, i, one);
+    bb3->pushBackInst(square);
+    bb3->pushBackInst(mask);
+    bb3->pushBackInst(sum);
+    bb3->pushBackInst(new_acc);
+    bb3->pushBackInst(new_i);
+    bb3->pushBackInst(graph->create<JumpInst>(19, InstType::Jmp, bb2));
+
+    i->addInput(zero, bb1);
+    i->addInput(new_i, bb3);
+    acc->addInput(zero, bb1);
+    acc->addInput(new_acc, bb3);
+    bb4->pushBackInst(graph->create<UnaryInst>(20, InstType::Return, acc));
+    return graph;
+}
+
+// loop iterations number, an iteration is about ten ops
+static void BM_Interpreter(benchmark::State& state)
+{
+    auto graph = buildSumLoop();
+    Interpreter interp(graph.get());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(interp.call<uint64_t>(state.range(0)).value);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Interpreter)->RangeMultiplier(10)->Range(10, 100000);
\ No newline at end of file
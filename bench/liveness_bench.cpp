@@ -0,0 +1,21 @@
+#include "cfg_generator.h"
+#include "pass/linear_order.h"
+#include "pass/liveness.h"
+#include <benchmark/benchmark.h>
+
+using namespace compiler;
+
+// blocks number, values number is 8 times more
+static void BM_Liveness(benchmark::State& state)
+{
+    auto graph = bench::generateFunction(state.range(0), 8);
+    graph->runPass<LinearOrder>();
+    for (auto _ : state)
+    {
+        graph->invalidateAnalysis<LivenessAnalysis>();
+        graph->runPass<LivenessAnalysis>();
+        benchmark::DoNotOptimize(graph->getLiveIntervals().size());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_Liveness)->RangeMultiplier(4)->Range(16, 1024)->Complexity();
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "cfg_generator.h"
+#include "pass/checks_elimination.h"
+#include "pass/dce.h"
+#include "pass/gvn.h"
+#include "pass/inline.h"
+#include "pass/linear_order.h"
+#include "pass/liveness.h"
+#include "pass/loop_analysis.h"
+#include "pass/peepholes.h"
+#include "pass/reg_alloc.h"
+#include "pass/rpo.h"
+#include "pass/sccp.h"
+#include <benchmark/benchmark.h>
+
+using namespace compiler;
+using bench::CfgShape;
+
+/**
+ * Besides the time of the run the pass is measured in time per block and per instruction
+ * of the graph given to it, so shapes and sizes can be compared with each other
+ */
+static void setPerItemCounters(benchmark::State& state, size_t bbs_num, size_t insts_num)
+{
+    auto flags = benchmark::Counter::kIsIterationInvariantRate |
+                           benchmark::Counter::kInvert;
+    state.counters["per_bb"] = benchmark::Counter(static_cast<double>(bbs_num), flags);
+    state.counters["per_inst"] = benchmark::Counter(static_cast<double>(insts_num), flags);
+}
+
+// analyses keep the graph, only the analysis itself is dropped and rerun
+template <typename AnalysisName>
+static void BM_Analysis(benchmark::State& state, CfgShape shape)
+{
+    auto graph = bench::generateShapeFunction(shape, state.range(0));
+    graph->runPass<AnalysisName>();
+    for (auto _ : state)
+    {
+        graph->invalidateAnalysis<AnalysisName>();
+        graph->runPass<AnalysisName>();
+    }
+    setPerItemCounters(state, graph->size(), bench::getInstsNum(graph.get()));
+}
+
+// optimizations change the graph, every run gets a new one with analyses it needs computed
+template <typename PassName>
+static void BM_Optimization(benchmark::State& state, CfgShape shape)
+{
+    std::shared_ptr<Graph> graph = nullptr;
+    size_t bbs_num = 0;
+    size_t insts_num = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        graph = bench::generateShapeFunction(shape, state.range(0));
+        bbs_num = graph->size();
+        insts_num = bench::getInstsNum(graph.get());
+        graph->runPass<DomTree>();
+        state.ResumeTiming();
+        graph->runPass<PassName>();
+    }
+    setPerItemCounters(state, bbs_num, insts_num);
+}
+
+/**
+ * Benchmarks of the pass on graphs of every shape with 10 to max_size blocks.
+ * Liveness and allocation keep bit vectors of values per block, so their graphs are smaller.
+ */
+static void registerPass(const std::string& name, void (*func)(benchmark::State&, CfgShape),
+                         int64_t max_size,
+                         std::initializer_list<CfgShape> shapes = {
+                             CfgShape::Diamonds, CfgShape::NestedLoops, CfgShape::Irreducible,
+                             CfgShape::Chain, CfgShape::FanOut, CfgShape::Calls})
+{
+    for (auto shape : shapes)
+        benchmark::RegisterBenchmark((name + "/" + bench::getShapeName(shape)).c_str(), func,
+                                     shape)
+            ->RangeMultiplier(10)
+            ->Range(10, max_size)
+            ->Unit(benchmark::kMicrosecond);
+}
+
+static const bool PASSES_REGISTERED = []() {
+    constexpr int64_t MAX_SIZE = 100000;
+    constexpr int64_t MAX_LIVENESS_SIZE = 10000;
+    registerPass("BM_Rpo", BM_Analysis<Rpo>, MAX_SIZE);
+    registerPass("BM_DomTree", BM_Analysis<DomTree>, MAX_SIZE);
+    registerPass("BM_LoopAnalysis", BM_Analysis<LoopAnalysis>, MAX_SIZE);
+    registerPass("BM_LinearOrder", BM_Analysis<LinearOrder>, MAX_SIZE);
+    registerPass("BM_LivenessAnalysis", BM_Analysis<LivenessAnalysis>, MAX_LIVENESS_SIZE);
+    registerPass("BM_RegisterAllocation", BM_Optimization<RegisterAllocation>,
+                 MAX_LIVENESS_SIZE);
+    registerPass("BM_Sccp", BM_Optimization<Sccp>, MAX_SIZE);
+    registerPass("BM_Peepholes", BM_Optimization<Peepholes>, MAX_SIZE);
+    registerPass("BM_Dce", BM_Optimization<Dce>, MAX_SIZE);
+    registerPass("BM_ChecksElimination", BM_Optimization<ChecksElimination>, MAX_SIZE);
+    registerPass("BM_Gvn", BM_Optimization<Gvn>, MAX_SIZE);
+    // only calls have something to inline
+    registerPass("BM_Inline", BM_Optimization<Inline>, MAX_SIZE, {CfgShape::Calls});
+    return true;
+}();
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "cfg_generator.h"
+#include "pass/reg_alloc.h"
+#include <benchmark/benchmark.h>
+
+using namespace compiler;
+
+/**
+ * Blocks number, values number is 8 times more. Besides the time the counters give the code
+ * quality: spill code and resolution moves of the last run on the same graph.
+ */
+template <RegAllocKind KIND>
+static void BM_RegAlloc(benchmark::State& state)
+{
+    RegAllocStats stats;
+    for (auto _ : state)
+    {
+        // allocation splits intervals and inserts moves, every run needs a new graph
+        state.PauseTiming();
+        auto graph = bench::generateFunction(state.range(0), 8, 16, 42, 8);
+        graph->setRegAllocKind(KIND);
+        state.ResumeTiming();
+        graph->runPass<RegisterAllocation>();
+        stats = graph->getRegAllocStats();
+    }
+    state.counters["spills"] = static_cast<double>(stats.spills);
+    state.counters["fills"] = static_cast<double>(stats.fills);
+    state.counters["remats"] = static_cast<double>(stats.remats);
+    state.counters["moves"] = static_cast<double>(stats.moves + stats.swaps);
+    state.counters["removed_moves"] = static_cast<double>(stats.removed_moves);
+}
+BENCHMARK(BM_RegAlloc<RegAllocKind::LinearScan>)
+    ->RangeMultiplier(4)
+    ->Range(16, 256)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RegAlloc<RegAllocKind::GraphColoring>)
+    ->RangeMultiplier(4)
+    ->Range(16, 256)
+    ->Unit(benchmark::kMillisecond);
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "aot.h"
+#include <algorithm>
+#include <array>
+#include <elf.h>
+#include <iomanip>
+
+namespace compiler
+{
+
+namespace
+{
+
+// sections of the object file
+enum : uint16_t
+{
+    SECTION_NULL = 0,
+    SECTION_TEXT,
+    SECTION_BSS,
+    SECTION_RELA_TEXT,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    SECTION_NOTE_STACK,
+    SECTIONS_NUM
+};
+
+constexpr size_t TEXT_ALIGN = 16;
+constexpr size_t BSS_ALIGN = 8;
+// symbols after the null one: .text and .bss sections
+constexpr uint32_t BSS_SYMBOL = 2;
+constexpr size_t BYTES_PER_LINE = 16;
+
+size_t addString(std::string& table, const std::string& str)
+{
+    auto offset = table.size();
+    table += str;
+    table.push_back('\0');
+    return offset;
+}
+
+size_t alignUp(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+template <typename T>
+void writeData(std::ostream& out, const T* data, size_t num)
+{
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * num));
+}
+
+void writePadding(std::ostream& out, size_t offset)
+{
+    auto cur = static_cast<size_t>(out.tellp());
+    ASSERT(cur <= offset, "sections overlap");
+    for (; cur < offset; ++cur)
+        out.put('\0');
+}
+
+} // namespace
+
+void AotCompiler::addFunction(Graph* graph)
+{
+    codegen.generate(graph);
+    exported.insert(graph);
+}
+
+size_t AotCompiler::getDataOffset(x86_64::label_t label) const
+{
+    if (label == codegen.getStatusLabel())
+        return x86_64::RUNTIME_STATUS_OFFSET;
+    ASSERT(label == codegen.getDepthLabel(), "reference to an unknown label");
+    return x86_64::RUNTIME_DEPTH_OFFSET;
+}
+
+std::vector<AotCompiler::Symbol> AotCompiler::finalize()
+{
+    masm.resolveLabels();
+    std::vector<Symbol> symbols;
+    std::unordered_set<std::string> names;
+    for (auto* func : codegen.getFunctions())
+    {
+        auto name = func->getName();
+        ASSERT(!name.empty() && names.insert(name).second,
+               "functions of the unit need unique names: '" << name << "'");
+        if (!symbols.empty())
+            symbols.back().size = masm.getLabelOffset(codegen.getFunctionLabel(func)) -
+                                  symbols.back().offset;
+        symbols.push_back({name, masm.getLabelOffset(codegen.getFunctionLabel(func)), 0,
+                           exported.contains(func)});
+    }
+    if (!symbols.empty())
+        symbols.back().size = masm.size() - symbols.back().offset;
+    return symbols;
+}
+
+void AotCompiler::writeObject(std::ostream& out)
+{
+    auto functions = finalize();
+    auto& code = masm.getCode();
+
+    std::string strtab(1, '\0');
+    std::vector<Elf64_Sym> symbols(1);
+    symbols.push_back({0, ELF64_ST_INFO(STB_LOCAL, STT_SECTION), STV_DEFAULT, SECTION_TEXT, 0, 0});
+    symbols.push_back({0, ELF64_ST_INFO(STB_LOCAL, STT_SECTION), STV_DEFAULT, SECTION_BSS, 0, 0});
+    // local symbols go first
+    for (bool is_global : {false, true})
+        for (auto& func : functions)
+            if (func.is_global == is_global)
+                symbols.push_back({static_cast<uint32_t>(addString(strtab, func.name)),
+                                   ELF64_ST_INFO(is_global ? STB_GLOBAL : STB_LOCAL, STT_FUNC),
+                                   STV_DEFAULT, SECTION_TEXT, func.offset, func.size});
+    auto first_global = std::find_if(symbols.begin() + BSS_SYMBOL + 1, symbols.end(),
+                                     [](const Elf64_Sym& sym) {
+                                         return ELF64_ST_BIND(sym.st_info) == STB_GLOBAL;
+                                     }) -
+                        symbols.begin();
+    symbols.push_back({static_cast<uint32_t>(addString(strtab, getStatusSymbol())),
+                       ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT), STV_DEFAULT, SECTION_BSS,
+                       x86_64::RUNTIME_STATUS_OFFSET, sizeof(uint8_t)});
+    symbols.push_back({static_cast<uint32_t>(addString(strtab, getDepthSymbol())),
+                       ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT), STV_DEFAULT, SECTION_BSS,
+                       x86_64::RUNTIME_DEPTH_OFFSET, sizeof(uint32_t)});
+
+    // the runtime data is addressed through the local section symbol, so the code is PIC
+    std::vector<Elf64_Rela> relocations;
+    for (auto& ref : masm.getLabelRefs())
+        relocations.push_back(
+            {ref.offset, ELF64_R_INFO(BSS_SYMBOL, R_X86_64_PC32),
+             static_cast<Elf64_Sxword>(getDataOffset(ref.label)) + ref.addend});
+
+    std::string shstrtab(1, '\0');
+    std::array<Elf64_Shdr, SECTIONS_NUM> sections{};
+    auto set_section = [&](uint16_t num, const char* name, uint32_t type, uint64_t flags,
+                           size_t offset, size_t size, size_t align, size_t entry_size = 0) {
+        auto& section = sections[num];
+        section.sh_name = static_cast<uint32_t>(addString(shstrtab, name));
+        section.sh_type = type;
+        section.sh_flags = flags;
+        section.sh_offset = offset;
+        section.sh_size = size;
+        section.sh_addralign = align;
+        section.sh_entsize = entry_size;
+    };
+
+    size_t offset = sizeof(Elf64_Ehdr);
+    auto place = [&offset](size_t size, size_t align) {
+        offset = alignUp(offset, align);
+        auto start = offset;
+        offset += size;
+        return start;
+    };
+    set_section(SECTION_TEXT, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                place(code.size(), TEXT_ALIGN), code.size(), TEXT_ALIGN);
+    set_section(SECTION_BSS, ".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, offset,
+                x86_64::RUNTIME_DATA_SIZE, BSS_ALIGN);
+    auto rela_size = relocations.size() * sizeof(Elf64_Rela);
+    set_section(SECTION_RELA_TEXT, ".rela.text", SHT_RELA, SHF_INFO_LINK,
+                place(rela_size, alignof(Elf64_Rela)), rela_size, alignof(Elf64_Rela),
+                sizeof(Elf64_Rela));
+    sections[SECTION_RELA_TEXT].sh_link = SECTION_SYMTAB;
+    sections[SECTION_RELA_TEXT].sh_info = SECTION_TEXT;
+    auto symtab_size = symbols.size() * sizeof(Elf64_Sym);
+    set_section(SECTION_SYMTAB, ".symtab", SHT_SYMTAB, 0, place(symtab_size, alignof(Elf64_Sym)),
+                symtab_size, alignof(Elf64_Sym), sizeof(Elf64_Sym));
+    sections[SECTION_SYMTAB].sh_link = SECTION_STRTAB;
+    sections[SECTION_SYMTAB].sh_info = static_cast<uint32_t>(first_global);
+    set_section(SECTION_STRTAB, ".strtab", SHT_STRTAB, 0, place(strtab.size(), 1),
+                strtab.size(), 1);
+    // the executable stack is not needed
+    set_section(SECTION_NOTE_STACK, ".note.GNU-stack", SHT_PROGBITS, 0, offset, 0, 1);
+    // the name of the table is in the table itself
+    sections[SECTION_SHSTRTAB].sh_name = static_cast<uint32_t>(addString(shstrtab, ".shstrtab"));
+    sections[SECTION_SHSTRTAB].sh_type = SHT_STRTAB;
+    sections[SECTION_SHSTRTAB].sh_offset = place(shstrtab.size(), 1);
+    sections[SECTION_SHSTRTAB].sh_size = shstrtab.size();
+    sections[SECTION_SHSTRTAB].sh_addralign = 1;
+    auto headers_offset = place(sections.size() * sizeof(Elf64_Shdr), alignof(Elf64_Shdr));
+
+    Elf64_Ehdr header{};
+    std::copy_n(ELFMAG, SELFMAG, header.e_ident);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = headers_offset;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = SECTIONS_NUM;
+    header.e_shstrndx = SECTION_SHSTRTAB;
+
+    auto start = out.tellp();
+    auto write_at = [&out, start](size_t pos, const auto* data, size_t num) {
+        writePadding(out, static_cast<size_t>(start) + pos);
+        writeData(out, data, num);
+    };
+    write_at(0, &header, 1);
+    write_at(sections[SECTION_TEXT].sh_offset, code.data(), code.size());
+    write_at(sections[SECTION_RELA_TEXT].sh_offset, relocations.data(), relocations.size());
+    write_at(sections[SECTION_SYMTAB].sh_offset, symbols.data(), symbols.size());
+    write_at(sections[SECTION_STRTAB].sh_offset, strtab.data(), strtab.size());
+    write_at(sections[SECTION_SHSTRTAB].sh_offset, shstrtab.data(), shstrtab.size());
+    write_at(headers_offset, sections.data(), sections.size());
+}
+
+void AotCompiler::writeAssembly(std::ostream& out)
+{
+    auto functions = finalize();
+    auto& code = masm.getCode();
+    auto& refs = masm.getLabelRefs();
+    auto data_label = ".L" + unit_name + "_data";
+
+    out << "\t.text\n\t.p2align 4\n";
+    auto flags = out.flags();
+    size_t ref_num = 0;
+    for (auto& func : functions)
+    {
+        if (func.is_global)
+            out << "\t.globl " << func.name << "\n";
+        out << "\t.type " << func.name << ", @function\n" << func.name << ":\n";
+
+        size_t end = func.offset + func.size;
+        for (size_t pos = func.offset; pos < end;)
+        {
+            // references to the runtime data are PC-relative: S + A - P
+            if (ref_num < refs.size() && refs[ref_num].offset == pos)
+            {
+                auto& ref = refs[ref_num++];
+                auto addend = static_cast<int64_t>(getDataOffset(ref.label)) + ref.addend;
+                out << std::dec << "\t.long " << data_label << (addend < 0 ? "" : "+") << addend
+                    << "-.\n";
+                pos += 4;
+                continue;
+            }
+            auto line_end = std::min(end, pos + BYTES_PER_LINE);
+            if (ref_num < refs.size())
+                line_end = std::min(line_end, refs[ref_num].offset);
+            out << "\t.byte ";
+            for (; pos < line_end; ++pos)
+                out << "0x" << std::hex << std::setw(2) << std::setfill('0')
+                    << static_cast<unsigned>(code[pos]) << (pos + 1 < line_end ? "," : "\n");
+        }
+        out << std::dec << "\t.size " << func.name << ", .-" << func.name << "\n";
+    }
+    out.flags(flags);
+
+    out << "\n\t.bss\n\t.p2align 3\n" << data_label << ":\n";
+    auto data_symbol = [&out](const std::string& name, size_t size) {
+        out << "\t.globl " << name << "\n\t.type " << name << ", @object\n\t.size " << name
+            << ", " << size << "\n"
+            << name << ":\n";
+    };
+    data_symbol(getStatusSymbol(), sizeof(uint8_t));
+    out << "\t.zero " << x86_64::RUNTIME_DEPTH_OFFSET - x86_64::RUNTIME_STATUS_OFFSET << "\n";
+    data_symbol(getDepthSymbol(), sizeof(uint32_t));
+    out << "\t.zero " << x86_64::RUNTIME_DATA_SIZE - x86_64::RUNTIME_DEPTH_OFFSET << "\n";
+    out << "\n\t.section .note.GNU-stack,\"\",@progbits\n";
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "codegen.h"
+#include "ir/graph.h"
+#include <ostream>
+#include <string>
+#include <unordered_set>
+
+namespace compiler
+{
+
+/**
+ * AOT mode of the x86-64 code generator: functions of a unit are generated into one .text,
+ * calls between them are resolved in the unit, only references to the runtime data in .bss
+ * are left to the linker. Added functions are global symbols named as their graphs,
+ * functions called from them are local ones; the runtime data is exported as
+ * <unit>_status (ExecStatus of the last call, uint8_t) and <unit>_depth (uint32_t).
+ * The unit is written as an ELF64 relocatable object or as GNU as source of the same bytes.
+ * Graphs must be register allocated and names of functions must be unique.
+ */
+class AotCompiler final
+{
+  public:
+    explicit AotCompiler(std::string unit_name_) : unit_name(unit_name_), codegen(masm)
+    {}
+
+    ~AotCompiler() = default;
+
+    void addFunction(Graph* graph);
+
+    void writeObject(std::ostream& out);
+    void writeAssembly(std::ostream& out);
+
+    DEFINE_ARRAY_GETTER(unit_name, UnitName, std::string)
+
+    std::string getStatusSymbol() const
+    {
+        return unit_name + "_status";
+    }
+
+    std::string getDepthSymbol() const
+    {
+        return unit_name + "_depth";
+    }
+
+  private:
+    struct Symbol
+    {
+        std::string name;
+        size_t offset = 0;
+        size_t size = 0;
+        bool is_global = false;
+    };
+
+    // functions in the order of the code, labels of the runtime data are left unbound
+    std::vector<Symbol> finalize();
+    size_t getDataOffset(x86_64::label_t label) const;
+
+  private:
+    std::string unit_name;
+    x86_64::Assembler masm;
+    x86_64::CodeGenerator codegen;
+    std::unordered_set<Graph*> exported;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "code_buffer.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace compiler
+{
+
+static size_t getPageSize()
+{
+    static const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+size_t CodeBuffer::getDataOffset(size_t code_size)
+{
+    auto page_size = getPageSize();
+    return (code_size + page_size - 1) / page_size * page_size;
+}
+
+CodeBuffer::CodeBuffer(const std::vector<uint8_t>& code, size_t data_offset_, size_t data_size)
+    : data_offset(data_offset_)
+{
+    ASSERT(data_offset == getDataOffset(code.size()), "data must start at the page after code");
+    size = data_offset + getDataOffset(data_size);
+    auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap of code buffer");
+    memory = static_cast<uint8_t*>(ptr);
+    std::memcpy(memory, code.data(), code.size());
+
+    if (data_offset != 0 && mprotect(memory, data_offset, PROT_READ | PROT_EXEC) != 0)
+    {
+        auto error = errno;
+        munmap(memory, size);
+        throw std::system_error(error, std::generic_category(), "mprotect of code buffer");
+    }
+}
+
+CodeBuffer::~CodeBuffer()
+{
+    if (memory != nullptr)
+        munmap(memory, size);
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ir/utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Executable memory under W^X: the code is copied to a fresh anonymous mapping,
+ * then its pages become read-only and executable. Data pages after the code stay writable
+ * and not executable, the code addresses them relative to RIP, so the data offset has to
+ * be known when labels are resolved.
+ */
+class CodeBuffer final
+{
+  public:
+    CodeBuffer(const std::vector<uint8_t>& code, size_t data_offset_, size_t data_size);
+    ~CodeBuffer();
+
+    CodeBuffer(const CodeBuffer&) = delete;
+    CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+    // offset of data pages after the code of the size
+    static size_t getDataOffset(size_t code_size);
+
+    const uint8_t* getCode() const noexcept
+    {
+        return memory;
+    }
+
+    uint8_t* getData() noexcept
+    {
+        return memory + data_offset;
+    }
+
+    DEFINE_GETTER(size, Size, size_t)
+
+  private:
+    uint8_t* memory = nullptr;
+    size_t size = 0;
+    size_t data_offset = 0;
+};
+
+} // namespace compiler
\ No newline at end of file
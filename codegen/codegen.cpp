@@ -0,0 +1,1061 @@
+#include "codegen.h"
+#include "pass/liveness.h"
+#include "runtime/interpreter.h"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace compiler::x86_64
+{
+
+namespace
+{
+
+constexpr size_t SLOT_SIZE = 8;
+// rsp is aligned at calls
+constexpr size_t STACK_ALIGN = 16;
+constexpr size_t HW_REGS_NUM = 16;
+constexpr std::array<uint8_t, 6> INT_ARG_REGS = {RDI, RSI, RDX, RCX, R8, R9};
+constexpr size_t FLOAT_ARG_REGS_NUM = 8;
+constexpr uint8_t INT_RET_REG = RAX;
+constexpr uint8_t FLOAT_RET_REG = 0;
+constexpr uint8_t SCRATCH = R11;
+constexpr uint8_t XMM_SCRATCH = 15;
+// C2 flag of the x87 status word: the partial remainder is not final
+constexpr uint8_t FPU_C2 = 0x4;
+
+constexpr std::array<std::string_view, HW_REGS_NUM> INT_REG_NAMES = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15"};
+
+uint8_t getHwReg(RegClass reg_class, const std::string& name)
+{
+    for (uint8_t reg = 0; reg < HW_REGS_NUM; ++reg)
+    {
+        if (reg_class == RegClass::Int && name == INT_REG_NAMES[reg])
+            return reg;
+        if (reg_class == RegClass::Float && name == "xmm" + std::to_string(reg))
+            return reg;
+    }
+    ASSERT(false, "unknown x86-64 register " << name);
+    return 0;
+}
+
+// System V preserved registers besides rbp, all xmm are clobbered by calls
+constexpr bool isCalleeSaved(RegClass reg_class, uint8_t reg)
+{
+    return reg_class == RegClass::Int && (reg == RBX || reg >= R12);
+}
+
+constexpr size_t alignUp(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+constexpr bool isWide(DataType type)
+{
+    return getDataTypeSize(type) == SLOT_SIZE;
+}
+
+bool isFloat(DataType type)
+{
+    return Target::getRegClass(type) == RegClass::Float;
+}
+
+// the only successor can be any of two after LinearOrder
+BasicBlock* getSucc(BasicBlock* bb)
+{
+    return bb->getTrueSucc() != nullptr ? bb->getTrueSucc() : bb->getFalseSucc();
+}
+
+DataType getReturnType(Graph* graph)
+{
+    for (auto* bb : graph->getBBs())
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+            if (inst->getInstType() == InstType::Return)
+                return inst->getInput(0)->getType();
+    return DataType::NoType;
+}
+
+Cond getJumpCond(InstType type)
+{
+    switch (type)
+    {
+        case InstType::Je:
+            return Cond::E;
+        case InstType::Jne:
+            return Cond::NE;
+        case InstType::Jb:
+            return Cond::B;
+        case InstType::Jbe:
+            return Cond::BE;
+        case InstType::Ja:
+            return Cond::A;
+        case InstType::Jae:
+            return Cond::AE;
+        default:
+            UNREACHABLE();
+    }
+}
+
+/**
+ * Code of one function. The frame from rbp down: saved callee-saved registers,
+ * save slots of caller-saved registers live across calls, the spill area of the graph
+ * and the outgoing area at rsp for stack args of calls and staged args in registers.
+ */
+class FunctionCodegen final
+{
+  public:
+    FunctionCodegen(CodeGenerator* codegen_, Assembler& masm_, Graph* graph_)
+        : codegen(codegen_), masm(masm_), graph(graph_),
+          live_intervals(graph_->getLiveIntervals())
+    {}
+
+    void generate(label_t entry);
+
+  private:
+    struct SavedReg
+    {
+        RegClass reg_class = RegClass::Int;
+        uint8_t reg = 0;
+        Mem mem;
+    };
+
+    void mapRegisters();
+    void layoutFrame();
+    void collectCallSaves(Inst* call, std::vector<LiveInterval*>& reg_parts);
+    std::vector<BasicBlock*> layoutBlocks();
+
+    void generatePrologue(label_t entry);
+    void generateParams();
+    void generateEpilogue();
+    void generateTraps();
+    label_t getTrapLabel(ExecStatus status);
+
+    uint8_t getReg(RegClass reg_class, size_t reg) const
+    {
+        return hw_regs[static_cast<size_t>(reg_class)][reg];
+    }
+
+    // num-th 8-byte slot of the saved registers
+    static Mem getFrameMem(size_t num)
+    {
+        return {RBP, -static_cast<int32_t>((num + 1) * SLOT_SIZE)};
+    }
+
+    Mem getSlotMem(size_t slot) const
+    {
+        return {RBP, spill_base + static_cast<int32_t>(graph->getStackSlots()[slot].offset)};
+    }
+
+    Location getDefLocation(Inst* inst) const;
+    Location getInputLocation(Inst* inst, size_t num) const;
+    uint8_t getInputReg(Inst* inst, size_t num) const;
+    // register to compute the result of inst in: its own or the scratch one
+    uint8_t getResultReg(Inst* inst, Location def) const;
+    void storeResult(DataType type, Location def, uint8_t reg);
+
+    void load(DataType type, uint8_t reg, Mem mem);
+    void store(DataType type, Mem mem, uint8_t reg);
+    void copy(DataType type, uint8_t dst, uint8_t src);
+    void move(DataType type, Location src, Location dst, Inst* value);
+    void swap(DataType type, Location left, Location right);
+    void loadConst(DataType type, Location dst, uint64_t bits);
+
+    void generateBlock(BasicBlock* bb, BasicBlock* next);
+    void generateInst(Inst* inst);
+    void generateIntBinary(Inst* inst);
+    void generateFloatBinary(Inst* inst);
+    void generateDivMod(Inst* inst);
+    void generateShift(Inst* inst);
+    void generateFloatMod(Inst* inst);
+    void generateUnary(Inst* inst);
+    void generateCmp(Inst* inst);
+    void generateCheck(Inst* inst);
+    void generateCast(Inst* inst);
+    void generateMov(Inst* inst);
+    void generateCall(Inst* inst);
+    void storeArg(Inst* call, size_t num, Mem mem);
+    void generateReturn(Inst* inst);
+    void generateBranch(BasicBlock* bb, Inst* jump, BasicBlock* next);
+
+  private:
+    CodeGenerator* codegen = nullptr;
+    Assembler& masm;
+    Graph* graph = nullptr;
+    Graph::live_intervals_t& live_intervals;
+
+    // hardware numbers of target registers with the scratch one at the end, by class
+    std::array<std::vector<uint8_t>, REG_CLASSES_NUM> hw_regs;
+
+    std::vector<uint8_t> callee_saved;
+    std::unordered_map<Inst*, std::vector<SavedReg>> call_saves;
+    size_t frame_size = 0;
+    int32_t spill_base = 0;
+
+    std::unordered_map<BasicBlock*, label_t> bb_labels;
+    label_t epilogue = INVALID_LABEL;
+    std::array<label_t, static_cast<size_t>(ExecStatus::StackOverflow) + 1> traps;
+};
+
+void FunctionCodegen::generate(label_t entry)
+{
+    traps.fill(INVALID_LABEL);
+    epilogue = masm.newLabel();
+    mapRegisters();
+    layoutFrame();
+
+    auto blocks = layoutBlocks();
+    for (auto* bb : blocks)
+        bb_labels[bb] = masm.newLabel();
+
+    generatePrologue(entry);
+    for (size_t i = 0; i < blocks.size(); ++i)
+        generateBlock(blocks[i], i + 1 < blocks.size() ? blocks[i + 1] : nullptr);
+    generateEpilogue();
+    generateTraps();
+}
+
+void FunctionCodegen::mapRegisters()
+{
+    auto* target = graph->getTarget();
+    for (size_t i = 0; i < REG_CLASSES_NUM; ++i)
+    {
+        auto reg_class = static_cast<RegClass>(i);
+        auto& regs = hw_regs[i];
+        regs.clear();
+        for (size_t reg = 0, size = target->getRegsNum(reg_class); reg <= size; ++reg)
+            regs.push_back(getHwReg(reg_class, target->getRegName(reg_class, reg)));
+
+        auto scratch = reg_class == RegClass::Int ? SCRATCH : XMM_SCRATCH;
+        ASSERT(regs.back() == scratch, "scratch registers must be r11 and xmm15");
+        for (size_t reg = 0; reg + 1 < regs.size(); ++reg)
+        {
+            ASSERT(regs[reg] != scratch, "scratch register is allocatable");
+            ASSERT(reg_class == RegClass::Float || (regs[reg] != RSP && regs[reg] != RBP),
+                   "rsp and rbp are reserved for the frame");
+        }
+    }
+}
+
+void FunctionCodegen::layoutFrame()
+{
+    std::vector<LiveInterval*> reg_parts;
+    std::array<bool, HW_REGS_NUM> is_used{};
+    for (auto* live_int : live_intervals)
+    {
+        if (live_int == nullptr || live_int->isEmpty())
+            continue;
+        auto reg_class = Target::getRegClass(live_int->getInst()->getType());
+        auto add_part = [&](LiveInterval* part) {
+            if (!part->isRealRegister())
+                return;
+            reg_parts.push_back(part);
+            auto reg = getReg(reg_class, part->getLocation());
+            if (isCalleeSaved(reg_class, reg))
+                is_used[reg] = true;
+        };
+        add_part(live_int);
+        for (auto* child : live_int->getSplitChildren())
+            add_part(child);
+    }
+    callee_saved.clear();
+    for (uint8_t reg = 0; reg < HW_REGS_NUM; ++reg)
+        if (is_used[reg])
+            callee_saved.push_back(reg);
+
+    // outgoing area keeps incoming args in registers at the entry
+    size_t outgoing = 0;
+    for (auto* inst = graph->getFirstBB()->getFirstInst(); inst != nullptr;
+         inst = inst->getNext())
+        if (inst->getInstType() == InstType::Param)
+            outgoing += SLOT_SIZE;
+
+    call_saves.clear();
+    size_t saves_num = 0;
+    for (auto* bb : graph->getBBs())
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            if (inst->getInstType() != InstType::Call)
+                continue;
+            outgoing = std::max(outgoing, inst->getInputsNum() * SLOT_SIZE);
+            collectCallSaves(inst, reg_parts);
+            saves_num = std::max(saves_num, call_saves[inst].size());
+        }
+
+    for (auto& [call, saves] : call_saves)
+        for (size_t i = 0; i < saves.size(); ++i)
+            saves[i].mem = getFrameMem(callee_saved.size() + i);
+    auto spill_size = (callee_saved.size() + saves_num) * SLOT_SIZE + graph->getFrameSize();
+    spill_base = -static_cast<int32_t>(spill_size);
+    frame_size = alignUp(spill_size + outgoing, STACK_ALIGN);
+}
+
+void FunctionCodegen::collectCallSaves(Inst* call, std::vector<LiveInterval*>& reg_parts)
+{
+    // values live across the call, the result and args used only by it don't cover it
+    auto pos = call->getLiveNum();
+    auto& saves = call_saves[call];
+    for (auto* part : reg_parts)
+    {
+        if (part->getSplitParent()->getInst() == call || !part->covers(pos))
+            continue;
+        auto reg_class = Target::getRegClass(part->getInst()->getType());
+        auto reg = getReg(reg_class, part->getLocation());
+        if (!isCalleeSaved(reg_class, reg))
+            saves.push_back({reg_class, reg, {}});
+    }
+}
+
+std::vector<BasicBlock*> FunctionCodegen::layoutBlocks()
+{
+    auto blocks = graph->getLinearOrderBBs();
+    ASSERT(!blocks.empty(), "graph has no linear order");
+    std::unordered_set<BasicBlock*> placed(blocks.begin(), blocks.end());
+    // blocks of split critical edges
+    for (auto* bb : graph->getBBs())
+        if (!placed.contains(bb) && !bb->getPreds().empty())
+            blocks.push_back(bb);
+    return blocks;
+}
+
+void FunctionCodegen::generatePrologue(label_t entry)
+{
+    masm.bind(entry);
+    masm.push(RBP);
+    masm.mov(true, RBP, RSP);
+    if (frame_size != 0)
+        masm.aluImm(AluOp::Sub, true, RSP, static_cast<int32_t>(frame_size));
+    for (size_t i = 0; i < callee_saved.size(); ++i)
+        masm.mov(true, getFrameMem(i), callee_saved[i]);
+
+    masm.aluImm(AluOp::Add, codegen->getDepthLabel(), 1);
+    masm.aluImm(AluOp::Cmp, codegen->getDepthLabel(),
+                static_cast<int32_t>(INTERP_MAX_CALL_DEPTH));
+    masm.jcc(Cond::A, getTrapLabel(ExecStatus::StackOverflow));
+    generateParams();
+}
+
+void FunctionCodegen::generateParams()
+{
+    // args in registers are staged first, since the def of one param can take the register
+    // of another
+    std::vector<std::pair<Inst*, Mem>> params;
+    size_t int_args = 0;
+    size_t float_args = 0;
+    size_t stack_args = 0;
+    for (auto* inst = graph->getFirstBB()->getFirstInst(); inst != nullptr;
+         inst = inst->getNext())
+    {
+        if (inst->getInstType() != InstType::Param)
+            continue;
+        auto type = inst->getType();
+        Mem mem{RSP, static_cast<int32_t>(params.size() * SLOT_SIZE)};
+        if (!isFloat(type) && int_args < INT_ARG_REGS.size())
+            store(type, mem, INT_ARG_REGS[int_args++]);
+        else if (isFloat(type) && float_args < FLOAT_ARG_REGS_NUM)
+            store(type, mem, static_cast<uint8_t>(float_args++));
+        else
+            mem = {RBP, static_cast<int32_t>(2 * SLOT_SIZE + SLOT_SIZE * stack_args++)};
+        params.emplace_back(inst, mem);
+    }
+
+    for (auto [param, mem] : params)
+    {
+        auto type = param->getType();
+        auto def = getDefLocation(param);
+        if (def.isRegister())
+            load(type, getReg(Target::getRegClass(type), def.index), mem);
+        else if (def.isStackSlot())
+        {
+            auto reg = isFloat(type) ? XMM_SCRATCH : SCRATCH;
+            load(type, reg, mem);
+            store(type, getSlotMem(def.index), reg);
+        }
+    }
+}
+
+void FunctionCodegen::generateEpilogue()
+{
+    masm.bind(epilogue);
+    masm.aluImm(AluOp::Sub, codegen->getDepthLabel(), 1);
+    for (size_t i = 0; i < callee_saved.size(); ++i)
+        masm.mov(true, callee_saved[i], getFrameMem(i));
+    masm.leave();
+    masm.ret();
+}
+
+void FunctionCodegen::generateTraps()
+{
+    for (size_t status = 0; status < traps.size(); ++status)
+    {
+        if (traps[status] == INVALID_LABEL)
+            continue;
+        masm.bind(traps[status]);
+        masm.movByte(codegen->getStatusLabel(), static_cast<uint8_t>(status));
+        masm.jmp(epilogue);
+    }
+}
+
+label_t FunctionCodegen::getTrapLabel(ExecStatus status)
+{
+    auto& label = traps[static_cast<size_t>(status)];
+    if (label == INVALID_LABEL)
+        label = masm.newLabel();
+    return label;
+}
+
+Location FunctionCodegen::getDefLocation(Inst* inst) const
+{
+    auto* live_int = live_intervals.get(inst);
+    if (live_int == nullptr || live_int->isEmpty())
+        return {};
+    return live_int->toLocation();
+}
+
+Location FunctionCodegen::getInputLocation(Inst* inst, size_t num) const
+{
+    auto* live_int = live_intervals.get(inst->getInput(num));
+    ASSERT(live_int != nullptr, "input is not allocated");
+    return live_int->getSplitChild(inst->getLiveNum())->toLocation();
+}
+
+uint8_t FunctionCodegen::getInputReg(Inst* inst, size_t num) const
+{
+    auto location = getInputLocation(inst, num);
+    ASSERT(location.isRegister(), "input is not in a register");
+    return getReg(Target::getRegClass(inst->getInput(num)->getType()), location.index);
+}
+
+uint8_t FunctionCodegen::getResultReg(Inst* inst, Location def) const
+{
+    auto reg_class = Target::getRegClass(inst->getType());
+    if (def.isRegister())
+        return getReg(reg_class, def.index);
+    return reg_class == RegClass::Float ? XMM_SCRATCH : SCRATCH;
+}
+
+void FunctionCodegen::storeResult(DataType type, Location def, uint8_t reg)
+{
+    if (def.isRegister())
+        copy(type, getReg(Target::getRegClass(type), def.index), reg);
+    else if (def.isStackSlot())
+        store(type, getSlotMem(def.index), reg);
+}
+
+void FunctionCodegen::load(DataType type, uint8_t reg, Mem mem)
+{
+    if (isFloat(type))
+        masm.movs(type == DataType::f64, reg, mem);
+    else
+        masm.mov(isWide(type), reg, mem);
+}
+
+void FunctionCodegen::store(DataType type, Mem mem, uint8_t reg)
+{
+    if (isFloat(type))
+        masm.movs(type == DataType::f64, mem, reg);
+    else
+        masm.mov(isWide(type), mem, reg);
+}
+
+void FunctionCodegen::copy(DataType type, uint8_t dst, uint8_t src)
+{
+    if (dst == src)
+        return;
+    if (isFloat(type))
+        masm.movaps(dst, src);
+    else
+        masm.mov(true, dst, src);
+}
+
+// moves keep flags: they can be between Cmp and its jump
+void FunctionCodegen::move(DataType type, Location src, Location dst, Inst* value)
+{
+    auto reg_class = Target::getRegClass(type);
+    if (dst.type == LocationType::Remat || dst.type == LocationType::None || src == dst)
+        return;
+    if (src.type == LocationType::Remat)
+    {
+        ASSERT(value->isConstInst(), "only constants are rematerialized");
+        loadConst(type, dst, static_cast<ConstInst*>(value)->getRawValue());
+    }
+    else if (src.isRegister())
+        storeResult(type, dst, getReg(reg_class, src.index));
+    else if (dst.isRegister())
+        load(type, getReg(reg_class, dst.index), getSlotMem(src.index));
+    else
+    {
+        // stack to stack goes through rax, it is saved on the stack for the time
+        auto wide = isWide(type);
+        masm.push(RAX);
+        masm.mov(wide, RAX, getSlotMem(src.index));
+        masm.mov(wide, getSlotMem(dst.index), RAX);
+        masm.pop(RAX);
+    }
+}
+
+void FunctionCodegen::swap(DataType type, Location left, Location right)
+{
+    ASSERT(left.isRegister() && right.isRegister(), "only registers are swapped");
+    auto reg_class = Target::getRegClass(type);
+    auto left_reg = getReg(reg_class, left.index);
+    auto right_reg = getReg(reg_class, right.index);
+    if (reg_class == RegClass::Int)
+    {
+        masm.xchg(true, left_reg, right_reg);
+        return;
+    }
+    masm.xorps(left_reg, right_reg);
+    masm.xorps(right_reg, left_reg);
+    masm.xorps(left_reg, right_reg);
+}
+
+void FunctionCodegen::loadConst(DataType type, Location dst, uint64_t bits)
+{
+    auto low = static_cast<int32_t>(static_cast<uint32_t>(bits));
+    auto high = static_cast<int32_t>(static_cast<uint32_t>(bits >> 32));
+    if (dst.isStackSlot())
+    {
+        auto mem = getSlotMem(dst.index);
+        if (!isWide(type) || static_cast<int64_t>(bits) == low)
+        {
+            masm.movImm(isWide(type), mem, low);
+            return;
+        }
+        masm.movImm(false, mem, low);
+        masm.movImm(false, Mem{mem.base, mem.disp + 4}, high);
+        return;
+    }
+
+    ASSERT(dst.isRegister(), "constant is loaded to nowhere");
+    auto reg = getReg(Target::getRegClass(type), dst.index);
+    if (!isFloat(type))
+    {
+        masm.movImm(reg, bits);
+        return;
+    }
+    // the scratch register can hold a value of the moves, so floats go through the red zone
+    masm.movImm(false, Mem{RSP, -8}, low);
+    if (isWide(type))
+        masm.movImm(false, Mem{RSP, -4}, high);
+    masm.movs(type == DataType::f64, reg, Mem{RSP, -8});
+}
+
+void FunctionCodegen::generateBlock(BasicBlock* bb, BasicBlock* next)
+{
+    masm.bind(bb_labels.at(bb));
+    for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+    {
+        switch (inst->getInstType())
+        {
+            case InstType::Jmp:
+            case InstType::Je:
+            case InstType::Jne:
+            case InstType::Jb:
+            case InstType::Jbe:
+            case InstType::Ja:
+            case InstType::Jae:
+                generateBranch(bb, inst, next);
+                return;
+            case InstType::Return:
+                generateReturn(inst);
+                return;
+            case InstType::RetVoid:
+                masm.jmp(epilogue);
+                return;
+            default:
+                generateInst(inst);
+        }
+    }
+    generateBranch(bb, nullptr, next);
+}
+
+void FunctionCodegen::generateInst(Inst* inst)
+{
+    switch (inst->getInstType())
+    {
+        case InstType::Add:
+        case InstType::Sub:
+        case InstType::Mul:
+        case InstType::And:
+        case InstType::Or:
+        case InstType::Xor:
+            if (isFloat(inst->getType()))
+                generateFloatBinary(inst);
+            else
+                generateIntBinary(inst);
+            break;
+        case InstType::Div:
+        case InstType::Mod:
+            if (!isFloat(inst->getType()))
+                generateDivMod(inst);
+            else if (inst->getInstType() == InstType::Div)
+                generateFloatBinary(inst);
+            else
+                generateFloatMod(inst);
+            break;
+        case InstType::Shl:
+        case InstType::Shr:
+        case InstType::AShr:
+            generateShift(inst);
+            break;
+        case InstType::Not:
+        case InstType::Neg:
+            generateUnary(inst);
+            break;
+        case InstType::Cmp:
+            generateCmp(inst);
+            break;
+        case InstType::ZeroCheck:
+        case InstType::BoundsCheck:
+            generateCheck(inst);
+            break;
+        case InstType::Cast:
+            generateCast(inst);
+            break;
+        case InstType::Mov:
+            generateMov(inst);
+            break;
+        case InstType::Call:
+            generateCall(inst);
+            break;
+        case InstType::Const:
+            move(inst->getType(), {LocationType::Remat}, getDefLocation(inst), inst);
+            break;
+        case InstType::Param:
+            // loaded in the prologue
+            break;
+        default:
+            UNREACHABLE();
+    }
+}
+
+void FunctionCodegen::generateIntBinary(Inst* inst)
+{
+    auto type = inst->getType();
+    auto wide = isWide(type);
+    auto def = getDefLocation(inst);
+    auto dst = getResultReg(inst, def);
+    auto left = getInputReg(inst, 0);
+    auto right = getInputReg(inst, 1);
+
+    auto emit_op = [this, inst, wide](uint8_t dst_reg, uint8_t src_reg) {
+        switch (inst->getInstType())
+        {
+            case InstType::Add:
+                masm.alu(AluOp::Add, wide, dst_reg, src_reg);
+                break;
+            case InstType::Sub:
+                masm.alu(AluOp::Sub, wide, dst_reg, src_reg);
+                break;
+            case InstType::Mul:
+                masm.imul(wide, dst_reg, src_reg);
+                break;
+            case InstType::And:
+                masm.alu(AluOp::And, wide, dst_reg, src_reg);
+                break;
+            case InstType::Or:
+                masm.alu(AluOp::Or, wide, dst_reg, src_reg);
+                break;
+            case InstType::Xor:
+                masm.alu(AluOp::Xor, wide, dst_reg, src_reg);
+                break;
+            default:
+                UNREACHABLE();
+        }
+    };
+
+    if (dst == right && dst != left)
+    {
+        if (inst->getInstType() == InstType::Sub)
+        {
+            masm.mov(true, SCRATCH, right);
+            masm.mov(true, dst, left);
+            emit_op(dst, SCRATCH);
+        }
+        else
+            emit_op(dst, left);
+    }
+    else
+    {
+        copy(type, dst, left);
+        emit_op(dst, right);
+    }
+    storeResult(type, def, dst);
+}
+
+void FunctionCodegen::generateFloatBinary(Inst* inst)
+{
+    auto type = inst->getType();
+    auto is_double = type == DataType::f64;
+    auto def = getDefLocation(inst);
+    auto dst = getResultReg(inst, def);
+    auto left = getInputReg(inst, 0);
+    auto right = getInputReg(inst, 1);
+
+    SseOp op = SseOp::Add;
+    switch (inst->getInstType())
+    {
+        case InstType::Add:
+            op = SseOp::Add;
+            break;
+        case InstType::Sub:
+            op = SseOp::Sub;
+            break;
+        case InstType::Mul:
+            op = SseOp::Mul;
+            break;
+        case InstType::Div:
+            op = SseOp::Div;
+            break;
+        default:
+            UNREACHABLE();
+    }
+
+    if (dst == right && dst != left)
+    {
+        if (op == SseOp::Sub || op == SseOp::Div)
+        {
+            masm.movaps(XMM_SCRATCH, right);
+            masm.movaps(dst, left);
+            masm.sse(op, is_double, dst, XMM_SCRATCH);
+        }
+        else
+            masm.sse(op, is_double, dst, left);
+    }
+    else
+    {
+        copy(type, dst, left);
+        masm.sse(op, is_double, dst, right);
+    }
+    storeResult(type, def, dst);
+}
+
+void FunctionCodegen::generateDivMod(Inst* inst)
+{
+    auto type = inst->getType();
+    auto wide = isWide(type);
+    auto left = getInputReg(inst, 0);
+    auto right = getInputReg(inst, 1);
+    masm.test(wide, right, right);
+    masm.jcc(Cond::E, getTrapLabel(ExecStatus::DivisionByZero));
+
+    // div takes rdx:rax, the result goes through the scratch register
+    masm.push(RAX);
+    masm.push(RDX);
+    masm.mov(true, SCRATCH, right);
+    masm.mov(true, RAX, left);
+    masm.alu(AluOp::Xor, false, RDX, RDX);
+    masm.unary(UnaryOp::Div, wide, SCRATCH);
+    masm.mov(true, SCRATCH, inst->getInstType() == InstType::Div ? RAX : RDX);
+    masm.pop(RDX);
+    masm.pop(RAX);
+    storeResult(type, getDefLocation(inst), SCRATCH);
+}
+
+void FunctionCodegen::generateShift(Inst* inst)
+{
+    auto type = inst->getType();
+    auto right = getInputReg(inst, 1);
+    ShiftOp op = ShiftOp::Shl;
+    if (inst->getInstType() == InstType::Shr)
+        op = ShiftOp::Shr;
+    else if (inst->getInstType() == InstType::AShr)
+        op = ShiftOp::Sar;
+
+    // the count goes in cl, the hardware masks it by the width of the operand
+    masm.mov(true, SCRATCH, getInputReg(inst, 0));
+    masm.push(RCX);
+    copy(DataType::i64, RCX, right);
+    masm.shiftCl(op, isWide(type), SCRATCH);
+    masm.pop(RCX);
+    storeResult(type, getDefLocation(inst), SCRATCH);
+}
+
+void FunctionCodegen::generateFloatMod(Inst* inst)
+{
+    auto type = inst->getType();
+    auto is_double = type == DataType::f64;
+    auto def = getDefLocation(inst);
+    auto dst = getResultReg(inst, def);
+    Mem left_mem{RSP, -16};
+    Mem right_mem{RSP, -8};
+
+    // fprem truncates the quotient like fmod, operands go through the red zone,
+    // the status word is read to ax
+    masm.push(RAX);
+    masm.movs(is_double, right_mem, getInputReg(inst, 1));
+    masm.movs(is_double, left_mem, getInputReg(inst, 0));
+    masm.fld(is_double, right_mem);
+    masm.fld(is_double, left_mem);
+    auto loop = masm.newLabel();
+    masm.bind(loop);
+    masm.fprem();
+    masm.fnstswAx();
+    masm.testAh(FPU_C2);
+    masm.jcc(Cond::NE, loop);
+    masm.fstp(is_double, left_mem);
+    masm.fstpSt0();
+    masm.movs(is_double, dst, left_mem);
+    masm.pop(RAX);
+    storeResult(type, def, dst);
+}
+
+void FunctionCodegen::generateUnary(Inst* inst)
+{
+    auto type = inst->getType();
+    auto wide = isWide(type);
+    auto def = getDefLocation(inst);
+    auto dst = getResultReg(inst, def);
+    auto src = getInputReg(inst, 0);
+    if (isFloat(type))
+    {
+        ASSERT(inst->getInstType() == InstType::Neg, "Not of a float");
+        masm.movFromXmm(wide, SCRATCH, src);
+        masm.btc(wide, SCRATCH, wide ? 63 : 31);
+        masm.movToXmm(wide, dst, SCRATCH);
+    }
+    else
+    {
+        copy(type, dst, src);
+        masm.unary(inst->getInstType() == InstType::Not ? UnaryOp::Not : UnaryOp::Neg, wide,
+                   dst);
+    }
+    storeResult(type, def, dst);
+}
+
+void FunctionCodegen::generateCmp(Inst* inst)
+{
+    auto type = inst->getInput(0)->getType();
+    auto left = getInputReg(inst, 0);
+    auto right = getInputReg(inst, 1);
+    // unordered floats set ZF and CF: "equal" and "below"
+    if (isFloat(type))
+        masm.ucomis(type == DataType::f64, left, right);
+    else
+        masm.alu(AluOp::Cmp, isWide(type), left, right);
+}
+
+void FunctionCodegen::generateCheck(Inst* inst)
+{
+    auto type = inst->getInput(0)->getType();
+    auto wide = isWide(type);
+    auto value = getInputReg(inst, 0);
+    if (inst->getInstType() == InstType::BoundsCheck)
+    {
+        masm.alu(AluOp::Cmp, wide, value, getInputReg(inst, 1));
+        masm.jcc(Cond::AE, getTrapLabel(ExecStatus::BoundsCheckFailed));
+    }
+    else if (isFloat(type))
+    {
+        // both zeros have no bits besides the sign
+        masm.movFromXmm(wide, SCRATCH, value);
+        masm.shiftImm(ShiftOp::Shl, wide, SCRATCH, 1);
+        masm.jcc(Cond::E, getTrapLabel(ExecStatus::ZeroCheckFailed));
+    }
+    else
+    {
+        masm.test(wide, value, value);
+        masm.jcc(Cond::E, getTrapLabel(ExecStatus::ZeroCheckFailed));
+    }
+    storeResult(type, getDefLocation(inst), value);
+}
+
+void FunctionCodegen::generateCast(Inst* inst)
+{
+    auto* cast = static_cast<CastInst*>(inst);
+    auto from = cast->getFromType();
+    auto to = cast->getToType();
+    auto def = getDefLocation(inst);
+    auto dst = getResultReg(inst, def);
+    auto src = getInputReg(inst, 0);
+
+    if (!isFloat(from) && !isFloat(to))
+    {
+        if (from == DataType::i32 && to == DataType::i64)
+            masm.movsxd(dst, src);
+        else if (from == DataType::i64 && to == DataType::i32)
+            masm.mov(false, dst, src);
+        else
+            copy(to, dst, src);
+    }
+    else if (!isFloat(from))
+        masm.cvtsi2s(to == DataType::f64, isWide(from), dst, src);
+    // out of range values and NaN give the minimal integer
+    else if (!isFloat(to))
+        masm.cvtts2si(from == DataType::f64, isWide(to), dst, src);
+    else if (from != to)
+        masm.cvts2s(from == DataType::f64, dst, src);
+    else
+        copy(to, dst, src);
+    storeResult(to, def, dst);
+}
+
+void FunctionCodegen::generateMov(Inst* inst)
+{
+    auto* mov = static_cast<MovInst*>(inst);
+    auto type = mov->getType();
+    auto* input = mov->getInput(0);
+    // moves of the resolution have no intervals, their locations are set
+    if (live_intervals.get(mov) == nullptr)
+    {
+        if (mov->isSwap())
+            swap(type, mov->getSrc(), mov->getDst());
+        else
+            move(type, mov->getSrc(), mov->getDst(), input);
+        return;
+    }
+    auto src = getInputReg(inst, 0);
+    storeResult(type, getDefLocation(inst), src);
+}
+
+void FunctionCodegen::generateCall(Inst* inst)
+{
+    auto* call = static_cast<CallInst*>(inst);
+    auto* callee = call->getFunc();
+    auto& saves = call_saves.at(inst);
+    for (auto& saved : saves)
+    {
+        if (saved.reg_class == RegClass::Float)
+            masm.movs(true, saved.mem, saved.reg);
+        else
+            masm.mov(true, saved.mem, saved.reg);
+    }
+
+    // args in registers are staged after the stack ones, all sources are read before
+    // any register of args is written
+    size_t int_args = 0;
+    size_t float_args = 0;
+    std::vector<std::pair<size_t, uint8_t>> reg_args;
+    std::vector<size_t> stack_args;
+    for (size_t i = 0, size = call->getInputsNum(); i < size; ++i)
+    {
+        auto type = call->getInput(i)->getType();
+        if (!isFloat(type) && int_args < INT_ARG_REGS.size())
+            reg_args.emplace_back(i, INT_ARG_REGS[int_args++]);
+        else if (isFloat(type) && float_args < FLOAT_ARG_REGS_NUM)
+            reg_args.emplace_back(i, static_cast<uint8_t>(float_args++));
+        else
+            stack_args.push_back(i);
+    }
+    auto get_arg_mem = [](size_t num) {
+        return Mem{RSP, static_cast<int32_t>(num * SLOT_SIZE)};
+    };
+    auto get_arg_type = [call](size_t num) { return call->getInput(num)->getType(); };
+
+    for (size_t i = 0; i < stack_args.size(); ++i)
+        storeArg(inst, stack_args[i], get_arg_mem(i));
+    for (size_t i = 0; i < reg_args.size(); ++i)
+        storeArg(inst, reg_args[i].first, get_arg_mem(stack_args.size() + i));
+    for (size_t i = 0; i < reg_args.size(); ++i)
+        load(get_arg_type(reg_args[i].first), reg_args[i].second,
+             get_arg_mem(stack_args.size() + i));
+
+    masm.call(codegen->getFunctionLabel(callee));
+    masm.cmpByte(codegen->getStatusLabel(), static_cast<uint8_t>(ExecStatus::Ok));
+    masm.jcc(Cond::NE, epilogue);
+
+    auto def = getDefLocation(inst);
+    auto ret_type = getReturnType(callee);
+    if (def.type != LocationType::None && ret_type != DataType::NoType)
+    {
+        ASSERT(isFloat(ret_type) == isFloat(inst->getType()),
+               "call result class differs from the class of its type");
+        storeResult(ret_type, def, isFloat(ret_type) ? FLOAT_RET_REG : INT_RET_REG);
+    }
+
+    for (auto& saved : saves)
+    {
+        if (saved.reg_class == RegClass::Float)
+            masm.movs(true, saved.reg, saved.mem);
+        else
+            masm.mov(true, saved.reg, saved.mem);
+    }
+}
+
+// args can stay on the stack if there are more of them than registers
+void FunctionCodegen::storeArg(Inst* call, size_t num, Mem mem)
+{
+    auto* arg = call->getInput(num);
+    auto type = arg->getType();
+    auto location = getInputLocation(call, num);
+    if (location.isRegister())
+    {
+        store(type, mem, getReg(Target::getRegClass(type), location.index));
+        return;
+    }
+    // bits of any type go through the scratch register
+    if (location.isStackSlot())
+        masm.mov(isWide(type), SCRATCH, getSlotMem(location.index));
+    else
+    {
+        ASSERT(arg->isConstInst(), "only constants are rematerialized");
+        masm.movImm(SCRATCH, static_cast<ConstInst*>(arg)->getRawValue());
+    }
+    masm.mov(isWide(type), mem, SCRATCH);
+}
+
+void FunctionCodegen::generateReturn(Inst* inst)
+{
+    auto type = inst->getInput(0)->getType();
+    copy(type, isFloat(type) ? FLOAT_RET_REG : INT_RET_REG, getInputReg(inst, 0));
+    masm.jmp(epilogue);
+}
+
+void FunctionCodegen::generateBranch(BasicBlock* bb, Inst* jump, BasicBlock* next)
+{
+    if (jump == nullptr || jump->getInstType() == InstType::Jmp)
+    {
+        auto* succ = getSucc(bb);
+        if (succ == nullptr)
+            masm.jmp(epilogue);
+        else if (succ != next)
+            masm.jmp(bb_labels.at(succ));
+        return;
+    }
+
+    // the jump goes to the false successor if the condition holds
+    auto cond = getJumpCond(jump->getInstType());
+    auto* taken = bb->getFalseSucc();
+    auto* not_taken = bb->getTrueSucc();
+    if (taken == next)
+    {
+        masm.jcc(invertCond(cond), bb_labels.at(not_taken));
+        return;
+    }
+    masm.jcc(cond, bb_labels.at(taken));
+    if (not_taken != next)
+        masm.jmp(bb_labels.at(not_taken));
+}
+
+} // namespace
+
+label_t CodeGenerator::getFunctionLabel(Graph* graph)
+{
+    auto [it, inserted] = function_labels.try_emplace(graph, INVALID_LABEL);
+    if (inserted)
+    {
+        it->second = masm.newLabel();
+        worklist.push_back(graph);
+    }
+    return it->second;
+}
+
+label_t CodeGenerator::generate(Graph* graph)
+{
+    ASSERT(graph != nullptr, "nullptr graph in CodeGenerator");
+    auto label = getFunctionLabel(graph);
+    while (!worklist.empty())
+    {
+        auto* func = worklist.back();
+        worklist.pop_back();
+        functions.push_back(func);
+        FunctionCodegen(this, masm, func).generate(function_labels.at(func));
+    }
+    return label;
+}
+
+} // namespace compiler::x86_64
\ No newline at end of file
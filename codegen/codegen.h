@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "x86_64_assembler.h"
+#include <unordered_map>
+#include <vector>
+
+namespace compiler::x86_64
+{
+
+// runtime data of the generated code shared by all its functions
+constexpr size_t RUNTIME_STATUS_OFFSET = 0;
+constexpr size_t RUNTIME_DEPTH_OFFSET = 4;
+constexpr size_t RUNTIME_DATA_SIZE = 8;
+
+/**
+ * x86-64 code generator of register allocated graphs.
+ * Values are taken from their LiveInterval locations: registers are mapped by names of
+ * the graph target to hardware registers, stack slots are addressed from rbp in the spill area
+ * of the frame, moves of SsaDestruction are lowered without changing flags, so they can stand
+ * between Cmp and the conditional jump. Blocks go in LinearOrder, split edges follow them.
+ *
+ * Functions follow System V calling convention whatever target the graph was allocated for:
+ * used callee-saved registers are saved in the prologue, registers live across a call
+ * are saved around it, so any register file of x86-64 names without rsp, rbp and the scratch
+ * registers r11 and xmm15 works. A failed check writes its ExecStatus to the status byte of
+ * the runtime data and returns, callers test the byte after every call and return too;
+ * the runtime data also counts the depth of calls, it is limited like in the Interpreter.
+ * The result class of a call is taken from the callee, it has to be the class of CallInst type.
+ */
+class CodeGenerator final
+{
+  public:
+    explicit CodeGenerator(Assembler& masm_)
+        : masm(masm_), status_label(masm.newLabel()), depth_label(masm.newLabel())
+    {}
+
+    ~CodeGenerator() = default;
+
+    /**
+     * Generate the function and all functions called from it, which are not generated yet,
+     * return the label of its entry
+     */
+    label_t generate(Graph* graph);
+
+    // label of the function entry, the function is generated with the next generate()
+    label_t getFunctionLabel(Graph* graph);
+
+    DEFINE_GETTER(status_label, StatusLabel, label_t)
+    DEFINE_GETTER(depth_label, DepthLabel, label_t)
+    // generated functions in the order of their code
+    DEFINE_ARRAY_GETTER(functions, Functions, std::vector<Graph*>&)
+
+  private:
+    Assembler& masm;
+    label_t status_label = INVALID_LABEL;
+    label_t depth_label = INVALID_LABEL;
+
+    std::vector<Graph*> functions;
+    std::vector<Graph*> worklist;
+    std::unordered_map<Graph*, label_t> function_labels;
+};
+
+} // namespace compiler::x86_64
\ No newline at end of file
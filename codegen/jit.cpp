@@ -0,0 +1,33 @@
+#include "jit.h"
+#include "codegen.h"
+
+namespace compiler
+{
+
+ExecStatus JitCode::getStatus() const
+{
+    auto* data = const_cast<CodeBuffer&>(buffer).getData();
+    return static_cast<ExecStatus>(data[x86_64::RUNTIME_STATUS_OFFSET]);
+}
+
+void JitCode::resetStatus()
+{
+    buffer.getData()[x86_64::RUNTIME_STATUS_OFFSET] = static_cast<uint8_t>(ExecStatus::Ok);
+}
+
+std::unique_ptr<JitCode> JitCompiler::compile(Graph* graph)
+{
+    x86_64::Assembler masm;
+    x86_64::CodeGenerator codegen(masm);
+    auto entry = codegen.generate(graph);
+    ASSERT(masm.getLabelOffset(entry) == 0, "function is not at the start of the code");
+
+    auto data_offset = CodeBuffer::getDataOffset(masm.size());
+    masm.bindAt(codegen.getStatusLabel(), data_offset + x86_64::RUNTIME_STATUS_OFFSET);
+    masm.bindAt(codegen.getDepthLabel(), data_offset + x86_64::RUNTIME_DEPTH_OFFSET);
+    bool resolved = masm.resolveLabels();
+    ASSERT(resolved, "code refers to unknown labels");
+    return std::make_unique<JitCode>(masm.getCode(), data_offset, x86_64::RUNTIME_DATA_SIZE);
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "code_buffer.h"
+#include "ir/graph.h"
+#include "runtime/interpreter.h"
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Machine code of a function and its callees in an executable buffer,
+ * the function is at the start of the code.
+ */
+class JitCode final
+{
+  public:
+    JitCode(const std::vector<uint8_t>& code, size_t data_offset, size_t data_size)
+        : buffer(code, data_offset, data_size)
+    {}
+
+    ~JitCode() = default;
+
+    template <typename Signature>
+    Signature* getFunction() const
+    {
+        return reinterpret_cast<Signature*>(const_cast<uint8_t*>(buffer.getCode()));
+    }
+
+    // status of the last call, not Ok if a check failed
+    ExecStatus getStatus() const;
+    void resetStatus();
+
+    /**
+     * Call the function as Ret(Args...) and return the result in the form of the Interpreter
+     */
+    template <typename Ret, typename... Args>
+    ExecResult call(Args... args)
+    {
+        resetStatus();
+        if constexpr (std::is_void_v<Ret>)
+        {
+            getFunction<Ret(Args...)>()(args...);
+            return ExecResult{getStatus()};
+        }
+        else
+        {
+            auto value = getFunction<Ret(Args...)>()(args...);
+            if (getStatus() != ExecStatus::Ok)
+                return ExecResult{getStatus()};
+            return ExecResult{ExecStatus::Ok, ConstInst::toBits(value)};
+        }
+    }
+
+    size_t getCodeSize() const noexcept
+    {
+        return buffer.getSize();
+    }
+
+  private:
+    CodeBuffer buffer;
+};
+
+/**
+ * JIT mode of the x86-64 code generator: the graph and all functions called from it
+ * are generated into one code buffer, calls between them are direct.
+ * Graphs must be register allocated.
+ */
+class JitCompiler final
+{
+  public:
+    static std::unique_ptr<JitCode> compile(Graph* graph);
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "x86_64_assembler.h"
+#include <algorithm>
+
+namespace compiler::x86_64
+{
+
+namespace
+{
+
+constexpr uint8_t REX = 0x40;
+constexpr uint8_t REX_W = 0x08;
+constexpr uint8_t REX_R = 0x04;
+constexpr uint8_t REX_B = 0x01;
+
+constexpr uint8_t MOD_DISP0 = 0x00;
+constexpr uint8_t MOD_DISP8 = 0x40;
+constexpr uint8_t MOD_DISP32 = 0x80;
+constexpr uint8_t MOD_REG = 0xc0;
+// rm of the SIB byte, of RIP-relative addressing without SIB
+constexpr uint8_t RM_SIB = 0x04;
+constexpr uint8_t RM_RIP = 0x05;
+
+constexpr uint8_t PREFIX_66 = 0x66;
+constexpr uint8_t PREFIX_F2 = 0xf2;
+constexpr uint8_t PREFIX_F3 = 0xf3;
+
+constexpr bool isInt8(int64_t value)
+{
+    return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+constexpr bool isInt32(int64_t value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+} // namespace
+
+bool Assembler::resolveLabels()
+{
+    std::erase_if(label_refs, [this](const LabelRef& ref) {
+        if (!isBound(ref.label))
+            return false;
+        auto value = static_cast<int64_t>(labels[ref.label]) + ref.addend -
+                     static_cast<int64_t>(ref.offset);
+        ASSERT(isInt32(value), "label is too far");
+        auto bits = static_cast<uint32_t>(value);
+        for (size_t i = 0; i < 4; ++i)
+            code[ref.offset + i] = static_cast<uint8_t>(bits >> (i * 8));
+        return true;
+    });
+    return label_refs.empty();
+}
+
+void Assembler::emit32(uint32_t value)
+{
+    for (size_t i = 0; i < 4; ++i)
+        emit8(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void Assembler::emitRex(bool w, uint8_t reg, uint8_t rm, bool force)
+{
+    uint8_t rex = (w ? REX_W : 0) | ((reg & 8) ? REX_R : 0) | ((rm & 8) ? REX_B : 0);
+    if (rex != 0 || force)
+        emit8(REX | rex);
+}
+
+void Assembler::emitModRR(uint8_t reg, uint8_t rm)
+{
+    emit8(MOD_REG | ((reg & 7) << 3) | (rm & 7));
+}
+
+void Assembler::emitModMem(uint8_t reg, Mem mem)
+{
+    auto base = mem.base & 7;
+    // [rbp] and [r13] have no encoding without a displacement
+    uint8_t mod = MOD_DISP32;
+    if (mem.disp == 0 && base != RBP)
+        mod = MOD_DISP0;
+    else if (isInt8(mem.disp))
+        mod = MOD_DISP8;
+
+    emit8(mod | ((reg & 7) << 3) | (base == RM_SIB ? RM_SIB : base));
+    // rsp and r12 as a base need SIB without an index
+    if (base == RM_SIB)
+        emit8(0x24);
+    if (mod == MOD_DISP8)
+        emit8(static_cast<uint8_t>(mem.disp));
+    else if (mod == MOD_DISP32)
+        emit32(static_cast<uint32_t>(mem.disp));
+}
+
+void Assembler::emitModRip(uint8_t reg, label_t label, size_t imm_size)
+{
+    emit8(MOD_DISP0 | ((reg & 7) << 3) | RM_RIP);
+    // RIP points to the end of the instruction
+    label_refs.push_back({code.size(), label, -4 - static_cast<int64_t>(imm_size)});
+    emit32(0);
+}
+
+void Assembler::emitRel32(label_t label)
+{
+    label_refs.push_back({code.size(), label, -4});
+    emit32(0);
+}
+
+void Assembler::emitSse(uint8_t prefix, bool w, uint8_t op, uint8_t reg, uint8_t rm)
+{
+    if (prefix != 0)
+        emit8(prefix);
+    emitRex(w, reg, rm);
+    emit8(0x0f);
+    emit8(op);
+    emitModRR(reg, rm);
+}
+
+void Assembler::emitSseMem(uint8_t prefix, uint8_t op, uint8_t reg, Mem mem)
+{
+    if (prefix != 0)
+        emit8(prefix);
+    emitRex(false, reg, mem.base);
+    emit8(0x0f);
+    emit8(op);
+    emitModMem(reg, mem);
+}
+
+void Assembler::mov(bool w, uint8_t dst, uint8_t src)
+{
+    emitRex(w, src, dst);
+    emit8(0x89);
+    emitModRR(src, dst);
+}
+
+void Assembler::mov(bool w, uint8_t dst, Mem src)
+{
+    emitRex(w, dst, src.base);
+    emit8(0x8b);
+    emitModMem(dst, src);
+}
+
+void Assembler::mov(bool w, Mem dst, uint8_t src)
+{
+    emitRex(w, src, dst.base);
+    emit8(0x89);
+    emitModMem(src, dst);
+}
+
+void Assembler::movImm(uint8_t dst, uint64_t imm)
+{
+    if (imm <= UINT32_MAX)
+    {
+        // 32-bit results are zero extended
+        emitRex(false, 0, dst);
+        emit8(0xb8 + (dst & 7));
+        emit32(static_cast<uint32_t>(imm));
+    }
+    else if (isInt32(static_cast<int64_t>(imm)))
+    {
+        emitRex(true, 0, dst);
+        emit8(0xc7);
+        emitModRR(0, dst);
+        emit32(static_cast<uint32_t>(imm));
+    }
+    else
+    {
+        emitRex(true, 0, dst);
+        emit8(0xb8 + (dst & 7));
+        emit32(static_cast<uint32_t>(imm));
+        emit32(static_cast<uint32_t>(imm >> 32));
+    }
+}
+
+void Assembler::movImm(bool w, Mem dst, int32_t imm)
+{
+    emitRex(w, 0, dst.base);
+    emit8(0xc7);
+    emitModMem(0, dst);
+    emit32(static_cast<uint32_t>(imm));
+}
+
+void Assembler::alu(AluOp op, bool w, uint8_t dst, uint8_t src)
+{
+    emitRex(w, src, dst);
+    emit8(static_cast<uint8_t>(op));
+    emitModRR(src, dst);
+}
+
+void Assembler::aluImm(AluOp op, bool w, uint8_t dst, int32_t imm)
+{
+    auto ext = static_cast<uint8_t>(op) >> 3;
+    emitRex(w, 0, dst);
+    if (isInt8(imm))
+    {
+        emit8(0x83);
+        emitModRR(ext, dst);
+        emit8(static_cast<uint8_t>(imm));
+    }
+    else
+    {
+        emit8(0x81);
+        emitModRR(ext, dst);
+        emit32(static_cast<uint32_t>(imm));
+    }
+}
+
+void Assembler::aluImm(AluOp op, label_t data, int32_t imm)
+{
+    auto ext = static_cast<uint8_t>(op) >> 3;
+    if (isInt8(imm))
+    {
+        emit8(0x83);
+        emitModRip(ext, data, 1);
+        emit8(static_cast<uint8_t>(imm));
+    }
+    else
+    {
+        emit8(0x81);
+        emitModRip(ext, data, 4);
+        emit32(static_cast<uint32_t>(imm));
+    }
+}
+
+void Assembler::test(bool w, uint8_t left, uint8_t right)
+{
+    emitRex(w, right, left);
+    emit8(0x85);
+    emitModRR(right, left);
+}
+
+void Assembler::imul(bool w, uint8_t dst, uint8_t src)
+{
+    emitRex(w, dst, src);
+    emit8(0x0f);
+    emit8(0xaf);
+    emitModRR(dst, src);
+}
+
+void Assembler::unary(UnaryOp op, bool w, uint8_t reg)
+{
+    emitRex(w, 0, reg);
+    emit8(0xf7);
+    emitModRR(static_cast<uint8_t>(op), reg);
+}
+
+void Assembler::shiftCl(ShiftOp op, bool w, uint8_t reg)
+{
+    emitRex(w, 0, reg);
+    emit8(0xd3);
+    emitModRR(static_cast<uint8_t>(op), reg);
+}
+
+void Assembler::shiftImm(ShiftOp op, bool w, uint8_t reg, uint8_t imm)
+{
+    emitRex(w, 0, reg);
+    emit8(0xc1);
+    emitModRR(static_cast<uint8_t>(op), reg);
+    emit8(imm);
+}
+
+void Assembler::btc(bool w, uint8_t reg, uint8_t bit)
+{
+    emitRex(w, 0, reg);
+    emit8(0x0f);
+    emit8(0xba);
+    emitModRR(7, reg);
+    emit8(bit);
+}
+
+void Assembler::movsxd(uint8_t dst, uint8_t src)
+{
+    emitRex(true, dst, src);
+    emit8(0x63);
+    emitModRR(dst, src);
+}
+
+void Assembler::xchg(bool w, uint8_t left, uint8_t right)
+{
+    emitRex(w, right, left);
+    emit8(0x87);
+    emitModRR(right, left);
+}
+
+void Assembler::push(uint8_t reg)
+{
+    emitRex(false, 0, reg);
+    emit8(0x50 + (reg & 7));
+}
+
+void Assembler::pop(uint8_t reg)
+{
+    emitRex(false, 0, reg);
+    emit8(0x58 + (reg & 7));
+}
+
+void Assembler::movByte(label_t data, uint8_t imm)
+{
+    emit8(0xc6);
+    emitModRip(0, data, 1);
+    emit8(imm);
+}
+
+void Assembler::cmpByte(label_t data, uint8_t imm)
+{
+    emit8(0x80);
+    emitModRip(7, data, 1);
+    emit8(imm);
+}
+
+void Assembler::sse(SseOp op, bool is_double, uint8_t dst, uint8_t src)
+{
+    emitSse(is_double ? PREFIX_F2 : PREFIX_F3, false, static_cast<uint8_t>(op), dst, src);
+}
+
+void Assembler::movs(bool is_double, uint8_t dst, Mem src)
+{
+    emitSseMem(is_double ? PREFIX_F2 : PREFIX_F3, 0x10, dst, src);
+}
+
+void Assembler::movs(bool is_double, Mem dst, uint8_t src)
+{
+    emitSseMem(is_double ? PREFIX_F2 : PREFIX_F3, 0x11, src, dst);
+}
+
+void Assembler::movaps(uint8_t dst, uint8_t src)
+{
+    emitSse(0, false, 0x28, dst, src);
+}
+
+void Assembler::xorps(uint8_t dst, uint8_t src)
+{
+    emitSse(0, false, 0x57, dst, src);
+}
+
+void Assembler::ucomis(bool is_double, uint8_t left, uint8_t right)
+{
+    emitSse(is_double ? PREFIX_66 : 0, false, 0x2e, left, right);
+}
+
+void Assembler::cvtsi2s(bool is_double, bool w, uint8_t dst, uint8_t src)
+{
+    emitSse(is_double ? PREFIX_F2 : PREFIX_F3, w, 0x2a, dst, src);
+}
+
+void Assembler::cvtts2si(bool is_double, bool w, uint8_t dst, uint8_t src)
+{
+    emitSse(is_double ? PREFIX_F2 : PREFIX_F3, w, 0x2c, dst, src);
+}
+
+void Assembler::cvts2s(bool from_double, uint8_t dst, uint8_t src)
+{
+    emitSse(from_double ? PREFIX_F2 : PREFIX_F3, false, 0x5a, dst, src);
+}
+
+void Assembler::movToXmm(bool w, uint8_t dst, uint8_t src)
+{
+    emitSse(PREFIX_66, w, 0x6e, dst, src);
+}
+
+void Assembler::movFromXmm(bool w, uint8_t dst, uint8_t src)
+{
+    emitSse(PREFIX_66, w, 0x7e, src, dst);
+}
+
+void Assembler::fld(bool is_double, Mem src)
+{
+    emitRex(false, 0, src.base);
+    emit8(is_double ? 0xdd : 0xd9);
+    emitModMem(0, src);
+}
+
+void Assembler::fstp(bool is_double, Mem dst)
+{
+    emitRex(false, 0, dst.base);
+    emit8(is_double ? 0xdd : 0xd9);
+    emitModMem(3, dst);
+}
+
+void Assembler::fstpSt0()
+{
+    emit8(0xdd);
+    emit8(0xd8);
+}
+
+void Assembler::fprem()
+{
+    emit8(0xd9);
+    emit8(0xf8);
+}
+
+void Assembler::fnstswAx()
+{
+    emit8(0xdf);
+    emit8(0xe0);
+}
+
+void Assembler::testAh(uint8_t imm)
+{
+    emit8(0xf6);
+    emit8(0xc4);
+    emit8(imm);
+}
+
+void Assembler::jmp(label_t label)
+{
+    emit8(0xe9);
+    emitRel32(label);
+}
+
+void Assembler::jcc(Cond cond, label_t label)
+{
+    emit8(0x0f);
+    emit8(0x80 + static_cast<uint8_t>(cond));
+    emitRel32(label);
+}
+
+void Assembler::call(label_t label)
+{
+    emit8(0xe8);
+    emitRel32(label);
+}
+
+void Assembler::ret()
+{
+    emit8(0xc3);
+}
+
+void Assembler::leave()
+{
+    emit8(0xc9);
+}
+
+} // namespace compiler::x86_64
\ No newline at end of file
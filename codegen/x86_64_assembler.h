@@ -0,0 +1,231 @@
+#pragma once
+
+#include "ir/utils.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace compiler::x86_64
+{
+
+using label_t = size_t;
+constexpr label_t INVALID_LABEL = std::numeric_limits<label_t>::max();
+
+// hardware numbers of general purpose registers, xmm registers are numbered 0-15 as is
+enum Reg : uint8_t
+{
+    RAX = 0,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15
+};
+
+// condition codes of jcc
+enum class Cond : uint8_t
+{
+    B = 0x2,
+    AE = 0x3,
+    E = 0x4,
+    NE = 0x5,
+    BE = 0x6,
+    A = 0x7,
+    P = 0xa,
+    NP = 0xb
+};
+
+constexpr Cond invertCond(Cond cond)
+{
+    return static_cast<Cond>(static_cast<uint8_t>(cond) ^ 1);
+}
+
+// "op r/m, r" opcodes, the opcode extension of the immediate form is opcode >> 3
+enum class AluOp : uint8_t
+{
+    Add = 0x01,
+    Or = 0x09,
+    And = 0x21,
+    Sub = 0x29,
+    Xor = 0x31,
+    Cmp = 0x39
+};
+
+// opcode extensions of F7 and D3 groups
+enum class UnaryOp : uint8_t
+{
+    Not = 2,
+    Neg = 3,
+    Div = 6
+};
+
+enum class ShiftOp : uint8_t
+{
+    Shl = 4,
+    Shr = 5,
+    Sar = 7
+};
+
+enum class SseOp : uint8_t
+{
+    Add = 0x58,
+    Mul = 0x59,
+    Sub = 0x5c,
+    Div = 0x5e
+};
+
+// [base + disp]
+struct Mem
+{
+    uint8_t base = RBP;
+    int32_t disp = 0;
+};
+
+/**
+ * Reference to a label from the code: 32-bit value S + A - P, where S is the label offset
+ * and P is the offset of the value (the same as ELF R_X86_64_PC32 relocation)
+ */
+struct LabelRef
+{
+    size_t offset = 0;
+    label_t label = INVALID_LABEL;
+    int64_t addend = 0;
+};
+
+/**
+ * Encoder of x86-64 instructions used by the code generator. Width of integer operations
+ * is 64 bits if w is set and 32 bits otherwise (32-bit results are zero extended),
+ * floating point ones take a double flag. Jumps, calls and RIP-relative operands refer to
+ * labels: labels bound in this code are resolved by resolveLabels(), other labels
+ * (functions and data outside) stay in the references list for the linker.
+ */
+class Assembler final
+{
+  public:
+    Assembler() = default;
+    ~Assembler() = default;
+
+    DEFINE_ARRAY_GETTER(code, Code, std::vector<uint8_t>&)
+    DEFINE_ARRAY_GETTER(label_refs, LabelRefs, std::vector<LabelRef>&)
+
+    size_t size() const noexcept
+    {
+        return code.size();
+    }
+
+    label_t newLabel()
+    {
+        labels.push_back(INVALID_LABEL);
+        return labels.size() - 1;
+    }
+
+    void bind(label_t label)
+    {
+        bindAt(label, code.size());
+    }
+
+    void bindAt(label_t label, size_t offset)
+    {
+        ASSERT(labels[label] == INVALID_LABEL, "label is bound twice");
+        labels[label] = offset;
+    }
+
+    bool isBound(label_t label) const
+    {
+        return labels[label] != INVALID_LABEL;
+    }
+
+    size_t getLabelOffset(label_t label) const
+    {
+        ASSERT(isBound(label), "label is not bound");
+        return labels[label];
+    }
+
+    // patch references to bound labels, return true if there are no other references
+    bool resolveLabels();
+
+    // integer
+    void mov(bool w, uint8_t dst, uint8_t src);
+    void mov(bool w, uint8_t dst, Mem src);
+    void mov(bool w, Mem dst, uint8_t src);
+    // mov r32, imm32 or mov r64, imm64 by the value, flags are not changed
+    void movImm(uint8_t dst, uint64_t imm);
+    void movImm(bool w, Mem dst, int32_t imm);
+    void alu(AluOp op, bool w, uint8_t dst, uint8_t src);
+    void aluImm(AluOp op, bool w, uint8_t dst, int32_t imm);
+    // op dword [data], imm
+    void aluImm(AluOp op, label_t data, int32_t imm);
+    void test(bool w, uint8_t left, uint8_t right);
+    void imul(bool w, uint8_t dst, uint8_t src);
+    void unary(UnaryOp op, bool w, uint8_t reg);
+    void shiftCl(ShiftOp op, bool w, uint8_t reg);
+    void shiftImm(ShiftOp op, bool w, uint8_t reg, uint8_t imm);
+    void btc(bool w, uint8_t reg, uint8_t bit);
+    void movsxd(uint8_t dst, uint8_t src);
+    void xchg(bool w, uint8_t left, uint8_t right);
+    void push(uint8_t reg);
+    void pop(uint8_t reg);
+    void movByte(label_t data, uint8_t imm);
+    void cmpByte(label_t data, uint8_t imm);
+
+    // sse
+    void sse(SseOp op, bool is_double, uint8_t dst, uint8_t src);
+    void movs(bool is_double, uint8_t dst, Mem src);
+    void movs(bool is_double, Mem dst, uint8_t src);
+    void movaps(uint8_t dst, uint8_t src);
+    void xorps(uint8_t dst, uint8_t src);
+    void ucomis(bool is_double, uint8_t left, uint8_t right);
+    void cvtsi2s(bool is_double, bool w, uint8_t dst, uint8_t src);
+    void cvtts2si(bool is_double, bool w, uint8_t dst, uint8_t src);
+    void cvts2s(bool from_double, uint8_t dst, uint8_t src);
+    void movToXmm(bool w, uint8_t dst, uint8_t src);
+    void movFromXmm(bool w, uint8_t dst, uint8_t src);
+
+    // x87, only for the floating point remainder
+    void fld(bool is_double, Mem src);
+    void fstp(bool is_double, Mem dst);
+    void fstpSt0();
+    void fprem();
+    void fnstswAx();
+    void testAh(uint8_t imm);
+
+    // control flow
+    void jmp(label_t label);
+    void jcc(Cond cond, label_t label);
+    void call(label_t label);
+    void ret();
+    void leave();
+
+  private:
+    void emit8(uint8_t byte)
+    {
+        code.push_back(byte);
+    }
+
+    void emit32(uint32_t value);
+    void emitRex(bool w, uint8_t reg, uint8_t rm, bool force = false);
+    void emitModRR(uint8_t reg, uint8_t rm);
+    void emitModMem(uint8_t reg, Mem mem);
+    // RIP-relative [label], imm_size bytes of an immediate go after the displacement
+    void emitModRip(uint8_t reg, label_t label, size_t imm_size);
+    void emitRel32(label_t label);
+    void emitSse(uint8_t prefix, bool w, uint8_t op, uint8_t reg, uint8_t rm);
+    void emitSseMem(uint8_t prefix, uint8_t op, uint8_t reg, Mem mem);
+
+  private:
+    std::vector<uint8_t> code;
+    std::vector<size_t> labels;
+    std::vector<LabelRef> label_refs;
+};
+
+} // namespace compiler::x86_64
\ No newline at end of file
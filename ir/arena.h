@@ -0,0 +1,186 @@
+#pragma once
+
+#include "utils.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace compiler
+{
+
+constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+constexpr size_t ARENA_DEFAULT_ALIGN = alignof(std::max_align_t);
+
+/**
+ * Bump-pointer allocator for IR nodes and pass-side data.
+ * Memory is taken from big chunks and is never freed one object at a time:
+ * reset() rewinds the arena (keeping its chunks for the next compilation),
+ * the destructor gives chunks back to the system.
+ * Objects with non-trivial destructors are registered in an intrusive list
+ * (placed in the arena too), so reset() can finalize them in reverse order.
+ */
+class ArenaAllocator final
+{
+  public:
+    explicit ArenaAllocator(size_t chunk_size_ = ARENA_CHUNK_SIZE) : chunk_size(chunk_size_)
+    {}
+
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    ~ArenaAllocator()
+    {
+        runDestructors();
+        while (first_chunk != nullptr)
+        {
+            auto* next = first_chunk->next;
+            std::free(first_chunk);
+            first_chunk = next;
+        }
+    }
+
+    void* allocate(size_t size, size_t align = ARENA_DEFAULT_ALIGN)
+    {
+        ASSERT(align != 0 && (align & (align - 1)) == 0, "alignment must be a power of two");
+        auto aligned = alignUp(cur, align);
+        if (cur_chunk == nullptr || aligned + size > end)
+        {
+            nextChunk(size + align);
+            aligned = alignUp(cur, align);
+        }
+        cur = aligned + size;
+        allocated_size += size;
+        ++allocs_num;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        auto* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            auto* node = new (allocate(sizeof(DtorNode), alignof(DtorNode)))
+                DtorNode{[](void* ptr) { static_cast<T*>(ptr)->~T(); }, obj, dtors};
+            dtors = node;
+        }
+        return obj;
+    }
+
+    /**
+     * Finalize all objects and rewind to the first chunk.
+     * Chunks stay allocated, so the arena can be reused by the next graph.
+     */
+    void reset()
+    {
+        runDestructors();
+        cur_chunk = first_chunk;
+        if (cur_chunk != nullptr)
+        {
+            cur = cur_chunk->begin();
+            end = cur_chunk->end();
+        }
+        else
+            cur = end = 0;
+        allocated_size = 0;
+        allocs_num = 0;
+    }
+
+    size_t getAllocatedSize() const noexcept
+    {
+        return allocated_size;
+    }
+
+    size_t getAllocsNum() const noexcept
+    {
+        return allocs_num;
+    }
+
+    size_t getChunksNum() const noexcept
+    {
+        size_t num = 0;
+        for (auto* chunk = first_chunk; chunk != nullptr; chunk = chunk->next)
+            ++num;
+        return num;
+    }
+
+  private:
+    struct Chunk
+    {
+        Chunk* next;
+        size_t size;
+
+        uintptr_t begin() noexcept
+        {
+            return reinterpret_cast<uintptr_t>(this) + sizeof(Chunk);
+        }
+
+        uintptr_t end() noexcept
+        {
+            return begin() + size;
+        }
+    };
+
+    struct DtorNode
+    {
+        void (*dtor)(void*);
+        void* obj;
+        DtorNode* next;
+    };
+
+    static uintptr_t alignUp(uintptr_t ptr, size_t align) noexcept
+    {
+        return (ptr + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+    }
+
+    void nextChunk(size_t min_size)
+    {
+        // after reset() reuse already allocated chunks if they are big enough
+        auto* next = cur_chunk != nullptr ? cur_chunk->next : first_chunk;
+        if (next == nullptr || next->size < min_size)
+        {
+            size_t size = std::max(chunk_size, min_size);
+            auto* chunk = static_cast<Chunk*>(std::malloc(sizeof(Chunk) + size));
+            if (chunk == nullptr)
+                throw std::bad_alloc{};
+            chunk->size = size;
+            chunk->next = next;
+            if (cur_chunk != nullptr)
+                cur_chunk->next = chunk;
+            else
+                first_chunk = chunk;
+            next = chunk;
+        }
+        cur_chunk = next;
+        cur = cur_chunk->begin();
+        end = cur_chunk->end();
+    }
+
+    void runDestructors()
+    {
+        while (dtors != nullptr)
+        {
+            auto* node = dtors;
+            dtors = node->next;
+            node->dtor(node->obj);
+        }
+    }
+
+  private:
+    size_t chunk_size = ARENA_CHUNK_SIZE;
+    size_t allocated_size = 0;
+    size_t allocs_num = 0;
+
+    Chunk* first_chunk = nullptr;
+    Chunk* cur_chunk = nullptr;
+    uintptr_t cur = 0;
+    uintptr_t end = 0;
+
+    DtorNode* dtors = nullptr;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -1,39 +1,18 @@
 #include "basicblock.h"
 #include "graph.h"
+#include "pass/domtree.h"
 #include "pass/liveness.h"
 #include "pass/loop_analysis.h"
 
 namespace compiler
 {
 
-BasicBlock::~BasicBlock()
-{
-    Inst* inst = first_inst;
-    Inst* phi = first_phi;
-    while (inst != nullptr)
-    {
-        first_inst = inst->getNext();
-        delete inst;
-        inst = first_inst;
-    }
-    while (phi != nullptr)
-    {
-        first_phi = static_cast<PhiInst*>(phi->getNext());
-        delete phi;
-        phi = first_phi;
-    }
-    if (live_int != nullptr)
-        delete live_int;
-    delete markers;
-}
-
 void BasicBlock::pushBackInst(Inst* inst)
 {
     ASSERT(inst->getInstType() != InstType::Phi);
     ASSERT(!inst->getPrev(), "inserted inst has predecessor");
 
-    if (inst->isConstInst())
-        graph->pushBackConstInst(static_cast<ConstInst*>(inst));
+    updateInstOrder(last_inst != nullptr ? last_inst : last_phi, inst, nullptr);
 
     if (first_inst == nullptr)
         first_inst = inst;
@@ -41,6 +20,9 @@ void BasicBlock::pushBackInst(Inst* inst)
     inst->setPrev(last_inst);
     inst->setNext(nullptr);
     inst->setBB(this);
+    if (inst->isConstInst())
+        graph->pushBackConstInst(static_cast<ConstInst*>(inst));
+    graph->assignDenseId(inst);
 
     auto inst_id = inst->getId();
     if (graph->getCurInstId() < inst_id)
@@ -57,12 +39,14 @@ void BasicBlock::pushBackPhiInst(PhiInst* inst)
     ASSERT(inst->getInstType() == InstType::Phi);
     ASSERT(!inst->getPrev(), "inserted inst has predecessor");
 
+    updateInstOrder(last_phi, inst, first_inst);
     if (first_phi == nullptr)
         first_phi = inst;
 
     inst->setPrev(last_phi);
     inst->setNext(nullptr);
     inst->setBB(this);
+    graph->assignDenseId(inst);
 
     auto inst_id = static_cast<Inst*>(inst)->getId();
     if (graph->getCurInstId() < inst_id)
@@ -79,12 +63,17 @@ void BasicBlock::pushFrontInst(Inst* inst)
     ASSERT(inst->getInstType() != InstType::Phi);
     ASSERT(!inst->getNext(), "inserted inst has successor");
 
+    updateInstOrder(last_phi, inst, first_inst);
+
     if (!last_inst)
         last_inst = inst;
 
     inst->setPrev(nullptr);
     inst->setNext(first_inst);
     inst->setBB(this);
+    if (inst->isConstInst())
+        graph->pushBackConstInst(static_cast<ConstInst*>(inst));
+    graph->assignDenseId(inst);
 
     auto inst_id = inst->getId();
     if (graph->getCurInstId() < inst_id)
@@ -101,12 +90,14 @@ void BasicBlock::pushFrontPhiInst(PhiInst* inst)
     ASSERT(inst->getInstType() == InstType::Phi);
     ASSERT(!inst->getNext(), "inserted inst has successor");
 
+    updateInstOrder(nullptr, inst, first_phi != nullptr ? first_phi : first_inst);
     if (!last_phi)
         last_phi = inst;
 
     inst->setPrev(nullptr);
     inst->setNext(first_phi);
     inst->setBB(this);
+    graph->assignDenseId(inst);
 
     auto inst_id = static_cast<Inst*>(inst)->getId();
     if (graph->getCurInstId() < inst_id)
@@ -133,12 +124,16 @@ void BasicBlock::insertAfter(Inst* prev_inst, Inst* inst)
     }
 
     auto next_inst = prev_inst->getNext();
+    updateInstOrder(prev_inst, inst, next_inst);
     next_inst->setPrev(inst);
     prev_inst->setNext(inst);
 
     inst->setNext(next_inst);
     inst->setPrev(prev_inst);
     inst->setBB(this);
+    if (inst->isConstInst())
+        graph->pushBackConstInst(static_cast<ConstInst*>(inst));
+    graph->assignDenseId(inst);
 
     auto inst_id = inst->getId();
     if (graph->getCurInstId() < inst_id)
@@ -146,54 +141,157 @@ void BasicBlock::insertAfter(Inst* prev_inst, Inst* inst)
     ++bb_size;
 }
 
+void BasicBlock::updateInstOrder(Inst* prev, Inst* inst, Inst* next)
+{
+    if (!insts_order_valid)
+        return;
+
+    size_t prev_num = prev != nullptr ? prev->getOrderNum() : 0;
+    if (next == nullptr)
+    {
+        inst->setOrderNum(prev_num + INST_ORDER_STEP);
+        return;
+    }
+
+    size_t next_num = next->getOrderNum();
+    if (next_num - prev_num > 1)
+        inst->setOrderNum(prev_num + (next_num - prev_num) / 2);
+    else
+        insts_order_valid = false;
+}
+
+void BasicBlock::renumberInsts()
+{
+    size_t num = 0;
+    for (auto* phi = getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        phi->setOrderNum(num += INST_ORDER_STEP);
+    for (auto* inst = first_inst; inst != nullptr; inst = inst->getNext())
+        inst->setOrderNum(num += INST_ORDER_STEP);
+    insts_order_valid = true;
+}
+
+void BasicBlock::insertBefore(Inst* next_inst, Inst* inst)
+{
+    if (next_inst == nullptr)
+        pushBackInst(inst);
+    else if (next_inst->getPrev() == nullptr)
+        pushFrontInst(inst);
+    else
+        insertAfter(next_inst->getPrev(), inst);
+}
+
+// removed instructions are unlinked from their inputs users lists
+// and stay in the graph arena until the graph dies
 void BasicBlock::popFrontInst()
 {
     ASSERT(first_inst, "first inst not existed");
-    auto deleted_inst = first_inst;
+    first_inst->dropInputs();
+    if (first_inst->isConstInst())
+        graph->removeConstInst(static_cast<ConstInst*>(first_inst));
     auto second_inst = first_inst->getNext();
-    second_inst->setPrev(nullptr);
+    if (second_inst)
+        second_inst->setPrev(nullptr);
+    else
+        last_inst = nullptr;
     first_inst->setNext(nullptr);
     first_inst = second_inst;
     --bb_size;
-    delete deleted_inst;
 }
 
 void BasicBlock::popBackInst()
 {
     ASSERT(last_inst, "last inst not existed");
-    auto deleted_inst = first_inst;
+    last_inst->dropInputs();
+    if (last_inst->isConstInst())
+        graph->removeConstInst(static_cast<ConstInst*>(last_inst));
     auto prev_inst = last_inst->getPrev();
-    prev_inst->setNext(nullptr);
+    if (prev_inst)
+        prev_inst->setNext(nullptr);
+    else
+        first_inst = nullptr;
     last_inst->setPrev(nullptr);
     last_inst = prev_inst;
     --bb_size;
-    delete deleted_inst;
 }
 
 void BasicBlock::removeInst(Inst* inst)
 {
+    inst->dropInputs();
+    if (inst->isConstInst())
+        graph->removeConstInst(static_cast<ConstInst*>(inst));
     auto next_inst = inst->getNext();
     auto prev_inst = inst->getPrev();
-    if (inst == first_inst)
-        first_inst = next_inst;
-    if (inst == last_inst)
-        last_inst = prev_inst;
+    if (inst->getInstType() == InstType::Phi)
+    {
+        if (inst == first_phi)
+            first_phi = static_cast<PhiInst*>(next_inst);
+        if (inst == last_phi)
+            last_phi = static_cast<PhiInst*>(prev_inst);
+    }
+    else
+    {
+        if (inst == first_inst)
+            first_inst = next_inst;
+        if (inst == last_inst)
+            last_inst = prev_inst;
+    }
     if (next_inst)
         next_inst->setPrev(prev_inst);
     if (prev_inst)
         prev_inst->setNext(next_inst);
     --bb_size;
-    delete inst;
+}
+
+std::vector<BasicBlock*>& BasicBlock::getDominators()
+{
+    if (dominators.empty() && idom != nullptr)
+    {
+        dominators.push_back(this);
+        for (auto* bb = this; bb->getIdom() != bb; bb = bb->getIdom())
+            dominators.push_back(bb->getIdom());
+        std::reverse(dominators.begin(), dominators.end());
+    }
+    return dominators;
+}
+
+bool BasicBlock::dominates(BasicBlock* bb) const
+{
+    if (graph != nullptr)
+        graph->getAnalysis<DomTree>();
+
+    if (idom == nullptr || bb->getIdom() == nullptr)
+        return false;
+    return dom_pre <= bb->getDomPre() && bb->getDomPost() <= dom_post;
+}
+
+void BasicBlock::markCfgChanged()
+{
+    if (graph != nullptr)
+        graph->markCfgChanged();
+}
+
+void BasicBlock::setTrueSucc(BasicBlock* bb)
+{
+    true_succ = bb;
+    markCfgChanged();
+}
+
+void BasicBlock::setFalseSucc(BasicBlock* bb)
+{
+    false_succ = bb;
+    markCfgChanged();
 }
 
 void BasicBlock::addPred(BasicBlock* bb)
 {
+    markCfgChanged();
     ASSERT(std::find(preds.begin(), preds.end(), bb) == preds.end(), "pred already existed");
     preds.push_back(bb);
 }
 
 void BasicBlock::addSucc(BasicBlock* bb)
 {
+    markCfgChanged();
     if (true_succ == nullptr)
         true_succ = bb;
     else if (false_succ == nullptr)
@@ -207,17 +305,20 @@ void BasicBlock::addSucc(BasicBlock* bb)
 
 void BasicBlock::removePred(BasicBlock* bb)
 {
+    markCfgChanged();
     preds.erase(std::find(preds.begin(), preds.end(), bb));
 }
 
 void BasicBlock::removePred(size_t num)
 {
+    markCfgChanged();
     preds.erase(std::find_if(preds.begin(), preds.end(),
                              [num](auto pred) { return pred->getId() == num; }));
 }
 
 void BasicBlock::removeSucc(BasicBlock* bb)
 {
+    markCfgChanged();
     if (true_succ == bb)
         true_succ = nullptr;
     else if (false_succ == bb)
@@ -228,6 +329,7 @@ void BasicBlock::removeSucc(BasicBlock* bb)
 
 void BasicBlock::removeSucc(size_t num)
 {
+    markCfgChanged();
     if (true_succ->getId() == num)
         true_succ = nullptr;
     else if (false_succ->getId() == num)
@@ -238,21 +340,24 @@ void BasicBlock::removeSucc(size_t num)
 
 void BasicBlock::replacePred(BasicBlock* pred, BasicBlock* bb)
 {
+    markCfgChanged();
     auto it = std::find(preds.begin(), preds.end(), pred);
     ASSERT(it != preds.end(), "replace not existing pred");
-    preds[(*it)->getId()] = bb;
+    *it = bb;
 }
 
 void BasicBlock::replacePred(size_t num, BasicBlock* bb)
 {
+    markCfgChanged();
     auto it =
         std::find_if(preds.begin(), preds.end(), [num](auto pred) { return pred->getId() == num; });
     ASSERT(it != preds.end(), "replace not existing pred");
-    preds[num] = bb;
+    *it = bb;
 }
 
 void BasicBlock::replaceSucc(BasicBlock* succ, BasicBlock* bb)
 {
+    markCfgChanged();
     if (true_succ == succ)
         true_succ = bb;
     else if (false_succ == succ)
@@ -266,6 +371,7 @@ void BasicBlock::replaceSucc(BasicBlock* succ, BasicBlock* bb)
 
 void BasicBlock::replaceSucc(size_t num, BasicBlock* bb)
 {
+    markCfgChanged();
     if (true_succ->getId() == num)
         true_succ = bb;
     else if (false_succ->getId() == num)
@@ -281,46 +387,65 @@ BasicBlock* BasicBlock::splitBlockAfterInst(Inst* inst, bool make_true_succ)
 {
     ASSERT(inst != nullptr);
     ASSERT(inst->getBB() == this);
+    ASSERT(inst->getInstType() != InstType::Phi, "cannot split block after phi");
 
-    auto id = graph->size() + 1;
-    auto* new_bb = new BasicBlock{id, graph};
-    graph->insertBBAfter(this, new_bb);
-
-    for (Inst* cur_inst = inst->getNext(); cur_inst != nullptr; cur_inst = cur_inst->getNext())
-        new_bb->pushBackInst(cur_inst);
+    auto* new_bb = graph->createBB(graph->size());
+    graph->addBB(new_bb);
 
+    // insts after the split point and successors go to the new block,
+    // pooled constants stay in the first block to dominate all their uses
+    bool keep_consts = this == graph->getFirstBB();
+    auto* cur_inst = inst->getNext();
     inst->setNext(nullptr);
     last_inst = inst;
-    if (inst->getInstType() == InstType::Phi)
-        first_inst = nullptr;
+    while (cur_inst != nullptr)
+    {
+        auto* next_inst = cur_inst->getNext();
+        cur_inst->setNext(nullptr);
+        if (keep_consts && cur_inst->isConstInst())
+        {
+            cur_inst->setPrev(last_inst);
+            last_inst->setNext(cur_inst);
+            last_inst = cur_inst;
+        }
+        else
+        {
+            cur_inst->setPrev(nullptr);
+            --bb_size;
+            new_bb->pushBackInst(cur_inst);
+        }
+        cur_inst = next_inst;
+    }
 
     for (auto* succ : {true_succ, false_succ})
         if (succ != nullptr)
-        {
             succ->replacePred(this, new_bb);
-            succ = nullptr;
-        }
+    new_bb->setTrueSucc(true_succ);
+    new_bb->setFalseSucc(false_succ);
+    true_succ = nullptr;
+    false_succ = nullptr;
 
     if (make_true_succ)
-        true_succ = new_bb;
+        setTrueSucc(new_bb);
     else
-        false_succ = new_bb;
+        setFalseSucc(new_bb);
+    new_bb->addPred(this);
     return new_bb;
 }
 
 void BasicBlock::setMarker(marker_t marker)
 {
-    markers->setMarker(marker);
+    markers.setMarker(marker);
 }
 
 void BasicBlock::resetMarker(marker_t marker)
 {
-    markers->resetMarker(marker);
+    markers.resetMarker(marker);
 }
 
 bool BasicBlock::isMarked(marker_t marker) const
 {
-    return markers->isMarked(marker);
+    return markers.isMarked(marker);
 }
 
 bool BasicBlock::isHeader() const noexcept
@@ -2,28 +2,39 @@
 
 #include "inst.h"
 #include "marker.h"
+#include <utility>
+#include <vector>
 
 namespace compiler
 {
 
 constexpr size_t BB_PREDS_NUM = 2;
-constexpr size_t BB_DOMINATED_NUM = 5;
+// gap between order numbers of neighbour insts, lets insertions avoid renumbering
+constexpr size_t INST_ORDER_STEP = 16;
 
 class Graph;
 class Loop;
 class LiveInterval;
+class BasicBlock;
+
+/**
+ * Explicit stack for iterative graph traversals: (bb, number of already visited
+ * successors/predecessors/children). Analyses keep it as a member, so it is reused
+ * by reruns of the cached analysis without new allocations.
+ */
+using bb_stack_t = std::vector<std::pair<BasicBlock*, size_t>>;
 
 class BasicBlock
 {
   public:
-    BasicBlock(size_t id_, std::shared_ptr<Graph> graph_ = nullptr, std::string name_ = "")
-        : id(id_), bb_size(0), name(name_), graph(graph_), markers(new MarkerSet)
+    BasicBlock(size_t id_, Graph* graph_ = nullptr, std::string name_ = "")
+        : id(id_), bb_size(0), name(name_), graph(graph_)
     {
         preds.reserve(BB_PREDS_NUM);
-        dominators.reserve(BB_DOMINATED_NUM);
     }
 
-    ~BasicBlock();
+    // instructions are owned by the graph arena
+    ~BasicBlock() = default;
 
     size_t size() const noexcept
     {
@@ -42,17 +53,23 @@ class BasicBlock
 
     DEFINE_GETTER_SETTER(name, Name, std::string)
     DEFINE_GETTER_SETTER(id, Id, size_t)
-    DEFINE_GETTER_SETTER(graph, Graph, std::shared_ptr<Graph>)
+    DEFINE_GETTER_SETTER(dense_id, DenseId, size_t)
+    DEFINE_GETTER_SETTER(graph, Graph, Graph*)
     DEFINE_ARRAY_GETTER(preds, Preds, std::vector<BasicBlock*>&)
-    DEFINE_GETTER_SETTER(true_succ, TrueSucc, BasicBlock*)
-    DEFINE_GETTER_SETTER(false_succ, FalseSucc, BasicBlock*)
+    DEFINE_GETTER(true_succ, TrueSucc, BasicBlock*)
+    DEFINE_GETTER(false_succ, FalseSucc, BasicBlock*)
     DEFINE_GETTER_SETTER(first_inst, FirstInst, Inst*)
     DEFINE_GETTER_SETTER(last_inst, LastInst, Inst*)
-    DEFINE_ARRAY_GETTER(dominators, Dominators, std::vector<BasicBlock*>&)
-    DEFINE_GETTER(idom, Idom, BasicBlock*)
+    DEFINE_GETTER_SETTER(idom, Idom, BasicBlock*)
+    DEFINE_ARRAY_GETTER(dom_children, DomChildren, std::vector<BasicBlock*>&)
+    DEFINE_GETTER_SETTER(dom_pre, DomPre, size_t)
+    DEFINE_GETTER_SETTER(dom_post, DomPost, size_t)
     DEFINE_GETTER_SETTER(loop, Loop, Loop*)
     DEFINE_GETTER_SETTER(live_int, LiveInterval, LiveInterval*)
 
+    void setTrueSucc(BasicBlock* bb);
+    void setFalseSucc(BasicBlock* bb);
+
     void swapSuccs()
     {
         std::swap(true_succ, false_succ);
@@ -89,6 +106,11 @@ class BasicBlock
      */
     void insertAfter(Inst* prev_inst, Inst* inst);
 
+    /**
+     * Insert inst before next_inst, at the end of the bb if next_inst is nullptr
+     */
+    void insertBefore(Inst* next_inst, Inst* inst);
+
     void popFrontInst();
     void popBackInst();
     void removeInst(Inst* inst);
@@ -114,48 +136,77 @@ class BasicBlock
     void resetMarker(marker_t marker);
     bool isMarked(marker_t marker) const;
 
-    void addDominator(BasicBlock* dom)
+    void addDomChild(BasicBlock* bb)
     {
-        dominators.push_back(dom);
+        dom_children.push_back(bb);
     }
 
-    // return true, if *this is a dominator of bb
-    bool dominates(BasicBlock* bb)
+    /**
+     * All dominators from the graph start block down to *this.
+     * The list is built lazily from the idom chain, DomTree keeps only idoms.
+     */
+    std::vector<BasicBlock*>& getDominators();
+
+    void resetDomInfo()
     {
-        auto& doms = bb->getDominators();
-        return std::find(doms.begin(), doms.end(), this) != doms.end();
+        idom = nullptr;
+        dominators.clear();
+        dom_children.clear();
     }
 
-    void countIdom()
+    /**
+     * Return true, if *this is a dominator of bb.
+     * O(1) check of DFS intervals in the dominator tree,
+     * DomTree is taken from the graph analyses cache and is rerun after CFG changes.
+     */
+    bool dominates(BasicBlock* bb) const;
+
+    /**
+     * Give insts increasing order numbers (phis first), so their relative position
+     * can be compared in O(1). Insertions keep the numbers valid while there is a gap
+     * between the neighbours, otherwise the bb is renumbered on the next query.
+     */
+    void renumberInsts();
+
+    void validateInstsOrder()
     {
-        size_t dom_num = dominators.size();
-        if (dom_num == 1)
-            idom = dominators[dominators.size() - 1];
-        else
-            idom = dominators[dominators.size() - 2];
+        if (!insts_order_valid)
+            renumberInsts();
     }
 
     void dump(std::ostream& out = std::cout) const;
 
+  private:
+    void markCfgChanged();
+    void updateInstOrder(Inst* prev, Inst* inst, Inst* next);
+
   private:
     size_t id = 0;
+    // compact number inside the graph, index for analyses side tables
+    size_t dense_id = INVALID_DENSE_ID;
     size_t bb_size = 0;
     std::string name = "";
-    std::shared_ptr<Graph> graph = nullptr;
+    Graph* graph = nullptr;
 
     std::vector<BasicBlock*> preds;
-    BasicBlock* true_succ;
-    BasicBlock* false_succ;
+    BasicBlock* true_succ = nullptr;
+    BasicBlock* false_succ = nullptr;
 
     Inst* first_inst = nullptr;
     Inst* last_inst = nullptr;
     PhiInst* first_phi = nullptr;
     PhiInst* last_phi = nullptr;
 
-    std::vector<BasicBlock*> dominators;
+    // start block is its own idom, unreachable blocks have no idom
     BasicBlock* idom = nullptr;
+    std::vector<BasicBlock*> dom_children;
+    std::vector<BasicBlock*> dominators;
+    // DFS entry and exit numbers in the dominator tree
+    size_t dom_pre = 0;
+    size_t dom_post = 0;
+    bool insts_order_valid = true;
 
-    MarkerSet* markers;
+    MarkerSet markers;
     Loop* loop = nullptr;
     LiveInterval* live_int = nullptr;
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "utils.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Dense set of small integers (insts or bbs dense ids).
+ * Set operations work word by word in plain loops, which compilers vectorize.
+ */
+class BitVector final
+{
+  public:
+    using word_t = uint64_t;
+    static constexpr size_t WORD_BITS = sizeof(word_t) * 8;
+
+    BitVector() = default;
+    explicit BitVector(size_t size_)
+    {
+        resize(size_);
+    }
+
+    void resize(size_t size_)
+    {
+        bits_num = size_;
+        words.resize((size_ + WORD_BITS - 1) / WORD_BITS, 0);
+    }
+
+    size_t size() const noexcept
+    {
+        return bits_num;
+    }
+
+    void set(size_t idx)
+    {
+        ASSERT(idx < bits_num, "bit index out of range");
+        words[idx / WORD_BITS] |= word_t{1} << (idx % WORD_BITS);
+    }
+
+    void reset(size_t idx)
+    {
+        ASSERT(idx < bits_num, "bit index out of range");
+        words[idx / WORD_BITS] &= ~(word_t{1} << (idx % WORD_BITS));
+    }
+
+    bool test(size_t idx) const
+    {
+        ASSERT(idx < bits_num, "bit index out of range");
+        return (words[idx / WORD_BITS] >> (idx % WORD_BITS)) & 1;
+    }
+
+    void clear() noexcept
+    {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    // *this |= other, return true if *this has changed
+    bool unite(const BitVector& other)
+    {
+        ASSERT(other.size() == bits_num, "bit vectors of different sizes");
+        word_t changed = 0;
+        for (size_t i = 0, size = words.size(); i < size; ++i)
+        {
+            auto word = words[i] | other.words[i];
+            changed |= word ^ words[i];
+            words[i] = word;
+        }
+        return changed != 0;
+    }
+
+    // *this &= ~other
+    void subtract(const BitVector& other)
+    {
+        ASSERT(other.size() == bits_num, "bit vectors of different sizes");
+        for (size_t i = 0, size = words.size(); i < size; ++i)
+            words[i] &= ~other.words[i];
+    }
+
+    // *this = gen | (in & ~kill), return true if *this has changed
+    bool transfer(const BitVector& gen, const BitVector& kill, const BitVector& in)
+    {
+        ASSERT(gen.size() == bits_num && kill.size() == bits_num && in.size() == bits_num);
+        word_t changed = 0;
+        for (size_t i = 0, size = words.size(); i < size; ++i)
+        {
+            auto word = gen.words[i] | (in.words[i] & ~kill.words[i]);
+            changed |= word ^ words[i];
+            words[i] = word;
+        }
+        return changed != 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return std::all_of(words.begin(), words.end(), [](auto word) { return word == 0; });
+    }
+
+    size_t count() const noexcept
+    {
+        size_t num = 0;
+        for (auto word : words)
+            num += std::popcount(word);
+        return num;
+    }
+
+    // call func for every set bit in increasing order
+    template <typename Func>
+    void forEach(Func func) const
+    {
+        for (size_t i = 0, size = words.size(); i < size; ++i)
+            for (auto word = words[i]; word != 0; word &= word - 1)
+                func(i * WORD_BITS + std::countr_zero(word));
+    }
+
+    bool operator==(const BitVector& other) const noexcept = default;
+
+  private:
+    size_t bits_num = 0;
+    std::vector<word_t> words;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -11,6 +11,8 @@ namespace compiler
 // clang-format off
 
 constexpr size_t INVALID_REG = 1000;
+constexpr size_t INVALID_DENSE_ID = static_cast<size_t>(-1);
+constexpr size_t INVALID_LIVE_POS = static_cast<size_t>(-1);
 
 //////////////////////////////////////__InstType__///////////////////////////////////////////////
 
@@ -127,5 +129,44 @@ constexpr std::array<const char *, static_cast<uint8_t>(DataType::End)> TYPE_NAM
 #undef CREATE_DATA_TYPE_NAME
 };
 
+constexpr size_t getDataTypeSize(DataType type)
+{
+    return type == DataType::i32 || type == DataType::f32 ? 4 : 8;
+}
+
 // clang-format on
+
+//////////////////////////////////////__Location__//////////////////////////////////////////////
+
+enum class LocationType : uint8_t
+{
+    None = 0,
+    Register,
+    StackSlot,
+    // not stored anywhere, recreated by its own instruction when needed
+    Remat
+};
+
+/**
+ * Place of a value after register allocation: register number in the class of the value
+ * or stack slot number
+ */
+struct Location
+{
+    LocationType type = LocationType::None;
+    size_t index = INVALID_REG;
+
+    bool isRegister() const noexcept
+    {
+        return type == LocationType::Register;
+    }
+
+    bool isStackSlot() const noexcept
+    {
+        return type == LocationType::StackSlot;
+    }
+
+    bool operator==(const Location& other) const noexcept = default;
+};
+
 } // namespace compiler
@@ -0,0 +1,401 @@
+#pragma once
+
+#include "const.h"
+#include "utils.h"
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace compiler
+{
+
+/**
+ * Constant evaluation core shared by the folding passes and the interpreter.
+ * Semantics follows the target machine: integers wrap around, Div, Mod and Cmp treat them
+ * as unsigned, shift counts are masked by the width of the type, Cmp gives flags for the next
+ * conditional jump (an unordered floats compare is "equal" and "below"). Cast is signed,
+ * float to integer conversions truncate and give the minimal integer on overflow and NaN.
+ * Values are passed as bit patterns of their types (see ConstInst::toBits).
+ *
+ * Every operation is a template over InstType and the C++ type of the value, so the
+ * interpreter instantiates it right in its dispatch switch. Folders go through
+ * evaluateBinary()/evaluateUnary()/evaluateCast(): a single lookup in tables generated from
+ * BINARY_OP_LIST/UNARY_OP_LIST and DATA_TYPE_LIST.
+ */
+
+enum class EvalStatus : uint8_t
+{
+    Ok = 0,
+    ZeroCheckFailed,
+    BoundsCheckFailed,
+    DivisionByZero,
+    // the operation is not defined for the type
+    Unsupported
+};
+
+struct EvalResult
+{
+    EvalStatus status = EvalStatus::Ok;
+    uint64_t bits = 0;
+
+    constexpr bool isOk() const noexcept
+    {
+        return status == EvalStatus::Ok;
+    }
+};
+
+// flags set by Cmp
+constexpr uint64_t CMP_EQUAL_FLAG = 1;
+constexpr uint64_t CMP_BELOW_FLAG = 2;
+
+// integers are unsigned, signed operations convert explicitly
+template <DataType TYPE>
+struct DataTypeTraits;
+
+template <>
+struct DataTypeTraits<DataType::i32>
+{
+    using type = uint32_t;
+};
+
+template <>
+struct DataTypeTraits<DataType::i64>
+{
+    using type = uint64_t;
+};
+
+template <>
+struct DataTypeTraits<DataType::f32>
+{
+    using type = float;
+};
+
+template <>
+struct DataTypeTraits<DataType::f64>
+{
+    using type = double;
+};
+
+template <DataType TYPE>
+using data_type_t = typename DataTypeTraits<TYPE>::type;
+
+/**
+ * i32 and f32 occupy low 32 bits, floats are stored bitwise
+ */
+template <typename T>
+constexpr uint64_t toBits(T value)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        if constexpr (sizeof(T) == sizeof(uint32_t))
+            return static_cast<uint32_t>(value);
+        else
+            return static_cast<uint64_t>(value);
+    }
+    else if constexpr (std::is_same_v<T, float>)
+        return std::bit_cast<uint32_t>(value);
+    else
+        return std::bit_cast<uint64_t>(value);
+}
+
+template <typename T>
+constexpr T fromBits(uint64_t bits)
+{
+    if constexpr (std::is_integral_v<T>)
+        return static_cast<T>(bits);
+    else if constexpr (std::is_same_v<T, float>)
+        return std::bit_cast<float>(static_cast<uint32_t>(bits));
+    else
+        return std::bit_cast<double>(bits);
+}
+
+template <typename T>
+constexpr EvalResult makeResult(T value)
+{
+    return EvalResult{EvalStatus::Ok, toBits(value)};
+}
+
+constexpr EvalResult UNSUPPORTED_RESULT{EvalStatus::Unsupported};
+
+template <InstType OP, typename T>
+constexpr EvalResult evalBinary(T left, T right)
+{
+    constexpr bool IS_INT = std::is_integral_v<T>;
+
+    if constexpr (OP == InstType::Add)
+        return makeResult<T>(left + right);
+    else if constexpr (OP == InstType::Sub)
+        return makeResult<T>(left - right);
+    else if constexpr (OP == InstType::Mul)
+        return makeResult<T>(left * right);
+    else if constexpr (OP == InstType::Div || OP == InstType::Mod)
+    {
+        if constexpr (IS_INT)
+        {
+            if (right == 0)
+                return EvalResult{EvalStatus::DivisionByZero};
+            return makeResult<T>(OP == InstType::Div ? left / right : left % right);
+        }
+        else if constexpr (OP == InstType::Div)
+            return makeResult<T>(left / right);
+        else
+            return makeResult<T>(std::fmod(left, right));
+    }
+    else if constexpr (OP == InstType::Cmp)
+    {
+        if constexpr (!IS_INT)
+            if (std::isunordered(left, right))
+                return EvalResult{EvalStatus::Ok, CMP_EQUAL_FLAG | CMP_BELOW_FLAG};
+        bool equal = !(left < right) && !(right < left);
+        return EvalResult{EvalStatus::Ok,
+                          (equal ? CMP_EQUAL_FLAG : 0) | (left < right ? CMP_BELOW_FLAG : 0)};
+    }
+    else if constexpr (!IS_INT)
+        return UNSUPPORTED_RESULT;
+    else
+    {
+        constexpr T SHIFT_MASK = sizeof(T) * 8 - 1;
+        if constexpr (OP == InstType::Shl)
+            return makeResult<T>(left << (right & SHIFT_MASK));
+        else if constexpr (OP == InstType::Shr)
+            return makeResult<T>(left >> (right & SHIFT_MASK));
+        else if constexpr (OP == InstType::AShr)
+            return makeResult<T>(
+                static_cast<T>(static_cast<std::make_signed_t<T>>(left) >> (right & SHIFT_MASK)));
+        else if constexpr (OP == InstType::And)
+            return makeResult<T>(left & right);
+        else if constexpr (OP == InstType::Or)
+            return makeResult<T>(left | right);
+        else if constexpr (OP == InstType::Xor)
+            return makeResult<T>(left ^ right);
+        else if constexpr (OP == InstType::BoundsCheck)
+        {
+            // the checked index is the value
+            if (left >= right)
+                return EvalResult{EvalStatus::BoundsCheckFailed};
+            return makeResult<T>(left);
+        }
+        else
+            return UNSUPPORTED_RESULT;
+    }
+}
+
+template <InstType OP, typename T>
+constexpr EvalResult evalUnary(T value)
+{
+    if constexpr (OP == InstType::Neg)
+        return makeResult<T>(-value);
+    else if constexpr (OP == InstType::Not && std::is_integral_v<T>)
+        return makeResult<T>(~value);
+    else if constexpr (OP == InstType::ZeroCheck)
+    {
+        if (value == static_cast<T>(0))
+            return EvalResult{EvalStatus::ZeroCheckFailed};
+        return makeResult<T>(value);
+    }
+    else
+        return UNSUPPORTED_RESULT;
+}
+
+template <typename From, typename To>
+constexpr EvalResult evalCast(From value)
+{
+    if constexpr (std::is_floating_point_v<From> && std::is_integral_v<To>)
+    {
+        using signed_t = std::make_signed_t<To>;
+        constexpr auto MIN = static_cast<From>(std::numeric_limits<signed_t>::min());
+        if (!(value >= MIN && value < -MIN))
+            return makeResult<To>(static_cast<To>(std::numeric_limits<signed_t>::min()));
+        return makeResult<To>(static_cast<To>(static_cast<signed_t>(value)));
+    }
+    else if constexpr (std::is_integral_v<From>)
+        return makeResult<To>(static_cast<To>(static_cast<std::make_signed_t<From>>(value)));
+    else
+        return makeResult<To>(static_cast<To>(value));
+}
+
+/**
+ * The conditional jump goes to the false successor of its block if the condition holds,
+ * Jmp always does
+ */
+template <InstType OP>
+constexpr bool evalCondition(uint64_t flags)
+{
+    bool equal = (flags & CMP_EQUAL_FLAG) != 0;
+    bool below = (flags & CMP_BELOW_FLAG) != 0;
+    if constexpr (OP == InstType::Je)
+        return equal;
+    else if constexpr (OP == InstType::Jne)
+        return !equal;
+    else if constexpr (OP == InstType::Jb)
+        return below;
+    else if constexpr (OP == InstType::Jbe)
+        return below || equal;
+    else if constexpr (OP == InstType::Ja)
+        return !below && !equal;
+    else if constexpr (OP == InstType::Jae)
+        return !below;
+    else
+        return true;
+}
+
+//////////////////////////////////////__Dispatch_tables__///////////////////////////////////////
+
+using binary_eval_t = EvalResult (*)(uint64_t, uint64_t);
+using unary_eval_t = EvalResult (*)(uint64_t);
+using condition_eval_t = bool (*)(uint64_t);
+
+constexpr size_t EVAL_OPS_NUM = static_cast<size_t>(InstType::End);
+constexpr size_t EVAL_TYPES_NUM = static_cast<size_t>(DataType::End);
+
+template <typename Func>
+using eval_table_t = std::array<std::array<Func, EVAL_TYPES_NUM>, EVAL_OPS_NUM>;
+
+template <InstType OP, DataType TYPE>
+constexpr EvalResult evalBinaryBits(uint64_t left, uint64_t right)
+{
+    using T = data_type_t<TYPE>;
+    return evalBinary<OP, T>(fromBits<T>(left), fromBits<T>(right));
+}
+
+template <InstType OP, DataType TYPE>
+constexpr EvalResult evalUnaryBits(uint64_t value)
+{
+    using T = data_type_t<TYPE>;
+    return evalUnary<OP, T>(fromBits<T>(value));
+}
+
+template <DataType FROM, DataType TO>
+constexpr EvalResult evalCastBits(uint64_t value)
+{
+    return evalCast<data_type_t<FROM>, data_type_t<TO>>(fromBits<data_type_t<FROM>>(value));
+}
+
+constexpr EvalResult evalUnsupported(uint64_t, uint64_t)
+{
+    return UNSUPPORTED_RESULT;
+}
+
+constexpr EvalResult evalUnsupported(uint64_t)
+{
+    return UNSUPPORTED_RESULT;
+}
+
+// clang-format off
+template <InstType OP>
+constexpr std::array<binary_eval_t, EVAL_TYPES_NUM> makeBinaryRow()
+{
+#define CREATE_BINARY_EVAL(TYPE) &evalBinaryBits<OP, DataType::TYPE>,
+
+    return {static_cast<binary_eval_t>(&evalUnsupported), DATA_TYPE_LIST(CREATE_BINARY_EVAL)};
+
+#undef CREATE_BINARY_EVAL
+}
+
+template <InstType OP>
+constexpr std::array<unary_eval_t, EVAL_TYPES_NUM> makeUnaryRow()
+{
+#define CREATE_UNARY_EVAL(TYPE) &evalUnaryBits<OP, DataType::TYPE>,
+
+    return {static_cast<unary_eval_t>(&evalUnsupported), DATA_TYPE_LIST(CREATE_UNARY_EVAL)};
+
+#undef CREATE_UNARY_EVAL
+}
+
+template <DataType FROM>
+constexpr std::array<unary_eval_t, EVAL_TYPES_NUM> makeCastRow()
+{
+#define CREATE_CAST_EVAL(TYPE) &evalCastBits<FROM, DataType::TYPE>,
+
+    return {static_cast<unary_eval_t>(&evalUnsupported), DATA_TYPE_LIST(CREATE_CAST_EVAL)};
+
+#undef CREATE_CAST_EVAL
+}
+
+// indexed by InstType and DataType
+constexpr eval_table_t<binary_eval_t> BINARY_EVAL_TABLE = []() {
+    eval_table_t<binary_eval_t> table{};
+    for (auto& row : table)
+        row.fill(&evalUnsupported);
+
+#define CREATE_BINARY_ROW(NAME, BASE)                                                              \
+    table[static_cast<size_t>(InstType::NAME)] = makeBinaryRow<InstType::NAME>();
+
+    BINARY_OP_LIST(CREATE_BINARY_ROW)
+
+#undef CREATE_BINARY_ROW
+    return table;
+}();
+
+// indexed by InstType and DataType
+constexpr eval_table_t<unary_eval_t> UNARY_EVAL_TABLE = []() {
+    eval_table_t<unary_eval_t> table{};
+    for (auto& row : table)
+        row.fill(&evalUnsupported);
+
+#define CREATE_UNARY_ROW(NAME, BASE)                                                               \
+    table[static_cast<size_t>(InstType::NAME)] = makeUnaryRow<InstType::NAME>();
+
+    UNARY_OP_LIST(CREATE_UNARY_ROW)
+
+#undef CREATE_UNARY_ROW
+    return table;
+}();
+
+// indexed by the source and the destination DataType
+constexpr std::array<std::array<unary_eval_t, EVAL_TYPES_NUM>, EVAL_TYPES_NUM> CAST_EVAL_TABLE =
+    []() {
+    std::array<std::array<unary_eval_t, EVAL_TYPES_NUM>, EVAL_TYPES_NUM> table{};
+    table[0].fill(&evalUnsupported);
+
+#define CREATE_CAST_ROW(TYPE)                                                                      \
+    table[static_cast<size_t>(DataType::TYPE)] = makeCastRow<DataType::TYPE>();
+
+    DATA_TYPE_LIST(CREATE_CAST_ROW)
+
+#undef CREATE_CAST_ROW
+    return table;
+}();
+
+// indexed by InstType, nullptr for not jumps
+constexpr std::array<condition_eval_t, EVAL_OPS_NUM> CONDITION_EVAL_TABLE = []() {
+    std::array<condition_eval_t, EVAL_OPS_NUM> table{};
+
+#define CREATE_CONDITION_EVAL(NAME, BASE)                                                          \
+    table[static_cast<size_t>(InstType::NAME)] = &evalCondition<InstType::NAME>;
+
+    JUMP_OP_LIST(CREATE_CONDITION_EVAL)
+
+#undef CREATE_CONDITION_EVAL
+    return table;
+}();
+// clang-format on
+
+constexpr EvalResult evaluateBinary(InstType op, DataType type, uint64_t left, uint64_t right)
+{
+    ASSERT(op < InstType::End && type < DataType::End);
+    return BINARY_EVAL_TABLE[static_cast<size_t>(op)][static_cast<size_t>(type)](left, right);
+}
+
+constexpr EvalResult evaluateUnary(InstType op, DataType type, uint64_t value)
+{
+    ASSERT(op < InstType::End && type < DataType::End);
+    return UNARY_EVAL_TABLE[static_cast<size_t>(op)][static_cast<size_t>(type)](value);
+}
+
+constexpr EvalResult evaluateCast(DataType from, DataType to, uint64_t value)
+{
+    ASSERT(from < DataType::End && to < DataType::End);
+    return CAST_EVAL_TABLE[static_cast<size_t>(from)][static_cast<size_t>(to)](value);
+}
+
+constexpr bool evaluateCondition(InstType jump, uint64_t flags)
+{
+    ASSERT(jump >= InstType::Jmp && jump <= InstType::Jae, "not a jump");
+    return CONDITION_EVAL_TABLE[static_cast<size_t>(jump)](flags);
+}
+
+} // namespace compiler
\ No newline at end of file
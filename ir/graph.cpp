@@ -7,12 +7,9 @@ namespace compiler
 
 Graph::~Graph()
 {
-    for (auto* bb : BBs)
-        delete bb;
-    if (root_loop != nullptr)
-        delete root_loop;
-    for (auto [inst, live_int] : live_intervals)
-        delete live_int;
+    // passes may refer to the graph data, so drop them before the arena;
+    // blocks, instructions, loops and live intervals are released with the arena
+    pm.reset();
 }
 
 marker_t Graph::getNewMarker()
@@ -27,6 +24,8 @@ void Graph::deleteMarker(marker_t marker)
 
 void Graph::insertBB(BasicBlock* bb)
 {
+    markCfgChanged();
+    assignDenseId(bb);
     if (graph_size == 0)
     {
         BBs.push_back(bb);
@@ -43,29 +42,84 @@ void Graph::insertBB(BasicBlock* bb)
 
 void Graph::addBB(BasicBlock* bb)
 {
+    markCfgChanged();
+    assignDenseId(bb);
     BBs.push_back(bb);
     bb->setId(graph_size);
     ++graph_size;
 }
 
+ConstInst* Graph::findConstant(DataType type, uint64_t bits)
+{
+    auto it = const_pool.find(ConstKey{type, bits});
+    if (it != const_pool.end())
+        return it->second;
+
+    auto* first_bb = getFirstBB();
+    ASSERT(first_bb != nullptr);
+    auto* new_const = create<ConstInst>(cur_inst_id++, type, bits);
+    first_bb->pushBackInst(new_const);
+    return new_const;
+}
+
 void Graph::pushBackConstInst(ConstInst* inst)
 {
-    if (first_const == nullptr)
-        first_const = inst;
-    last_const = inst;
+    // constants of other blocks do not dominate all the uses findConstant() gives them to
+    if (inst->getBB() != getFirstBB())
+        return;
+    // the first block keeps one constant per value, so removal needs no search for another one
+    auto [it, is_inserted] =
+        const_pool.try_emplace(ConstKey{inst->getType(), inst->getRawValue()}, inst);
+    ASSERT(is_inserted, "duplicate constant in the first block, use findConstant()");
+}
+
+void Graph::removeConstInst(ConstInst* inst)
+{
+    auto it = const_pool.find(ConstKey{inst->getType(), inst->getRawValue()});
+    if (it != const_pool.end() && it->second == inst)
+        const_pool.erase(it);
+}
+
+void Graph::renumberDenseIds()
+{
+    size_t bb_num = 0;
+    size_t inst_num = 0;
+    for (auto* bb : BBs)
+    {
+        bb->setDenseId(bb_num++);
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+            phi->setDenseId(inst_num++);
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+            inst->setDenseId(inst_num++);
+    }
+    bbs_dense_num = bb_num;
+    insts_dense_num = inst_num;
+    live_intervals.clear();
 }
 
 void Graph::removeBB(BasicBlock* bb)
 {
-    auto it = BBs.erase(std::find(BBs.begin(), BBs.end(), bb));
+    markCfgChanged();
+    auto it = std::find(BBs.begin(), BBs.end(), bb);
     ASSERT(it != BBs.end(), "remove not existing bb");
+    BBs.erase(it);
+    --graph_size;
 }
 
 void Graph::removeBB(size_t num)
 {
-    auto it = BBs.erase(
-        std::find_if(BBs.begin(), BBs.end(), [num](auto bb) { return bb->getId() == num; }));
+    markCfgChanged();
+    auto it = std::find_if(BBs.begin(), BBs.end(), [num](auto bb) { return bb->getId() == num; });
     ASSERT(it != BBs.end(), "remove not existing bb");
+    BBs.erase(it);
+    --graph_size;
+}
+
+void Graph::removeUnmarkedBBs(marker_t marker)
+{
+    markCfgChanged();
+    std::erase_if(BBs, [marker](auto* bb) { return !bb->isMarked(marker); });
+    graph_size = BBs.size();
 }
 
 /**
@@ -73,6 +127,7 @@ void Graph::removeBB(size_t num)
  */
 void Graph::insertBBAfter(BasicBlock* prev_bb, BasicBlock* bb, bool is_true_succ)
 {
+    assignDenseId(bb);
     if (is_true_succ)
     {
         auto* true_succ = prev_bb->getTrueSucc();
@@ -107,8 +162,44 @@ void Graph::addEdge(BasicBlock* prev_bb, BasicBlock* bb)
     prev_bb->addSucc(bb);
 }
 
+/**
+ * New bb on the edge jumps to succ, the jump and phis of succ are redirected to it
+ */
+BasicBlock* Graph::splitEdge(BasicBlock* pred, BasicBlock* succ)
+{
+    size_t id = 0;
+    for (auto* graph_bb : BBs)
+        id = std::max(id, graph_bb->getId() + 1);
+    auto* bb = createBB(id);
+    markCfgChanged();
+    assignDenseId(bb);
+    BBs.push_back(bb);
+    ++graph_size;
+
+    pred->replaceSucc(succ, bb);
+    bb->addPred(pred);
+    bb->addSucc(succ);
+    succ->replacePred(pred, bb);
+
+    auto* last_inst = pred->getLastInst();
+    if (last_inst != nullptr && last_inst->isJumpInst())
+    {
+        auto* jump = static_cast<JumpInst*>(last_inst);
+        if (jump->getTargetBB() == succ)
+            jump->setTargetBB(bb);
+    }
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        for (auto*& input_bb : static_cast<PhiInst*>(phi)->getInputBBs())
+            if (input_bb == pred)
+                input_bb = bb;
+
+    bb->pushBackInst(create<JumpInst>(cur_inst_id++, InstType::Jmp, succ));
+    return bb;
+}
+
 void Graph::replaceBB(BasicBlock* bb, BasicBlock* new_bb)
 {
+    markCfgChanged();
     auto it = std::find(BBs.begin(), BBs.end(), bb);
     ASSERT(it != BBs.end(), "replace not existing bb");
     BBs[(*it)->getId()] = new_bb;
@@ -116,6 +207,7 @@ void Graph::replaceBB(BasicBlock* bb, BasicBlock* new_bb)
 
 void Graph::replaceBB(size_t num, BasicBlock* new_bb)
 {
+    markCfgChanged();
     auto it = std::find_if(BBs.begin(), BBs.end(), [num](auto bb) { return bb->getId() == num; });
     ASSERT(it != BBs.end(), "replace not existing bb");
     BBs[num] = new_bb;
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "arena.h"
 #include "basicblock.h"
+#include "id_vector.h"
 #include "inst.h"
 #include "pass/passmanager.h"
+#include "target.h"
 #include <algorithm>
 #include <iostream>
 #include <memory>
@@ -26,11 +29,82 @@ class LivenessAnalysis;
 class LiveInterval;
 class RegisterAllocation;
 
+/**
+ * Constants are equal if their types and bit patterns are equal
+ */
+struct ConstKey
+{
+    DataType type;
+    uint64_t bits;
+
+    bool operator==(const ConstKey&) const noexcept = default;
+};
+
+struct ConstKeyHash
+{
+    size_t operator()(const ConstKey& key) const noexcept
+    {
+        // mix the bits, small integers and floats differ mostly in upper bits
+        uint64_t hash = (key.bits ^ (key.bits >> 32)) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(hash ^ static_cast<uint64_t>(key.type));
+    }
+};
+
+/**
+ * Spill slot in the stack frame, spilled live intervals locations index them
+ */
+struct StackSlot
+{
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+/**
+ * Spill code of the register allocation result
+ */
+struct RegAllocStats
+{
+    // stores of values to their stack slots, a value is stored once
+    size_t spills = 0;
+    // loads from stack slots to registers
+    size_t fills = 0;
+    // constants recreated in registers instead of loads
+    size_t remats = 0;
+    // moves inserted by the resolution of split intervals and phis, swaps not included
+    size_t moves = 0;
+    // exchanges of two registers breaking cycles of moves
+    size_t swaps = 0;
+    // moves of the graph deleted because the value is already in the destination
+    size_t removed_moves = 0;
+};
+
+/**
+ * Allocator run by RegisterAllocation: linear scan is fast enough for JIT, graph coloring
+ * spends more compile time on better code for AOT
+ */
+enum class RegAllocKind : uint8_t
+{
+    LinearScan,
+    GraphColoring
+};
+
 class Graph
 {
   public:
-    Graph(std::string name = "") : func_name(name), graph_size(0), cur_inst_id(0)
+    /**
+     * If arena_ is not given, graph owns its own arena and releases it on destruction.
+     * An external arena outlives the graph, so the caller can reset() and reuse it
+     * for the next compilation on the same thread.
+     * Inline moves callee blocks to the caller, so a callee has to share its arena.
+     */
+    Graph(std::string name = "", ArenaAllocator* arena_ = nullptr)
+        : func_name(name), graph_size(0), cur_inst_id(0), arena(arena_)
     {
+        if (arena == nullptr)
+        {
+            own_arena = std::make_unique<ArenaAllocator>();
+            arena = own_arena.get();
+        }
         BBs.reserve(GRAPH_BB_NUM);
         rpo_BBs.reserve(GRAPH_BB_NUM);
         linear_order_BBs.reserve(GRAPH_BB_NUM);
@@ -39,7 +113,9 @@ class Graph
     }
     ~Graph();
 
-    using live_intervals_t = std::unordered_map<Inst*, LiveInterval*>;
+    // indexed by inst dense id
+    using live_intervals_t = IdVector<LiveInterval*>;
+    using const_pool_t = std::unordered_map<ConstKey, ConstInst*, ConstKeyHash>;
 
     size_t size() const noexcept
     {
@@ -52,14 +128,46 @@ class Graph
     }
 
     DEFINE_GETTER_SETTER(cur_inst_id, CurInstId, size_t)
+    DEFINE_GETTER(insts_dense_num, InstsDenseNum, size_t)
+    DEFINE_GETTER(bbs_dense_num, BBsDenseNum, size_t)
     DEFINE_ARRAY_GETTER(func_name, Name, std::string)
     DEFINE_ARRAY_GETTER(BBs, BBs, std::vector<BasicBlock*>&)
     DEFINE_ARRAY_GETTER_SETTER(rpo_BBs, RpoBBs, std::vector<BasicBlock*>&)
     DEFINE_ARRAY_GETTER_SETTER(linear_order_BBs, LinearOrderBBs, std::vector<BasicBlock*>&)
     DEFINE_ARRAY_GETTER_SETTER(live_intervals, LiveIntervals, live_intervals_t&)
     DEFINE_GETTER_SETTER(root_loop, RootLoop, Loop*)
-    DEFINE_GETTER(first_const, FirstConst, ConstInst*)
-    DEFINE_GETTER(last_const, LastConst, ConstInst*)
+    DEFINE_ARRAY_GETTER(const_pool, ConstPool, const_pool_t&)
+    DEFINE_GETTER(arena, Arena, ArenaAllocator*)
+    // register file for allocators, x86-64 unless set
+    DEFINE_GETTER_SETTER(target, Target, const Target*)
+    DEFINE_GETTER_SETTER(regalloc_kind, RegAllocKind, RegAllocKind)
+    // spill area layout after register allocation
+    DEFINE_ARRAY_GETTER_SETTER(stack_slots, StackSlots, std::vector<StackSlot>&)
+    DEFINE_GETTER_SETTER(frame_size, FrameSize, size_t)
+    DEFINE_GETTER_SETTER(regalloc_stats, RegAllocStats, RegAllocStats)
+
+    // any CFG change makes cached analyses results stale, they are rerun on the next request
+    DEFINE_GETTER(cfg_version, CfgVersion, size_t)
+
+    void markCfgChanged() noexcept
+    {
+        ++cfg_version;
+    }
+
+    /**
+     * Allocate IR node or analysis data in the graph arena.
+     * Objects are never deleted one by one, they all die together with the arena.
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        return arena->create<T>(std::forward<Args>(args)...);
+    }
+
+    BasicBlock* createBB(size_t id, std::string name = "")
+    {
+        return create<BasicBlock>(id, this, name);
+    }
 
     BasicBlock* getFirstBB() const noexcept
     {
@@ -83,39 +191,50 @@ class Graph
             return BBs[id];
     }
 
+    /**
+     * Find constant in the pool or create it at the end of the first block
+     */
     template <typename T>
     ConstInst* findConstant(T value)
     {
-        if (first_const == nullptr)
-        {
-            auto* new_const = new ConstInst{cur_inst_id++, value};
-            auto* first_bb = getFirstBB();
-            ASSERT(first_bb != nullptr);
-            first_bb->pushBackInst(new_const);
-            return first_const;
-        }
+        return findConstant(getDataType<T>(), ConstInst::toBits(value));
+    }
 
-        for (ConstInst* cur_const = first_const; cur_const != nullptr;
-             cur_const = static_cast<ConstInst*>(cur_const->getNext()))
-            if (cur_const->getType() == getDataType<T>() && cur_const->getValue<T>() == value)
-                return cur_const;
+    ConstInst* findConstant(DataType type, uint64_t bits);
+
+    // keep the constant pool consistent with constants in the first block
+    void pushBackConstInst(ConstInst* inst);
+    void removeConstInst(ConstInst* inst);
 
-        auto* new_const = new ConstInst{cur_inst_id++, value};
-        auto* first_bb = getFirstBB();
-        first_bb->pushBackInst(new_const);
-        last_const = new_const;
-        return last_const;
+    void assignDenseId(Inst* inst)
+    {
+        if (inst->getDenseId() == INVALID_DENSE_ID)
+            inst->setDenseId(insts_dense_num++);
     }
 
-    void pushBackConstInst(ConstInst* inst);
+    void assignDenseId(BasicBlock* bb)
+    {
+        if (bb->getDenseId() == INVALID_DENSE_ID)
+            bb->setDenseId(bbs_dense_num++);
+    }
+
+    /**
+     * Compact dense ids of all blocks and instructions after removing or merging code.
+     * Analyses side tables are invalidated: analyses have to be rerun.
+     */
+    void renumberDenseIds();
 
     void removeBB(BasicBlock* bb);
     void removeBB(size_t num);
+    // remove all blocks without the marker at once, edges and insts are not touched
+    void removeUnmarkedBBs(marker_t marker);
 
     void addBB(BasicBlock* bb);
     void insertBB(BasicBlock* bb);
     void insertBBAfter(BasicBlock* prev_bb, BasicBlock* bb, bool is_true_succ = true);
     void addEdge(BasicBlock* prev_bb, BasicBlock* bb);
+    // critical edge splitting, returns the new bb between pred and succ
+    BasicBlock* splitEdge(BasicBlock* pred, BasicBlock* succ);
 
     void replaceBB(BasicBlock* bb, BasicBlock* new_bb);
     void replaceBB(size_t num, BasicBlock* new_bb);
@@ -136,10 +255,50 @@ class Graph
         return pm->runPass<PassName>(std::forward<Args>(args)...);
     }
 
+    template <LegalAnalysis AnalysisName>
+    AnalysisName* getAnalysis()
+    {
+        ASSERT(pm != nullptr);
+        return pm->getAnalysis<AnalysisName>();
+    }
+
+    template <LegalAnalysis AnalysisName>
+    bool isAnalysisValid() const
+    {
+        ASSERT(pm != nullptr);
+        return pm->isAnalysisValid<AnalysisName>();
+    }
+
+    // per pass timing, allocations and IR size, see PassStats
+    void enablePassStats()
+    {
+        ASSERT(pm != nullptr);
+        pm->enableStats();
+    }
+
+    PassStats* getPassStats() const
+    {
+        ASSERT(pm != nullptr);
+        return pm->getStats();
+    }
+
+    template <LegalAnalysis AnalysisName>
+    void invalidateAnalysis()
+    {
+        ASSERT(pm != nullptr);
+        pm->invalidateAnalyses(makeAnalysesMask<AnalysisName>());
+    }
+
   private:
+    // declared first to be destroyed last
+    std::unique_ptr<ArenaAllocator> own_arena = nullptr;
+
     std::string func_name = "";
     size_t graph_size = 0;
     size_t cur_inst_id = 0;
+    size_t insts_dense_num = 0;
+    size_t bbs_dense_num = 0;
+    ArenaAllocator* arena = nullptr;
 
     std::vector<BasicBlock*> BBs;
     std::vector<BasicBlock*> rpo_BBs;
@@ -149,11 +308,15 @@ class Graph
     std::unique_ptr<MarkerManager> mm = nullptr;
     Loop* root_loop = nullptr;
 
-    ConstInst* first_const = nullptr;
-    ConstInst* last_const = nullptr;
+    const_pool_t const_pool;
+    size_t cfg_version = 0;
 
-    std::unordered_map<Inst*, LiveInterval*> live_intervals;
-    std::unordered_map<Inst*, int32_t> reg_map;
+    live_intervals_t live_intervals;
+    const Target* target = Target::getDefault();
+    RegAllocKind regalloc_kind = RegAllocKind::LinearScan;
+    std::vector<StackSlot> stack_slots;
+    size_t frame_size = 0;
+    RegAllocStats regalloc_stats;
 };
 
 } // namespace compiler
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "const.h"
+#include "utils.h"
+#include <concepts>
+#include <vector>
+
+namespace compiler
+{
+
+template <typename T>
+concept DenseNumbered = requires(const T* obj)
+{
+    { obj->getDenseId() } -> std::convertible_to<size_t>;
+};
+
+/**
+ * Side table for analyses data indexed by dense id of instruction or basic block.
+ * Storage is a flat array, it grows on demand on write access,
+ * read access out of bounds returns the default value.
+ */
+template <typename T>
+class IdVector final
+{
+  public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    explicit IdVector(T default_value_ = T{}) : default_value(default_value_)
+    {}
+
+    IdVector(size_t size, T default_value_)
+        : data(size, default_value_), default_value(default_value_)
+    {}
+
+    T& operator[](size_t id)
+    {
+        ASSERT(id != INVALID_DENSE_ID, "object has no dense id");
+        if (id >= data.size())
+            data.resize(id + 1, default_value);
+        return data[id];
+    }
+
+    template <DenseNumbered Obj>
+    T& operator[](const Obj* obj)
+    {
+        return (*this)[obj->getDenseId()];
+    }
+
+    const T& get(size_t id) const
+    {
+        if (id >= data.size())
+            return default_value;
+        return data[id];
+    }
+
+    template <DenseNumbered Obj>
+    const T& get(const Obj* obj) const
+    {
+        return get(obj->getDenseId());
+    }
+
+    void resize(size_t size)
+    {
+        data.resize(size, default_value);
+    }
+
+    void reserve(size_t size)
+    {
+        data.reserve(size);
+    }
+
+    void clear() noexcept
+    {
+        data.clear();
+    }
+
+    size_t size() const noexcept
+    {
+        return data.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return data.empty();
+    }
+
+    iterator begin() noexcept
+    {
+        return data.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return data.end();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return data.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return data.end();
+    }
+
+  private:
+    std::vector<T> data;
+    T default_value;
+};
+
+} // namespace compiler
\ No newline at end of file
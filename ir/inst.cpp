@@ -21,20 +21,14 @@ bool Inst::dominates(Inst* inst) const
     if (inst == this)
         return true;
 
-    auto* cur_inst = next;
-    while (cur_inst != nullptr)
-    {
-        if (cur_inst == inst)
-            return true;
-        cur_inst = cur_inst->getNext();
-    }
-    return false;
+    bb->validateInstsOrder();
+    return order_num < inst->getOrderNum();
 }
 
 void Inst::dumpUsers(std::ostream& out) const
 {
-    auto size = users.size();
-    if (size == 0)
+    auto users = getUsers();
+    if (users.empty())
         return;
 
     out << " ->"
@@ -58,8 +52,7 @@ CallInst::CallInst(size_t id_, Graph* g, std::initializer_list<size_t> args_)
     for (auto arg : args_)
     {
         auto* inst = bb->getInst(arg);
-        args.push_back(inst);
-        inst->addUser(this);
+        args.emplace_back(this, inst);
     }
 }
 
@@ -70,9 +63,9 @@ void CallInst::dump(std::ostream& out) const
         << func->getName();
     if (args.size() == 0)
         return;
-    out << "(v" << args[0]->getId();
+    out << "(v" << args[0].get()->getId();
     for (auto it = ++args.begin(), ite = args.end(); it != ite; ++it)
-        out << ", v" << (*it)->getId();
+        out << ", v" << it->get()->getId();
     out << ")";
 }
 
@@ -80,9 +73,9 @@ void PhiInst::dump(std::ostream& out) const
 {
     out << "\t"
         << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " ";
-    for (auto&& input : inputs)
+    for (size_t i = 0, size = inputs.size(); i < size; ++i)
         out << "("
-            << "v" << input.first->getId() << ", bb" << input.second->getId() << ")";
+            << "v" << inputs[i].get()->getId() << ", bb" << input_bbs[i]->getId() << ")";
 }
 
 void RetVoidInst::dump(std::ostream& out) const
@@ -1,20 +1,187 @@
 #pragma once
 #include "const.h"
+#include "evaluator.h"
 #include "utils.h"
 
+#include <bit>
 #include <initializer_list>
 #include <iostream>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <vector>
 
 namespace compiler
 {
 
-constexpr size_t INST_USERS_NUM = 4;
-
 class BasicBlock;
 class Graph;
+class Inst;
+
+/**
+ * Def-use edge. It is embedded into the operand slot of the user and is linked
+ * into the intrusive users list of the used instruction, so creating, removing
+ * and replacing an edge is O(1) and does not allocate.
+ * Moving a Use (e.g. on vector growth) relinks it in place.
+ */
+class Use final
+{
+  public:
+    Use() = default;
+    Use(Inst* user_, Inst* value_ = nullptr) : user(user_)
+    {
+        set(value_);
+    }
+
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
+
+    Use(Use&& other) noexcept
+    {
+        takePlaceOf(other);
+    }
+
+    Use& operator=(Use&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unlink();
+            takePlaceOf(other);
+        }
+        return *this;
+    }
+
+    // users lists die together with the graph arena, so nothing to unlink here
+    ~Use() = default;
+
+    DEFINE_GETTER_SETTER(user, User, Inst*)
+    DEFINE_GETTER(next, Next, Use*)
+
+    Inst* get() const noexcept
+    {
+        return value;
+    }
+
+    // relink the edge to the new value, nullptr just drops it
+    inline void set(Inst* new_value);
+
+  private:
+    inline void link();
+    inline void unlink();
+
+    void takePlaceOf(Use& other) noexcept
+    {
+        value = other.value;
+        user = other.user;
+        next = other.next;
+        prev = other.prev;
+        if (prev != nullptr)
+            *prev = this;
+        if (next != nullptr)
+            next->prev = &next;
+        other.value = nullptr;
+        other.next = nullptr;
+        other.prev = nullptr;
+    }
+
+  private:
+    Inst* value = nullptr;
+    Inst* user = nullptr;
+
+    Use* next = nullptr;
+    // address of the pointer to this use: either users head or previous use next
+    Use** prev = nullptr;
+};
+
+/**
+ * Iterates over users of the instruction.
+ * Users go in the reverse order of edge creation (the latest added edge first);
+ * an instruction using a value in several operands is visited once per operand.
+ */
+class UsersIterator final
+{
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Inst*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Inst**;
+    using reference = Inst*;
+
+    explicit UsersIterator(Use* use_ = nullptr) : use(use_)
+    {}
+
+    Inst* operator*() const noexcept
+    {
+        return use->getUser();
+    }
+
+    UsersIterator& operator++() noexcept
+    {
+        use = use->getNext();
+        return *this;
+    }
+
+    UsersIterator operator++(int) noexcept
+    {
+        auto tmp = *this;
+        use = use->getNext();
+        return tmp;
+    }
+
+    bool operator==(const UsersIterator& other) const noexcept
+    {
+        return use == other.use;
+    }
+
+    bool operator!=(const UsersIterator& other) const noexcept
+    {
+        return use != other.use;
+    }
+
+    Use* getUse() const noexcept
+    {
+        return use;
+    }
+
+  private:
+    Use* use = nullptr;
+};
+
+class UsersRange final
+{
+  public:
+    UsersRange(Use* first_, size_t size_) : first(first_), users_num(size_)
+    {}
+
+    UsersIterator begin() const noexcept
+    {
+        return UsersIterator{first};
+    }
+
+    UsersIterator end() const noexcept
+    {
+        return UsersIterator{};
+    }
+
+    Inst* front() const noexcept
+    {
+        ASSERT(first != nullptr);
+        return first->getUser();
+    }
+
+    size_t size() const noexcept
+    {
+        return users_num;
+    }
+
+    bool empty() const noexcept
+    {
+        return users_num == 0;
+    }
+
+  private:
+    Use* first = nullptr;
+    size_t users_num = 0;
+};
 
 class Inst
 {
@@ -25,47 +192,37 @@ class Inst
     virtual ~Inst() = default;
 
     DEFINE_GETTER_SETTER(id, Id, size_t)
+    DEFINE_GETTER_SETTER(dense_id, DenseId, size_t)
+    DEFINE_GETTER_SETTER(order_num, OrderNum, size_t)
     DEFINE_GETTER_SETTER(inst_type, InstType, InstType)
     DEFINE_GETTER_SETTER(linear_num, LinearNum, size_t)
     DEFINE_GETTER_SETTER(live_num, LiveNum, size_t)
     DEFINE_GETTER_SETTER(bb, BB, BasicBlock*)
     DEFINE_GETTER_SETTER(next, Next, Inst*)
     DEFINE_GETTER_SETTER(prev, Prev, Inst*)
-    DEFINE_ARRAY_GETTER(users, Users, std::list<Inst*>&)
-
-    size_t getUsersNum()
-    {
-        return users.size();
-    }
 
-    void addUser(Inst* user)
+    UsersRange getUsers() const noexcept
     {
-        auto it = std::find_if(users.begin(), users.end(),
-                               [user](auto* u) { return u->getId() > user->getId(); });
-        if (it != users.end())
-            users.insert(it, user);
-        else
-            users.push_back(user);
+        return UsersRange{first_use, users_num};
     }
 
-    void removeUser(Inst* user)
+    size_t getUsersNum() const noexcept
     {
-        users.erase(std::find(users.begin(), users.end(), user));
+        return users_num;
     }
 
-    void removeUser(size_t num)
+    bool hasUsers() const noexcept
     {
-        users.erase(
-            std::find_if(users.begin(), users.end(), [num](auto u) { return u->getId() == num; }));
+        return first_use != nullptr;
     }
 
+    // redirect all uses of this to inst, O(users)
     void replaceUsers(Inst* inst)
     {
         ASSERT(inst != nullptr);
         ASSERT(inst != this);
-        for (auto* user : users)
-            user->replaceInput(this, inst);
-        users.clear();
+        while (first_use != nullptr)
+            first_use->set(inst);
     }
 
     bool isBinaryInst()
@@ -93,6 +250,16 @@ class Inst
         return DataType::NoType;
     }
 
+    virtual size_t getInputsNum() const noexcept
+    {
+        return 0;
+    }
+
+    virtual Inst* getInput([[maybe_unused]] size_t num) const
+    {
+        UNREACHABLE();
+    }
+
     virtual void setInput([[maybe_unused]] Inst* input, [[maybe_unused]] size_t num)
     {}
     virtual void swapInputs()
@@ -101,6 +268,9 @@ class Inst
     {}
     virtual void replaceInput([[maybe_unused]] size_t num, [[maybe_unused]] Inst* new_input)
     {}
+    // unlink inst from the users lists of all its inputs
+    virtual void dropInputs()
+    {}
     virtual void dump(std::ostream& out = std::cout) const = 0;
     void dumpUsers(std::ostream& out = std::cout) const;
     bool dominates(Inst* inst) const;
@@ -108,6 +278,10 @@ class Inst
   protected:
     InstType inst_type = InstType::NoneInst;
     size_t id = 0;
+    // compact number inside the graph, index for analyses side tables
+    size_t dense_id = INVALID_DENSE_ID;
+    // position inside the bb, maintained lazily by the bb (see BasicBlock::updateInstOrder)
+    size_t order_num = 0;
 
     size_t linear_num = 0;
     size_t live_num = 0;
@@ -116,48 +290,100 @@ class Inst
     Inst* prev = nullptr;
     Inst* next = nullptr;
 
-    std::list<Inst*> users;
+  private:
+    friend class Use;
+
+    Use* first_use = nullptr;
+    size_t users_num = 0;
 };
 
+void Use::set(Inst* new_value)
+{
+    if (value == new_value)
+        return;
+    unlink();
+    value = new_value;
+    link();
+}
+
+void Use::link()
+{
+    if (value == nullptr)
+        return;
+    next = value->first_use;
+    if (next != nullptr)
+        next->prev = &next;
+    prev = &value->first_use;
+    value->first_use = this;
+    ++value->users_num;
+}
+
+void Use::unlink()
+{
+    if (value == nullptr)
+        return;
+    *prev = next;
+    if (next != nullptr)
+        next->prev = prev;
+    next = nullptr;
+    prev = nullptr;
+    --value->users_num;
+    value = nullptr;
+}
+
 std::string getDataTypeString(DataType type);
 
 template <size_t N = 0>
 class FixedInputsInst : public Inst
 {
   public:
-    using Inst::Inst;
+    explicit FixedInputsInst(size_t id_, InstType inst_type_ = InstType::NoneInst)
+        : Inst(id_, inst_type_)
+    {
+        for (auto& input : inputs)
+            input.setUser(this);
+    }
     virtual ~FixedInputsInst() = default;
 
-    Inst* getInput(size_t num) const
+    size_t getInputsNum() const noexcept override
+    {
+        return N;
+    }
+
+    Inst* getInput(size_t num) const override
     {
         ASSERT(num < N, "too big input number");
-        return inputs[num];
+        return inputs[num].get();
     }
 
     void setInput(Inst* input, size_t num) override
     {
         ASSERT(num < N, "too big input number");
-        inputs[num] = input;
-        input->addUser(this);
+        inputs[num].set(input);
     }
 
     void replaceInput(Inst* old_input, Inst* new_input) override
     {
-        auto it = std::find(inputs.begin(), inputs.end(), old_input);
+        auto it = std::find_if(inputs.begin(), inputs.end(),
+                               [old_input](auto& input) { return input.get() == old_input; });
         ASSERT(it != inputs.end());
-        *it = new_input;
-        new_input->addUser(this);
+        it->set(new_input);
     }
 
     void replaceInput(size_t num, Inst* new_input) override
     {
         ASSERT(num < N, "too big input number");
-        inputs[num] = new_input;
-        new_input->addUser(this);
+        inputs[num].set(new_input);
+    }
+
+    void dropInputs() override
+    {
+        for (auto& input : inputs)
+            input.set(nullptr);
     }
 
   protected:
-    std::array<Inst*, N> inputs;
+    std::array<Use, N> inputs;
 };
 
 class BinaryInst final : public FixedInputsInst<2>
@@ -167,33 +393,33 @@ class BinaryInst final : public FixedInputsInst<2>
                         Inst* right = nullptr)
         : FixedInputsInst(id_, inst_type_)
     {
-        inputs[0] = left;
-        inputs[1] = right;
-        left->addUser(this);
-        right->addUser(this);
+        inputs[0].set(left);
+        inputs[1].set(right);
     }
 
     ~BinaryInst() = default;
 
     DataType getType() const noexcept override
     {
-        DataType data_type = inputs[0]->getType();
+        DataType data_type = inputs[0].get()->getType();
         if (data_type == DataType::NoType)
-            return inputs[1]->getType();
+            return inputs[1].get()->getType();
         return data_type;
     }
 
     void swapInputs() override
     {
-        std::swap(inputs[0], inputs[1]);
+        auto* left = inputs[0].get();
+        inputs[0].set(inputs[1].get());
+        inputs[1].set(left);
     }
 
     void dump(std::ostream& out = std::cout) const override
     {
         out << "\t"
             << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " "
-            << TYPE_NAME[static_cast<uint8_t>(getType())] << " v" << inputs[0]->getId() << ", v"
-            << inputs[1]->getId();
+            << TYPE_NAME[static_cast<uint8_t>(getType())] << " v" << getInput(0)->getId()
+            << ", v" << getInput(1)->getId();
     }
 };
 
@@ -203,22 +429,21 @@ class UnaryInst final : public FixedInputsInst<1>
     explicit UnaryInst(size_t id_, InstType inst_type_ = InstType::NoneInst, Inst* input = nullptr)
         : FixedInputsInst(id_, inst_type_)
     {
-        inputs[0] = input;
-        input->addUser(this);
+        inputs[0].set(input);
     }
 
     ~UnaryInst() = default;
 
     DataType getType() const noexcept override
     {
-        return inputs[0]->getType();
+        return inputs[0].get()->getType();
     }
 
     void dump(std::ostream& out = std::cout) const override
     {
         out << "\t"
             << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " "
-            << TYPE_NAME[static_cast<uint8_t>(getType())] << " v" << inputs[0]->getId();
+            << TYPE_NAME[static_cast<uint8_t>(getType())] << " v" << inputs[0].get()->getId();
     }
 };
 
@@ -247,23 +472,29 @@ class ConstInst final : public Inst
     {}
 
     template <typename T>
-    ConstInst(size_t id_, T value_) : Inst(id_, InstType::Const)
-    {
-        static_assert(getDataType<T>() != DataType::NoType);
+    ConstInst(size_t id_, T value_)
+        : Inst(id_, InstType::Const), data_type(getDataType<T>()), value(toBits(value_))
+    {}
 
-        if constexpr (getDataType<T>() == DataType::i32)
-            value = static_cast<uint64_t>(value_);
-        else if constexpr (getDataType<T>() == DataType::i64)
-            value = value_;
-        else if constexpr (getDataType<T>() == DataType::f32)
-            value = static_cast<uint64_t>(value_);
-        else // f64
-            value = static_cast<uint64_t>(value_);
+    ConstInst(size_t id_, DataType data_type_, uint64_t bits_)
+        : Inst(id_, InstType::Const), data_type(data_type_), value(bits_)
+    {}
 
-        data_type = getDataType<T>();
+    ~ConstInst() = default;
+
+    /**
+     * Bit pattern of the value as it is kept in the instruction:
+     * i32 and f32 occupy low 32 bits, floats are stored bitwise,
+     * so NaNs payloads and -0.0 are preserved.
+     */
+    template <typename T>
+    static uint64_t toBits(T value_)
+    {
+        static_assert(getDataType<T>() != DataType::NoType);
+        return compiler::toBits(value_);
     }
 
-    ~ConstInst() = default;
+    DEFINE_GETTER(value, RawValue, uint64_t)
 
     uint32_t getInt32Value() const
     {
@@ -286,13 +517,13 @@ class ConstInst final : public Inst
     float getFloatValue() const
     {
         ASSERT(data_type == DataType::f32);
-        return static_cast<float>(value);
+        return std::bit_cast<float>(static_cast<uint32_t>(value));
     }
 
     double getDoubleValue() const
     {
         ASSERT(data_type == DataType::f64);
-        return static_cast<double>(value);
+        return std::bit_cast<double>(value);
     }
 
     template <typename T>
@@ -326,12 +557,18 @@ class ConstInst final : public Inst
     {
         out << "\t"
             << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " "
-            << TYPE_NAME[static_cast<uint8_t>(data_type)] << " " << value;
+            << TYPE_NAME[static_cast<uint8_t>(data_type)] << " ";
+        if (data_type == DataType::f32)
+            out << getFloatValue();
+        else if (data_type == DataType::f64)
+            out << getDoubleValue();
+        else
+            out << value;
     }
 
   private:
     DataType data_type = DataType::NoType;
-    uint64_t value;
+    uint64_t value = 0;
 };
 
 class ParamInst final : public Inst
@@ -394,46 +631,68 @@ class CallInst final : public Inst
     explicit CallInst(size_t id_, Graph* g, std::initializer_list<Inst*> args_)
         : Inst(id_, InstType::Call), func(g)
     {
-        args.insert(args.end(), args_.begin(), args_.end());
-        std::for_each(args_.begin(), args_.end(), [this](auto* arg) { arg->addUser(this); });
+        args.reserve(args_.size());
+        for (auto* arg : args_)
+            args.emplace_back(this, arg);
     }
 
     CallInst(size_t id_, Graph* g, std::initializer_list<size_t> args_);
     ~CallInst() = default;
 
-    DEFINE_ARRAY_GETTER(args, Args, std::vector<Inst*>&)
+    DEFINE_ARRAY_GETTER(args, Args, std::vector<Use>&)
     DEFINE_GETTER_SETTER(func, Func, Graph*)
 
+    size_t getInputsNum() const noexcept override
+    {
+        return args.size();
+    }
+
+    Inst* getInput(size_t num) const override
+    {
+        ASSERT(num < args.size(), "too big arg number");
+        return args[num].get();
+    }
+
+    Inst* getArg(size_t num) const
+    {
+        return getInput(num);
+    }
+
     void setInput(Inst* arg, size_t num) override
     {
         ASSERT(num < args.size(), "too big arg number");
-        args[num] = arg;
-        arg->addUser(this);
+        args[num].set(arg);
     }
 
     void insertArg(Inst* arg)
     {
-        args.push_back(arg);
-        arg->addUser(this);
+        args.emplace_back(this, arg);
     }
 
     void replaceInput(Inst* old_arg, Inst* new_arg) override
     {
-        std::replace(args.begin(), args.end(), old_arg, new_arg);
-        new_arg->addUser(this);
+        for (auto& arg : args)
+            if (arg.get() == old_arg)
+                arg.set(new_arg);
+    }
+
+    void replaceInput(size_t num, Inst* new_arg) override
+    {
+        ASSERT(num < args.size(), "too big arg number");
+        args[num].set(new_arg);
     }
 
-    void replaceInput(size_t num, Inst* new_arg)
+    void dropInputs() override
     {
-        args[num] = new_arg;
-        new_arg->addUser(this);
+        for (auto& arg : args)
+            arg.set(nullptr);
     }
 
     DataType getType() const noexcept override
     {
         for (auto&& arg : args)
         {
-            DataType type = arg->getType();
+            DataType type = arg.get()->getType();
             if (type != DataType::NoType)
                 return type;
         }
@@ -443,8 +702,8 @@ class CallInst final : public Inst
     void dump(std::ostream& out = std::cout) const override;
 
   private:
-    Graph* func;
-    std::vector<Inst*> args;
+    Graph* func = nullptr;
+    std::vector<Use> args;
 };
 
 class CastInst final : public FixedInputsInst<1>
@@ -453,15 +712,14 @@ class CastInst final : public FixedInputsInst<1>
     explicit CastInst(size_t id_, Inst* input = nullptr, DataType to_ = DataType::NoType)
         : FixedInputsInst(id_, InstType::Cast), to(to_)
     {
-        inputs[0] = input;
-        input->addUser(this);
+        inputs[0].set(input);
     }
 
     ~CastInst() = default;
 
     DataType getFromType() const noexcept
     {
-        return inputs[0]->getType();
+        return inputs[0].get()->getType();
     }
 
     DEFINE_GETTER_SETTER(to, ToType, DataType)
@@ -475,42 +733,83 @@ class CastInst final : public FixedInputsInst<1>
     {
         out << "\t"
             << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " v"
-            << inputs[0]->getId() << " to " << TYPE_NAME[static_cast<uint8_t>(to)];
+            << inputs[0].get()->getId() << " to " << TYPE_NAME[static_cast<uint8_t>(to)];
     }
 
   private:
     DataType to = DataType::NoType;
 };
 
+/**
+ * Copy of a value from src to dst location, inserted by the register allocation
+ * to connect split intervals and to destruct phis. A swap exchanges two registers contents.
+ * Remat src means the value is recreated by its own instruction (a constant) right in dst.
+ */
 class MovInst final : public FixedInputsInst<1>
 {
   public:
     explicit MovInst(size_t id_, size_t reg = 0, Inst* input = nullptr)
-        : FixedInputsInst(id_, InstType::Mov), reg_num(reg)
+        : MovInst(id_, input, Location{}, Location{LocationType::Register, reg})
+    {}
+
+    MovInst(size_t id_, Inst* input, Location src_, Location dst_, bool swap_ = false)
+        : FixedInputsInst(id_, InstType::Mov), src(src_), dst(dst_), swap(swap_)
     {
-        inputs[0] = input;
-        input->addUser(this);
+        inputs[0].set(input);
     }
 
     ~MovInst() = default;
 
-    DEFINE_GETTER_SETTER(reg_num, RegNum, size_t)
+    DEFINE_GETTER_SETTER(src, Src, Location)
+    DEFINE_GETTER_SETTER(dst, Dst, Location)
+
+    bool isSwap() const noexcept
+    {
+        return swap;
+    }
+
+    size_t getRegNum() const noexcept
+    {
+        return dst.index;
+    }
+
+    void setRegNum(size_t reg) noexcept
+    {
+        dst = Location{LocationType::Register, reg};
+    }
 
     DataType getType() const noexcept override
     {
-        return inputs[0]->getType();
+        return inputs[0].get()->getType();
     }
 
     void dump(std::ostream& out = std::cout) const override
     {
         out << "\t"
             << "v" << id << ". " << OPER_NAME[static_cast<uint8_t>(inst_type)] << " "
-            << TYPE_NAME[static_cast<uint8_t>(getType())] << " r" << reg_num << ", v"
-            << inputs[0]->getId();
+            << TYPE_NAME[static_cast<uint8_t>(getType())] << " ";
+        dumpLocation(out, dst);
+        if (src.type != LocationType::None)
+        {
+            out << (swap ? " <-> " : " <- ");
+            dumpLocation(out, src);
+        }
+        out << ", v" << inputs[0].get()->getId();
     }
 
   private:
-    size_t reg_num = 0;
+    static void dumpLocation(std::ostream& out, Location loc)
+    {
+        if (loc.type == LocationType::Remat)
+            out << "remat";
+        else
+            out << (loc.isStackSlot() ? "s" : "r") << loc.index;
+    }
+
+  private:
+    Location src;
+    Location dst;
+    bool swap = false;
 };
 
 class PhiInst final : public Inst
@@ -524,63 +823,90 @@ class PhiInst final : public Inst
     explicit PhiInst(size_t id_, std::initializer_list<phi_pair_t> inputs_)
         : Inst(id_, InstType::Phi)
     {
+        inputs.reserve(inputs_.size());
+        input_bbs.reserve(inputs_.size());
         for (auto input : inputs_)
-        {
-            inputs.push_back(input);
-            input.first->addUser(this);
-        }
+            addInput(input);
     }
 
     ~PhiInst() = default;
 
-    DEFINE_ARRAY_GETTER(inputs, Inputs, std::vector<phi_pair_t>&)
+    DEFINE_ARRAY_GETTER(input_bbs, InputBBs, std::vector<BasicBlock*>&)
+
+    size_t getInputsNum() const noexcept override
+    {
+        return inputs.size();
+    }
+
+    Inst* getInput(size_t num) const override
+    {
+        ASSERT(num < inputs.size(), "too big input number");
+        return inputs[num].get();
+    }
+
+    BasicBlock* getInputBB(size_t num) const
+    {
+        ASSERT(num < input_bbs.size(), "too big input number");
+        return input_bbs[num];
+    }
 
     void addInput(Inst* inst, BasicBlock* bb)
     {
-        inputs.push_back(std::make_pair(inst, bb));
-        inst->addUser(this);
+        inputs.emplace_back(this, inst);
+        input_bbs.push_back(bb);
     }
 
     void addInput(phi_pair_t pair)
     {
-        inputs.push_back(pair);
-        pair.first->addUser(this);
+        addInput(pair.first, pair.second);
     }
 
     void setInput(Inst* input, size_t num) override
     {
         ASSERT(num < inputs.size(), "too big arg number");
-        inputs[num].first = input;
-        input->addUser(this);
+        inputs[num].set(input);
+    }
+
+    // drop the input coming from a removed CFG edge
+    void removeInput(size_t num)
+    {
+        ASSERT(num < inputs.size(), "too big input number");
+        inputs[num].set(nullptr);
+        inputs.erase(inputs.begin() + num);
+        input_bbs.erase(input_bbs.begin() + num);
     }
 
     void replaceBB(size_t num, BasicBlock* new_bb)
     {
-        ASSERT(num < inputs.size() && "too big input number");
-        inputs[num].second = new_bb;
+        ASSERT(num < input_bbs.size() && "too big input number");
+        input_bbs[num] = new_bb;
     }
 
     void replaceInput(Inst* old_input, Inst* new_input) override
     {
         auto it = std::find_if(inputs.begin(), inputs.end(),
-                               [old_input](auto phi_pair) { return phi_pair.first == old_input; });
+                               [old_input](auto& input) { return input.get() == old_input; });
         ASSERT(it != inputs.end());
-        (*it).first = new_input;
-        new_input->addUser(this);
+        it->set(new_input);
     }
 
     void replaceInput(size_t num, Inst* new_arg) override
     {
         ASSERT(num < inputs.size() && "too big input number");
-        inputs[num].first = new_arg;
-        new_arg->addUser(this);
+        inputs[num].set(new_arg);
+    }
+
+    void dropInputs() override
+    {
+        for (auto& input : inputs)
+            input.set(nullptr);
     }
 
     DataType getType() const noexcept override
     {
         for (auto&& input : inputs)
         {
-            DataType type = input.first->getType();
+            DataType type = input.get()->getType();
             if (type != DataType::NoType)
                 return type;
         }
@@ -590,11 +916,14 @@ class PhiInst final : public Inst
     void dump(std::ostream& out = std::cout) const override;
 
   private:
-    std::vector<phi_pair_t> inputs;
+    // inputs[i] comes from input_bbs[i]
+    std::vector<Use> inputs;
+    std::vector<BasicBlock*> input_bbs;
 };
 
 class RetVoidInst final : public Inst
 {
+  public:
     explicit RetVoidInst(size_t id_) : Inst(id_, InstType::RetVoid)
     {}
 
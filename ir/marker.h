@@ -70,7 +70,7 @@ class MarkerSet final
     }
 
   private:
-    std::array<marker_t, MARKERS_NUM> markers;
+    std::array<marker_t, MARKERS_NUM> markers{};
 };
 
 } // namespace compiler
\ No newline at end of file
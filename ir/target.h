@@ -0,0 +1,144 @@
+#pragma once
+
+#include "const.h"
+#include "utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace compiler
+{
+
+enum class RegClass
+{
+    Int = 0,
+    Float,
+    End
+};
+
+constexpr size_t REG_CLASSES_NUM = static_cast<size_t>(RegClass::End);
+constexpr size_t MAX_REGS_NUM = 64;
+
+using regs_mask_t = uint64_t;
+
+/**
+ * Allocatable registers of one class, indexed by register number
+ */
+struct RegFile
+{
+    std::vector<std::string> names;
+    // registers preserved across calls, bit per register number
+    regs_mask_t callee_saved = 0;
+    // not allocatable register for the move resolution, its number goes after allocatable ones
+    std::string scratch;
+    // calling convention: registers of arguments in their order and of the returned value
+    std::vector<size_t> args = {};
+    size_t ret = INVALID_REG;
+};
+
+/**
+ * Register file of the target machine, register allocators take it from the graph.
+ * Registers go in the order of preference: caller-saved first, they need no save/restore.
+ */
+class Target final
+{
+  public:
+    Target(std::string name_, RegFile int_regs, RegFile float_regs, size_t stack_align_ = 16)
+        : name(name_), stack_align(stack_align_)
+    {
+        reg_files[static_cast<size_t>(RegClass::Int)] = std::move(int_regs);
+        reg_files[static_cast<size_t>(RegClass::Float)] = std::move(float_regs);
+        for (auto& file : reg_files)
+            ASSERT(file.names.size() <= MAX_REGS_NUM, "too many registers in the class");
+    }
+
+    DEFINE_ARRAY_GETTER(name, Name, std::string)
+    // frame size is a multiple of it
+    DEFINE_GETTER(stack_align, StackAlign, size_t)
+
+    size_t getRegsNum(RegClass reg_class) const noexcept
+    {
+        return getRegFile(reg_class).names.size();
+    }
+
+    const std::string& getRegName(RegClass reg_class, size_t reg) const
+    {
+        if (reg == getScratchReg(reg_class))
+            return getRegFile(reg_class).scratch;
+        ASSERT(reg < getRegsNum(reg_class), "incorrect reg number");
+        return getRegFile(reg_class).names[reg];
+    }
+
+    // INVALID_REG if the argument is passed on the stack
+    size_t getArgReg(RegClass reg_class, size_t arg_num) const noexcept
+    {
+        auto& args = getRegFile(reg_class).args;
+        return arg_num < args.size() ? args[arg_num] : INVALID_REG;
+    }
+
+    size_t getRetReg(RegClass reg_class) const noexcept
+    {
+        return getRegFile(reg_class).ret;
+    }
+
+    size_t getScratchReg(RegClass reg_class) const
+    {
+        ASSERT(!getRegFile(reg_class).scratch.empty(), "target has no scratch register");
+        return getRegsNum(reg_class);
+    }
+
+    bool isCalleeSaved(RegClass reg_class, size_t reg) const noexcept
+    {
+        return (getRegFile(reg_class).callee_saved >> reg) & 1;
+    }
+
+    bool isCallerSaved(RegClass reg_class, size_t reg) const noexcept
+    {
+        return !isCalleeSaved(reg_class, reg);
+    }
+
+    const RegFile& getRegFile(RegClass reg_class) const noexcept
+    {
+        return reg_files[static_cast<size_t>(reg_class)];
+    }
+
+    static RegClass getRegClass(DataType type) noexcept
+    {
+        return type == DataType::f32 || type == DataType::f64 ? RegClass::Float : RegClass::Int;
+    }
+
+    /**
+     * x86-64 System V: rsp and rbp are reserved for the frame, r11 and xmm15 are scratch.
+     * Arguments go in rdi, rsi, rdx, rcx, r8, r9 and xmm0-7, results in rax and xmm0
+     */
+    static const Target* getX86_64()
+    {
+        static const Target target(
+            "x86-64",
+            {{"rax", "rcx", "rdx", "rsi", "rdi", "r8", "r9", "r10", "rbx", "r12", "r13", "r14",
+              "r15"},
+             0b11111ULL << 8,
+             "r11",
+             {4, 3, 2, 1, 5, 6},
+             0},
+            {{"xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "xmm8", "xmm9",
+              "xmm10", "xmm11", "xmm12", "xmm13", "xmm14"},
+             0,
+             "xmm15",
+             {0, 1, 2, 3, 4, 5, 6, 7},
+             0});
+        return &target;
+    }
+
+    static const Target* getDefault()
+    {
+        return getX86_64();
+    }
+
+  private:
+    std::string name;
+    size_t stack_align = 16;
+    RegFile reg_files[REG_CLASSES_NUM];
+};
+
+} // namespace compiler
\ No newline at end of file
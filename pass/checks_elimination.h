@@ -2,15 +2,18 @@
 
 #include "ir/graph.h"
 #include "pass.h"
-#include "visitor.h"
 
 namespace compiler
 {
 
-class ChecksElimination final : public Optimization, public Visitor
+/**
+ * Removes ZeroCheck and BoundsCheck dominated by the same check of the same values.
+ * It is Gvn restricted to checks, so the checks are found by hash in one dominator tree walk.
+ */
+class ChecksElimination final : public Optimization
 {
   public:
-    explicit ChecksElimination(Graph* g) : Optimization(g), Visitor()
+    explicit ChecksElimination(Graph* g) : Optimization(g)
     {}
 
     ~ChecksElimination() override = default;
@@ -22,9 +25,11 @@ class ChecksElimination final : public Optimization, public Visitor
         return "ChecksElimination";
     }
 
-  private:
-    void visitZeroCheck([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitBoundsCheck([[maybe_unused]] Visitor* v, Inst* inst) override;
+    // removes checks only
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
 };
 
 } // namespace compiler
\ No newline at end of file
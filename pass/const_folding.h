@@ -2,15 +2,18 @@
 
 #include "ir/graph.h"
 #include "pass.h"
-#include "visitor.h"
 
 namespace compiler
 {
 
-class ConstFolding final : public Optimization, public Visitor
+/**
+ * Kept for the pipelines which name it: the folding is done by Sccp, which also folds
+ * through phis and decided branches, so there is a single folding pass to maintain.
+ */
+class ConstFolding final : public Optimization
 {
   public:
-    explicit ConstFolding(Graph* g) : Optimization(g), Visitor()
+    explicit ConstFolding(Graph* g) : Optimization(g)
     {}
 
     ~ConstFolding() override = default;
@@ -22,20 +25,11 @@ class ConstFolding final : public Optimization, public Visitor
         return "ConstFolding";
     }
 
-  private:
-    void visitAdd([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitSub([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitMul([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitDiv([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitMod([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitShl([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitShr([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitAShr([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitAnd([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitOr([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitXor([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitNot([[maybe_unused]] Visitor* v, Inst* inst) override;
-    void visitNeg([[maybe_unused]] Visitor* v, Inst* inst) override;
+    // the same as Sccp: removed edges and blocks change the CFG version
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
 };
 
 } // namespace compiler
\ No newline at end of file
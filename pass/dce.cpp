@@ -30,6 +30,7 @@ bool Dce::runPassImpl()
                 inst = inst->getNext();
         }
     }
+    graph->renumberDenseIds();
     return true;
 }
 
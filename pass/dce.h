@@ -23,6 +23,12 @@ class Dce final : public Optimization
         return "Dce";
     }
 
+    // removes instructions only
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
+
   private:
     bool isDceAppliable(Inst* inst);
 };
@@ -6,52 +6,163 @@ namespace compiler
 
 void DomTree::invalidateAnalysis()
 {
-    for (auto* bb : bbs)
-        bb->getDominators().clear();
+    for (auto* bb : graph->getBBs())
+        bb->resetDomInfo();
+    Analysis::invalidateAnalysis();
 }
 
-auto DomTree::getUnreachedBBs(std::vector<BasicBlock*>& reached)
+/**
+ * Number blocks reachable from the start block in DFS preorder
+ * and remember the parent of each block in the DFS spanning tree
+ */
+void DomTree::numberBBs()
 {
-    std::vector<BasicBlock*> unreached;
-    for (auto* bb : bbs)
-        if (std::find_if(reached.begin(), reached.end(), [bb](auto* elem) { return bb == elem; }) ==
-            reached.end())
+    auto* start_bb = graph->getFirstBB();
+    ASSERT(stack.empty());
+
+    auto visit = [this](BasicBlock* bb, size_t parent_num) {
+        dfs_num[bb] = bbs.size();
+        bbs.push_back(bb);
+        parent.push_back(parent_num);
+        stack.emplace_back(bb, 0);
+    };
+
+    visit(start_bb, NO_NUM);
+    while (!stack.empty())
+    {
+        auto& [bb, succ_idx] = stack.back();
+        if (succ_idx == 2)
         {
-            // if bb was not found in reached array -> it is unreached
-            unreached.push_back(bb);
+            stack.pop_back();
+            continue;
         }
+        auto* succ = succ_idx++ == 0 ? bb->getTrueSucc() : bb->getFalseSucc();
+        if (succ != nullptr && dfs_num.get(succ) == NO_NUM)
+            visit(succ, dfs_num[bb]);
+    }
+}
 
-    return unreached;
+/**
+ * Path compression in the forest built by the semidominators calculation:
+ * after it label[num] is the vertex with the minimal semi on the path to the forest root
+ */
+void DomTree::compress(size_t num)
+{
+    path.clear();
+    for (auto cur = num; ancestor[ancestor[cur]] != NO_NUM; cur = ancestor[cur])
+        path.push_back(cur);
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+    {
+        auto cur = *it;
+        auto anc = ancestor[cur];
+        if (semi[label[anc]] < semi[label[cur]])
+            label[cur] = label[anc];
+        ancestor[cur] = ancestor[anc];
+    }
 }
 
-bool DomTree::runPassImpl()
+size_t DomTree::eval(size_t num)
 {
-    ASSERT(graph != nullptr, "nullptr graph in domtree pass");
+    if (ancestor[num] == NO_NUM)
+        return num;
+    compress(num);
+    return label[num];
+}
 
-    marker_t visited = graph->getNewMarker();
-    graph->runPass<Rpo>();
-    bbs = graph->getRpoBBs();
-    ASSERT(bbs.size() > 0, "empty graph in DomTree");
+void DomTree::countSemiDominators()
+{
+    size_t size = bbs.size();
+    semi.resize(size);
+    label.resize(size);
+    ancestor.assign(size, NO_NUM);
+    for (size_t num = 0; num < size; ++num)
+        semi[num] = label[num] = num;
 
-    for (auto* bb : bbs)
+    for (size_t num = size - 1; num > 0; --num)
     {
-        bb->setMarker(visited);
+        for (auto* pred : bbs[num]->getPreds())
+        {
+            auto pred_num = dfs_num.get(pred);
+            // skip unreachable predecessors
+            if (pred_num == NO_NUM)
+                continue;
+            auto min_num = eval(pred_num);
+            if (semi[min_num] < semi[num])
+                semi[num] = semi[min_num];
+        }
+        // link bb to the forest
+        ancestor[num] = parent[num];
+    }
+}
 
-        graph->runPass<Rpo>(visited);
-        auto reached_bbs = graph->getRpoBBs();
-        auto unreached_bbs = getUnreachedBBs(reached_bbs);
+/**
+ * idom is the nearest common ancestor of the DFS parent and the semidominator,
+ * parents are processed before their children in preorder
+ */
+void DomTree::countIdoms()
+{
+    size_t size = bbs.size();
+    idom.resize(size);
+    idom[0] = 0;
+    for (size_t num = 1; num < size; ++num)
+    {
+        auto cur_idom = parent[num];
+        while (cur_idom > semi[num])
+            cur_idom = idom[cur_idom];
+        idom[num] = cur_idom;
+    }
 
-        for (auto unreached : unreached_bbs)
-            unreached->addDominator(bb);
+    bbs[0]->setIdom(bbs[0]);
+    for (size_t num = 1; num < size; ++num)
+    {
+        auto* idom_bb = bbs[idom[num]];
+        bbs[num]->setIdom(idom_bb);
+        idom_bb->addDomChild(bbs[num]);
+    }
+}
 
-        bb->resetMarker(visited);
+/**
+ * a dominates b <=> pre(a) <= pre(b) && post(b) <= post(a)
+ */
+void DomTree::numberDomTree()
+{
+    size_t num = 0;
+    ASSERT(stack.empty());
+    bbs[0]->setDomPre(num++);
+    stack.emplace_back(bbs[0], 0);
+    while (!stack.empty())
+    {
+        auto& [bb, child_idx] = stack.back();
+        auto& children = bb->getDomChildren();
+        if (child_idx == children.size())
+        {
+            bb->setDomPost(num++);
+            stack.pop_back();
+            continue;
+        }
+        auto* child = children[child_idx++];
+        child->setDomPre(num++);
+        stack.emplace_back(child, 0);
     }
+}
+
+bool DomTree::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in domtree pass");
+    ASSERT(graph->size() > 0, "empty graph in DomTree");
 
-    for (auto* bb : bbs)
-        bb->countIdom();
+    invalidateAnalysis();
+    bbs.clear();
+    parent.clear();
+    dfs_num.clear();
+    dfs_num.resize(graph->getBBsDenseNum());
+    numberBBs();
+    countSemiDominators();
+    countIdoms();
+    numberDomTree();
 
     graph->runPass<Rpo>();
-    graph->deleteMarker(visited);
     return true;
 }
 
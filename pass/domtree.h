@@ -8,6 +8,12 @@ namespace compiler
 
 class BasicBlock;
 
+/**
+ * Dominator tree construction with Lengauer-Tarjan semidominators
+ * and idoms found as nearest common ancestors in the DFS tree (SEMI-NCA).
+ * Result: idom and dominator tree children of every reachable block
+ * and DFS entry/exit numbers in the tree for O(1) dominance checks.
+ */
 class DomTree final : public Analysis
 {
   public:
@@ -25,10 +31,28 @@ class DomTree final : public Analysis
     void invalidateAnalysis() override;
 
   private:
-    auto getUnreachedBBs(std::vector<BasicBlock*>& reached);
+    static constexpr size_t NO_NUM = static_cast<size_t>(-1);
+
+    void numberBBs();
+    void countSemiDominators();
+    void countIdoms();
+    void numberDomTree();
+    size_t eval(size_t num);
+    void compress(size_t num);
 
   private:
+    // all vectors below are indexed by bb number in DFS preorder
     std::vector<BasicBlock*> bbs;
+    std::vector<size_t> parent;
+    std::vector<size_t> semi;
+    std::vector<size_t> idom;
+    std::vector<size_t> ancestor;
+    std::vector<size_t> label;
+    // scratch of compress(), kept to not allocate on every call and rerun
+    std::vector<size_t> path;
+    // indexed by bb dense id
+    IdVector<size_t> dfs_num{NO_NUM};
+    bb_stack_t stack;
 };
 
 } // namespace compiler
\ No newline at end of file
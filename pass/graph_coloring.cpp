@@ -0,0 +1,546 @@
+#include "graph_coloring.h"
+#include "loop_analysis.h"
+#include "reg_alloc.h"
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace compiler
+{
+
+bool GraphColoringAllocation::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in GraphColoringAllocation pass");
+
+    bool liveness = graph->runPass<LivenessAnalysis>();
+    if (!liveness)
+        return false;
+
+    cur_spill_slot = 0;
+    spill_slots.clear();
+    spill_slots.resize(graph->getInstsDenseNum());
+    calcBlocksLoopDepth();
+    calcRegAllocHints(graph);
+    for (size_t i = 0; i < REG_CLASSES_NUM; ++i)
+        allocateClass(static_cast<RegClass>(i));
+    graph->setRegAllocStats(countSpillCode(graph));
+    return resolveRegAlloc(graph);
+}
+
+void GraphColoringAllocation::calcBlocksLoopDepth()
+{
+    bb_starts.clear();
+    bb_depths.clear();
+    for (auto* bb : graph->getLinearOrderBBs())
+    {
+        bb_starts.push_back(bb->getLiveInterval()->getIntervalStart());
+        auto* loop = bb->getLoop();
+        bb_depths.push_back(loop != nullptr ? loop->getDepth() : 0);
+    }
+}
+
+// estimated execution count of the position: 10 per loop level
+double GraphColoringAllocation::getWeight(size_t pos) const
+{
+    auto idx = std::upper_bound(bb_starts.begin(), bb_starts.end(), pos) - bb_starts.begin();
+    return std::pow(10.0, static_cast<double>(bb_depths[idx - 1]));
+}
+
+void GraphColoringAllocation::allocateClass(RegClass reg_class)
+{
+    regs_num = graph->getTarget()->getRegsNum(reg_class);
+    if (regs_num == 0)
+    {
+        for (auto* live_int : graph->getLiveIntervals())
+            if (live_int != nullptr && !live_int->isEmpty() &&
+                Target::getRegClass(live_int->getInst()->getType()) == reg_class)
+                setSpillLocation(live_int);
+        return;
+    }
+
+    while (true)
+    {
+        collectNodes(reg_class);
+        if (nodes.empty())
+            return;
+
+        build();
+        makeWorklist();
+        while (true)
+        {
+            if (!simplify_worklist.empty())
+                simplify();
+            else if (!worklist_moves.empty())
+                coalesce();
+            else if (!freeze_worklist.empty())
+                freeze();
+            else if (!spill_worklist.empty())
+                selectSpill();
+            else
+                break;
+        }
+        assignColors();
+        if (spilled_nodes.empty())
+            return;
+
+        // spilled values leave only parts around their uses, the graph is built again
+        for (auto node : spilled_nodes)
+            spillValue(nodes[node]);
+    }
+}
+
+/**
+ * Nodes are parts needing a register: whole values and parts of spilled values around uses
+ */
+void GraphColoringAllocation::collectNodes(RegClass reg_class)
+{
+    nodes.clear();
+    value_nodes.clear();
+    value_nodes.resize(graph->getInstsDenseNum());
+    for (auto* live_int : graph->getLiveIntervals())
+    {
+        if (live_int == nullptr || live_int->isEmpty() ||
+            Target::getRegClass(live_int->getInst()->getType()) != reg_class)
+            continue;
+        auto& children = live_int->getSplitChildren();
+        if (children.empty() && !live_int->isStackSlot() && !live_int->isRematerialized())
+            value_nodes[live_int->getInst()] = nodes.size();
+
+        if (!live_int->isStackSlot() && !live_int->isRematerialized())
+            nodes.push_back(live_int);
+        for (auto* part : children)
+            if (!part->isStackSlot() && !part->isRematerialized())
+                nodes.push_back(part);
+    }
+}
+
+void GraphColoringAllocation::build()
+{
+    auto nodes_num = nodes.size();
+    states.assign(nodes_num, NodeState::Simplify);
+    degrees.assign(nodes_num, 0);
+    aliases.resize(nodes_num);
+    std::iota(aliases.begin(), aliases.end(), 0);
+    colors.assign(nodes_num, INVALID_REG);
+    hint_regs.resize(nodes_num);
+    spill_costs.resize(nodes_num);
+    adj_lists.assign(nodes_num, {});
+    adj_matrix.assign(nodes_num, BitVector(nodes_num));
+    move_lists.assign(nodes_num, {});
+    moves.clear();
+    for (size_t i = 0; i < nodes_num; ++i)
+    {
+        hint_regs[i] = nodes[i]->getSplitParent()->getHintReg();
+        spill_costs[i] = calcSpillCost(nodes[i]);
+    }
+
+    // sweep by starts: an interval may intersect only the ones not ended yet
+    std::vector<size_t> order(nodes_num);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t left, size_t right) {
+        return nodes[left]->getIntervalStart() < nodes[right]->getIntervalStart();
+    });
+    std::vector<size_t> live;
+    for (auto node : order)
+    {
+        auto start = nodes[node]->getIntervalStart();
+        std::erase_if(live, [this, start](size_t other) {
+            return nodes[other]->getIntervalEnd() <= start;
+        });
+        for (auto other : live)
+            if (nodes[node]->intersects(nodes[other]))
+                addEdge(node, other);
+        live.push_back(node);
+    }
+
+    for (auto* bb : graph->getLinearOrderBBs())
+    {
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        {
+            auto* phi_inst = static_cast<PhiInst*>(phi);
+            for (size_t i = 0, size = phi_inst->getInputsNum(); i < size; ++i)
+            {
+                auto pred_end = phi_inst->getInputBB(i)->getLiveInterval()->getIntervalEnd();
+                addMove(phi_inst->getInput(i), phi, getWeight(pred_end - 1));
+            }
+        }
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+            if (inst->getInstType() == InstType::Mov)
+                addMove(inst->getInput(0), inst, getWeight(inst->getLiveNum()));
+    }
+}
+
+void GraphColoringAllocation::addEdge(size_t u, size_t v)
+{
+    if (u == v || adj_matrix[u].test(v))
+        return;
+    adj_matrix[u].set(v);
+    adj_matrix[v].set(u);
+    adj_lists[u].push_back(v);
+    adj_lists[v].push_back(u);
+    ++degrees[u];
+    ++degrees[v];
+}
+
+void GraphColoringAllocation::addMove(Inst* src, Inst* dst, double weight)
+{
+    auto src_node = value_nodes.get(src);
+    auto dst_node = value_nodes.get(dst);
+    if (src_node == INVALID_NODE || dst_node == INVALID_NODE || src_node == dst_node)
+        return;
+    move_lists[src_node].push_back(moves.size());
+    move_lists[dst_node].push_back(moves.size());
+    moves.push_back({src_node, dst_node, weight});
+}
+
+/**
+ * Weighted number of memory accesses added if the part is spilled. A value is stored at the
+ * definition and loaded in every block with uses, constants are only recreated.
+ * A part over uses in one block would be split to a load per use, a part of one use
+ * can't be spilled again.
+ */
+double GraphColoringAllocation::calcSpillCost(LiveInterval* live_int) const
+{
+    auto& uses = live_int->getUsePositions();
+    if (live_int->getSplitParent() != live_int || !live_int->getSplitChildren().empty())
+    {
+        if (uses.size() <= 1)
+            return std::numeric_limits<double>::infinity();
+        return getWeight(uses.front() - 1) * static_cast<double>(uses.size() - 1);
+    }
+
+    double cost = 0;
+    auto* inst = live_int->getInst();
+    if (!isRematerializable(inst) && inst->getInstType() != InstType::Phi)
+        cost += getWeight(live_int->getIntervalStart());
+    for (auto use : uses)
+        cost += getWeight(use - 1);
+    return cost;
+}
+
+void GraphColoringAllocation::makeWorklist()
+{
+    simplify_worklist.clear();
+    freeze_worklist.clear();
+    spill_worklist.clear();
+    select_stack.clear();
+    spilled_nodes.clear();
+    for (size_t node = 0, size = nodes.size(); node < size; ++node)
+    {
+        if (degrees[node] >= regs_num)
+            pushNode(node, NodeState::Spill);
+        else if (isMoveRelated(node))
+            pushNode(node, NodeState::Freeze);
+        else
+            pushNode(node, NodeState::Simplify);
+    }
+
+    // the most frequent moves are coalesced first
+    worklist_moves.resize(moves.size());
+    std::iota(worklist_moves.begin(), worklist_moves.end(), 0);
+    std::stable_sort(worklist_moves.begin(), worklist_moves.end(),
+                     [this](size_t left, size_t right) {
+                         return moves[left].weight < moves[right].weight;
+                     });
+}
+
+void GraphColoringAllocation::simplify()
+{
+    auto node = simplify_worklist.back();
+    simplify_worklist.pop_back();
+    if (states[node] != NodeState::Simplify)
+        return;
+    states[node] = NodeState::Selected;
+    select_stack.push_back(node);
+    forEachAdjacent(node, [this](size_t adj) { decrementDegree(adj); });
+}
+
+void GraphColoringAllocation::coalesce()
+{
+    auto& move = moves[worklist_moves.back()];
+    worklist_moves.pop_back();
+    if (move.state != MoveState::Worklist)
+        return;
+
+    auto u = getAlias(move.src);
+    auto v = getAlias(move.dst);
+    if (u == v)
+    {
+        move.state = MoveState::Coalesced;
+        addWorkList(u);
+    }
+    else if (adj_matrix[u].test(v))
+    {
+        move.state = MoveState::Constrained;
+        addWorkList(u);
+        addWorkList(v);
+    }
+    else if (isConservative(u, v))
+    {
+        move.state = MoveState::Coalesced;
+        combine(u, v);
+        addWorkList(u);
+    }
+    else
+        move.state = MoveState::Active;
+}
+
+void GraphColoringAllocation::freeze()
+{
+    auto node = freeze_worklist.back();
+    freeze_worklist.pop_back();
+    if (states[node] != NodeState::Freeze)
+        return;
+    pushNode(node, NodeState::Simplify);
+    freezeMoves(node);
+}
+
+void GraphColoringAllocation::selectSpill()
+{
+    // the cheapest spill that unblocks the most neighbours
+    auto best = INVALID_NODE;
+    auto best_cost = std::numeric_limits<double>::infinity();
+    std::erase_if(spill_worklist,
+                  [this](size_t node) { return states[node] != NodeState::Spill; });
+    for (auto node : spill_worklist)
+    {
+        auto cost = spill_costs[node] / static_cast<double>(degrees[node]);
+        if (best == INVALID_NODE || cost < best_cost)
+        {
+            best = node;
+            best_cost = cost;
+        }
+    }
+    if (best == INVALID_NODE)
+        return;
+    pushNode(best, NodeState::Simplify);
+    freezeMoves(best);
+}
+
+void GraphColoringAllocation::assignColors()
+{
+    std::vector<bool> free_colors(regs_num);
+    while (!select_stack.empty())
+    {
+        auto node = select_stack.back();
+        select_stack.pop_back();
+        std::fill(free_colors.begin(), free_colors.end(), true);
+        for (auto adj : adj_lists[node])
+        {
+            auto alias = getAlias(adj);
+            if (states[alias] == NodeState::Colored)
+                free_colors[colors[alias]] = false;
+        }
+
+        // fixed register of the node, then the color of a move partner, then the first free
+        auto color = hint_regs[node];
+        if (color >= regs_num || !free_colors[color])
+        {
+            color = INVALID_REG;
+            for (auto idx : move_lists[node])
+            {
+                auto other = getAlias(moves[idx].src);
+                if (other == node)
+                    other = getAlias(moves[idx].dst);
+                if (states[other] == NodeState::Colored && free_colors[colors[other]])
+                {
+                    color = colors[other];
+                    break;
+                }
+            }
+        }
+        if (color == INVALID_REG)
+            color = static_cast<size_t>(std::find(free_colors.begin(), free_colors.end(), true) -
+                                        free_colors.begin());
+        if (color == regs_num)
+        {
+            ASSERT(std::isfinite(spill_costs[node]),
+                   "not enough registers for operands of an instruction");
+            states[node] = NodeState::Spilled;
+            spilled_nodes.push_back(node);
+            continue;
+        }
+        states[node] = NodeState::Colored;
+        colors[node] = color;
+    }
+
+    for (size_t node = 0, size = nodes.size(); node < size; ++node)
+    {
+        if (states[node] == NodeState::Coalesced)
+        {
+            auto alias = getAlias(node);
+            if (states[alias] == NodeState::Spilled)
+            {
+                spilled_nodes.push_back(node);
+                continue;
+            }
+            colors[node] = colors[alias];
+        }
+        if (colors[node] != INVALID_REG)
+            nodes[node]->setRegister(colors[node]);
+    }
+}
+
+template <typename Callback>
+void GraphColoringAllocation::forEachAdjacent(size_t node, Callback callback) const
+{
+    for (auto adj : adj_lists[node])
+        if (states[adj] != NodeState::Selected && states[adj] != NodeState::Coalesced)
+            callback(adj);
+}
+
+bool GraphColoringAllocation::isMoveRelated(size_t node) const
+{
+    return std::any_of(move_lists[node].begin(), move_lists[node].end(), [this](size_t idx) {
+        return moves[idx].state == MoveState::Active || moves[idx].state == MoveState::Worklist;
+    });
+}
+
+void GraphColoringAllocation::decrementDegree(size_t node)
+{
+    auto degree = degrees[node]--;
+    if (degree != regs_num || states[node] != NodeState::Spill)
+        return;
+    enableMoves(node);
+    forEachAdjacent(node, [this](size_t adj) { enableMoves(adj); });
+    pushNode(node, isMoveRelated(node) ? NodeState::Freeze : NodeState::Simplify);
+}
+
+void GraphColoringAllocation::enableMoves(size_t node)
+{
+    for (auto idx : move_lists[node])
+    {
+        if (moves[idx].state == MoveState::Active)
+        {
+            moves[idx].state = MoveState::Worklist;
+            worklist_moves.push_back(idx);
+        }
+    }
+}
+
+void GraphColoringAllocation::addWorkList(size_t node)
+{
+    if (states[node] == NodeState::Freeze && !isMoveRelated(node) && degrees[node] < regs_num)
+        pushNode(node, NodeState::Simplify);
+}
+
+// Briggs: the merged node has less than K neighbours of significant degree
+bool GraphColoringAllocation::isConservative(size_t u, size_t v) const
+{
+    size_t significant = 0;
+    forEachAdjacent(u, [this, &significant](size_t adj) {
+        significant += degrees[adj] >= regs_num;
+    });
+    forEachAdjacent(v, [this, u, &significant](size_t adj) {
+        significant += degrees[adj] >= regs_num && !adj_matrix[u].test(adj);
+    });
+    return significant < regs_num;
+}
+
+void GraphColoringAllocation::combine(size_t u, size_t v)
+{
+    states[v] = NodeState::Coalesced;
+    aliases[v] = u;
+    move_lists[u].insert(move_lists[u].end(), move_lists[v].begin(), move_lists[v].end());
+    enableMoves(v);
+    spill_costs[u] += spill_costs[v];
+    if (hint_regs[u] == INVALID_REG)
+        hint_regs[u] = hint_regs[v];
+    forEachAdjacent(v, [this, u](size_t adj) {
+        addEdge(adj, u);
+        decrementDegree(adj);
+    });
+    if (degrees[u] >= regs_num && states[u] == NodeState::Freeze)
+        pushNode(u, NodeState::Spill);
+}
+
+void GraphColoringAllocation::freezeMoves(size_t node)
+{
+    for (auto idx : move_lists[node])
+    {
+        auto& move = moves[idx];
+        if (move.state != MoveState::Active && move.state != MoveState::Worklist)
+            continue;
+        move.state = MoveState::Frozen;
+        auto other = getAlias(move.src);
+        if (other == getAlias(node))
+            other = getAlias(move.dst);
+        if (states[other] == NodeState::Freeze && !isMoveRelated(other) &&
+            degrees[other] < regs_num)
+            pushNode(other, NodeState::Simplify);
+    }
+}
+
+size_t GraphColoringAllocation::getAlias(size_t node) const
+{
+    while (states[node] == NodeState::Coalesced)
+        node = aliases[node];
+    return node;
+}
+
+void GraphColoringAllocation::pushNode(size_t node, NodeState state)
+{
+    states[node] = state;
+    if (state == NodeState::Simplify)
+        simplify_worklist.push_back(node);
+    else if (state == NodeState::Freeze)
+        freeze_worklist.push_back(node);
+    else if (state == NodeState::Spill)
+        spill_worklist.push_back(node);
+}
+
+/**
+ * A spilled value gets registers only around its uses in every block, it is defined right
+ * in its stack slot. A spilled part over uses in one block is split to parts around every use,
+ * so at most operands of one inst need registers at a time. Split positions are between insts
+ * as in the linear scan. Other parts are on the stack or rematerialized.
+ */
+void GraphColoringAllocation::spillValue(LiveInterval* live_int)
+{
+    bool whole = live_int->getSplitParent() == live_int && live_int->getSplitChildren().empty();
+    auto get_bb_idx = [this](size_t pos) {
+        return std::upper_bound(bb_starts.begin(), bb_starts.end(), pos) - bb_starts.begin();
+    };
+    std::vector<LiveRange> windows;
+    for (auto use : live_int->getUsePositions())
+    {
+        if (whole && !windows.empty() && get_bb_idx(windows.back().start) == get_bb_idx(use - 1))
+            windows.back().end = use + 1;
+        else
+            windows.push_back({use - 1, use + 1});
+    }
+
+    auto split = [this](LiveInterval* part, size_t pos) {
+        auto* child = graph->create<LiveInterval>();
+        part->split(pos, child);
+        return child;
+    };
+    auto* part = live_int;
+    for (const auto& window : windows)
+    {
+        if (part->getIntervalStart() < window.start)
+        {
+            setSpillLocation(part);
+            part = split(part, window.start);
+        }
+        if (window.end >= part->getIntervalEnd())
+            return;
+        part = split(part, window.end);
+    }
+    setSpillLocation(part);
+}
+
+void GraphColoringAllocation::setSpillLocation(LiveInterval* live_int)
+{
+    if (isRematerializable(live_int->getInst()))
+    {
+        live_int->setRematerialized();
+        return;
+    }
+    auto& slot = spill_slots[live_int->getInst()];
+    if (slot == INVALID_REG)
+        slot = cur_spill_slot++;
+    live_int->setSpillSlot(slot);
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "ir/bit_vector.h"
+#include "ir/graph.h"
+#include "liveness.h"
+#include "pass.h"
+#include <limits>
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Iterated register coalescing (George, Appel 1996) over the target register file, every
+ * register class is allocated independently. Nodes of the interference graph are live
+ * intervals, two of them interfere if their live ranges intersect; moves are phis inputs
+ * and movs. Nodes connected by a move are coalesced by the Briggs test, so the move is free.
+ * Spill candidates have the lowest cost per degree: uses and definitions weighted by 10 to
+ * the loop depth (constants are only recreated at uses). A spilled value stays on the stack
+ * (or is rematerialized) except parts around its uses in every block, they need registers
+ * and the graph is rebuilt until everything is colored; such a part may be spilled again
+ * to parts around single uses.
+ * Colors prefer the fixed registers of the calling convention and colors of move partners.
+ * Slower than linear scan, it is chosen for a graph by RegAllocKind::GraphColoring,
+ * the result is resolved by the same passes.
+ */
+class GraphColoringAllocation final : public Optimization
+{
+  public:
+    explicit GraphColoringAllocation(Graph* g)
+        : Optimization(g), spill_slots(INVALID_REG), value_nodes(INVALID_NODE)
+    {}
+
+    ~GraphColoringAllocation() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "GraphColoringAllocation";
+    }
+
+    // live intervals are split, so liveness has to be rebuilt for the next allocation
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return ALL_ANALYSES & ~makeAnalysesMask<LivenessAnalysis>();
+    }
+
+  private:
+    static constexpr size_t INVALID_NODE = std::numeric_limits<size_t>::max();
+
+    enum class NodeState : uint8_t
+    {
+        Simplify,
+        Freeze,
+        Spill,
+        Coalesced,
+        Selected,
+        Colored,
+        Spilled
+    };
+
+    enum class MoveState : uint8_t
+    {
+        Worklist,
+        Active,
+        Coalesced,
+        Constrained,
+        Frozen
+    };
+
+    struct Move
+    {
+        size_t src = 0;
+        size_t dst = 0;
+        double weight = 0;
+        MoveState state = MoveState::Worklist;
+    };
+
+    void calcBlocksLoopDepth();
+    double getWeight(size_t pos) const;
+    void allocateClass(RegClass reg_class);
+    void collectNodes(RegClass reg_class);
+
+    void build();
+    void addEdge(size_t u, size_t v);
+    void addMove(Inst* src, Inst* dst, double weight);
+    double calcSpillCost(LiveInterval* live_int) const;
+    void makeWorklist();
+
+    void simplify();
+    void coalesce();
+    void freeze();
+    void selectSpill();
+    void assignColors();
+
+    template <typename Callback>
+    void forEachAdjacent(size_t node, Callback callback) const;
+    bool isMoveRelated(size_t node) const;
+    void decrementDegree(size_t node);
+    void enableMoves(size_t node);
+    void addWorkList(size_t node);
+    bool isConservative(size_t u, size_t v) const;
+    void combine(size_t u, size_t v);
+    void freezeMoves(size_t node);
+    size_t getAlias(size_t node) const;
+    void pushNode(size_t node, NodeState state);
+
+    void spillValue(LiveInterval* live_int);
+    void setSpillLocation(LiveInterval* live_int);
+
+  private:
+    size_t regs_num = 0;
+    size_t cur_spill_slot = 0;
+    // one slot per value, indexed by inst dense id
+    IdVector<size_t> spill_slots;
+    // node of a not split value, indexed by inst dense id
+    IdVector<size_t> value_nodes;
+
+    std::vector<LiveInterval*> nodes;
+    std::vector<NodeState> states;
+    std::vector<size_t> degrees;
+    std::vector<size_t> aliases;
+    std::vector<size_t> colors;
+    std::vector<size_t> hint_regs;
+    std::vector<double> spill_costs;
+    std::vector<std::vector<size_t>> adj_lists;
+    std::vector<BitVector> adj_matrix;
+    std::vector<std::vector<size_t>> move_lists;
+    std::vector<Move> moves;
+
+    // worklists keep stale entries, a node is taken if it is still in the list state
+    std::vector<size_t> simplify_worklist;
+    std::vector<size_t> freeze_worklist;
+    std::vector<size_t> spill_worklist;
+    std::vector<size_t> worklist_moves;
+    std::vector<size_t> select_stack;
+    std::vector<size_t> spilled_nodes;
+
+    // linear order block starts and loop depths, to weight uses
+    std::vector<size_t> bb_starts;
+    std::vector<size_t> bb_depths;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "gvn.h"
+#include "domtree.h"
+
+namespace compiler
+{
+
+namespace
+{
+
+bool isCommutative(InstType type)
+{
+    return type == InstType::Add || type == InstType::Mul || type == InstType::And ||
+           type == InstType::Or || type == InstType::Xor;
+}
+
+bool isCheck(InstType type)
+{
+    return type == InstType::ZeroCheck || type == InstType::BoundsCheck;
+}
+
+} // namespace
+
+bool Gvn::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in Gvn pass");
+    auto* first_bb = graph->getFirstBB();
+    if (first_bb == nullptr)
+        return true;
+
+    bool domtree = graph->runPass<DomTree>();
+    if (!domtree)
+        return false;
+
+    table.clear();
+    scope_keys.clear();
+    scope_sizes.clear();
+    stack.clear();
+
+    // iterative DFS over the dominator tree: a block sees the values of its dominators only,
+    // the values added in a subtree are erased when the walk goes back
+    visitBlock(first_bb);
+    while (!stack.empty())
+    {
+        auto& [bb, child_idx] = stack.back();
+        auto& children = bb->getDomChildren();
+        if (child_idx < children.size())
+        {
+            visitBlock(children[child_idx++]);
+            continue;
+        }
+
+        for (size_t size = scope_sizes.back(); scope_keys.size() > size; scope_keys.pop_back())
+            table.erase(scope_keys.back());
+        scope_sizes.pop_back();
+        stack.pop_back();
+    }
+    return true;
+}
+
+bool Gvn::isNumbered(Inst* inst) const
+{
+    auto type = inst->getInstType();
+    if (checks_only || isCheck(type))
+        return isCheck(type);
+    return (inst->isBinaryInst() && type != InstType::Cmp) || type == InstType::Not ||
+           type == InstType::Neg || type == InstType::Cast;
+}
+
+ValueKey Gvn::makeKey(Inst* inst) const
+{
+    auto type = inst->getInstType();
+    ValueKey key{type, inst->getType(), {inst->getInput(0), nullptr}};
+    if (inst->getInputsNum() == 2)
+    {
+        key.inputs[1] = inst->getInput(1);
+        if (isCommutative(type) && key.inputs[1]->getDenseId() < key.inputs[0]->getDenseId())
+            std::swap(key.inputs[0], key.inputs[1]);
+    }
+    return key;
+}
+
+void Gvn::visitBlock(BasicBlock* bb)
+{
+    stack.emplace_back(bb, 0);
+    scope_sizes.push_back(scope_keys.size());
+
+    for (auto* inst = bb->getFirstInst(); inst != nullptr;)
+    {
+        auto* next = inst->getNext();
+        if (isNumbered(inst))
+        {
+            auto key = makeKey(inst);
+            auto [it, is_inserted] = table.try_emplace(key, inst);
+            if (is_inserted)
+                scope_keys.push_back(key);
+            else
+            {
+                // the dominating inst gives the same value (or has already passed the check)
+                if (inst->hasUsers())
+                    inst->replaceUsers(it->second);
+                bb->removeInst(inst);
+            }
+        }
+        inst = next;
+    }
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "pass.h"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Computations are equal if their operations, result types and inputs are equal.
+ * Inputs of commutative operations are ordered by their dense ids
+ */
+struct ValueKey
+{
+    InstType op;
+    DataType type;
+    std::array<Inst*, 2> inputs;
+
+    bool operator==(const ValueKey&) const noexcept = default;
+};
+
+struct ValueKeyHash
+{
+    size_t operator()(const ValueKey& key) const noexcept
+    {
+        auto hash = static_cast<uint64_t>(key.op) << 8 | static_cast<uint64_t>(key.type);
+        for (auto* input : key.inputs)
+            hash = (hash ^ reinterpret_cast<uintptr_t>(input)) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+/**
+ * Global Value Numbering over the dominator tree.
+ * Pure BinaryInst, UnaryInst and CastInst and ZeroCheck/BoundsCheck are hashed by ValueKey
+ * in a table scoped by the dominator tree walk: a computation found in the table is computed
+ * in a dominating block (or above in the same block) with the same inputs, so its users are
+ * redirected to the dominating one and it is removed. Cmp is left as is, its flags are used
+ * by the next conditional jump implicitly.
+ * With checks_only the checks are numbered only (see ChecksElimination).
+ */
+class Gvn final : public Optimization
+{
+  public:
+    explicit Gvn(Graph* g, bool checks_only_ = false) : Optimization(g), checks_only(checks_only_)
+    {}
+
+    ~Gvn() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "Gvn";
+    }
+
+    // removes instructions inside blocks
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
+
+  private:
+    bool isNumbered(Inst* inst) const;
+    ValueKey makeKey(Inst* inst) const;
+    void visitBlock(BasicBlock* bb);
+
+  private:
+    bool checks_only = false;
+
+    std::unordered_map<ValueKey, Inst*, ValueKeyHash> table;
+    // keys in the order of insertion, the keys of a subtree are erased on leaving it
+    std::vector<ValueKey> scope_keys;
+    // scope_keys size on entry of every block in the stack
+    std::vector<size_t> scope_sizes;
+    // blocks of the dominator tree path with the index of their next child
+    bb_stack_t stack;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -6,10 +6,16 @@ namespace compiler
 bool Inline::runPassImpl()
 {
     ASSERT(graph != nullptr, "nullptr graph in Inline pass");
+    // inlining splits blocks and adds callee ones, so calls are collected first
+    std::vector<Inst*> calls;
     for (auto* bb : graph->getBBs())
         for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
             if (inst->getInstType() == InstType::Call)
-                inlineMethod(inst);
+                calls.push_back(inst);
+    for (auto* inst : calls)
+        inlineMethod(inst);
+    // inlined insts and blocks keep dense ids of the callee
+    graph->renumberDenseIds();
     return true;
 }
 
@@ -18,115 +24,149 @@ void Inline::inlineMethod(Inst* inst)
     BasicBlock* caller_bb = inst->getBB();
     CallInst* call_inst = static_cast<CallInst*>(inst);
     auto* callee = call_inst->getFunc();
+    ASSERT(callee->getArena() == graph->getArena(),
+           "callee has to share the arena with the caller");
 
-    auto* next_bb = caller_bb->splitBlockAfterInst(inst, callee);
+    auto* next_bb = caller_bb->splitBlockAfterInst(inst);
     processInputs(call_inst, callee);
-    processReturn(inst, callee);
+    auto* exit_bb = processReturn(inst, callee);
     caller_bb->removeInst(inst);
     moveConstants(callee);
     doInline(callee);
-    linkBlocks(caller_bb, next_bb, callee);
+    linkBlocks(caller_bb, next_bb, callee, exit_bb);
 }
 
 void Inline::processInputs(CallInst* call_inst, Graph* callee)
 {
-    auto& args = call_inst->getArgs();
     auto* callee_first_bb = callee->getFirstBB();
-    for (auto* arg : args)
+    for (auto& arg : call_inst->getArgs())
     {
-        call_inst->removeUser(arg);
+        // replace all callee params to args instructions
         auto* param = callee_first_bb->getFirstInst();
-        auto& users = param->getUsers();
-        for (auto* user : users)
-        {
-            // replace all callee params to args instructions
-            arg->addUser(user);
-            user->replaceInput(param, arg);
-        }
+        param->replaceUsers(arg.get());
         callee_first_bb->popFrontInst();
     }
 }
 
-void Inline::processReturn(Inst* call_inst, Graph* callee)
+/**
+ * Returns the exit block of the inlined body: the only return block,
+ * or a new block which all return blocks go to and which merges the returned values by phi
+ */
+BasicBlock* Inline::processReturn(Inst* call_inst, Graph* callee)
 {
-    auto* call_inst_bb = call_inst->getBB();
-    std::vector<Inst*> returns;
+    std::vector<BasicBlock*> ret_bbs;
     for (auto* bb : callee->getBBs())
-        if (bb->getLastInst()->getInstType() == InstType::Return)
-            returns.push_back(bb->getLastInst());
+    {
+        auto* last_inst = bb->getLastInst();
+        if (last_inst != nullptr && (last_inst->getInstType() == InstType::Return ||
+                                     last_inst->getInstType() == InstType::RetVoid))
+            ret_bbs.push_back(bb);
+    }
+    ASSERT(!ret_bbs.empty(), "callee without return");
 
-    if (returns.size() == 1)
+    // a return ends its block, so other out edges of the block are never taken
+    for (auto* bb : ret_bbs)
+        removeSuccs(bb);
+    removeUnreachableBlocks(callee);
+    std::erase_if(ret_bbs, [callee](auto* bb) {
+        return bb != callee->getFirstBB() && bb->getPreds().empty();
+    });
+
+    if (ret_bbs.size() == 1)
     {
+        auto* exit_bb = ret_bbs[0];
+        auto* ret_inst = exit_bb->getLastInst();
         // substitute return value inst to call users
-        auto& call_users = call_inst->getUsers();
-        auto* retval_inst = static_cast<UnaryInst*>(returns[0])->getInput(0);
-        for (auto* user : call_users)
-        {
-            retval_inst->addUser(user);
-            user->replaceInput(call_inst, retval_inst);
-        }
+        if (ret_inst->getInstType() == InstType::Return)
+            call_inst->replaceUsers(static_cast<UnaryInst*>(ret_inst)->getInput(0));
+        exit_bb->popBackInst();
+        return exit_bb;
     }
-    else if (returns.size() > 1)
+
+    // the exit block is created in the caller, the callee blocks are moved to it later
+    auto* exit_bb = graph->createBB(graph->size());
+    graph->addBB(exit_bb);
+    PhiInst* phi_retval = nullptr;
+    if (ret_bbs[0]->getLastInst()->getInstType() == InstType::Return)
     {
-        // create phi instruction to return value
-        auto* phi_retval = new PhiInst{graph->getCurInstId()};
-        call_inst_bb->pushBackPhiInst(phi_retval);
-        for (auto* ret_inst : returns)
-        {
-            auto* retval_inst = static_cast<UnaryInst*>(ret_inst)->getInput(0);
-            phi_retval->addInput(std::make_pair(retval_inst, retval_inst->getBB()));
-            retval_inst->addUser(phi_retval);
-        }
+        auto phi_id = graph->getCurInstId();
+        graph->setCurInstId(phi_id + 1);
+        phi_retval = graph->create<PhiInst>(phi_id);
+        exit_bb->pushBackPhiInst(phi_retval);
+    }
+    for (auto* bb : ret_bbs)
+    {
+        if (phi_retval != nullptr)
+            phi_retval->addInput(static_cast<UnaryInst*>(bb->getLastInst())->getInput(0), bb);
+        bb->popBackInst();
+        graph->addEdge(bb, exit_bb);
+    }
+    if (phi_retval != nullptr)
+        call_inst->replaceUsers(phi_retval);
+    return exit_bb;
+}
 
-        auto& call_users = call_inst->getUsers();
-        for (auto* user : call_users)
+void Inline::removeEdge(BasicBlock* pred, BasicBlock* succ)
+{
+    pred->removeSucc(succ);
+    succ->removePred(pred);
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    {
+        auto* phi_inst = static_cast<PhiInst*>(phi);
+        for (size_t i = 0; i < phi_inst->getInputsNum(); ++i)
         {
-            phi_retval->addUser(user);
-            user->replaceInput(call_inst, phi_retval);
+            if (phi_inst->getInputBB(i) == pred)
+            {
+                phi_inst->removeInput(i);
+                break;
+            }
         }
     }
+}
 
-    for (auto* bb : callee->getBBs())
+void Inline::removeSuccs(BasicBlock* bb)
+{
+    for (auto* succ : {bb->getTrueSucc(), bb->getFalseSucc()})
+        if (succ != nullptr)
+            removeEdge(bb, succ);
+}
+
+// blocks reached only through removed edges after returns
+void Inline::removeUnreachableBlocks(Graph* callee)
+{
+    auto* first_bb = callee->getFirstBB();
+    bool is_removed = true;
+    while (is_removed)
     {
-        auto last_inst = bb->getLastInst();
-        if (last_inst->getInstType() == InstType::Return ||
-            last_inst->getInstType() == InstType::RetVoid)
+        is_removed = false;
+        for (auto* bb : callee->getBBs())
         {
-            auto* retval_inst = static_cast<UnaryInst*>(last_inst)->getInput(0);
-            retval_inst->removeUser(last_inst);
-            bb->popBackInst();
+            if (bb == first_bb || !bb->getPreds().empty())
+                continue;
+            removeSuccs(bb);
+            callee->removeBB(bb);
+            is_removed = true;
+            break;
         }
     }
 }
 
 void Inline::moveConstants(Graph* callee)
 {
-    auto* firstBB = callee->getFirstBB();
-    auto* cur_const = callee->getFirstConst();
-    while (cur_const != nullptr)
+    // callee constants are merged into the caller pool by their type and bits
+    auto* first_bb = callee->getFirstBB();
+    auto* inst = first_bb->getFirstInst();
+    while (inst != nullptr)
     {
-        auto type = cur_const->getType();
-        ConstInst* new_const = nullptr;
-        switch (type)
+        auto* next_inst = inst->getNext();
+        if (inst->isConstInst())
         {
-            case DataType::i32:
-                new_const = graph->findConstant(cur_const->getInt32Value());
-                break;
-            case DataType::i64:
-                new_const = graph->findConstant(cur_const->getInt64Value());
-                break;
-            case DataType::f32:
-                new_const = graph->findConstant(cur_const->getFloatValue());
-                break;
-            case DataType::f64:
-                new_const = graph->findConstant(cur_const->getDoubleValue());
-                break;
-            default:
-                UNREACHABLE();
+            auto* cur_const = static_cast<ConstInst*>(inst);
+            auto* new_const = graph->findConstant(cur_const->getType(), cur_const->getRawValue());
+            cur_const->replaceUsers(new_const);
+            first_bb->removeInst(cur_const);
         }
-        cur_const->replaceUsers(new_const);
-        firstBB->popFrontInst();
-        cur_const = callee->getFirstConst();
+        inst = next_inst;
     }
 }
 
@@ -139,23 +179,26 @@ void Inline::doInline(Graph* callee)
     for (auto it = std::next(blocks.begin()), end = blocks.end(); it != end; ++it)
     {
         auto* bb = (*it);
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+            phi->setId(cur_inst_id++);
         for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
             inst->setId(cur_inst_id++);
 
+        bb->setGraph(graph);
         graph->addBB(bb);
     }
     graph->setCurInstId(cur_inst_id);
 }
 
-void Inline::linkBlocks(BasicBlock* prev_bb, BasicBlock* next_bb, Graph* callee)
+void Inline::linkBlocks(BasicBlock* prev_bb, BasicBlock* next_bb, Graph* callee,
+                        BasicBlock* exit_bb)
 {
     auto first_bb = callee->getFirstBB()->getTrueSucc();
-    auto last_bb = callee->getLastBB();
     ASSERT(first_bb != nullptr);
     first_bb->replacePred(callee->getFirstBB(), prev_bb);
-    last_bb->addSucc(next_bb);
-    prev_bb->addSucc(first_bb);
-    next_bb->replacePred(prev_bb, last_bb);
+    exit_bb->addSucc(next_bb);
+    prev_bb->replaceSucc(next_bb, first_bb);
+    next_bb->replacePred(prev_bb, exit_bb);
 }
 
 } // namespace compiler
\ No newline at end of file
@@ -7,6 +7,12 @@
 namespace compiler
 {
 
+/**
+ * Inlines the bodies of called graphs into the caller.
+ * Callee blocks and instructions are moved to the caller, not copied,
+ * so a callee has to be allocated in the arena of the caller (see Graph)
+ * and loses its blocks but the first one.
+ */
 class Inline final : public Optimization
 {
   public:
@@ -25,10 +31,14 @@ class Inline final : public Optimization
   private:
     void inlineMethod(Inst* inst);
     void processInputs(CallInst* call_inst, Graph* callee);
-    void processReturn(Inst* call_inst, Graph* callee);
+    BasicBlock* processReturn(Inst* call_inst, Graph* callee);
+    void removeEdge(BasicBlock* pred, BasicBlock* succ);
+    void removeSuccs(BasicBlock* bb);
+    void removeUnreachableBlocks(Graph* callee);
     void moveConstants(Graph* callee);
     void doInline(Graph* callee);
-    void linkBlocks(BasicBlock* prev_bb, BasicBlock* next_bb, Graph* callee);
+    void linkBlocks(BasicBlock* prev_bb, BasicBlock* next_bb, Graph* callee,
+                    BasicBlock* exit_bb);
 };
 
 } // namespace compiler
\ No newline at end of file
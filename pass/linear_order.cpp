@@ -14,6 +14,7 @@ bool LinearOrder::runPassImpl()
 
     mrk = graph->getNewMarker();
 
+    linear_bbs.clear();
     processBBs();
     graph->setLinearOrderBBs(linear_bbs);
 
@@ -24,6 +25,9 @@ bool LinearOrder::runPassImpl()
 void LinearOrder::processBBs()
 {
     auto& rpo_bbs = graph->getRpoBBs();
+    rpo_nums.clear();
+    for (size_t i = 0; i < rpo_bbs.size(); ++i)
+        rpo_nums[rpo_bbs[i]] = i;
 
     for (auto* bb : rpo_bbs)
     {
@@ -44,11 +48,14 @@ void LinearOrder::processBBs()
 
 void LinearOrder::processLoop(Loop* loop)
 {
-    auto& body = loop->getBody();
-    // blocks in loop lying in reversed order
-    for (auto it = body.rbegin(), first = body.rend(); it != first; ++it)
+    // body is collected going up from latches, RPO puts every block after its dominators,
+    // so live intervals start at definitions
+    auto body = loop->getBody();
+    std::sort(body.begin(), body.end(), [this](BasicBlock* left, BasicBlock* right) {
+        return rpo_nums[left] < rpo_nums[right];
+    });
+    for (auto* bb : body)
     {
-        auto* bb = *it;
         if (bb->isMarked(mrk))
             continue;
 
@@ -30,6 +30,8 @@ class LinearOrder final : public Analysis
   private:
     marker_t mrk;
     std::vector<BasicBlock*> linear_bbs;
+    // positions in RPO indexed by bb dense ids
+    IdVector<size_t> rpo_nums;
 };
 
 } // namespace compiler
\ No newline at end of file
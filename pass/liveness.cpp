@@ -8,12 +8,6 @@ namespace compiler
 #define LINEAR_NUMBER_STEP 1
 #define LIVE_NUMBER_STEP 2
 
-LivenessAnalysis::~LivenessAnalysis()
-{
-    for (auto [bb, live_set] : live_sets)
-        delete live_set;
-}
-
 bool LivenessAnalysis::runPassImpl()
 {
     ASSERT(graph != nullptr, "nullptr graph in LivenessAnalysis pass");
@@ -23,29 +17,39 @@ bool LivenessAnalysis::runPassImpl()
         return false;
 
     linear_bbs = graph->getLinearOrderBBs();
+    auto insts_num = graph->getInstsDenseNum();
+    live_intervals.clear();
+    live_intervals.resize(insts_num);
+    insts.clear();
+    insts.resize(insts_num);
+
+    // sets keep their memory between reruns of the cached analysis
+    for (auto* sets : {&live_in, &live_out, &gen, &kill, &phi_uses})
+    {
+        sets->resize(graph->getBBsDenseNum());
+        for (auto& set : *sets)
+        {
+            set.resize(insts_num);
+            set.clear();
+        }
+    }
+    live.resize(insts_num);
 
     setInstsInitialNumbers();
+    calcLocalSets();
+    calcGlobalSets();
     buildLiveIntervals();
 
     graph->setLiveIntervals(live_intervals);
     return true;
 }
 
-void LivenessAnalysis::insertInstLiveInterval(Inst* inst, size_t start, size_t end)
+LiveInterval* LivenessAnalysis::getInstLiveInterval(Inst* inst)
 {
-    auto it = live_intervals.find(inst);
-    if (it == live_intervals.end())
-        live_intervals[inst] = new LiveInterval{start, end};
-    else
-    {
-        auto* cur_interval = (*it).second;
-        auto cur_start = cur_interval->getIntervalStart();
-        auto cur_end = cur_interval->getIntervalEnd();
-
-        // TODO: think about live holes
-        live_intervals[inst]->setIntervalStart(std::min(start, cur_start));
-        live_intervals[inst]->setIntervalEnd(std::max(end, cur_end));
-    }
+    auto*& live_int = live_intervals[inst];
+    if (live_int == nullptr)
+        live_int = graph->create<LiveInterval>(inst);
+    return live_int;
 }
 
 void LivenessAnalysis::setInstsInitialNumbers()
@@ -55,9 +59,10 @@ void LivenessAnalysis::setInstsInitialNumbers()
 
     for (auto* bb : linear_bbs)
     {
-        auto live = new LiveInterval{cur_live_num, cur_live_num};
+        auto bb_start = cur_live_num;
         for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
         {
+            insts[phi] = phi;
             phi->setLinearNum(cur_lin_num);
             phi->setLiveNum(cur_live_num);
             cur_lin_num += LINEAR_NUMBER_STEP;
@@ -66,142 +71,285 @@ void LivenessAnalysis::setInstsInitialNumbers()
 
         for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
         {
+            insts[inst] = inst;
             inst->setLinearNum(cur_lin_num);
             inst->setLiveNum(cur_live_num);
             cur_lin_num += LINEAR_NUMBER_STEP;
             cur_live_num += LIVE_NUMBER_STEP;
         }
-        live->setIntervalEnd(cur_live_num);
-        bb->setLiveInterval(live);
+        bb->setLiveInterval(graph->create<LiveInterval>(bb_start, cur_live_num));
     }
 }
 
-void LivenessAnalysis::buildLiveIntervals()
+void LivenessAnalysis::calcLocalSets()
 {
-    for (auto it = linear_bbs.rbegin(), first = linear_bbs.rend(); it != first; ++it)
+    for (auto* bb : linear_bbs)
     {
-        auto* bb = *it;
-        auto* live_set = calcInitLiveSets(bb);
-
-        appendBBIntervals(live_set, bb->getLiveInterval());
-        processBBInsts(bb, live_set);
+        auto bb_id = bb->getDenseId();
+        auto& bb_gen = gen[bb_id];
+        auto& bb_kill = kill[bb_id];
 
-        if (bb->isHeader() && !bb->getLoop()->isIrreducible())
-            processLoop(bb, live_set);
-    }
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+            bb_kill.set(phi->getDenseId());
 
-    for (auto [inst, live_int] : live_intervals)
-        if (inst->isJumpInst())
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
         {
-            live_int->setIntervalStart(0);
-            live_int->setIntervalEnd(0);
+            for (size_t i = 0, size = inst->getInputsNum(); i < size; ++i)
+            {
+                auto input_id = inst->getInput(i)->getDenseId();
+                if (!bb_kill.test(input_id))
+                    bb_gen.set(input_id);
+            }
+            bb_kill.set(inst->getDenseId());
         }
+
+        for (auto* succ : {bb->getTrueSucc(), bb->getFalseSucc()})
+            if (succ != nullptr)
+                calcPhiUses(bb, succ);
+    }
 }
 
-LiveSet* LivenessAnalysis::calcInitLiveSets(BasicBlock* bb)
+void LivenessAnalysis::calcPhiUses(BasicBlock* bb, BasicBlock* succ)
 {
-    auto* live_set = new LiveSet{};
-    live_sets[bb] = live_set;
-
-    auto* true_succ = bb->getTrueSucc();
-    auto* false_succ = bb->getFalseSucc();
-
-    if (true_succ != nullptr)
-        processSucc(bb, true_succ, live_set);
-
-    if (false_succ != nullptr)
-        processSucc(bb, false_succ, live_set);
-
-    return live_set;
+    auto& bb_phi_uses = phi_uses[bb->getDenseId()];
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    {
+        auto* phi_inst = static_cast<PhiInst*>(phi);
+        for (size_t i = 0, size = phi_inst->getInputsNum(); i < size; ++i)
+            if (phi_inst->getInputBB(i) == bb)
+                bb_phi_uses.set(phi_inst->getInput(i)->getDenseId());
+    }
 }
 
-void LivenessAnalysis::processSucc(BasicBlock* bb, BasicBlock* succ, LiveSet* live_set)
+void LivenessAnalysis::calcGlobalSets()
 {
-    if (live_sets.find(succ) == live_sets.end())
-        return;
-
-    live_set->unite(live_sets[succ]);
-    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    // sets only grow, so live_out can accumulate successors live_in between iterations;
+    // backward order makes loop-free graphs converge in one iteration
+    bool changed = true;
+    while (changed)
     {
-        auto& phi_inputs = static_cast<PhiInst*>(phi)->getInputs();
-        for (auto& input : phi_inputs)
-            if (input.second == bb)
-                live_set->addInst(input.first);
+        changed = false;
+        for (auto it = linear_bbs.rbegin(), first = linear_bbs.rend(); it != first; ++it)
+        {
+            auto bb_id = (*it)->getDenseId();
+            auto& bb_live_out = live_out[bb_id];
+            bb_live_out.unite(phi_uses[bb_id]);
+            for (auto* succ : {(*it)->getTrueSucc(), (*it)->getFalseSucc()})
+                if (succ != nullptr)
+                    bb_live_out.unite(live_in[succ->getDenseId()]);
+
+            changed |= live_in[bb_id].transfer(gen[bb_id], kill[bb_id], bb_live_out);
+        }
     }
 }
 
-void LivenessAnalysis::appendBBIntervals(LiveSet* live_set, LiveInterval* live_int)
+void LivenessAnalysis::buildLiveIntervals()
 {
-    auto& live_insts = live_set->getLiveSet();
-    auto start = live_int->getIntervalStart();
-    auto end = live_int->getIntervalEnd();
+    for (auto it = linear_bbs.rbegin(), first = linear_bbs.rend(); it != first; ++it)
+    {
+        auto* bb = *it;
+        auto* bb_live_int = bb->getLiveInterval();
+        auto start = bb_live_int->getIntervalStart();
+        auto end = bb_live_int->getIntervalEnd();
+        auto bb_id = bb->getDenseId();
+
+        live = live_out[bb_id];
+        live.forEach([this, start, end](size_t id) {
+            getInstLiveInterval(insts[id])->addRange(start, end);
+        });
+        // phi inputs are used on the edge, i.e. at the end of the pred
+        phi_uses[bb_id].forEach(
+            [this, end](size_t id) { getInstLiveInterval(insts[id])->addUse(end); });
+        processBBInsts(bb);
+    }
 
-    for (auto* inst : live_insts)
-        insertInstLiveInterval(inst, start, end);
+    for (auto* live_int : live_intervals)
+        if (live_int != nullptr)
+            live_int->finalize();
 }
 
-void LivenessAnalysis::processBBInsts(BasicBlock* bb, LiveSet* live_set)
+void LivenessAnalysis::processBBInsts(BasicBlock* bb)
 {
+    auto start = bb->getLiveInterval()->getIntervalStart();
     for (auto* inst = bb->getLastInst(); inst != nullptr; inst = inst->getPrev())
     {
         auto live_num = inst->getLiveNum();
 
-        auto it = live_intervals.find(inst);
-        if (it == live_intervals.end())
-            live_intervals[inst] = new LiveInterval{live_num, live_num + LIVE_NUMBER_STEP};
-        else
-            it->second->setIntervalStart(live_num);
+        // jumps define no value
+        if (!inst->isJumpInst())
+            getInstLiveInterval(inst)->setDef(live_num, live_num + LIVE_NUMBER_STEP);
 
-        processInstInputs(inst, live_set, bb->getLiveInterval()->getIntervalStart());
-        live_set->deleteInst(inst);
+        live.reset(inst->getDenseId());
+        for (size_t i = 0, size = inst->getInputsNum(); i < size; ++i)
+            processInput(inst->getInput(i), start, live_num);
     }
 
-    for (auto* phi = bb->getLastPhi(); phi != nullptr; phi = phi->getPrev())
-        live_set->deleteInst(phi);
+    for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    {
+        getInstLiveInterval(phi)->setDef(start, start + LIVE_NUMBER_STEP);
+        live.reset(phi->getDenseId());
+    }
 }
 
-void LivenessAnalysis::processInstInputs(Inst* inst, LiveSet* live_set, size_t start)
+void LivenessAnalysis::processInput(Inst* input, size_t start, size_t live_num)
 {
-    auto type = inst->getInstType();
-    if (inst->isBinaryInst())
+    live.set(input->getDenseId());
+    auto* live_int = getInstLiveInterval(input);
+    live_int->addRange(start, live_num);
+    live_int->addUse(live_num);
+}
+
+void LivenessAnalysis::replaceLiveValue(Inst* inst, Inst* other)
+{
+    auto id = inst->getDenseId();
+    auto other_id = other->getDenseId();
+    for (auto* sets : {&live_in, &live_out})
     {
-        auto* bin_inst = static_cast<BinaryInst*>(inst);
-        auto num = bin_inst->getLiveNum();
-        processInput(bin_inst->getInput(0), live_set, start, num);
-        processInput(bin_inst->getInput(1), live_set, start, num);
+        for (auto& set : *sets)
+        {
+            if (set.test(id))
+            {
+                set.reset(id);
+                set.set(other_id);
+            }
+        }
     }
-    else if (inst->isUnaryInst() || type == InstType::Cast || type == InstType::Mov)
+}
+
+void LiveInterval::addRange(size_t start, size_t end)
+{
+    ASSERT(start <= end, "incorrect live range");
+    if (start == end)
+        return;
+
+    // ranges are reversed until finalize(), so the back one is the first
+    if (!ranges.empty() && end >= ranges.back().start)
     {
-        auto* un_inst = static_cast<UnaryInst*>(inst);
-        auto num = un_inst->getLiveNum();
-        processInput(un_inst->getInput(0), live_set, start, num);
+        ASSERT(start <= ranges.back().start, "live ranges must be added backwards");
+        ranges.back().start = start;
+        ranges.back().end = std::max(ranges.back().end, end);
     }
-    else if (type == InstType::Call)
+    else
+        ranges.push_back({start, end});
+}
+
+void LiveInterval::setDef(size_t pos, size_t end)
+{
+    // value without uses still occupies a location at its definition
+    if (ranges.empty())
+        ranges.push_back({pos, end});
+    else
+        ranges.back().start = pos;
+}
+
+void LiveInterval::addUse(size_t pos)
+{
+    if (use_positions.empty() || use_positions.back() != pos)
+    {
+        ASSERT(use_positions.empty() || use_positions.back() > pos,
+               "use positions must be added backwards");
+        use_positions.push_back(pos);
+    }
+}
+
+void LiveInterval::finalize()
+{
+    std::reverse(ranges.begin(), ranges.end());
+    std::reverse(use_positions.begin(), use_positions.end());
+}
+
+bool LiveInterval::covers(size_t pos) const noexcept
+{
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), pos,
+                               [](size_t p, const LiveRange& range) { return p < range.start; });
+    return it != ranges.begin() && std::prev(it)->contains(pos);
+}
+
+size_t LiveInterval::findIntersection(const LiveInterval* other) const noexcept
+{
+    auto it = ranges.begin();
+    auto other_it = other->ranges.begin();
+    while (it != ranges.end() && other_it != other->ranges.end())
     {
-        auto* call_inst = static_cast<CallInst*>(inst);
-        auto num = call_inst->getLiveNum();
-        auto& args = call_inst->getArgs();
-        for (auto* arg : args)
-            processInput(arg, live_set, start, num);
+        if (it->end <= other_it->start)
+            ++it;
+        else if (other_it->end <= it->start)
+            ++other_it;
+        else
+            return std::max(it->start, other_it->start);
     }
+    return INVALID_LIVE_POS;
 }
 
-void LivenessAnalysis::processInput(Inst* input, LiveSet* live_set, size_t start, size_t live_num)
+size_t LiveInterval::getNextUse(size_t pos) const noexcept
 {
-    live_set->addInst(input);
-    insertInstLiveInterval(input, start, live_num);
+    auto it = std::lower_bound(use_positions.begin(), use_positions.end(), pos);
+    return it != use_positions.end() ? *it : INVALID_LIVE_POS;
 }
 
-void LivenessAnalysis::processLoop(BasicBlock* header, LiveSet* live_set)
+size_t LiveInterval::getPrevUse(size_t pos) const noexcept
 {
-    auto* loop = header->getLoop();
-    auto start = header->getLiveInterval()->getIntervalStart();
-    auto& body = loop->getBody();
-    auto end = body[0]->getLiveInterval()->getIntervalEnd();
-    auto& insts = live_set->getLiveSet();
+    auto it = std::lower_bound(use_positions.begin(), use_positions.end(), pos);
+    return it != use_positions.begin() ? *std::prev(it) : INVALID_LIVE_POS;
+}
 
-    for (auto* inst : insts)
-        insertInstLiveInterval(inst, start, end);
+void LiveInterval::split(size_t pos, LiveInterval* child)
+{
+    ASSERT(child->isEmpty() && child->use_positions.empty(), "split to not empty interval");
+    ASSERT(getIntervalStart() < pos && pos < getIntervalEnd(), "split out of interval");
+
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), pos,
+                               [](const LiveRange& range, size_t p) { return range.end <= p; });
+    if (it->start < pos)
+    {
+        child->ranges.push_back({pos, it->end});
+        it->end = pos;
+        ++it;
+    }
+    child->ranges.insert(child->ranges.end(), it, ranges.end());
+    ranges.erase(it, ranges.end());
+
+    auto use_it = std::upper_bound(use_positions.begin(), use_positions.end(), pos);
+    child->use_positions.assign(use_it, use_positions.end());
+    use_positions.erase(use_it, use_positions.end());
+
+    child->inst = inst;
+    auto* split_parent = getSplitParent();
+    child->parent = split_parent;
+    auto& children = split_parent->split_children;
+    auto child_start = child->getIntervalStart();
+    children.insert(std::upper_bound(children.begin(), children.end(), child_start,
+                                     [](size_t start, LiveInterval* part) {
+                                         return start < part->getIntervalStart();
+                                     }),
+                    child);
+}
+
+LiveInterval* LiveInterval::getSplitChild(size_t pos) noexcept
+{
+    auto* split_parent = getSplitParent();
+    auto& children = split_parent->split_children;
+    auto it = std::upper_bound(children.begin(), children.end(), pos,
+                               [](size_t p, LiveInterval* part) {
+                                   return p < part->getIntervalStart();
+                               });
+    return it != children.begin() ? *std::prev(it) : split_parent;
+}
+
+void LiveInterval::join(const LiveInterval* other)
+{
+    ASSERT(!ranges.empty() && !other->ranges.empty(), "join of empty intervals");
+    ASSERT(other->getIntervalStart() >= getIntervalEnd(), "joined intervals intersect");
+    for (const auto& range : other->ranges)
+    {
+        if (ranges.back().end == range.start)
+            ranges.back().end = range.end;
+        else
+            ranges.push_back(range);
+    }
+    for (auto pos : other->use_positions)
+        if (use_positions.empty() || use_positions.back() != pos)
+            use_positions.push_back(pos);
 }
 
 } // namespace compiler
\ No newline at end of file
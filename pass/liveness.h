@@ -1,16 +1,21 @@
 #pragma once
 
+#include "ir/bit_vector.h"
 #include "ir/graph.h"
 #include "pass.h"
-#include <set>
-#include <unordered_map>
 
 namespace compiler
 {
 
 class LiveInterval;
-class LiveSet;
 
+/**
+ * Live sets are found by the iterative backward dataflow over bit vectors of inst dense ids:
+ *     live_out(bb) = phi_uses(bb) + U live_in(succ)
+ *     live_in(bb)  = gen(bb) + (live_out(bb) - kill(bb))
+ * then live intervals are built from live_out sets going back through every bb:
+ * a value gets a range per bb it is live in, so intervals have holes where it is dead.
+ */
 class LivenessAnalysis final : public Analysis
 {
   public:
@@ -19,7 +24,7 @@ class LivenessAnalysis final : public Analysis
         linear_bbs.reserve(GRAPH_BB_NUM);
     }
 
-    ~LivenessAnalysis() override;
+    ~LivenessAnalysis() override = default;
 
     bool runPassImpl() override;
 
@@ -28,83 +33,202 @@ class LivenessAnalysis final : public Analysis
         return "LivenessAnalysis";
     }
 
+    // values live at the bb start, phis of the bb excluded; bits are inst dense ids
+    const BitVector& getLiveIn(BasicBlock* bb) const
+    {
+        return live_in[bb->getDenseId()];
+    }
+
+    // the value of inst is held by other from now on, they are not live at the same time
+    void replaceLiveValue(Inst* inst, Inst* other);
+
   private:
     void setInstsInitialNumbers();
+    void calcLocalSets();
+    void calcPhiUses(BasicBlock* bb, BasicBlock* succ);
+    void calcGlobalSets();
     void buildLiveIntervals();
-    void insertInstLiveInterval(Inst* inst, size_t start, size_t end);
-    LiveSet* calcInitLiveSets(BasicBlock* bb);
-    void processSucc(BasicBlock* bb, BasicBlock* succ, LiveSet* live_set);
-    void appendBBIntervals(LiveSet* live_set, LiveInterval* live_int);
-    void processBBInsts(BasicBlock* bb, LiveSet* live_set);
-    void processInstInputs(Inst* inst, LiveSet* live_set, size_t start);
-    void processInput(Inst* input, LiveSet* live_set, size_t start, size_t live_num);
-    void processLoop(BasicBlock* header, LiveSet* live_set);
+    LiveInterval* getInstLiveInterval(Inst* inst);
+    void processBBInsts(BasicBlock* bb);
+    void processInput(Inst* input, size_t start, size_t live_num);
 
   private:
     std::vector<BasicBlock*> linear_bbs;
-    std::unordered_map<Inst*, LiveInterval*> live_intervals;
-    std::unordered_map<BasicBlock*, LiveSet*> live_sets;
+    // side tables indexed by inst dense ids
+    IdVector<LiveInterval*> live_intervals;
+    IdVector<Inst*> insts;
+
+    // dataflow sets indexed by bb dense ids
+    std::vector<BitVector> live_in;
+    std::vector<BitVector> live_out;
+    // upward exposed uses
+    std::vector<BitVector> gen;
+    // definitions, phis included
+    std::vector<BitVector> kill;
+    // inputs of successors phis coming from the bb
+    std::vector<BitVector> phi_uses;
+    // live set of the currently processed bb
+    BitVector live;
+};
+
+/**
+ * Half-open range [start, end) of live numbers
+ */
+struct LiveRange
+{
+    size_t start = 0;
+    size_t end = 0;
+
+    bool contains(size_t pos) const noexcept
+    {
+        return start <= pos && pos < end;
+    }
 };
 
+/**
+ * Lifetime of a value: sorted disjoint ranges with holes between them and sorted use positions.
+ * Liveness builds it going backwards, so addRange/addUse prepend and finalize() restores order.
+ * Register allocator splits it into parts with own locations, the whole interval is the parent
+ * of all parts and the first part at the same time.
+ */
 class LiveInterval
 {
   public:
-    LiveInterval(size_t start_, size_t end_) : start(start_), end(end_)
+    LiveInterval(Inst* inst_ = nullptr) : inst(inst_)
     {}
+    LiveInterval(size_t start, size_t end, Inst* inst_ = nullptr) : inst(inst_)
+    {
+        addRange(start, end);
+    }
     ~LiveInterval() = default;
 
-    DEFINE_GETTER_SETTER(start, IntervalStart, size_t)
-    DEFINE_GETTER_SETTER(end, IntervalEnd, size_t)
-    DEFINE_GETTER_SETTER(location, Location, size_t)
+    // nullptr for basic block intervals
+    DEFINE_GETTER(inst, Inst, Inst*)
+    DEFINE_ARRAY_GETTER(ranges, Ranges, std::vector<LiveRange>&)
+    DEFINE_ARRAY_GETTER(use_positions, UsePositions, std::vector<size_t>&)
+    DEFINE_GETTER(location, Location, size_t)
+    DEFINE_GETTER(location_type, LocationType, LocationType)
+    DEFINE_ARRAY_GETTER(split_children, SplitChildren, std::vector<LiveInterval*>&)
+    // register of the calling convention the value is preferred in
+    DEFINE_GETTER_SETTER(hint_reg, HintReg, size_t)
+    DEFINE_GETTER(hint, Hint, LiveInterval*)
+    DEFINE_GETTER(hint_pos, HintPos, size_t)
+
+    LiveInterval* getSplitParent() noexcept
+    {
+        return parent != nullptr ? parent : this;
+    }
+
+    size_t getIntervalStart() const noexcept
+    {
+        return ranges.empty() ? 0 : ranges.front().start;
+    }
+
+    size_t getIntervalEnd() const noexcept
+    {
+        return ranges.empty() ? 0 : ranges.back().end;
+    }
 
     bool isEmpty() const noexcept
     {
-        return start == end;
+        return ranges.empty();
     }
 
     bool isRealRegister() const noexcept
     {
-        return is_real_register;
+        return location_type == LocationType::Register;
     }
 
-    void setNeedSpillFill() noexcept
+    bool isStackSlot() const noexcept
     {
-        is_real_register = false;
+        return location_type == LocationType::StackSlot;
     }
 
-  private:
-    size_t start = 0;
-    size_t end = 0;
-    size_t location = INVALID_REG;
-    bool is_real_register = true;
-};
+    bool isRematerialized() const noexcept
+    {
+        return location_type == LocationType::Remat;
+    }
 
-class LiveSet
-{
-  public:
-    LiveSet() = default;
-    ~LiveSet() = default;
+    bool hasLocation() const noexcept
+    {
+        return location_type != LocationType::None;
+    }
+
+    Location toLocation() const noexcept
+    {
+        return {location_type, location};
+    }
 
-    DEFINE_ARRAY_GETTER(live_set, LiveSet, std::set<Inst*>&)
+    void setRegister(size_t reg) noexcept
+    {
+        location = reg;
+        location_type = LocationType::Register;
+    }
 
-    void addInst(Inst* inst)
+    void setSpillSlot(size_t slot) noexcept
     {
-        live_set.insert(inst);
+        location = slot;
+        location_type = LocationType::StackSlot;
     }
 
-    void deleteInst(Inst* inst)
+    void setRematerialized() noexcept
     {
-        live_set.erase(inst);
+        location = INVALID_REG;
+        location_type = LocationType::Remat;
     }
 
-    void unite(LiveSet* live)
+    /**
+     * The value is preferred in the register of other at pos, they are connected by a phi,
+     * so the same register saves a move
+     */
+    void setHint(LiveInterval* other, size_t pos) noexcept
     {
-        for (auto* inst : live->getLiveSet())
-            live_set.insert(inst);
+        hint = other;
+        hint_pos = pos;
     }
 
+    // build interface, positions must not increase between calls
+    void addRange(size_t start, size_t end);
+    void setDef(size_t pos, size_t end);
+    void addUse(size_t pos);
+    void finalize();
+
+    bool covers(size_t pos) const noexcept;
+    // first live position covered by both intervals or INVALID_LIVE_POS
+    size_t findIntersection(const LiveInterval* other) const noexcept;
+    bool intersects(const LiveInterval* other) const noexcept
+    {
+        return findIntersection(other) != INVALID_LIVE_POS;
+    }
+    // first use at or after pos or INVALID_LIVE_POS
+    size_t getNextUse(size_t pos) const noexcept;
+    // last use before pos or INVALID_LIVE_POS
+    size_t getPrevUse(size_t pos) const noexcept;
+
+    /**
+     * Move ranges and uses after pos to the empty child, it becomes a part of the split parent.
+     * A use at pos stays here: the value has to be in this part location when it is used.
+     */
+    void split(size_t pos, LiveInterval* child);
+    // the part where the value is at pos: the last part started at or before pos
+    LiveInterval* getSplitChild(size_t pos) noexcept;
+    // append ranges and uses of other, which starts where this ends
+    void join(const LiveInterval* other);
+
   private:
-    std::set<Inst*> live_set;
+    std::vector<LiveRange> ranges;
+    std::vector<size_t> use_positions;
+    size_t location = INVALID_REG;
+    LocationType location_type = LocationType::None;
+    Inst* inst = nullptr;
+
+    LiveInterval* parent = nullptr;
+    // sorted by start
+    std::vector<LiveInterval*> split_children;
+
+    size_t hint_reg = INVALID_REG;
+    LiveInterval* hint = nullptr;
+    size_t hint_pos = INVALID_LIVE_POS;
 };
 
 } // namespace compiler
\ No newline at end of file
@@ -14,11 +14,15 @@ bool LoopAnalysis::runPassImpl()
     if (!rpo || !domtree)
         return false;
 
+    // drop results of the previous run
+    for (auto* bb : graph->getBBs())
+        bb->setLoop(nullptr);
+    graph->setRootLoop(nullptr);
+
     gray_mrk = graph->getNewMarker();
     black_mrk = graph->getNewMarker();
 
-    auto* firstBB = graph->getFirstBB();
-    findLoopsRec(firstBB, nullptr);
+    findLoops(graph->getFirstBB());
 
     graph->deleteMarker(gray_mrk);
     graph->deleteMarker(black_mrk);
@@ -28,7 +32,7 @@ bool LoopAnalysis::runPassImpl()
     return true;
 }
 
-void LoopAnalysis::findLoopsRec(BasicBlock* bb, BasicBlock* prev_bb)
+void LoopAnalysis::visitEdge(BasicBlock* bb, BasicBlock* prev_bb)
 {
     if (bb->isMarked(gray_mrk))
     {
@@ -41,7 +45,7 @@ void LoopAnalysis::findLoopsRec(BasicBlock* bb, BasicBlock* prev_bb)
         }
 
         bool is_irreducible = !bb->dominates(prev_bb);
-        loop = new Loop{/*header=*/bb, /*latch=*/prev_bb, is_irreducible};
+        loop = graph->create<Loop>(/*header=*/bb, /*latch=*/prev_bb, is_irreducible);
         bb->setLoop(loop);
         return;
     }
@@ -55,17 +59,40 @@ void LoopAnalysis::findLoopsRec(BasicBlock* bb, BasicBlock* prev_bb)
     // mark bb with both markers
     bb->setMarker(gray_mrk);
     bb->setMarker(black_mrk);
+    stack.emplace_back(bb, 0);
+}
 
-    // visit successors
-    auto* true_succ = bb->getTrueSucc();
-    auto* false_succ = bb->getFalseSucc();
-    if (true_succ != nullptr)
-        findLoopsRec(true_succ, bb);
-    if (false_succ != nullptr)
-        findLoopsRec(false_succ, bb);
+/**
+ * Iterative DFS: gray marker is set on the blocks lying on the stack,
+ * so an edge to a gray block is a back edge
+ */
+void LoopAnalysis::findLoops(BasicBlock* start_bb)
+{
+    ASSERT(stack.empty());
+    visitEdge(start_bb, nullptr);
 
-    // visit all successors -> unmark bb
-    bb->resetMarker(gray_mrk);
+    while (!stack.empty())
+    {
+        auto& [bb, succ_idx] = stack.back();
+        if (succ_idx == 0)
+        {
+            succ_idx = 1;
+            if (bb->getTrueSucc() != nullptr)
+                visitEdge(bb->getTrueSucc(), bb);
+        }
+        else if (succ_idx == 1)
+        {
+            succ_idx = 2;
+            if (bb->getFalseSucc() != nullptr)
+                visitEdge(bb->getFalseSucc(), bb);
+        }
+        else
+        {
+            // visit all successors -> unmark bb
+            bb->resetMarker(gray_mrk);
+            stack.pop_back();
+        }
+    }
 }
 
 void LoopAnalysis::populateLoops()
@@ -100,7 +127,7 @@ void LoopAnalysis::populateLoops()
 
             // fill loop body going up from latch to header
             for (auto latch : latches)
-                fillLoopRec(loop, latch);
+                fillLoop(loop, latch);
 
             loop->addBlock(bb);
             graph->deleteMarker(gray_mrk);
@@ -108,14 +135,8 @@ void LoopAnalysis::populateLoops()
     }
 }
 
-void LoopAnalysis::fillLoopRec(Loop* loop, BasicBlock* bb)
+void LoopAnalysis::addLoopBlock(Loop* loop, BasicBlock* bb)
 {
-    if (bb->isMarked(gray_mrk))
-    {
-        // we reach a header or already visited node
-        return;
-    }
-
     bb->setMarker(gray_mrk);
 
     // add inner-outer loops
@@ -135,16 +156,40 @@ void LoopAnalysis::fillLoopRec(Loop* loop, BasicBlock* bb)
         bb->setLoop(loop);
         loop->addBlock(bb);
     }
+    stack.emplace_back(bb, 0);
+}
+
+/**
+ * Fill loop body going up from latch to header (header is already marked),
+ * blocks are added in the DFS preorder of the reversed CFG
+ */
+void LoopAnalysis::fillLoop(Loop* loop, BasicBlock* latch)
+{
+    ASSERT(stack.empty());
+    if (latch->isMarked(gray_mrk))
+        return;
+    addLoopBlock(loop, latch);
 
-    // process blocks going up
-    auto& preds = bb->getPreds();
-    for (auto* pred : preds)
-        fillLoopRec(loop, pred);
+    while (!stack.empty())
+    {
+        auto& [bb, pred_idx] = stack.back();
+        auto& preds = bb->getPreds();
+        if (pred_idx == preds.size())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        auto* pred = preds[pred_idx++];
+        // we reach a header or already visited node
+        if (!pred->isMarked(gray_mrk))
+            addLoopBlock(loop, pred);
+    }
 }
 
 void LoopAnalysis::buildLoopTree()
 {
-    Loop* root_loop = new Loop{nullptr};
+    Loop* root_loop = graph->create<Loop>(nullptr);
     auto& bbs = graph->getBBs();
 
     for (auto* graph_bb : bbs)
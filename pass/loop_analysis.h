@@ -27,14 +27,17 @@ class LoopAnalysis final : public Analysis
     }
 
   private:
-    void findLoopsRec(BasicBlock* bb, BasicBlock* prev_bb);
+    void findLoops(BasicBlock* start_bb);
+    void visitEdge(BasicBlock* bb, BasicBlock* prev_bb);
     void populateLoops();
-    void fillLoopRec(Loop* loop, BasicBlock* bb);
+    void fillLoop(Loop* loop, BasicBlock* latch);
+    void addLoopBlock(Loop* loop, BasicBlock* bb);
     void buildLoopTree();
 
   private:
     marker_t gray_mrk;
     marker_t black_mrk;
+    bb_stack_t stack;
 };
 
 class Loop final
@@ -50,11 +53,8 @@ class Loop final
             addLatch(latch);
     }
 
-    ~Loop()
-    {
-        for (auto* inner : inners)
-            delete inner;
-    }
+    // inner loops are owned by the graph arena
+    ~Loop() = default;
 
     bool isIrreducible() const noexcept
     {
@@ -72,6 +72,15 @@ class Loop final
     DEFINE_ARRAY_GETTER(latches, Latches, std::vector<BasicBlock*>&)
     DEFINE_ARRAY_GETTER(inners, InnerLoops, std::vector<Loop*>&)
 
+    // 0 for the root loop
+    size_t getDepth() const noexcept
+    {
+        size_t depth = 0;
+        for (auto* loop = outer; loop != nullptr; loop = loop->outer)
+            ++depth;
+        return depth;
+    }
+
     void addBlock(BasicBlock* bb)
     {
         body.push_back(bb);
@@ -0,0 +1,59 @@
+#include "moves_elimination.h"
+
+namespace compiler
+{
+
+bool MovesElimination::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in MovesElimination pass");
+    ASSERT(graph->isAnalysisValid<LivenessAnalysis>(),
+           "MovesElimination needs live intervals of the register allocation");
+
+    size_t removed = 0;
+    for (auto* bb : graph->getLinearOrderBBs())
+    {
+        for (auto* inst = bb->getFirstInst(); inst != nullptr;)
+        {
+            auto* next = inst->getNext();
+            if (inst->getInstType() == InstType::Mov && tryEliminate(static_cast<MovInst*>(inst)))
+                ++removed;
+            inst = next;
+        }
+    }
+
+    auto stats = graph->getRegAllocStats();
+    stats.removed_moves += removed;
+    graph->setRegAllocStats(stats);
+    return true;
+}
+
+bool MovesElimination::tryEliminate(MovInst* mov)
+{
+    auto& live_intervals = graph->getLiveIntervals();
+    auto* mov_int = live_intervals[mov];
+    if (mov_int == nullptr)
+        return false;
+    auto pos = mov->getLiveNum();
+    auto* input = mov->getInput(0);
+    auto* input_int = live_intervals[input];
+    // the part where the input is used by the move
+    auto* input_part = input_int->getSplitChild(pos - 1);
+    mov->setSrc(input_part->toLocation());
+    mov->setDst(mov_int->toLocation());
+    if (mov->getSrc() != mov->getDst() || !mov_int->getSplitChildren().empty())
+        return false;
+
+    auto& input_parts = input_int->getSplitChildren();
+    auto* input_last = input_parts.empty() ? input_int : input_parts.back();
+    if (input_part != input_last || input_part->getIntervalEnd() != pos)
+        return false;
+
+    input_part->join(mov_int);
+    live_intervals[mov] = nullptr;
+    graph->getAnalysis<LivenessAnalysis>()->replaceLiveValue(mov, input);
+    mov->replaceUsers(input);
+    mov->getBB()->removeInst(mov);
+    return true;
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "liveness.h"
+#include "pass.h"
+
+namespace compiler
+{
+
+/**
+ * Deletes moves of the graph coalesced by the register allocation, it runs on the live
+ * intervals of the allocation, so the allocation starts it itself before SsaDestruction.
+ * A move is deleted if its input dies at the move in the register the move writes to:
+ * users of the move take the input and the input interval is joined with the move interval.
+ * Kept moves get their source and destination locations.
+ * The number of deleted moves is added to the graph RegAllocStats.
+ */
+class MovesElimination final : public Optimization
+{
+  public:
+    explicit MovesElimination(Graph* g) : Optimization(g)
+    {}
+
+    ~MovesElimination() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "MovesElimination";
+    }
+
+    // live intervals are updated together with the graph
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return ALL_ANALYSES;
+    }
+
+  private:
+    bool tryEliminate(MovInst* mov);
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "parallel_move.h"
+
+namespace compiler
+{
+
+void ParallelMove::addMove(Inst* value, Location src, Location dst)
+{
+    ASSERT(src.type != LocationType::None && dst.type != LocationType::None,
+           "move of not allocated value");
+    auto reg_class = Target::getRegClass(value->getType());
+    if (dst.type == LocationType::Remat || isSameLocation(src, reg_class, dst, reg_class))
+        return;
+    ASSERT(std::none_of(moves.begin(), moves.end(),
+                        [dst, reg_class](const Move& move) {
+                            return isSameLocation(move.dst, move.reg_class, dst, reg_class);
+                        }),
+           "location is written twice");
+    moves.push_back({value, src, dst, reg_class});
+}
+
+bool ParallelMove::isRead(const Move& move) const noexcept
+{
+    return std::any_of(moves.begin(), moves.end(), [&move](const Move& other) {
+        return &other != &move &&
+               isSameLocation(other.src, other.reg_class, move.dst, move.reg_class);
+    });
+}
+
+void ParallelMove::emit(BasicBlock* bb, Inst* inst)
+{
+    cur_bb = bb;
+    cur_inst = inst;
+    while (!moves.empty())
+    {
+        bool emitted = false;
+        for (size_t i = 0; i < moves.size();)
+        {
+            if (isRead(moves[i]))
+            {
+                ++i;
+                continue;
+            }
+            insertMov(moves[i].value, moves[i].src, moves[i].dst);
+            moves[i] = moves.back();
+            moves.pop_back();
+            emitted = true;
+        }
+        // every destination is read by another move: only cycles are left
+        if (!emitted)
+            breakCycle();
+    }
+}
+
+void ParallelMove::breakCycle()
+{
+    auto it = std::find_if(moves.begin(), moves.end(), [](const Move& move) {
+        return move.src.isRegister() && move.dst.isRegister();
+    });
+    if (it != moves.end())
+    {
+        // dst gets its value, src gets the value of dst, which is read by the next move
+        auto move = *it;
+        *it = moves.back();
+        moves.pop_back();
+        insertMov(move.value, move.src, move.dst, true);
+        for (auto& other : moves)
+            if (isSameLocation(other.src, other.reg_class, move.dst, move.reg_class))
+                other.src = move.src;
+        // the last move of a cycle is done by the swap
+        std::erase_if(moves, [](const Move& other) {
+            return isSameLocation(other.src, other.reg_class, other.dst, other.reg_class);
+        });
+        return;
+    }
+
+    // the cycle goes through the stack, free one destination through the scratch register
+    auto& move = moves.back();
+    auto reader = std::find_if(moves.begin(), moves.end(), [&move](const Move& other) {
+        return isSameLocation(other.src, other.reg_class, move.dst, move.reg_class);
+    });
+    ASSERT(reader != moves.end());
+    Location scratch{LocationType::Register,
+                     graph->getTarget()->getScratchReg(reader->reg_class)};
+    insertMov(reader->value, reader->src, scratch);
+    reader->src = scratch;
+}
+
+void ParallelMove::insertMov(Inst* value, Location src, Location dst, bool swap)
+{
+    auto id = graph->getCurInstId();
+    graph->setCurInstId(id + 1);
+    cur_bb->insertBefore(cur_inst, graph->create<MovInst>(id, value, src, dst, swap));
+    if (swap)
+        ++swaps_num;
+    else
+        ++moves_num;
+}
+
+} // namespace compiler
\ No newline at end of file
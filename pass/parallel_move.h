@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ir/graph.h"
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Moves which take effect at once at one program point (phis of an edge, parts of
+ * intervals split at one position) sequentialized into MovInsts.
+ * A move is emitted when no other pending move reads its destination. What is left then
+ * are cycles: cycles of registers are broken by swaps, a cycle through the stack saves
+ * one location to the scratch register of the class.
+ * Stack to stack moves stay single MovInsts, the code generator expands them
+ * without registers.
+ */
+class ParallelMove final
+{
+  public:
+    explicit ParallelMove(Graph* g) : graph(g)
+    {}
+
+    ~ParallelMove() = default;
+
+    DEFINE_GETTER(moves_num, MovesNum, size_t)
+    DEFINE_GETTER(swaps_num, SwapsNum, size_t)
+
+    // moves to the same location and to rematerialized parts are dropped
+    void addMove(Inst* value, Location src, Location dst);
+
+    bool isEmpty() const noexcept
+    {
+        return moves.empty();
+    }
+
+    /**
+     * Insert the sequence before inst (at the end of bb if it is nullptr),
+     * the resolver is empty after it
+     */
+    void emit(BasicBlock* bb, Inst* inst);
+
+  private:
+    struct Move
+    {
+        Inst* value = nullptr;
+        Location src;
+        Location dst;
+        RegClass reg_class = RegClass::Int;
+    };
+
+    // registers of different classes with the same number are different locations
+    static bool isSameLocation(Location left, RegClass left_class, Location right,
+                               RegClass right_class) noexcept
+    {
+        return left == right && (!left.isRegister() || left_class == right_class);
+    }
+
+    bool isRead(const Move& move) const noexcept;
+    void insertMov(Inst* value, Location src, Location dst, bool swap = false);
+    void breakCycle();
+
+  private:
+    Graph* graph = nullptr;
+    std::vector<Move> moves;
+
+    BasicBlock* cur_bb = nullptr;
+    Inst* cur_inst = nullptr;
+
+    size_t moves_num = 0;
+    size_t swaps_num = 0;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
 namespace compiler
 {
 
 class Graph;
 
+// bit set of analyses, bit numbers are given by getAnalysisIndex<T>()
+using analyses_mask_t = uint32_t;
+
 class Pass
 {
   public:
@@ -58,8 +65,21 @@ class Analysis : public Pass
         return is_valid;
     }
 
+    // result is valid for the CFG with the given version
+    void validate(size_t cfg_version_) noexcept
+    {
+        is_valid = true;
+        cfg_version = cfg_version_;
+    }
+
+    size_t getCfgVersion() const noexcept
+    {
+        return cfg_version;
+    }
+
   protected:
     bool is_valid = false;
+    size_t cfg_version = 0;
 };
 
 class Optimization : public Pass
@@ -73,6 +93,12 @@ class Optimization : public Pass
     virtual ~Optimization() = default;
 
     virtual std::string getOptName() const = 0;
+
+    // analyses results that stay valid after the optimization, others are invalidated
+    virtual analyses_mask_t getPreservedAnalyses() const noexcept
+    {
+        return 0;
+    }
 };
 
 } // namespace compiler
\ No newline at end of file
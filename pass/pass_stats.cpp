@@ -0,0 +1,175 @@
+#include "pass_stats.h"
+#include "ir/graph.h"
+#include <functional>
+#include <thread>
+
+namespace compiler
+{
+
+void dumpJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (auto c : str)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+ThreadPassStats& ThreadPassStats::get()
+{
+    thread_local ThreadPassStats stats;
+    return stats;
+}
+
+void ThreadPassStats::addRecord(const PassRecord& record)
+{
+    auto& pass_totals = totals[record.name];
+    ++pass_totals.runs_num;
+    if (record.is_cached)
+        ++pass_totals.cached_num;
+    if (!record.is_success)
+        ++pass_totals.failed_num;
+    pass_totals.time_ns += record.time_ns;
+    pass_totals.self_time_ns += record.time_ns - record.nested_time_ns;
+    // allocations include nested passes like the time does
+    pass_totals.allocs_num += record.allocs_num;
+    pass_totals.alloc_bytes += record.alloc_bytes;
+}
+
+void ThreadPassStats::reset()
+{
+    graphs_num = 0;
+    totals.clear();
+}
+
+void ThreadPassStats::dumpJson(std::ostream& out) const
+{
+    out << "{\"thread\": \"" << std::this_thread::get_id() << "\", \"graphs\": " << graphs_num
+        << ", \"passes\": [";
+    bool is_first = true;
+    for (auto& [name, pass_totals] : totals)
+    {
+        out << (is_first ? "" : ", ") << "{\"name\": ";
+        dumpJsonString(out, name);
+        out << ", \"runs\": " << pass_totals.runs_num << ", \"cached\": " << pass_totals.cached_num
+            << ", \"failed\": " << pass_totals.failed_num
+            << ", \"time_ns\": " << pass_totals.time_ns
+            << ", \"self_time_ns\": " << pass_totals.self_time_ns
+            << ", \"allocs\": " << pass_totals.allocs_num
+            << ", \"alloc_bytes\": " << pass_totals.alloc_bytes << "}";
+        is_first = false;
+    }
+    out << "]}";
+}
+
+PassStats::PassStats(Graph* g) : graph(g)
+{
+    ThreadPassStats::get().addGraph();
+}
+
+void PassStats::countIR(size_t& insts_num, size_t& bbs_num) const
+{
+    insts_num = 0;
+    bbs_num = graph->size();
+    for (auto* bb : graph->getBBs())
+        insts_num += bb->size();
+}
+
+size_t PassStats::beginPass(const std::string& name, bool is_analysis)
+{
+    auto& record = records.emplace_back();
+    record.name = name;
+    record.is_analysis = is_analysis;
+    record.parent = open_records.empty() ? INVALID_PASS_RECORD : open_records.back().record;
+    countIR(record.insts_before, record.bbs_before);
+
+    auto* arena = graph->getArena();
+    open_records.push_back(
+        {records.size() - 1, clock_t::now(), arena->getAllocsNum(), arena->getAllocatedSize()});
+    return records.size() - 1;
+}
+
+void PassStats::endPass(size_t record_num, bool is_success)
+{
+    auto end = clock_t::now();
+    ASSERT(!open_records.empty() && open_records.back().record == record_num,
+           "passes have to be finished in the reverse order");
+    auto open = open_records.back();
+    open_records.pop_back();
+
+    auto& record = records[record_num];
+    auto* arena = graph->getArena();
+    record.is_success = is_success;
+    record.time_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - open.start).count());
+    // the arena is rewound only between compilations
+    record.allocs_num = arena->getAllocsNum() - open.allocs_num;
+    record.alloc_bytes = arena->getAllocatedSize() - open.alloc_bytes;
+    countIR(record.insts_after, record.bbs_after);
+    if (record.parent != INVALID_PASS_RECORD)
+        records[record.parent].nested_time_ns += record.time_ns;
+    ThreadPassStats::get().addRecord(record);
+}
+
+void PassStats::addCachedAnalysis(const std::string& name)
+{
+    auto& record = records.emplace_back();
+    record.name = name;
+    record.is_analysis = true;
+    record.is_cached = true;
+    record.parent = open_records.empty() ? INVALID_PASS_RECORD : open_records.back().record;
+    ThreadPassStats::get().addRecord(record);
+}
+
+void PassStats::dumpJson(std::ostream& out) const
+{
+    std::vector<std::vector<size_t>> children(records.size());
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < records.size(); ++i)
+        (records[i].parent == INVALID_PASS_RECORD ? roots : children[records[i].parent])
+            .push_back(i);
+
+    std::function<void(const std::vector<size_t>&)> dump_records =
+        [&](const std::vector<size_t>& nums) {
+            out << "[";
+            for (size_t i = 0; i < nums.size(); ++i)
+            {
+                auto& record = records[nums[i]];
+                out << (i == 0 ? "" : ", ") << "{\"name\": ";
+                dumpJsonString(out, record.name);
+                out << ", \"kind\": \"" << (record.is_analysis ? "analysis" : "optimization")
+                    << "\", \"cached\": " << std::boolalpha << record.is_cached
+                    << ", \"success\": " << record.is_success << std::noboolalpha;
+                if (!record.is_cached)
+                    out << ", \"time_ns\": " << record.time_ns
+                        << ", \"self_time_ns\": " << record.time_ns - record.nested_time_ns
+                        << ", \"allocs\": " << record.allocs_num
+                        << ", \"alloc_bytes\": " << record.alloc_bytes
+                        << ", \"insts_before\": " << record.insts_before
+                        << ", \"insts_after\": " << record.insts_after
+                        << ", \"bbs_before\": " << record.bbs_before
+                        << ", \"bbs_after\": " << record.bbs_after;
+                if (!children[nums[i]].empty())
+                {
+                    out << ", \"nested\": ";
+                    dump_records(children[nums[i]]);
+                }
+                out << "}";
+            }
+            out << "]";
+        };
+
+    out << "{\"graph\": ";
+    dumpJsonString(out, graph->getName());
+    out << ", \"passes\": ";
+    dump_records(roots);
+    out << "}";
+}
+
+} // namespace compiler
\ No newline at end of file
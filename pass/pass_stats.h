@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ir/utils.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace compiler
+{
+
+class Graph;
+
+constexpr size_t INVALID_PASS_RECORD = static_cast<size_t>(-1);
+
+// quoted string with escapes for JSON reports
+void dumpJsonString(std::ostream& out, const std::string& str);
+
+/**
+ * One run of a pass or one request of a cached analysis. Time and allocations include
+ * nested passes: analyses requested while the pass runs are its children.
+ * Allocations are counted in the graph arena.
+ */
+struct PassRecord
+{
+    std::string name;
+    bool is_analysis = false;
+    bool is_cached = false;
+    bool is_success = true;
+    // record of the pass that requested this one
+    size_t parent = INVALID_PASS_RECORD;
+    uint64_t time_ns = 0;
+    uint64_t nested_time_ns = 0;
+    size_t allocs_num = 0;
+    size_t alloc_bytes = 0;
+    size_t insts_before = 0;
+    size_t insts_after = 0;
+    size_t bbs_before = 0;
+    size_t bbs_after = 0;
+};
+
+// records of a pass summed over graphs, self time does not include nested passes
+struct PassTotals
+{
+    size_t runs_num = 0;
+    size_t cached_num = 0;
+    size_t failed_num = 0;
+    uint64_t time_ns = 0;
+    uint64_t self_time_ns = 0;
+    size_t allocs_num = 0;
+    size_t alloc_bytes = 0;
+};
+
+/**
+ * Aggregated pass stats of all graphs compiled by the current thread.
+ * While enabled, every graph created by the thread records its passes.
+ */
+class ThreadPassStats final
+{
+  public:
+    // ordered by pass names for stable reports
+    using totals_t = std::map<std::string, PassTotals>;
+
+    static ThreadPassStats& get();
+
+    static bool isEnabled() noexcept
+    {
+        return enabled;
+    }
+
+    static void setEnabled(bool enabled_) noexcept
+    {
+        enabled = enabled_;
+    }
+
+    void addGraph() noexcept
+    {
+        ++graphs_num;
+    }
+
+    void addRecord(const PassRecord& record);
+    void reset();
+    void dumpJson(std::ostream& out = std::cout) const;
+
+    DEFINE_GETTER(graphs_num, GraphsNum, size_t)
+    DEFINE_ARRAY_GETTER(totals, Totals, totals_t&)
+
+  private:
+    static inline thread_local bool enabled = false;
+
+    size_t graphs_num = 0;
+    totals_t totals;
+};
+
+/**
+ * Pass stats of a graph filled by its PassManager: per pass invocation the time,
+ * arena allocations, instructions and blocks before and after, cached analyses results.
+ * Records go in the order of starts, so nested passes follow their parents.
+ */
+class PassStats final
+{
+  public:
+    explicit PassStats(Graph* g);
+    ~PassStats() = default;
+
+    size_t beginPass(const std::string& name, bool is_analysis);
+    void endPass(size_t record, bool is_success);
+    void addCachedAnalysis(const std::string& name);
+
+    DEFINE_ARRAY_GETTER(records, Records, std::vector<PassRecord>&)
+
+    void dumpJson(std::ostream& out = std::cout) const;
+
+  private:
+    using clock_t = std::chrono::steady_clock;
+
+    struct OpenRecord
+    {
+        size_t record = INVALID_PASS_RECORD;
+        clock_t::time_point start;
+        size_t allocs_num = 0;
+        size_t alloc_bytes = 0;
+    };
+
+    void countIR(size_t& insts_num, size_t& bbs_num) const;
+
+  private:
+    Graph* graph = nullptr;
+    std::vector<PassRecord> records;
+    // stack of running passes
+    std::vector<OpenRecord> open_records;
+};
+
+} // namespace compiler
\ No newline at end of file
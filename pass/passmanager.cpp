@@ -1,4 +1,5 @@
 #include "passmanager.h"
+#include "ir/graph.h"
 #include "domtree.h"
 #include "linear_order.h"
 #include "liveness.h"
@@ -11,22 +12,56 @@ namespace compiler
 
 PassManager::~PassManager()
 {
-    for (auto* analysis : analyses)
-        delete analysis;
+    if (trace_start != 0)
+        Tracer::addSpan(trace_start, graph->getName(), TraceCategory::Graph);
+}
+
+bool PassManager::isAnalysisValid(const Analysis* analysis) const
+{
+    return analysis->isValid() && analysis->getCfgVersion() == graph->getCfgVersion();
+}
 
-    for (auto* opt : opts)
-        delete opt;
+bool PassManager::runAnalysis(Analysis* analysis)
+{
+    // dependencies are requested inside and can change nothing in the CFG
+    auto cfg_version = graph->getCfgVersion();
+    auto record = stats != nullptr ? stats->beginPass(analysis->getAnalysisName(), true)
+                                   : INVALID_PASS_RECORD;
+    auto analysis_trace_start = Tracer::now();
+    bool res = analysis->runPassImpl();
+    if (analysis_trace_start != 0)
+        Tracer::addSpan(analysis_trace_start, analysis->getAnalysisName(),
+                        TraceCategory::Analysis);
+    if (stats != nullptr)
+        stats->endPass(record, res);
+    if (!res)
+    {
+        std::cerr << "Pass " << analysis->getAnalysisName() << " failed" << std::endl;
+        return false;
+    }
+    analysis->validate(cfg_version);
+    return true;
+}
+
+void PassManager::invalidateAnalyses(analyses_mask_t mask)
+{
+    for (size_t i = 0; i < ANALYSES_NUM; ++i)
+        if ((mask & (analyses_mask_t{1} << i)) != 0 && analyses[i] != nullptr &&
+            analyses[i]->isValid())
+            analyses[i]->invalidateAnalysis();
 }
 
 void PassManager::dumpAnalyses(std::ostream& out)
 {
-    std::for_each(analyses.begin(), analyses.end(),
-                  [&out](auto* analysis) { out << analysis->getAnalysisName() << " "; });
+    std::for_each(analyses.begin(), analyses.end(), [&out](auto& analysis) {
+        if (analysis != nullptr)
+            out << analysis->getAnalysisName() << " ";
+    });
 }
 
 void PassManager::dumpOpts(std::ostream& out)
 {
-    std::for_each(opts.begin(), opts.end(), [&out](auto* opt) { out << opt->getOptName() << " "; });
+    std::for_each(opts.begin(), opts.end(), [&out](auto& opt) { out << opt << " "; });
 }
 
 } // namespace compiler
\ No newline at end of file
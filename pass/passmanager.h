@@ -2,8 +2,12 @@
 
 #include "ir/marker.h"
 #include "pass.h"
+#include "pass_stats.h"
+#include "trace.h"
+#include <array>
 #include <concepts>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 namespace compiler
@@ -15,13 +19,19 @@ class Rpo;
 class DomTree;
 class LoopAnalysis;
 class ConstFolding;
+class Sccp;
 class Dce;
 class Inline;
 class Peepholes;
 class ChecksElimination;
+class Gvn;
 class LinearOrder;
 class LivenessAnalysis;
 class RegisterAllocation;
+class StackSlotsAllocation;
+class SsaDestruction;
+class MovesElimination;
+class GraphColoringAllocation;
 class Graph;
 
 template <typename T>
@@ -31,60 +41,153 @@ concept LegalAnalysis =
 
 template <typename T>
 concept LegalOptimization =
-    std::is_same_v<T, ConstFolding> || std::is_same_v<T, Dce> || std::is_same_v<T, Inline> ||
-    std::is_same_v<T, Peepholes> || std::is_same_v<T, ChecksElimination> ||
-    std::is_same_v<T, RegisterAllocation>;
+    std::is_same_v<T, ConstFolding> || std::is_same_v<T, Sccp> || std::is_same_v<T, Dce> ||
+    std::is_same_v<T, Inline> || std::is_same_v<T, Peepholes> ||
+    std::is_same_v<T, ChecksElimination> || std::is_same_v<T, Gvn> ||
+    std::is_same_v<T, RegisterAllocation> || std::is_same_v<T, StackSlotsAllocation> ||
+    std::is_same_v<T, SsaDestruction> || std::is_same_v<T, MovesElimination> ||
+    std::is_same_v<T, GraphColoringAllocation>;
 
 template <typename T>
 concept LegalPass = LegalAnalysis<T> || LegalOptimization<T>;
 
+constexpr size_t ANALYSES_NUM = 5;
+
+template <LegalAnalysis T>
+constexpr size_t getAnalysisIndex()
+{
+    if constexpr (std::is_same_v<T, Rpo>)
+        return 0;
+    else if constexpr (std::is_same_v<T, DomTree>)
+        return 1;
+    else if constexpr (std::is_same_v<T, LoopAnalysis>)
+        return 2;
+    else if constexpr (std::is_same_v<T, LinearOrder>)
+        return 3;
+    else // LivenessAnalysis
+        return 4;
+}
+
+template <LegalAnalysis... Ts>
+constexpr analyses_mask_t makeAnalysesMask()
+{
+    return ((analyses_mask_t{1} << getAnalysisIndex<Ts>()) | ... | 0);
+}
+
+constexpr analyses_mask_t ALL_ANALYSES = (analyses_mask_t{1} << ANALYSES_NUM) - 1;
+// analyses which depend on the CFG only, not on the instructions
+constexpr analyses_mask_t CFG_ANALYSES = makeAnalysesMask<Rpo, DomTree, LoopAnalysis, LinearOrder>();
+
+/**
+ * Runs optimizations and caches analyses results.
+ * An analysis is rerun only if its result was invalidated: by an optimization
+ * which does not preserve it, or by a CFG change (graph CFG version is compared).
+ * Other IR changes made outside of optimizations require explicit invalidation.
+ */
 class PassManager final
 {
   public:
-    explicit PassManager(Graph* g) : graph(g)
-    {}
+    explicit PassManager(Graph* g) : graph(g), trace_start(Tracer::now())
+    {
+        if (ThreadPassStats::isEnabled())
+            enableStats();
+    }
+    // the graph span of the trace lasts as long as its PassManager
     ~PassManager();
 
     template <LegalPass PassName, typename... Args>
     bool runPass(Args&&... args)
     {
-        auto* pass = new PassName{graph, std::forward<Args>(args)...};
-        [[maybe_unused]] std::string pass_name;
         if constexpr (LegalAnalysis<PassName>)
         {
-            analyses.push_back(static_cast<Analysis*>(pass));
-            pass_name = pass->getAnalysisName();
-        }
-        else if constexpr (LegalOptimization<PassName>)
-        {
-            opts.push_back(static_cast<Optimization*>(pass));
-            pass_name = pass->getOptName();
+            static_assert(sizeof...(Args) == 0, "cached analyses have no parameters");
+            return getAnalysis<PassName>() != nullptr;
         }
         else
         {
-            UNREACHABLE();
+            PassName pass{graph, std::forward<Args>(args)...};
+            opts.push_back(pass.getOptName());
+            auto record = stats != nullptr ? stats->beginPass(opts.back(), false)
+                                           : INVALID_PASS_RECORD;
+            auto pass_trace_start = Tracer::now();
+            bool res = pass.runPassImpl();
+            invalidateAnalyses(ALL_ANALYSES & ~pass.getPreservedAnalyses());
+            if (pass_trace_start != 0)
+                Tracer::addSpan(pass_trace_start, opts.back(), TraceCategory::Optimization);
+            if (stats != nullptr)
+                stats->endPass(record, res);
+            if (!res)
+                std::cerr << "Pass " << opts.back() << " failed" << std::endl;
+            return res;
         }
+    }
 
-        if (!pass->runPassImpl())
+    /**
+     * Return cached analysis if it is still valid, otherwise (re)run it.
+     * nullptr if the analysis failed.
+     */
+    template <LegalAnalysis T>
+    T* getAnalysis()
+    {
+        auto& analysis = analyses[getAnalysisIndex<T>()];
+        if (analysis != nullptr && isAnalysisValid(analysis.get()))
         {
-            std::cerr << "Pass " << pass_name << " failed" << std::endl;
-            return false;
+            if (stats != nullptr)
+                stats->addCachedAnalysis(analysis->getAnalysisName());
+            return static_cast<T*>(analysis.get());
         }
-        return true;
+
+        if (analysis == nullptr)
+            analysis = std::make_unique<T>(graph);
+        else
+            analysis->invalidateAnalysis();
+        if (!runAnalysis(analysis.get()))
+            return nullptr;
+        return static_cast<T*>(analysis.get());
+    }
+
+    template <LegalAnalysis T>
+    bool isAnalysisValid() const
+    {
+        auto& analysis = analyses[getAnalysisIndex<T>()];
+        return analysis != nullptr && isAnalysisValid(analysis.get());
     }
 
+    void invalidateAnalyses(analyses_mask_t mask);
+
     Graph* getGraph() const noexcept
     {
         return graph;
     }
 
+    // stats are collected from now on, graphs of threads with enabled ThreadPassStats have them
+    void enableStats()
+    {
+        if (stats == nullptr)
+            stats = std::make_unique<PassStats>(graph);
+    }
+
+    // nullptr if stats are disabled
+    PassStats* getStats() const noexcept
+    {
+        return stats.get();
+    }
+
     void dumpAnalyses(std::ostream& out = std::cout);
     void dumpOpts(std::ostream& out = std::cout);
 
+  private:
+    bool isAnalysisValid(const Analysis* analysis) const;
+    bool runAnalysis(Analysis* analysis);
+
   private:
     Graph* graph = nullptr;
-    std::vector<Analysis*> analyses;
-    std::vector<Optimization*> opts;
+    // indexed by getAnalysisIndex<T>()
+    std::array<std::unique_ptr<Analysis>, ANALYSES_NUM> analyses;
+    // names of already run optimizations
+    std::vector<std::string> opts;
+    std::unique_ptr<PassStats> stats = nullptr;
+    uint64_t trace_start = 0;
 };
 
 } // namespace compiler
@@ -49,7 +49,7 @@ void Peepholes::visitMul([[maybe_unused]] Visitor* v, Inst* inst)
     else if (value == static_cast<uint64_t>(-1))
     {
         // 3. Mul v1, -1 --> Neg v1
-        auto* neg_inst = new UnaryInst{graph->getCurInstId(), InstType::Neg, left};
+        auto* neg_inst = graph->create<UnaryInst>(graph->getCurInstId(), InstType::Neg, left);
         graph->setCurInstId(graph->getCurInstId() + 1);
         auto* bb = inst->getBB();
         bb->insertAfter(inst, neg_inst);
@@ -60,7 +60,8 @@ void Peepholes::visitMul([[maybe_unused]] Visitor* v, Inst* inst)
         // 4. Mul v1, 2^k  -->  Shl v1, k
         uint32_t power = static_cast<uint32_t>(std::log2(value));
         auto* new_const = graph->findConstant(power);
-        auto* shl_inst = new BinaryInst{graph->getCurInstId(), InstType::Shl, left, new_const};
+        auto* shl_inst =
+            graph->create<BinaryInst>(graph->getCurInstId(), InstType::Shl, left, new_const);
         graph->setCurInstId(graph->getCurInstId() + 1);
         auto* bb = inst->getBB();
         bb->insertAfter(inst, shl_inst);
@@ -92,14 +93,14 @@ void Peepholes::visitOr([[maybe_unused]] Visitor* v, Inst* inst)
         auto* right_neg = static_cast<UnaryInst*>(right);
         auto* left_input = left_neg->getInput(0);
         auto* right_input = right_neg->getInput(0);
-        auto* and_inst =
-            new BinaryInst{graph->getCurInstId(), InstType::And, left_input, right_input};
+        auto* and_inst = graph->create<BinaryInst>(graph->getCurInstId(), InstType::And,
+                                                   left_input, right_input);
         graph->setCurInstId(graph->getCurInstId() + 1);
         auto* bb = inst->getBB();
         bb->insertAfter(inst, and_inst);
-        left_neg->removeUser(inst);
-        right_neg->removeUser(inst);
         inst->replaceUsers(and_inst);
+        // drop the edges to Not insts, so DCE can remove them
+        bb->removeInst(inst);
         return;
     }
 
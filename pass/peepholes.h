@@ -22,6 +22,12 @@ class Peepholes final : public Optimization, public Visitor
         return "Peepholes";
     }
 
+    // rewrites instructions inside blocks
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
+
   private:
     void visitMul([[maybe_unused]] Visitor* v, Inst* inst) override;
     void visitAShr([[maybe_unused]] Visitor* v, Inst* inst) override;
@@ -1,4 +1,9 @@
 #include "reg_alloc.h"
+#include "graph_coloring.h"
+#include "loop_analysis.h"
+#include "moves_elimination.h"
+#include "ssa_destruction.h"
+#include "stack_slots.h"
 
 namespace compiler
 {
@@ -6,81 +11,393 @@ namespace compiler
 bool RegisterAllocation::runPassImpl()
 {
     ASSERT(graph != nullptr, "nullptr graph in RegisterAllocation pass");
+    if (graph->getRegAllocKind() == RegAllocKind::GraphColoring)
+        return graph->runPass<GraphColoringAllocation>();
 
     bool liveness = graph->runPass<LivenessAnalysis>();
     if (!liveness)
         return false;
 
-    getLiveIntervals();
-    linearScan();
-    return true;
+    spill_slots.clear();
+    spill_slots.resize(graph->getInstsDenseNum());
+    calcBlocksLoopDepth();
+    calcRegAllocHints(graph);
+    for (size_t i = 0; i < REG_CLASSES_NUM; ++i)
+        allocateClass(static_cast<RegClass>(i));
+    graph->setRegAllocStats(countSpillCode(graph));
+    return resolveRegAlloc(graph);
+}
+
+void RegisterAllocation::calcBlocksLoopDepth()
+{
+    bb_starts.clear();
+    bb_depths.clear();
+    for (auto* bb : graph->getLinearOrderBBs())
+    {
+        bb_starts.push_back(bb->getLiveInterval()->getIntervalStart());
+        auto* loop = bb->getLoop();
+        bb_depths.push_back(loop != nullptr ? loop->getDepth() : 0);
+    }
+}
+
+void calcRegAllocHints(Graph* graph)
+{
+    auto* target = graph->getTarget();
+    auto& live_intervals = graph->getLiveIntervals();
+    auto set_hint_reg = [&live_intervals](Inst* inst, size_t reg) {
+        auto* live_int = live_intervals[inst];
+        if (live_int != nullptr && live_int->getHintReg() == INVALID_REG)
+            live_int->setHintReg(reg);
+    };
+    // arguments numbers are counted per register class
+    auto get_arg_reg = [target](Inst* inst, std::array<size_t, REG_CLASSES_NUM>& args_num) {
+        auto reg_class = Target::getRegClass(inst->getType());
+        return target->getArgReg(reg_class, args_num[static_cast<size_t>(reg_class)]++);
+    };
+    auto get_ret_reg = [target](Inst* inst) {
+        return target->getRetReg(Target::getRegClass(inst->getType()));
+    };
+
+    std::array<size_t, REG_CLASSES_NUM> params_num{};
+    for (auto* bb : graph->getLinearOrderBBs())
+    {
+        auto bb_start = bb->getLiveInterval()->getIntervalStart();
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        {
+            auto* phi_inst = static_cast<PhiInst*>(phi);
+            auto* phi_int = live_intervals[phi];
+            for (size_t i = 0, size = phi_inst->getInputsNum(); i < size; ++i)
+            {
+                // the one allocated later takes the register of the other
+                auto* input_int = live_intervals[phi_inst->getInput(i)];
+                auto pred_end = phi_inst->getInputBB(i)->getLiveInterval()->getIntervalEnd();
+                if (input_int->getIntervalStart() < bb_start)
+                {
+                    if (phi_int->getHint() == nullptr)
+                        phi_int->setHint(input_int, pred_end - 1);
+                }
+                else if (input_int->getHint() == nullptr)
+                    input_int->setHint(phi_int, bb_start);
+            }
+        }
+
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            switch (inst->getInstType())
+            {
+                case InstType::Param:
+                    set_hint_reg(inst, get_arg_reg(inst, params_num));
+                    break;
+                case InstType::Mov:
+                {
+                    // both sides in the register of the mov make it free
+                    auto reg = static_cast<MovInst*>(inst)->getRegNum();
+                    set_hint_reg(inst, reg);
+                    set_hint_reg(inst->getInput(0), reg);
+                    break;
+                }
+                case InstType::Return:
+                    set_hint_reg(inst->getInput(0), get_ret_reg(inst->getInput(0)));
+                    break;
+                case InstType::Call:
+                {
+                    std::array<size_t, REG_CLASSES_NUM> args_num{};
+                    for (size_t i = 0, size = inst->getInputsNum(); i < size; ++i)
+                        set_hint_reg(inst->getInput(i), get_arg_reg(inst->getInput(i), args_num));
+                    set_hint_reg(inst, get_ret_reg(inst));
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+size_t RegisterAllocation::getHintReg(LiveInterval* live_int)
+{
+    auto* parent = live_int->getSplitParent();
+    if (parent->getHintReg() != INVALID_REG)
+        return parent->getHintReg();
+
+    auto* hint = parent->getHint();
+    if (hint == nullptr || hint->getIntervalStart() > parent->getHintPos())
+        return INVALID_REG;
+    auto* part = hint->getSplitChild(parent->getHintPos());
+    return part->isRealRegister() ? part->getLocation() : INVALID_REG;
 }
 
-void RegisterAllocation::getLiveIntervals()
+void RegisterAllocation::allocateClass(RegClass reg_class)
 {
-    auto& intervals = graph->getLiveIntervals();
-    for (auto [inst, live_int] : intervals)
-        if (!live_int->isEmpty())
-            live_intervals.push_back(live_int);
+    regs_num = graph->getTarget()->getRegsNum(reg_class);
+    free_until_pos.resize(regs_num);
+    next_use_pos.resize(regs_num);
+    remat_only.resize(regs_num);
+    active.clear();
+    inactive.clear();
 
-    std::sort(live_intervals.begin(), live_intervals.end(), [](auto* left, auto* right) {
-        return left->getIntervalStart() < right->getIntervalStart();
-    });
+    for (auto* live_int : graph->getLiveIntervals())
+        if (live_int != nullptr && !live_int->isEmpty() &&
+            Target::getRegClass(live_int->getInst()->getType()) == reg_class)
+            unhandled.push(live_int);
+
+    while (!unhandled.empty())
+    {
+        auto* cur = unhandled.top();
+        unhandled.pop();
+        walkIntervals(cur->getIntervalStart());
+
+        // constants are created right where they are needed, not at the definition
+        if (cur->getSplitParent() == cur && isRematerializable(cur->getInst()))
+        {
+            auto first_use = cur->getNextUse(cur->getIntervalStart());
+            if (first_use != INVALID_LIVE_POS)
+                unhandled.push(splitInterval(cur, cur->getIntervalStart(), first_use - 1));
+            cur->setRematerialized();
+            continue;
+        }
+
+        if (!tryAllocateFreeReg(cur))
+            allocateBlockedReg(cur);
+        if (cur->isRealRegister())
+            active.push_back(cur);
+    }
 }
 
-void RegisterAllocation::linearScan()
+void RegisterAllocation::walkIntervals(size_t pos)
 {
-    for (auto* live_int : live_intervals)
+    for (size_t i = 0; i < active.size();)
     {
-        expireOldIntervals(live_int);
-        if (used_regs == REG_NUM)
+        auto* live_int = active[i];
+        if (live_int->getIntervalEnd() > pos && live_int->covers(pos))
         {
-            spillAtInterval(live_int);
+            ++i;
+            continue;
         }
-        else
+        if (live_int->getIntervalEnd() > pos)
+            inactive.push_back(live_int);
+        active[i] = active.back();
+        active.pop_back();
+    }
+
+    for (size_t i = 0; i < inactive.size();)
+    {
+        auto* live_int = inactive[i];
+        if (live_int->getIntervalEnd() > pos && !live_int->covers(pos))
         {
-            auto reg = getReg();
-            live_int->setLocation(reg);
-            active_intervals.insert(live_int);
+            ++i;
+            continue;
         }
+        if (live_int->getIntervalEnd() > pos)
+            active.push_back(live_int);
+        inactive[i] = inactive.back();
+        inactive.pop_back();
     }
 }
 
-void RegisterAllocation::expireOldIntervals(LiveInterval* curr)
+bool RegisterAllocation::tryAllocateFreeReg(LiveInterval* cur)
+{
+    if (regs_num == 0)
+        return false;
+
+    std::fill(free_until_pos.begin(), free_until_pos.end(), INVALID_LIVE_POS);
+    for (auto* live_int : active)
+        free_until_pos[live_int->getLocation()] = 0;
+    for (auto* live_int : inactive)
+    {
+        auto& free_until = free_until_pos[live_int->getLocation()];
+        free_until = std::min(free_until, live_int->findIntersection(cur));
+    }
+
+    auto reg = static_cast<size_t>(std::max_element(free_until_pos.begin(), free_until_pos.end()) -
+                                   free_until_pos.begin());
+    // the hint is taken if it is free as long as the best register or up to the end of cur
+    auto hint_reg = getHintReg(cur);
+    if (hint_reg < regs_num &&
+        free_until_pos[hint_reg] >= std::min(free_until_pos[reg], cur->getIntervalEnd()))
+        reg = hint_reg;
+    auto free_until = alignSplitPos(free_until_pos[reg]);
+    if (free_until <= cur->getIntervalStart())
+        return false;
+
+    // the register is free only for the first part of cur
+    if (free_until < cur->getIntervalEnd())
+        unhandled.push(splitInterval(cur, cur->getIntervalStart(), free_until));
+    cur->setRegister(reg);
+    return true;
+}
+
+void RegisterAllocation::allocateBlockedReg(LiveInterval* cur)
 {
-    for (auto it = active_intervals.begin(), ite = active_intervals.end(); it != ite;)
+    auto pos = cur->getIntervalStart();
+    if (regs_num == 0)
     {
-        auto* live_int = *it;
-        if (live_int->getIntervalEnd() > curr->getIntervalStart())
-            return;
+        spillInterval(cur);
+        return;
+    }
+
+    std::fill(next_use_pos.begin(), next_use_pos.end(), INVALID_LIVE_POS);
+    std::fill(remat_only.begin(), remat_only.end(), true);
+    auto block_reg = [this, pos](LiveInterval* live_int) {
         auto reg = live_int->getLocation();
-        ASSERT(reg != INVALID_REG);
-        releaseReg(reg);
-        it = active_intervals.erase(it);
+        next_use_pos[reg] = std::min(next_use_pos[reg], live_int->getNextUse(pos));
+        remat_only[reg] = remat_only[reg] && isRematerializable(live_int->getInst());
+    };
+    for (auto* live_int : active)
+        block_reg(live_int);
+    for (auto* live_int : inactive)
+        if (live_int->intersects(cur))
+            block_reg(live_int);
+
+    auto reg = static_cast<size_t>(std::max_element(next_use_pos.begin(), next_use_pos.end()) -
+                                   next_use_pos.begin());
+    auto first_use = cur->getNextUse(pos);
+    // evicted constants are recreated without memory access, prefer them if they are not needed
+    // before cur
+    for (size_t i = 0; i < regs_num; ++i)
+        if (remat_only[i] && next_use_pos[i] > first_use &&
+            (!remat_only[reg] || next_use_pos[i] > next_use_pos[reg]))
+            reg = i;
+    if (first_use > next_use_pos[reg])
+    {
+        // other values are needed earlier: keep cur on the stack up to its first use
+        if (first_use != INVALID_LIVE_POS)
+            unhandled.push(splitInterval(cur, pos, first_use - 1));
+        spillInterval(cur);
+        return;
+    }
+
+    // cur takes the register, its owners are spilled from here up to their next uses
+    cur->setRegister(reg);
+    for (size_t i = 0; i < active.size();)
+    {
+        auto* live_int = active[i];
+        if (live_int->getLocation() != reg)
+        {
+            ++i;
+            continue;
+        }
+        splitAndSpill(live_int, pos);
+        active[i] = active.back();
+        active.pop_back();
+    }
+    for (size_t i = 0; i < inactive.size();)
+    {
+        auto* live_int = inactive[i];
+        if (live_int->getLocation() != reg || !live_int->intersects(cur))
+        {
+            ++i;
+            continue;
+        }
+        splitAndSpill(live_int, pos);
+        inactive[i] = inactive.back();
+        inactive.pop_back();
     }
 }
 
-void RegisterAllocation::spillAtInterval(LiveInterval* curr)
+void RegisterAllocation::spillInterval(LiveInterval* live_int)
 {
-    auto it = std::prev(active_intervals.end());
-    auto spill = *it;
-    if (spill->getIntervalEnd() > curr->getIntervalEnd())
+    if (isRematerializable(live_int->getInst()))
     {
-        auto reg = spill->getLocation();
-        ASSERT(reg != INVALID_REG);
-        curr->setLocation(reg);
-        spill->setLocation(cur_spill_fill);
-        spill->setNeedSpillFill();
-        ++cur_spill_fill;
-        active_intervals.erase(spill);
-        active_intervals.insert(curr);
+        live_int->setRematerialized();
+        return;
     }
-    else
+    auto& slot = spill_slots[live_int->getInst()];
+    if (slot == INVALID_REG)
+        slot = cur_spill_slot++;
+    live_int->setSpillSlot(slot);
+}
+
+void RegisterAllocation::splitAndSpill(LiveInterval* live_int, size_t pos)
+{
+    // the part before pos keeps the register, it is split after its last use
+    auto* spilled = live_int;
+    auto start = live_int->getIntervalStart();
+    if (start < alignSplitPos(pos))
     {
-        curr->setLocation(cur_spill_fill);
-        curr->setNeedSpillFill();
-        ++cur_spill_fill;
+        auto prev_use = live_int->getPrevUse(pos);
+        auto min_pos = prev_use != INVALID_LIVE_POS ? std::max(prev_use, start) : start;
+        spilled = splitInterval(live_int, min_pos, pos);
     }
+
+    auto next_use = spilled->getNextUse(pos);
+    auto min_pos = std::max(spilled->getIntervalStart(), pos);
+    // can't be reloaded before the use only if there are not enough registers for inputs
+    if (next_use != INVALID_LIVE_POS && next_use - 1 > min_pos)
+        unhandled.push(splitInterval(spilled, min_pos, next_use - 1));
+    spillInterval(spilled);
+}
+
+RegAllocStats countSpillCode(Graph* graph)
+{
+    RegAllocStats stats;
+    for (auto* live_int : graph->getLiveIntervals())
+    {
+        if (live_int == nullptr || live_int->isEmpty())
+            continue;
+
+        // spilled at the definition
+        bool stored = live_int->isStackSlot();
+        stats.spills += stored;
+        // a constant rematerialized at its definition is created at the first register part
+        bool created = live_int->isRealRegister();
+        auto* prev = live_int;
+        for (auto* part : live_int->getSplitChildren())
+        {
+            if (part->isStackSlot() && !stored)
+                ++stats.spills;
+            stored |= part->isStackSlot();
+
+            if (part->isRealRegister() && prev->isStackSlot())
+                ++stats.fills;
+            else if (part->isRealRegister() && prev->isRematerialized() && created)
+                ++stats.remats;
+            created |= part->isRealRegister();
+            prev = part;
+        }
+    }
+    return stats;
+}
+
+bool resolveRegAlloc(Graph* graph)
+{
+    return graph->runPass<StackSlotsAllocation>() && graph->runPass<MovesElimination>() &&
+           graph->runPass<SsaDestruction>();
+}
+
+LiveInterval* RegisterAllocation::splitInterval(LiveInterval* live_int, size_t min_pos,
+                                                size_t max_pos)
+{
+    auto* child = graph->create<LiveInterval>();
+    live_int->split(findSplitPos(min_pos, max_pos), child);
+    return child;
+}
+
+size_t RegisterAllocation::findSplitPos(size_t min_pos, size_t max_pos)
+{
+    max_pos = alignSplitPos(max_pos);
+    ASSERT(min_pos < max_pos, "empty split range");
+
+    // the latest block boundary out of the deepest loops, moves there are executed less often
+    auto min_idx = std::upper_bound(bb_starts.begin(), bb_starts.end(), min_pos) - bb_starts.begin();
+    auto max_idx = std::upper_bound(bb_starts.begin(), bb_starts.end(), max_pos) - bb_starts.begin();
+    auto split_pos = max_pos;
+    auto split_depth = bb_depths[max_idx - 1];
+    for (auto idx = max_idx; idx-- > min_idx;)
+        if (bb_depths[idx] < split_depth)
+        {
+            split_pos = bb_starts[idx];
+            split_depth = bb_depths[idx];
+        }
+    return split_pos;
+}
+
+// insts are at even positions: a split there moves to the gap before the inst
+size_t RegisterAllocation::alignSplitPos(size_t pos) const
+{
+    if (pos % 2 == 1 || std::binary_search(bb_starts.begin(), bb_starts.end(), pos))
+        return pos;
+    return pos - 1;
 }
 
 } // namespace compiler
\ No newline at end of file
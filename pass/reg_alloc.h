@@ -3,8 +3,7 @@
 #include "ir/graph.h"
 #include "liveness.h"
 #include "pass.h"
-#include <bitset>
-#include <set>
+#include <queue>
 #include <vector>
 
 namespace compiler
@@ -12,15 +11,45 @@ namespace compiler
 
 class LiveInterval;
 
-constexpr size_t REG_NUM = 2;
-constexpr size_t INST_NUM = 50;
+// values recreated by one instruction without inputs, so they are never stored to the stack
+inline bool isRematerializable(Inst* inst)
+{
+    return inst->isConstInst();
+}
+
+/**
+ * Shared by the allocators: hints of values to registers, spill code counting for
+ * the graph RegAllocStats, and the passes run after the allocation.
+ */
+void calcRegAllocHints(Graph* graph);
+RegAllocStats countSpillCode(Graph* graph);
+bool resolveRegAlloc(Graph* graph);
 
+/**
+ * SSA linear scan (Wimmer, Franz 2010) over the target register file, every register class
+ * is allocated independently. Intervals with lifetime holes are split instead of spilled whole:
+ * a value gets a register while it is free, and is spilled only between its uses.
+ * Split positions are moved to block boundaries with the lowest loop depth, inside blocks they
+ * are between instructions, so moves there never clobber inputs or outputs of an instruction.
+ * All uses need the value in a register, a spilled part ends right before the next use.
+ * Every spilled value has one stack slot shared by all its spilled parts,
+ * then StackSlotsAllocation packs the slots into the frame.
+ * Constants are never spilled: they get a register from their first use and are recreated
+ * at the next use after eviction.
+ * A free register is chosen by hints if it is free long enough: values connected by phis
+ * prefer the same register, params, call args and results, returned values and inputs of movs
+ * prefer their fixed registers.
+ * Then StackSlotsAllocation lays out the frame, MovesElimination deletes coalesced movs
+ * and SsaDestruction inserts moves between locations of the parts.
+ * Graphs with RegAllocKind::GraphColoring are given to GraphColoringAllocation instead.
+ */
 class RegisterAllocation final : public Optimization
 {
   public:
-    explicit RegisterAllocation(Graph* g) : Optimization(g), active_intervals(&decrIntervalEndComp)
+    explicit RegisterAllocation(Graph* g) : Optimization(g), spill_slots(INVALID_REG)
     {
-        live_intervals.reserve(GRAPH_INST_NUM);
+        active.reserve(MAX_REGS_NUM);
+        inactive.reserve(MAX_REGS_NUM);
     }
 
     ~RegisterAllocation() override = default;
@@ -32,45 +61,56 @@ class RegisterAllocation final : public Optimization
         return "RegisterAllocation";
     }
 
-  private:
-    size_t getReg()
+    // live intervals are split, so liveness has to be rebuilt for the next allocation
+    analyses_mask_t getPreservedAnalyses() const noexcept override
     {
-        if (used_regs == REG_NUM)
-            return INVALID_REG;
-        for (size_t i = 0; i < REG_NUM; ++i)
-            if (regs[i] == 0)
-            {
-                regs[i] = 1;
-                ++used_regs;
-                return i;
-            }
-        UNREACHABLE();
+        return ALL_ANALYSES & ~makeAnalysesMask<LivenessAnalysis>();
     }
 
-    void releaseReg(size_t number)
-    {
-        ASSERT(number < REG_NUM, "incorrect reg number");
-        regs[number] = 0;
-        --used_regs;
-    }
+  private:
+    void calcBlocksLoopDepth();
+    size_t getHintReg(LiveInterval* live_int);
+    void allocateClass(RegClass reg_class);
+    void walkIntervals(size_t pos);
+    bool tryAllocateFreeReg(LiveInterval* cur);
+    void allocateBlockedReg(LiveInterval* cur);
 
-    void getLiveIntervals();
-    void linearScan();
-    void expireOldIntervals(LiveInterval* curr);
-    void spillAtInterval(LiveInterval* curr);
+    void spillInterval(LiveInterval* live_int);
+    void splitAndSpill(LiveInterval* live_int, size_t pos);
+    LiveInterval* splitInterval(LiveInterval* live_int, size_t min_pos, size_t max_pos);
+    size_t findSplitPos(size_t min_pos, size_t max_pos);
+    size_t alignSplitPos(size_t pos) const;
 
-    static bool decrIntervalEndComp(LiveInterval* left, LiveInterval* right)
+    static bool laterStartComp(LiveInterval* left, LiveInterval* right)
     {
-        return left->getIntervalEnd() < right->getIntervalEnd();
+        auto left_start = left->getIntervalStart();
+        auto right_start = right->getIntervalStart();
+        if (left_start != right_start)
+            return left_start > right_start;
+        return left->getInst()->getDenseId() > right->getInst()->getDenseId();
     }
-    using decrIntervalEndComp_t = decltype(&decrIntervalEndComp);
+    using laterStartComp_t = decltype(&laterStartComp);
 
   private:
-    std::vector<LiveInterval*> live_intervals;
-    std::set<LiveInterval*, decrIntervalEndComp_t> active_intervals;
-    std::bitset<REG_NUM> regs; // 1 if used, 0 if free
-    size_t used_regs = 0;
-    size_t cur_spill_fill = 0;
+    size_t regs_num = 0;
+    size_t cur_spill_slot = 0;
+    // one slot per value, indexed by inst dense id
+    IdVector<size_t> spill_slots;
+
+    std::priority_queue<LiveInterval*, std::vector<LiveInterval*>, laterStartComp_t> unhandled{
+        &laterStartComp};
+    std::vector<LiveInterval*> active;
+    std::vector<LiveInterval*> inactive;
+
+    // per register positions for the current interval
+    std::vector<size_t> free_until_pos;
+    std::vector<size_t> next_use_pos;
+    // register is held by rematerializable values only
+    std::vector<bool> remat_only;
+
+    // linear order block starts and loop depths, to find split positions
+    std::vector<size_t> bb_starts;
+    std::vector<size_t> bb_depths;
 };
 
 } // namespace compiler
\ No newline at end of file
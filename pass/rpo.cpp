@@ -3,40 +3,56 @@
 namespace compiler
 {
 
-Rpo::Rpo(Graph* g, marker_t marker) : Analysis(g), visited(marker)
+Rpo::Rpo(Graph* g) : Analysis(g)
 {
-    size_t size = g->size();
-    rpo_bbs.reserve(size);
-    // rpo_bbs.resize(size);
-    // cur_num = size-1;
+    rpo_bbs.reserve(g->size());
 }
 
-void Rpo::visitBasicBlock(BasicBlock* bb)
+void Rpo::visitSucc(BasicBlock* succ)
 {
-    ASSERT(bb != nullptr, "nullptr bb in RPO pass");
-    if (bb->isMarked(visited))
+    if (succ == nullptr || succ->isMarked(visited))
         return;
+    succ->setMarker(visited);
+    stack.emplace_back(succ, 0);
+}
 
-    auto* true_succ = bb->getTrueSucc();
-    auto* false_succ = bb->getFalseSucc();
-
-    bb->setMarker(visited);
-
-    if (true_succ != nullptr)
-        visitBasicBlock(true_succ);
-    if (false_succ != nullptr)
-        visitBasicBlock(false_succ);
+/**
+ * Iterative DFS, gives the same order as the recursive one:
+ * true successor is visited before false successor, bb is added after both
+ */
+void Rpo::visitBasicBlock(BasicBlock* bb)
+{
+    ASSERT(bb != nullptr, "nullptr bb in RPO pass");
+    ASSERT(stack.empty());
+    visitSucc(bb);
 
-    // rpo_bbs[cur_num--] = bb;
-    rpo_bbs.push_back(bb);
+    while (!stack.empty())
+    {
+        auto& [cur_bb, succ_idx] = stack.back();
+        if (succ_idx == 0)
+        {
+            succ_idx = 1;
+            visitSucc(cur_bb->getTrueSucc());
+        }
+        else if (succ_idx == 1)
+        {
+            succ_idx = 2;
+            visitSucc(cur_bb->getFalseSucc());
+        }
+        else
+        {
+            rpo_bbs.push_back(cur_bb);
+            stack.pop_back();
+        }
+    }
 }
 
 bool Rpo::runPassImpl()
 {
     ASSERT(graph != nullptr, "nullptr graph in RPO pass");
 
-    if (visited == NO_MARKER)
-        visited = graph->getNewMarker();
+    rpo_bbs.clear();
+    visited = graph->getNewMarker();
 
     auto bbs = graph->getBBs();
     ASSERT(bbs.size() > 0, "empty graph in RPO");
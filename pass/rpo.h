@@ -6,13 +6,10 @@
 namespace compiler
 {
 
-#define NO_MARKER 1000
-
-// TODO: fix algo when implement fast DomTree
 class Rpo final : public Analysis
 {
   public:
-    Rpo(Graph* g, marker_t marker = NO_MARKER);
+    explicit Rpo(Graph* g);
     ~Rpo() override = default;
 
     bool runPassImpl() override;
@@ -30,11 +27,12 @@ class Rpo final : public Analysis
 
   private:
     void visitBasicBlock(BasicBlock* bb);
+    void visitSucc(BasicBlock* succ);
 
   private:
-    // size_t cur_num;
     std::vector<BasicBlock*> rpo_bbs;
-    marker_t visited = NO_MARKER;
+    bb_stack_t stack;
+    marker_t visited;
 };
 
 } // namespace compiler
\ No newline at end of file
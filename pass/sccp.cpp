@@ -0,0 +1,373 @@
+#include "sccp.h"
+#include "ir/evaluator.h"
+#include <array>
+
+namespace compiler
+{
+
+namespace
+{
+
+bool isConditionalJump(Inst* inst)
+{
+    return inst != nullptr && inst->isJumpInst() && inst->getInstType() != InstType::Jmp;
+}
+
+// the flags of a conditional jump are set by the last Cmp before it
+Inst* findCmp(Inst* jump)
+{
+    auto* inst = jump->getPrev();
+    while (inst != nullptr && inst->getInstType() != InstType::Cmp)
+        inst = inst->getPrev();
+    return inst;
+}
+
+} // namespace
+
+bool Sccp::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in Sccp pass");
+    auto* first_bb = graph->getFirstBB();
+    if (first_bb == nullptr)
+        return true;
+
+    values.clear();
+    values.resize(graph->getInstsDenseNum());
+    edges.clear();
+    edges.resize(graph->getBBsDenseNum());
+    inst_worklist.clear();
+    bb_worklist.clear();
+
+    executable = graph->getNewMarker();
+    visited = graph->getNewMarker();
+    markEdge(nullptr, first_bb, TRUE_EDGE);
+    propagate();
+    rewrite();
+    graph->deleteMarker(visited);
+    graph->deleteMarker(executable);
+
+    graph->renumberDenseIds();
+    return true;
+}
+
+void Sccp::propagate()
+{
+    while (!inst_worklist.empty() || !bb_worklist.empty())
+    {
+        while (!inst_worklist.empty())
+        {
+            auto* inst = inst_worklist.back();
+            inst_worklist.pop_back();
+            visitInst(inst);
+        }
+
+        if (!bb_worklist.empty())
+        {
+            auto* bb = bb_worklist.back();
+            bb_worklist.pop_back();
+            visitBlock(bb);
+        }
+    }
+}
+
+void Sccp::markEdge(BasicBlock* pred, BasicBlock* succ, uint8_t edge)
+{
+    if (pred != nullptr)
+    {
+        if ((edges[pred] & edge) != 0)
+            return;
+        edges[pred] |= edge;
+    }
+
+    if (!succ->isMarked(executable))
+    {
+        succ->setMarker(executable);
+        bb_worklist.push_back(succ);
+        return;
+    }
+    if (!succ->isMarked(visited))
+        return;
+    // a new edge into already visited block can change its phis only
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        inst_worklist.push_back(phi);
+}
+
+bool Sccp::isEdgeExecutable(BasicBlock* pred, BasicBlock* succ) const
+{
+    auto flags = edges.get(pred);
+    return (pred->getTrueSucc() == succ && (flags & TRUE_EDGE) != 0) ||
+           (pred->getFalseSucc() == succ && (flags & FALSE_EDGE) != 0);
+}
+
+void Sccp::visitBlock(BasicBlock* bb)
+{
+    bb->setMarker(visited);
+    for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        visitInst(phi);
+    for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        visitInst(inst);
+    visitSuccs(bb);
+}
+
+void Sccp::visitInst(Inst* inst)
+{
+    auto value = evaluate(inst);
+    auto& old_value = values[inst];
+    if (value.kind == old_value.kind && value.bits == old_value.bits)
+        return;
+    ASSERT(old_value.kind < value.kind, "lattice value can only go down");
+    old_value.kind = value.kind;
+    old_value.bits = value.bits;
+
+    // users of not read values and users in not visited yet blocks will see the new value,
+    // so scans of long users lists are mostly avoided
+    if (old_value.is_read)
+        for (auto* user : inst->getUsers())
+            if (user->getBB()->isMarked(visited))
+                inst_worklist.push_back(user);
+    // the flags are used by the jump implicitly
+    if (inst->getInstType() == InstType::Cmp)
+        visitSuccs(inst->getBB());
+}
+
+void Sccp::visitSuccs(BasicBlock* bb)
+{
+    auto* jump = bb->getLastInst();
+    if (isConditionalJump(jump))
+    {
+        auto* cmp = findCmp(jump);
+        auto flags = cmp != nullptr ? values.get(cmp) : LatticeValue{LatticeKind::Bottom};
+        if (flags.kind == LatticeKind::Top)
+            return;
+        if (flags.kind == LatticeKind::Const)
+        {
+            // the successors can be the same block, so the taken edge is passed explicitly
+            if (evaluateCondition(jump->getInstType(), flags.bits))
+            {
+                if (bb->getFalseSucc() != nullptr)
+                    markEdge(bb, bb->getFalseSucc(), FALSE_EDGE);
+            }
+            else if (bb->getTrueSucc() != nullptr)
+                markEdge(bb, bb->getTrueSucc(), TRUE_EDGE);
+            return;
+        }
+    }
+
+    if (bb->getTrueSucc() != nullptr)
+        markEdge(bb, bb->getTrueSucc(), TRUE_EDGE);
+    if (bb->getFalseSucc() != nullptr)
+        markEdge(bb, bb->getFalseSucc(), FALSE_EDGE);
+}
+
+Sccp::LatticeValue Sccp::evaluate(Inst* inst)
+{
+    constexpr LatticeValue TOP{LatticeKind::Top};
+    constexpr LatticeValue BOTTOM{LatticeKind::Bottom};
+
+    auto type = inst->getInstType();
+    if (type == InstType::Const)
+        return LatticeValue{LatticeKind::Const, static_cast<ConstInst*>(inst)->getRawValue()};
+    if (type == InstType::Phi)
+        return evaluatePhi(static_cast<PhiInst*>(inst));
+
+    bool is_binary = inst->isBinaryInst() || type == InstType::BoundsCheck;
+    bool is_unary = type == InstType::Not || type == InstType::Neg ||
+                    type == InstType::ZeroCheck || type == InstType::Cast;
+    if (!is_binary && !is_unary)
+        return BOTTOM;
+
+    // the result of Bottom does not change, the rest of inputs is not read
+    std::array<uint64_t, 2> inputs{};
+    bool has_top = false;
+    for (size_t i = 0, size = inst->getInputsNum(); i < size; ++i)
+    {
+        auto value = readValue(inst->getInput(i));
+        if (value.kind == LatticeKind::Bottom)
+            return BOTTOM;
+        has_top |= value.kind == LatticeKind::Top;
+        inputs[i] = value.bits;
+    }
+    if (has_top)
+        return TOP;
+
+    // operations failing at runtime (division by zero, failed checks) are not folded
+    EvalResult result;
+    if (type == InstType::Cast)
+    {
+        auto* cast = static_cast<CastInst*>(inst);
+        result = evaluateCast(cast->getFromType(), cast->getToType(), inputs[0]);
+    }
+    else if (is_binary)
+        result = evaluateBinary(type, inst->getType(), inputs[0], inputs[1]);
+    else
+        result = evaluateUnary(type, inst->getType(), inputs[0]);
+    if (!result.isOk())
+        return BOTTOM;
+    return LatticeValue{LatticeKind::Const, result.bits};
+}
+
+Sccp::LatticeValue Sccp::evaluatePhi(PhiInst* phi)
+{
+    auto* bb = phi->getBB();
+    LatticeValue result{LatticeKind::Top};
+    for (size_t i = 0, size = phi->getInputsNum(); i < size; ++i)
+    {
+        if (!isEdgeExecutable(phi->getInputBB(i), bb))
+            continue;
+        auto value = readValue(phi->getInput(i));
+        if (value.kind == LatticeKind::Top)
+            continue;
+        if (value.kind == LatticeKind::Bottom ||
+            (result.kind == LatticeKind::Const && result.bits != value.bits))
+            return LatticeValue{LatticeKind::Bottom};
+        result = value;
+    }
+    return result;
+}
+
+Sccp::LatticeValue Sccp::readValue(Inst* input)
+{
+    auto& value = values[input];
+    value.is_read = true;
+    return value;
+}
+
+void Sccp::rewrite()
+{
+    for (auto* bb : graph->getBBs())
+        if (bb->isMarked(executable))
+            replaceConstants(bb);
+
+    for (auto* bb : graph->getBBs())
+    {
+        if (bb->isMarked(executable))
+            removeDeadEdges(bb);
+        else
+            removeBlock(bb);
+    }
+    graph->removeUnmarkedBBs(executable);
+
+    // phis of blocks which lost all preds but one are copies
+    for (auto* bb : graph->getBBs())
+    {
+        auto* phi = bb->getFirstPhi();
+        while (phi != nullptr)
+        {
+            auto* next = phi->getNext();
+            if (phi->getInputsNum() == 1 && phi->getInput(0) != phi)
+            {
+                phi->replaceUsers(phi->getInput(0));
+                bb->removeInst(phi);
+            }
+            phi = next;
+        }
+    }
+}
+
+void Sccp::replaceConstants(BasicBlock* bb)
+{
+    auto replace = [this, bb](Inst* inst) {
+        auto value = values.get(inst);
+        if (value.kind != LatticeKind::Const || inst->isConstInst() ||
+            inst->getInstType() == InstType::Cmp)
+            return;
+        if (inst->hasUsers())
+            inst->replaceUsers(graph->findConstant(inst->getType(), value.bits));
+        bb->removeInst(inst);
+    };
+
+    for (auto* phi = bb->getFirstPhi(); phi != nullptr;)
+    {
+        auto* next = phi->getNext();
+        replace(phi);
+        phi = next;
+    }
+    // constants created here go to the end of the first block and are skipped
+    for (auto* inst = bb->getFirstInst(); inst != nullptr;)
+    {
+        auto* next = inst->getNext();
+        replace(inst);
+        inst = next;
+    }
+}
+
+void Sccp::removeDeadEdges(BasicBlock* bb)
+{
+    auto flags = edges.get(bb);
+    auto* true_succ = bb->getTrueSucc();
+    auto* false_succ = bb->getFalseSucc();
+    bool is_removed = false;
+    if (true_succ != nullptr && true_succ == false_succ)
+    {
+        // both ways of the branch are one edge, so the branch is a plain jump
+        bb->setFalseSucc(nullptr);
+        if (flags == 0)
+            removeEdge(bb, true_succ);
+        is_removed = true;
+    }
+    else
+    {
+        if (true_succ != nullptr && (flags & TRUE_EDGE) == 0)
+        {
+            removeEdge(bb, true_succ);
+            is_removed = true;
+        }
+        if (false_succ != nullptr && (flags & FALSE_EDGE) == 0)
+        {
+            removeEdge(bb, false_succ);
+            is_removed = true;
+        }
+    }
+    if (!is_removed)
+        return;
+
+    // the only successor is the true one
+    if (bb->getTrueSucc() == nullptr && bb->getFalseSucc() != nullptr)
+    {
+        bb->setTrueSucc(bb->getFalseSucc());
+        bb->setFalseSucc(nullptr);
+    }
+
+    auto* jump = bb->getLastInst();
+    if (!isConditionalJump(jump))
+        return;
+    auto* succ = bb->getTrueSucc();
+    ASSERT(succ != nullptr, "executable block without executable successors");
+    if (auto* cmp = findCmp(jump); cmp != nullptr)
+        bb->removeInst(cmp);
+    bb->removeInst(jump);
+    bb->pushBackInst(graph->create<JumpInst>(graph->getCurInstId(), InstType::Jmp, succ));
+    graph->setCurInstId(graph->getCurInstId() + 1);
+}
+
+void Sccp::removeEdge(BasicBlock* pred, BasicBlock* succ)
+{
+    pred->removeSucc(succ);
+    succ->removePred(pred);
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    {
+        auto* phi_inst = static_cast<PhiInst*>(phi);
+        for (size_t i = 0; i < phi_inst->getInputsNum(); ++i)
+        {
+            if (phi_inst->getInputBB(i) == pred)
+            {
+                phi_inst->removeInput(i);
+                break;
+            }
+        }
+    }
+}
+
+void Sccp::removeBlock(BasicBlock* bb)
+{
+    for (auto* succ : {bb->getTrueSucc(), bb->getFalseSucc()})
+        if (succ != nullptr && succ->isMarked(executable))
+            removeEdge(bb, succ);
+
+    while (bb->getFirstPhi() != nullptr)
+        bb->removeInst(bb->getFirstPhi());
+    while (bb->getFirstInst() != nullptr)
+        bb->removeInst(bb->getFirstInst());
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "pass.h"
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Sparse Conditional Constant Propagation (Wegman-Zadeck).
+ * Values are propagated along def-use edges and only along CFG edges proven executable:
+ * phis meet the inputs of executable edges only, Cmp with constant inputs decides its
+ * conditional jump, so constants flow through branches that never go the other way.
+ * After the fixed point the graph is rewritten once: constant values replace their insts,
+ * decided jumps become Jmp, never executed edges and blocks are removed.
+ */
+class Sccp final : public Optimization
+{
+  public:
+    explicit Sccp(Graph* g) : Optimization(g)
+    {}
+
+    ~Sccp() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "Sccp";
+    }
+
+    // removed edges and blocks change the CFG version, that invalidates the CFG analyses
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return CFG_ANALYSES;
+    }
+
+  private:
+    enum class LatticeKind : uint8_t
+    {
+        // no value is known yet
+        Top = 0,
+        Const,
+        // not a constant
+        Bottom
+    };
+
+    // a Cmp keeps its flags in bits (see makeFlags in sccp.cpp)
+    struct LatticeValue
+    {
+        LatticeKind kind = LatticeKind::Top;
+        uint64_t bits = 0;
+        // some user was evaluated with the value, so its change has to be propagated
+        bool is_read = false;
+    };
+
+    // bits of executable out edges in edges side table
+    static constexpr uint8_t TRUE_EDGE = 1;
+    static constexpr uint8_t FALSE_EDGE = 2;
+
+    void propagate();
+    void markEdge(BasicBlock* pred, BasicBlock* succ, uint8_t edge);
+    bool isEdgeExecutable(BasicBlock* pred, BasicBlock* succ) const;
+    void visitBlock(BasicBlock* bb);
+    void visitInst(Inst* inst);
+    void visitSuccs(BasicBlock* bb);
+    LatticeValue evaluate(Inst* inst);
+    LatticeValue evaluatePhi(PhiInst* phi);
+    LatticeValue readValue(Inst* input);
+
+    void rewrite();
+    void replaceConstants(BasicBlock* bb);
+    void removeDeadEdges(BasicBlock* bb);
+    void removeEdge(BasicBlock* pred, BasicBlock* succ);
+    void removeBlock(BasicBlock* bb);
+
+  private:
+    // indexed by inst dense id
+    IdVector<LatticeValue> values;
+    // indexed by bb dense id
+    IdVector<uint8_t> edges{0};
+    marker_t executable = EMPTY_MARKER;
+    // the block insts were evaluated, later changes of inputs are propagated to them
+    marker_t visited = EMPTY_MARKER;
+
+    std::vector<Inst*> inst_worklist;
+    std::vector<BasicBlock*> bb_worklist;
+};
+
+} // namespace compiler
\ No newline at end of file
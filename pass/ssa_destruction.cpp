@@ -0,0 +1,117 @@
+#include "ssa_destruction.h"
+
+namespace compiler
+{
+
+bool SsaDestruction::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in SsaDestruction pass");
+    ASSERT(graph->isAnalysisValid<LivenessAnalysis>(),
+           "SsaDestruction needs live intervals of the register allocation");
+
+    liveness = graph->getAnalysis<LivenessAnalysis>();
+    linear_bbs = graph->getLinearOrderBBs();
+    bb_starts.clear();
+    for (auto* bb : linear_bbs)
+        bb_starts.push_back(bb->getLiveInterval()->getIntervalStart());
+
+    resolveSplitPositions();
+    for (auto* succ : linear_bbs)
+    {
+        // critical edges splitting replaces preds
+        auto preds = succ->getPreds();
+        for (auto* pred : preds)
+            resolveEdge(pred, succ);
+    }
+
+    auto stats = graph->getRegAllocStats();
+    stats.moves = resolver.getMovesNum();
+    stats.swaps = resolver.getSwapsNum();
+    graph->setRegAllocStats(stats);
+    return true;
+}
+
+void SsaDestruction::resolveSplitPositions()
+{
+    // parts started at block starts get their values on the edges
+    std::vector<LiveInterval*> parts;
+    for (auto* live_int : graph->getLiveIntervals())
+        if (live_int != nullptr)
+            for (auto* part : live_int->getSplitChildren())
+                if (!std::binary_search(bb_starts.begin(), bb_starts.end(),
+                                        part->getIntervalStart()))
+                    parts.push_back(part);
+    std::sort(parts.begin(), parts.end(), [](LiveInterval* left, LiveInterval* right) {
+        auto left_start = left->getIntervalStart();
+        auto right_start = right->getIntervalStart();
+        if (left_start != right_start)
+            return left_start < right_start;
+        return left->getInst()->getDenseId() < right->getInst()->getDenseId();
+    });
+
+    for (size_t i = 0; i < parts.size();)
+    {
+        auto pos = parts[i]->getIntervalStart();
+        for (; i < parts.size() && parts[i]->getIntervalStart() == pos; ++i)
+        {
+            auto* prev = parts[i]->getSplitChild(pos - 1);
+            resolver.addMove(parts[i]->getInst(), prev->toLocation(), parts[i]->toLocation());
+        }
+        auto* bb = linear_bbs[std::upper_bound(bb_starts.begin(), bb_starts.end(), pos) -
+                              bb_starts.begin() - 1];
+        resolver.emit(bb, findInsertPoint(bb, pos));
+    }
+}
+
+void SsaDestruction::resolveEdge(BasicBlock* pred, BasicBlock* succ)
+{
+    auto pred_end = pred->getLiveInterval()->getIntervalEnd();
+    auto succ_start = succ->getLiveInterval()->getIntervalStart();
+    auto& live_intervals = graph->getLiveIntervals();
+
+    liveness->getLiveIn(succ).forEach([this, &live_intervals, pred_end, succ_start](size_t id) {
+        auto* live_int = live_intervals[id];
+        resolver.addMove(live_int->getInst(), live_int->getSplitChild(pred_end - 1)->toLocation(),
+                         live_int->getSplitChild(succ_start)->toLocation());
+    });
+    for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+    {
+        auto* phi_inst = static_cast<PhiInst*>(phi);
+        for (size_t i = 0, size = phi_inst->getInputsNum(); i < size; ++i)
+        {
+            if (phi_inst->getInputBB(i) != pred)
+                continue;
+            auto* input = phi_inst->getInput(i);
+            auto* input_part = live_intervals[input]->getSplitChild(pred_end - 1);
+            resolver.addMove(input, input_part->toLocation(),
+                             live_intervals[phi]->getSplitChild(succ_start)->toLocation());
+        }
+    }
+    if (resolver.isEmpty())
+        return;
+
+    if (pred->getTrueSucc() == nullptr || pred->getFalseSucc() == nullptr)
+        resolver.emit(pred, findInsertPoint(pred, pred_end));
+    else if (succ->getPreds().size() == 1)
+        resolver.emit(succ, succ->getFirstInst());
+    else
+    {
+        auto* edge_bb = graph->splitEdge(pred, succ);
+        resolver.emit(edge_bb, edge_bb->getLastInst());
+    }
+}
+
+/**
+ * Moves at pos go before the inst at pos or after it, at the end of the bb before its jump
+ */
+Inst* SsaDestruction::findInsertPoint(BasicBlock* bb, size_t pos)
+{
+    // inserted moves have no live numbers, they are passed
+    for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        if (inst->getLiveNum() >= pos)
+            return inst;
+    auto* last_inst = bb->getLastInst();
+    return last_inst != nullptr && last_inst->isJumpInst() ? last_inst : nullptr;
+}
+
+} // namespace compiler
\ No newline at end of file
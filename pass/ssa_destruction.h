@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "liveness.h"
+#include "parallel_move.h"
+#include "pass.h"
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Resolution after register allocation (Wimmer, Franz 2010), it runs on the live intervals
+ * of the allocation, so the allocation starts it itself:
+ * - a part of an interval split inside a block gets the value from the previous part
+ *   right before the split position;
+ * - on every edge values live into the successor are moved from their locations at the end
+ *   of the predecessor, phis get their inputs on the same edge.
+ * Edge moves go to the end of the predecessor if it has one successor, to the start of
+ * the successor if it has one predecessor, otherwise the critical edge is split.
+ * Moves of one point are sequentialized by ParallelMove. Phis stay in place and generate
+ * no code. Numbers of inserted moves and swaps are added to the graph RegAllocStats.
+ */
+class SsaDestruction final : public Optimization
+{
+  public:
+    explicit SsaDestruction(Graph* g) : Optimization(g), resolver(g)
+    {}
+
+    ~SsaDestruction() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "SsaDestruction";
+    }
+
+    // new insts have no live intervals, split edges change the CFG version themselves
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return ALL_ANALYSES & ~makeAnalysesMask<LivenessAnalysis>();
+    }
+
+  private:
+    void resolveSplitPositions();
+    void resolveEdge(BasicBlock* pred, BasicBlock* succ);
+    Inst* findInsertPoint(BasicBlock* bb, size_t pos);
+
+  private:
+    ParallelMove resolver;
+    LivenessAnalysis* liveness = nullptr;
+    std::vector<BasicBlock*> linear_bbs;
+    std::vector<size_t> bb_starts;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "stack_slots.h"
+
+namespace compiler
+{
+
+static bool intersects(const std::vector<LiveRange>& left, const std::vector<LiveRange>& right)
+{
+    auto it = left.begin();
+    auto right_it = right.begin();
+    while (it != left.end() && right_it != right.end())
+    {
+        if (it->end <= right_it->start)
+            ++it;
+        else if (right_it->end <= it->start)
+            ++right_it;
+        else
+            return true;
+    }
+    return false;
+}
+
+bool StackSlotsAllocation::runPassImpl()
+{
+    ASSERT(graph != nullptr, "nullptr graph in StackSlotsAllocation pass");
+
+    collectSpilledValues();
+    std::sort(values.begin(), values.end(), [](const auto& left, const auto& right) {
+        return left.lifetime.front().start < right.lifetime.front().start;
+    });
+
+    for (auto& value : values)
+    {
+        auto slot = findSlot(value);
+        if (value.live_int->isStackSlot())
+            value.live_int->setSpillSlot(slot);
+        for (auto* child : value.live_int->getSplitChildren())
+            if (child->isStackSlot())
+                child->setSpillSlot(slot);
+    }
+
+    layoutFrame();
+    return true;
+}
+
+void StackSlotsAllocation::collectSpilledValues()
+{
+    for (auto* live_int : graph->getLiveIntervals())
+    {
+        if (live_int == nullptr || live_int->isEmpty())
+            continue;
+
+        // parts go one after another, the slot is written at the first spill
+        SpilledValue value{live_int, getDataTypeSize(live_int->getInst()->getType()), {}};
+        auto add_part = [&value](LiveInterval* part) {
+            if (value.lifetime.empty() && !part->isStackSlot())
+                return;
+            for (auto& range : part->getRanges())
+            {
+                if (!value.lifetime.empty() && value.lifetime.back().end == range.start)
+                    value.lifetime.back().end = range.end;
+                else
+                    value.lifetime.push_back(range);
+            }
+        };
+        add_part(live_int);
+        for (auto* child : live_int->getSplitChildren())
+            add_part(child);
+
+        if (!value.lifetime.empty())
+            values.push_back(std::move(value));
+    }
+}
+
+size_t StackSlotsAllocation::findSlot(const SpilledValue& value)
+{
+    size_t slot_num = 0;
+    for (; slot_num < slots.size(); ++slot_num)
+        if (slots[slot_num].size == value.size &&
+            !intersects(slots[slot_num].occupied, value.lifetime))
+            break;
+    if (slot_num == slots.size())
+        slots.push_back({value.size, {}});
+
+    auto& occupied = slots[slot_num].occupied;
+    auto middle = occupied.insert(occupied.end(), value.lifetime.begin(), value.lifetime.end());
+    std::inplace_merge(occupied.begin(), middle, occupied.end(),
+                       [](const auto& left, const auto& right) { return left.start < right.start; });
+    return slot_num;
+}
+
+void StackSlotsAllocation::layoutFrame()
+{
+    std::vector<StackSlot> frame(slots.size());
+    size_t offset = 0;
+    for (size_t size : {8, 4})
+        for (size_t i = 0; i < slots.size(); ++i)
+            if (slots[i].size == size)
+            {
+                frame[i] = {offset, size};
+                offset += size;
+            }
+
+    auto align = graph->getTarget()->getStackAlign();
+    graph->setFrameSize((offset + align - 1) / align * align);
+    graph->setStackSlots(frame);
+}
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "liveness.h"
+#include "pass.h"
+#include <vector>
+
+namespace compiler
+{
+
+/**
+ * Spill slots coloring after register allocation.
+ * A spilled value holds its slot from the first spill up to the end of its live ranges,
+ * values of the same size with not intersecting slot lifetimes share a slot
+ * (first fit in the order of lifetimes starts). 8-byte slots are placed first, so every slot
+ * is aligned to its size, and the frame size is aligned to the target stack alignment.
+ */
+class StackSlotsAllocation final : public Optimization
+{
+  public:
+    explicit StackSlotsAllocation(Graph* g) : Optimization(g)
+    {}
+
+    ~StackSlotsAllocation() override = default;
+
+    bool runPassImpl() override;
+
+    std::string getOptName() const noexcept override
+    {
+        return "StackSlotsAllocation";
+    }
+
+    // only reassigns locations of spilled intervals
+    analyses_mask_t getPreservedAnalyses() const noexcept override
+    {
+        return ALL_ANALYSES;
+    }
+
+  private:
+    struct SpilledValue
+    {
+        LiveInterval* live_int = nullptr;
+        size_t size = 0;
+        std::vector<LiveRange> lifetime;
+    };
+
+    struct Slot
+    {
+        size_t size = 0;
+        // sorted lifetimes of the values in the slot
+        std::vector<LiveRange> occupied;
+    };
+
+    void collectSpilledValues();
+    size_t findSlot(const SpilledValue& value);
+    void layoutFrame();
+
+  private:
+    std::vector<SpilledValue> values;
+    std::vector<Slot> slots;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "trace.h"
+#include "pass_stats.h"
+#include <algorithm>
+#include <iomanip>
+#include <unistd.h>
+
+namespace compiler
+{
+
+namespace
+{
+
+// buffers of all threads which have ever traced, a buffer of an exited thread is reused
+struct TraceState
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    // buffers of exited threads, already flushed
+    std::vector<std::shared_ptr<TraceBuffer>> free_buffers;
+    std::ofstream file;
+    bool is_first_event = true;
+    uint64_t start_ns = 0;
+    // tracks with thread_name metadata in the current file
+    size_t named_tracks_num = 0;
+};
+
+TraceState& getState()
+{
+    static TraceState state;
+    return state;
+}
+
+const char* getCategoryName(TraceCategory category)
+{
+    switch (category)
+    {
+        case TraceCategory::Graph:
+            return "graph";
+        case TraceCategory::Analysis:
+            return "analysis";
+        case TraceCategory::Optimization:
+            return "optimization";
+        default:
+            UNREACHABLE();
+    }
+}
+
+void dumpMicroseconds(std::ostream& out, uint64_t ns)
+{
+    out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+}
+
+} // namespace
+
+bool TraceBuffer::push(const TraceEvent& event) noexcept
+{
+    auto head_pos = head.load(std::memory_order_relaxed);
+    if (head_pos - tail.load(std::memory_order_acquire) == TRACE_BUFFER_SIZE)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    events[head_pos % TRACE_BUFFER_SIZE] = event;
+    head.store(head_pos + 1, std::memory_order_release);
+    return true;
+}
+
+TraceBuffer& Tracer::getThreadBuffer()
+{
+    // gives the buffer back when its thread exits, so a thread pool with thread churn
+    // keeps as many buffers as it has threads at once
+    struct BufferOwner
+    {
+        std::shared_ptr<TraceBuffer> buffer = nullptr;
+
+        ~BufferOwner()
+        {
+            if (buffer == nullptr)
+                return;
+            auto& state = getState();
+            std::lock_guard lock(state.mutex);
+            // spans of the thread go to the file before the next thread takes the buffer
+            flushLocked();
+            buffer->drain([](const TraceEvent&) {});
+            state.free_buffers.push_back(std::move(buffer));
+        }
+    };
+
+    thread_local BufferOwner owner;
+    if (owner.buffer == nullptr)
+    {
+        auto& state = getState();
+        std::lock_guard lock(state.mutex);
+        if (!state.free_buffers.empty())
+        {
+            owner.buffer = std::move(state.free_buffers.back());
+            state.free_buffers.pop_back();
+        }
+        else
+        {
+            owner.buffer =
+                std::make_shared<TraceBuffer>(static_cast<uint32_t>(state.buffers.size() + 1));
+            state.buffers.push_back(owner.buffer);
+        }
+    }
+    return *owner.buffer;
+}
+
+bool Tracer::start(const std::string& path)
+{
+    auto& state = getState();
+    {
+        std::lock_guard lock(state.mutex);
+        if (state.file.is_open())
+            return false;
+        state.file.open(path, std::ios::out | std::ios::trunc);
+        if (!state.file.is_open())
+            return false;
+        // spans left from the previous trace
+        for (auto& buffer : state.buffers)
+            buffer->drain([](const TraceEvent&) {});
+        state.file << "[";
+        state.is_first_event = true;
+        state.named_tracks_num = 0;
+        enabled.store(true, std::memory_order_relaxed);
+        state.start_ns = now();
+    }
+    return true;
+}
+
+void Tracer::stop()
+{
+    auto& state = getState();
+    enabled.store(false, std::memory_order_relaxed);
+    std::lock_guard lock(state.mutex);
+    if (!state.file.is_open())
+        return;
+    flushLocked();
+    state.file << "\n]\n";
+    state.file.close();
+}
+
+void Tracer::flush()
+{
+    std::lock_guard lock(getState().mutex);
+    flushLocked();
+}
+
+void Tracer::flushLocked()
+{
+    auto& state = getState();
+    if (!state.file.is_open())
+        return;
+
+    auto& out = state.file;
+    auto pid = getpid();
+    auto next_event = [&state, &out]() {
+        out << (state.is_first_event ? "\n" : ",\n");
+        state.is_first_event = false;
+    };
+    for (; state.named_tracks_num < state.buffers.size(); ++state.named_tracks_num)
+    {
+        next_event();
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+            << ", \"tid\": " << state.buffers[state.named_tracks_num]->getTid()
+            << ", \"args\": {\"name\": \"compiler thread "
+            << state.buffers[state.named_tracks_num]->getTid() << "\"}}";
+    }
+    for (auto& buffer : state.buffers)
+        buffer->drain([&](const TraceEvent& event) {
+            // spans started before the trace are cut
+            auto begin_ns = std::max(event.begin_ns, state.start_ns);
+            next_event();
+            out << "{\"name\": ";
+            dumpJsonString(out, event.name.data());
+            out << ", \"cat\": \"" << getCategoryName(event.category)
+                << "\", \"ph\": \"X\", \"ts\": ";
+            dumpMicroseconds(out, begin_ns - state.start_ns);
+            out << ", \"dur\": ";
+            dumpMicroseconds(out, std::max(event.end_ns, begin_ns) - begin_ns);
+            out << ", \"pid\": " << pid << ", \"tid\": " << buffer->getTid() << "}";
+        });
+    out.flush();
+}
+
+void Tracer::addSpan(uint64_t begin_ns, const std::string& name, TraceCategory category)
+{
+    if (begin_ns == 0 || !isEnabled())
+        return;
+    TraceEvent event;
+    auto size = std::min(name.size(), TRACE_NAME_SIZE - 1);
+    std::copy_n(name.begin(), size, event.name.begin());
+    event.name[size] = '\0';
+    event.category = category;
+    event.begin_ns = begin_ns;
+    event.end_ns = now();
+    getThreadBuffer().push(event);
+}
+
+size_t Tracer::getBuffersNum()
+{
+    auto& state = getState();
+    std::lock_guard lock(state.mutex);
+    return state.buffers.size();
+}
+
+uint64_t Tracer::getDroppedNum()
+{
+    auto& state = getState();
+    std::lock_guard lock(state.mutex);
+    uint64_t num = 0;
+    for (auto& buffer : state.buffers)
+        num += buffer->getDroppedNum();
+    return num;
+}
+
+} // namespace compiler
\ No newline at end of file
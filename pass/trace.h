@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace compiler
+{
+
+enum class TraceCategory : uint8_t
+{
+    Graph,
+    Analysis,
+    Optimization,
+};
+
+constexpr size_t TRACE_NAME_SIZE = 48;
+// events of a thread between two flushes, newer ones are dropped on overflow
+constexpr size_t TRACE_BUFFER_SIZE = 8192;
+
+// complete span, the name is truncated to fit the buffer slot
+struct TraceEvent
+{
+    std::array<char, TRACE_NAME_SIZE> name;
+    TraceCategory category = TraceCategory::Graph;
+    uint64_t begin_ns = 0;
+    uint64_t end_ns = 0;
+};
+
+/**
+ * Ring buffer of spans of one thread: the thread is the only producer,
+ * Tracer::flush() is the only consumer, so push and drain need no locks.
+ */
+class TraceBuffer final
+{
+  public:
+    explicit TraceBuffer(uint32_t tid_) : tid(tid_), events(TRACE_BUFFER_SIZE)
+    {}
+
+    // false if the buffer is full and the event is dropped
+    bool push(const TraceEvent& event) noexcept;
+
+    template <typename Callback>
+    void drain(Callback&& callback)
+    {
+        auto tail_pos = tail.load(std::memory_order_relaxed);
+        auto head_pos = head.load(std::memory_order_acquire);
+        for (; tail_pos != head_pos; ++tail_pos)
+            callback(events[tail_pos % TRACE_BUFFER_SIZE]);
+        tail.store(tail_pos, std::memory_order_release);
+    }
+
+    uint32_t getTid() const noexcept
+    {
+        return tid;
+    }
+
+    uint64_t getDroppedNum() const noexcept
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    uint32_t tid = 0;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head = 0;
+    std::atomic<uint64_t> tail = 0;
+    std::atomic<uint64_t> dropped = 0;
+};
+
+/**
+ * Chrome/Perfetto trace of the compilation pipeline: spans of graphs, passes and nested
+ * analyses are written as complete ("X") events of the JSON array format, one track per
+ * compiler thread. Spans go to per-thread ring buffers, flush() appends them to the file,
+ * so it can be called periodically while threads compile. A buffer is flushed and reused
+ * when its thread exits, so threads not living at the same time share a track.
+ * Disabled tracing costs a relaxed atomic load per pass.
+ */
+class Tracer final
+{
+  public:
+    static bool isEnabled() noexcept
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // start writing the trace to the file, false if it cannot be opened
+    static bool start(const std::string& path);
+    // flush spans and close the file
+    static void stop();
+    static void flush();
+
+    // time for span starts, 0 if tracing is disabled
+    static uint64_t now() noexcept
+    {
+        if (!isEnabled())
+            return 0;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    // span from begin_ns to now, nothing if the span was started with disabled tracing
+    static void addSpan(uint64_t begin_ns, const std::string& name, TraceCategory category);
+
+    // spans dropped on full buffers of all threads
+    static uint64_t getDroppedNum();
+    // buffers ever created, exited threads give theirs to the next ones
+    static size_t getBuffersNum();
+
+  private:
+    static TraceBuffer& getThreadBuffer();
+    static void flushLocked();
+
+  private:
+    static inline std::atomic<bool> enabled = false;
+};
+
+} // namespace compiler
\ No newline at end of file
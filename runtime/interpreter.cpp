@@ -0,0 +1,476 @@
+#include "interpreter.h"
+#include "ir/evaluator.h"
+#include <limits>
+
+namespace compiler
+{
+
+namespace
+{
+
+constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+constexpr uint16_t DATA_TYPES_NUM = static_cast<uint16_t>(DataType::End);
+
+constexpr uint16_t makeOpcode(InstType type, DataType data_type = DataType::NoType)
+{
+    return static_cast<uint16_t>(type) * DATA_TYPES_NUM + static_cast<uint16_t>(data_type);
+}
+
+// casts are numbered after all other ops by the pair of types
+constexpr uint16_t makeCastOpcode(DataType from, DataType to)
+{
+    return makeOpcode(InstType::End) + static_cast<uint16_t>(from) * DATA_TYPES_NUM +
+           static_cast<uint16_t>(to);
+}
+
+// the only successor can be any of two after LinearOrder
+BasicBlock* getSucc(BasicBlock* bb)
+{
+    return bb->getTrueSucc() != nullptr ? bb->getTrueSucc() : bb->getFalseSucc();
+}
+
+constexpr bool isJumpOpcode(uint16_t opcode)
+{
+    return opcode >= makeOpcode(InstType::Jmp) && opcode <= makeOpcode(InstType::Jae);
+}
+
+// failures of the evaluation map to the execution statuses one to one
+constexpr ExecStatus toExecStatus(EvalStatus status)
+{
+    switch (status)
+    {
+        case EvalStatus::Ok:
+            return ExecStatus::Ok;
+        case EvalStatus::ZeroCheckFailed:
+            return ExecStatus::ZeroCheckFailed;
+        case EvalStatus::BoundsCheckFailed:
+            return ExecStatus::BoundsCheckFailed;
+        case EvalStatus::DivisionByZero:
+            return ExecStatus::DivisionByZero;
+        default:
+            UNREACHABLE();
+    }
+}
+
+} // namespace
+
+/**
+ * dst and srcs are slots in the frame, jumps keep the taken and the not taken op indices
+ * in srcs, a call keeps the number of its call site
+ */
+struct Interpreter::Op
+{
+    uint16_t opcode = 0;
+    uint32_t dst = INVALID_INDEX;
+    uint32_t src0 = INVALID_INDEX;
+    uint32_t src1 = INVALID_INDEX;
+};
+
+struct Interpreter::CallSite
+{
+    Graph* func = nullptr;
+    // translated on the first execution of the call
+    mutable const Code* callee = nullptr;
+    uint32_t args_begin = 0;
+    uint32_t args_num = 0;
+};
+
+struct Interpreter::Code
+{
+    std::vector<Op> ops;
+    // initial frame: constants are preset, other slots are zero
+    std::vector<uint64_t> frame;
+    // slots of params in the order of args
+    std::vector<uint32_t> params;
+    std::vector<CallSite> calls;
+    std::vector<uint32_t> call_args;
+};
+
+Interpreter::Interpreter(Graph* graph_) : graph(graph_)
+{
+    ASSERT(graph != nullptr, "nullptr graph in Interpreter");
+    getCode(graph);
+}
+
+Interpreter::~Interpreter() = default;
+
+Interpreter::Code* Interpreter::getCode(Graph* func)
+{
+    auto it = codes.find(func);
+    if (it != codes.end())
+        return it->second.get();
+
+    auto* code = codes.emplace(func, std::make_unique<Code>()).first->second.get();
+    translate(code, func);
+    return code;
+}
+
+void Interpreter::translate(Code* code, Graph* func)
+{
+    ASSERT(!func->getBBs().empty(), "empty graph in Interpreter");
+    auto& ops = code->ops;
+    auto& frame = code->frame;
+
+    IdVector<uint32_t> slots(INVALID_INDEX);
+    auto newSlot = [&frame]() {
+        frame.push_back(0);
+        return static_cast<uint32_t>(frame.size() - 1);
+    };
+    auto getSlot = [&slots](Inst* inst) {
+        auto slot = slots.get(inst);
+        ASSERT(slot != INVALID_INDEX, "input is not defined in the graph");
+        return slot;
+    };
+
+    auto* first_bb = func->getFirstBB();
+    for (auto* bb : func->getBBs())
+    {
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+            slots[phi] = newSlot();
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            slots[inst] = newSlot();
+            if (inst->isConstInst())
+                frame[slots[inst]] = static_cast<ConstInst*>(inst)->getRawValue();
+            else if (inst->getInstType() == InstType::Param && bb == first_bb)
+                code->params.push_back(slots[inst]);
+        }
+    }
+
+    // jumps refer to CFG edges until all blocks are placed
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> edges;
+    auto addEdge = [&edges](BasicBlock* pred, BasicBlock* succ) {
+        ASSERT(succ != nullptr, "jump to nowhere");
+        edges.emplace_back(pred, succ);
+        return static_cast<uint32_t>(edges.size() - 1);
+    };
+
+    IdVector<uint32_t> bb_pc(INVALID_INDEX);
+    for (auto* bb : func->getBBs())
+    {
+        bb_pc[bb] = static_cast<uint32_t>(ops.size());
+        bool is_terminated = false;
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            auto type = inst->getInstType();
+            switch (type)
+            {
+                case InstType::Const:
+                case InstType::Param:
+                    break;
+                case InstType::Jmp:
+                    ops.push_back({makeOpcode(type), INVALID_INDEX, addEdge(bb, getSucc(bb))});
+                    is_terminated = true;
+                    break;
+                case InstType::Je:
+                case InstType::Jne:
+                case InstType::Jb:
+                case InstType::Jbe:
+                case InstType::Ja:
+                case InstType::Jae:
+                    // LinearOrder inverts the condition together with succs, not the target
+                    ops.push_back({makeOpcode(type), INVALID_INDEX,
+                                   addEdge(bb, bb->getFalseSucc()),
+                                   addEdge(bb, bb->getTrueSucc())});
+                    is_terminated = true;
+                    break;
+                case InstType::Return:
+                    ops.push_back({makeOpcode(type), INVALID_INDEX, getSlot(inst->getInput(0))});
+                    is_terminated = true;
+                    break;
+                case InstType::RetVoid:
+                    ops.push_back({makeOpcode(type)});
+                    is_terminated = true;
+                    break;
+                case InstType::Call:
+                {
+                    auto* call = static_cast<CallInst*>(inst);
+                    auto args_begin = static_cast<uint32_t>(code->call_args.size());
+                    for (size_t i = 0, size = call->getInputsNum(); i < size; ++i)
+                        code->call_args.push_back(getSlot(call->getInput(i)));
+                    code->calls.push_back({call->getFunc(), nullptr, args_begin,
+                                           static_cast<uint32_t>(call->getInputsNum())});
+                    ops.push_back({makeOpcode(type), slots[inst],
+                                   static_cast<uint32_t>(code->calls.size() - 1)});
+                    break;
+                }
+                case InstType::Cast:
+                {
+                    auto* cast = static_cast<CastInst*>(inst);
+                    ops.push_back({makeCastOpcode(cast->getFromType(), cast->getToType()),
+                                   slots[inst], getSlot(cast->getInput(0))});
+                    break;
+                }
+                case InstType::Mov:
+                    ops.push_back({makeOpcode(type), slots[inst], getSlot(inst->getInput(0))});
+                    break;
+                default:
+                {
+                    Op op{makeOpcode(type, inst->getType()), slots[inst]};
+                    op.src0 = getSlot(inst->getInput(0));
+                    if (inst->getInputsNum() > 1)
+                        op.src1 = getSlot(inst->getInput(1));
+                    ops.push_back(op);
+                }
+            }
+        }
+
+        if (!is_terminated)
+        {
+            if (auto* succ = getSucc(bb); succ != nullptr)
+                ops.push_back({makeOpcode(InstType::Jmp), INVALID_INDEX, addEdge(bb, succ)});
+            else
+                ops.push_back({makeOpcode(InstType::RetVoid)});
+        }
+    }
+
+    // an edge into a block with phis gets its own copies of phi inputs before the jump,
+    // copies are parallel, so they go through temporary slots if a phi is an input
+    auto blocks_end = ops.size();
+    std::vector<uint32_t> edge_pc(edges.size());
+    std::vector<std::pair<uint32_t, uint32_t>> copies;
+    for (size_t i = 0; i < edges.size(); ++i)
+    {
+        auto [pred, succ] = edges[i];
+        if (succ->getFirstPhi() == nullptr)
+        {
+            edge_pc[i] = bb_pc[succ];
+            continue;
+        }
+
+        copies.clear();
+        for (auto* phi = succ->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        {
+            auto* phi_inst = static_cast<PhiInst*>(phi);
+            size_t num = 0;
+            while (num < phi_inst->getInputsNum() && phi_inst->getInputBB(num) != pred)
+                ++num;
+            ASSERT(num < phi_inst->getInputsNum(), "phi has no input from the predecessor");
+            auto src = getSlot(phi_inst->getInput(num));
+            if (src != slots[phi])
+                copies.emplace_back(slots[phi], src);
+        }
+
+        bool is_overlapped = std::any_of(copies.begin(), copies.end(), [&copies](auto copy) {
+            return std::any_of(copies.begin(), copies.end(),
+                               [copy](auto other) { return other.first == copy.second; });
+        });
+
+        edge_pc[i] = static_cast<uint32_t>(ops.size());
+        if (is_overlapped)
+        {
+            for (auto& [dst, src] : copies)
+            {
+                auto tmp = newSlot();
+                ops.push_back({makeOpcode(InstType::Mov), tmp, src});
+                src = tmp;
+            }
+        }
+        for (auto [dst, src] : copies)
+            ops.push_back({makeOpcode(InstType::Mov), dst, src});
+        ops.push_back({makeOpcode(InstType::Jmp), INVALID_INDEX, bb_pc[succ]});
+    }
+
+    for (size_t pc = 0; pc < blocks_end; ++pc)
+    {
+        auto& op = ops[pc];
+        if (!isJumpOpcode(op.opcode))
+            continue;
+        op.src0 = edge_pc[op.src0];
+        if (op.opcode != makeOpcode(InstType::Jmp))
+            op.src1 = edge_pc[op.src1];
+    }
+}
+
+void Interpreter::enterFrame(const Code* code, size_t base)
+{
+    auto frame_end = base + code->frame.size();
+    if (stack.size() < frame_end)
+        stack.resize(frame_end);
+    std::copy(code->frame.begin(), code->frame.end(), stack.begin() + base);
+}
+
+ExecResult Interpreter::run(const std::vector<uint64_t>& args)
+{
+    auto* code = getCode(graph);
+    ASSERT(args.size() == code->params.size(), "wrong number of arguments");
+    enterFrame(code, 0);
+    for (size_t i = 0; i < args.size(); ++i)
+        stack[code->params[i]] = args[i];
+    return execute(code, 0);
+}
+
+// clang-format off
+#define INTERP_BINARY_CASE(OP, TYPE)                                                               \
+    case makeOpcode(InstType::OP, DataType::TYPE):                                                 \
+    {                                                                                              \
+        auto result =                                                                              \
+            evalBinaryBits<InstType::OP, DataType::TYPE>(slots[op.src0], slots[op.src1]);          \
+        if (!result.isOk())                                                                        \
+            return ExecResult{toExecStatus(result.status)};                                        \
+        slots[op.dst] = result.bits;                                                               \
+        break;                                                                                     \
+    }
+
+#define INTERP_INT_BINARY_CASES(OP)                                                                \
+    INTERP_BINARY_CASE(OP, i32)                                                                    \
+    INTERP_BINARY_CASE(OP, i64)
+
+#define INTERP_FLOAT_BINARY_CASES(OP)                                                              \
+    INTERP_BINARY_CASE(OP, f32)                                                                    \
+    INTERP_BINARY_CASE(OP, f64)
+
+#define INTERP_UNARY_CASE(OP, TYPE)                                                                \
+    case makeOpcode(InstType::OP, DataType::TYPE):                                                 \
+    {                                                                                              \
+        auto result = evalUnaryBits<InstType::OP, DataType::TYPE>(slots[op.src0]);                 \
+        if (!result.isOk())                                                                        \
+            return ExecResult{toExecStatus(result.status)};                                        \
+        slots[op.dst] = result.bits;                                                               \
+        break;                                                                                     \
+    }
+
+#define INTERP_CMP_CASE(TYPE)                                                                      \
+    case makeOpcode(InstType::Cmp, DataType::TYPE):                                                \
+        flags = evalBinaryBits<InstType::Cmp, DataType::TYPE>(slots[op.src0], slots[op.src1]).bits;\
+        break;
+
+#define INTERP_CAST_CASE(FROM, TO)                                                                 \
+    case makeCastOpcode(DataType::FROM, DataType::TO):                                             \
+        slots[op.dst] = evalCastBits<DataType::FROM, DataType::TO>(slots[op.src0]).bits;           \
+        break;
+
+#define INTERP_CAST_CASES(FROM)                                                                    \
+    INTERP_CAST_CASE(FROM, i32)                                                                    \
+    INTERP_CAST_CASE(FROM, i64)                                                                    \
+    INTERP_CAST_CASE(FROM, f32)                                                                    \
+    INTERP_CAST_CASE(FROM, f64)
+
+#define INTERP_JUMP_CASE(OP)                                                                       \
+    case makeOpcode(InstType::OP):                                                                 \
+        pc = evalCondition<InstType::OP>(flags) ? op.src0 : op.src1;                               \
+        break;
+// clang-format on
+
+ExecResult Interpreter::execute(const Code* code, size_t base)
+{
+    if (depth >= INTERP_MAX_CALL_DEPTH)
+        return ExecResult{ExecStatus::StackOverflow};
+
+    struct DepthScope
+    {
+        size_t& depth;
+        ~DepthScope()
+        {
+            --depth;
+        }
+    } depth_scope{++depth};
+
+    const auto* ops = code->ops.data();
+    auto* slots = stack.data() + base;
+    // flags of the last Cmp
+    uint64_t flags = 0;
+
+    for (size_t pc = 0;;)
+    {
+        const auto& op = ops[pc++];
+        switch (op.opcode)
+        {
+            INTERP_INT_BINARY_CASES(Add)
+            INTERP_FLOAT_BINARY_CASES(Add)
+            INTERP_INT_BINARY_CASES(Sub)
+            INTERP_FLOAT_BINARY_CASES(Sub)
+            INTERP_INT_BINARY_CASES(Mul)
+            INTERP_FLOAT_BINARY_CASES(Mul)
+            INTERP_INT_BINARY_CASES(Div)
+            INTERP_FLOAT_BINARY_CASES(Div)
+            INTERP_INT_BINARY_CASES(Mod)
+            INTERP_FLOAT_BINARY_CASES(Mod)
+            INTERP_INT_BINARY_CASES(Shl)
+            INTERP_INT_BINARY_CASES(Shr)
+            INTERP_INT_BINARY_CASES(AShr)
+            INTERP_INT_BINARY_CASES(And)
+            INTERP_INT_BINARY_CASES(Or)
+            INTERP_INT_BINARY_CASES(Xor)
+
+            INTERP_UNARY_CASE(Not, i32)
+            INTERP_UNARY_CASE(Not, i64)
+            INTERP_UNARY_CASE(Neg, i32)
+            INTERP_UNARY_CASE(Neg, i64)
+            INTERP_UNARY_CASE(Neg, f32)
+            INTERP_UNARY_CASE(Neg, f64)
+
+            INTERP_CMP_CASE(i32)
+            INTERP_CMP_CASE(i64)
+            INTERP_CMP_CASE(f32)
+            INTERP_CMP_CASE(f64)
+
+            INTERP_UNARY_CASE(ZeroCheck, i32)
+            INTERP_UNARY_CASE(ZeroCheck, i64)
+            INTERP_UNARY_CASE(ZeroCheck, f32)
+            INTERP_UNARY_CASE(ZeroCheck, f64)
+            INTERP_INT_BINARY_CASES(BoundsCheck)
+
+            INTERP_CAST_CASES(i32)
+            INTERP_CAST_CASES(i64)
+            INTERP_CAST_CASES(f32)
+            INTERP_CAST_CASES(f64)
+
+            case makeOpcode(InstType::Jmp):
+                pc = op.src0;
+                break;
+            INTERP_JUMP_CASE(Je)
+            INTERP_JUMP_CASE(Jne)
+            INTERP_JUMP_CASE(Jb)
+            INTERP_JUMP_CASE(Jbe)
+            INTERP_JUMP_CASE(Ja)
+            INTERP_JUMP_CASE(Jae)
+
+            case makeOpcode(InstType::Mov):
+                slots[op.dst] = slots[op.src0];
+                break;
+            case makeOpcode(InstType::Call):
+            {
+                const auto& call = code->calls[op.src0];
+                if (call.callee == nullptr)
+                {
+                    call.callee = getCode(call.func);
+                    ASSERT(call.callee->params.size() == call.args_num,
+                           "wrong number of call arguments");
+                }
+                auto callee_base = base + code->frame.size();
+                enterFrame(call.callee, callee_base);
+                // the stack could be reallocated
+                slots = stack.data() + base;
+                auto* callee_slots = stack.data() + callee_base;
+                for (uint32_t i = 0; i < call.args_num; ++i)
+                    callee_slots[call.callee->params[i]] =
+                        slots[code->call_args[call.args_begin + i]];
+
+                auto result = execute(call.callee, callee_base);
+                if (!result.isOk())
+                    return result;
+                slots = stack.data() + base;
+                slots[op.dst] = result.value;
+                break;
+            }
+            case makeOpcode(InstType::Return):
+                return ExecResult{ExecStatus::Ok, slots[op.src0]};
+            case makeOpcode(InstType::RetVoid):
+                return ExecResult{};
+            default:
+                UNREACHABLE();
+        }
+    }
+}
+
+#undef INTERP_BINARY_CASE
+#undef INTERP_INT_BINARY_CASES
+#undef INTERP_FLOAT_BINARY_CASES
+#undef INTERP_UNARY_CASE
+#undef INTERP_CMP_CASE
+#undef INTERP_CAST_CASE
+#undef INTERP_CAST_CASES
+#undef INTERP_JUMP_CASE
+
+} // namespace compiler
\ No newline at end of file
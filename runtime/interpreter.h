@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ir/graph.h"
+#include "ir/id_vector.h"
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace compiler
+{
+
+constexpr size_t INTERP_MAX_CALL_DEPTH = 4096;
+
+enum class ExecStatus : uint8_t
+{
+    Ok = 0,
+    ZeroCheckFailed,
+    BoundsCheckFailed,
+    DivisionByZero,
+    StackOverflow
+};
+
+/**
+ * Result of an execution: the returned value is kept as a bit pattern of its type
+ * (see ConstInst::toBits), a failed check stops the whole calls chain with its status.
+ */
+struct ExecResult
+{
+    ExecStatus status = ExecStatus::Ok;
+    uint64_t value = 0;
+
+    bool isOk() const noexcept
+    {
+        return status == ExecStatus::Ok;
+    }
+
+    template <typename T>
+    T getValue() const
+    {
+        if constexpr (std::is_integral_v<T>)
+            return static_cast<T>(value);
+        else if constexpr (std::is_same_v<T, float>)
+            return std::bit_cast<float>(static_cast<uint32_t>(value));
+        else
+            return std::bit_cast<double>(value);
+    }
+};
+
+/**
+ * Reference interpreter of the IR, tier-0 executor and the engine of runtime benchmarks.
+ * Every graph is translated once into a flat array of ops: an op is an opcode fused from
+ * InstType and DataType and slot indices of its inputs in the frame, jumps refer to op
+ * indices, so the main loop is a single switch without pointer chasing or virtual calls.
+ * Phis become copies on the CFG edges coming into their block, constants are preset in the
+ * frame template. A callee is translated when its call is executed for the first time,
+ * so only the reached part of the call graph is translated; callees share the values stack.
+ *
+ * Semantics follows the target machine: integers wrap around, Div, Mod and Cmp treat them
+ * as unsigned, shift counts are masked by the width of the type, Cmp sets flags for the
+ * next conditional jump (an unordered floats compare is "equal" and "below"), the jump goes
+ * to the false successor of the block if the condition holds and to the true one otherwise.
+ * Cast is signed, float to integer conversions truncate and give the minimal integer
+ * on overflow and NaN. The translation is cached, so the graph must not be changed
+ * after the first run.
+ */
+class Interpreter final
+{
+  public:
+    explicit Interpreter(Graph* graph_);
+    ~Interpreter();
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    /**
+     * Run the graph with arguments given as bit patterns in the order of its params
+     */
+    ExecResult run(const std::vector<uint64_t>& args = {});
+
+    template <typename... Args>
+    ExecResult call(Args... args)
+    {
+        return run({ConstInst::toBits(args)...});
+    }
+
+    DEFINE_GETTER(graph, Graph, Graph*)
+
+  private:
+    struct Op;
+    struct CallSite;
+    struct Code;
+
+    Code* getCode(Graph* func);
+    void translate(Code* code, Graph* func);
+    void enterFrame(const Code* code, size_t base);
+    ExecResult execute(const Code* code, size_t base);
+
+  private:
+    Graph* graph = nullptr;
+    std::unordered_map<Graph*, std::unique_ptr<Code>> codes;
+
+    // frames of all active calls, a frame is addressed by its base, since the stack can grow
+    std::vector<uint64_t> stack;
+    size_t depth = 0;
+};
+
+} // namespace compiler
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "codegen/aot.h"
+#include "codegen/code_buffer.h"
+#include "codegen/jit.h"
+#include "pass/reg_alloc.h"
+#include "runtime/interpreter.h"
+#include "test_graphs.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <elf.h>
+#include <optional>
+#include <sstream>
+
+#if defined(__x86_64__) && defined(__linux__)
+
+using namespace compiler;
+
+/**
+ * Minimal reader of the relocatable object: the test links .text by itself,
+ * so the code can be run from the JIT buffer
+ */
+struct ObjectFile
+{
+    explicit ObjectFile(std::string bytes_) : bytes(std::move(bytes_))
+    {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        sections.resize(header.e_shnum);
+        std::memcpy(sections.data(), bytes.data() + header.e_shoff,
+                    sizeof(Elf64_Shdr) * header.e_shnum);
+    }
+
+    const char* getSectionName(const Elf64_Shdr& section) const
+    {
+        return bytes.data() + sections[header.e_shstrndx].sh_offset + section.sh_name;
+    }
+
+    const Elf64_Shdr* findSection(const std::string& name) const
+    {
+        for (auto& section : sections)
+            if (name == getSectionName(section))
+                return &section;
+        return nullptr;
+    }
+
+    template <typename T>
+    std::vector<T> getEntries(const Elf64_Shdr& section) const
+    {
+        std::vector<T> entries(section.sh_size / sizeof(T));
+        std::memcpy(entries.data(), bytes.data() + section.sh_offset, section.sh_size);
+        return entries;
+    }
+
+    std::optional<Elf64_Sym> findSymbol(const std::string& name) const
+    {
+        auto* symtab = findSection(".symtab");
+        auto* strtab = bytes.data() + sections[symtab->sh_link].sh_offset;
+        for (auto& sym : getEntries<Elf64_Sym>(*symtab))
+            if (name == strtab + sym.st_name)
+                return sym;
+        return std::nullopt;
+    }
+
+    std::string bytes;
+    Elf64_Ehdr header;
+    std::vector<Elf64_Shdr> sections;
+};
+
+static std::shared_ptr<Graph> allocate(std::shared_ptr<Graph> graph)
+{
+    EXPECT_TRUE(graph->runPass<RegisterAllocation>());
+    return graph;
+}
+
+TEST(AOT_TEST, OBJECT)
+{
+    auto factorial = allocate(buildFactorial());
+    auto sum = allocate(buildSum());
+    AotCompiler aot("unit");
+    aot.addFunction(factorial.get());
+    aot.addFunction(sum.get());
+    std::ostringstream out;
+    aot.writeObject(out);
+    ObjectFile obj(out.str());
+
+    ASSERT_EQ(std::memcmp(obj.header.e_ident, ELFMAG, SELFMAG), 0);
+    EXPECT_EQ(obj.header.e_type, ET_REL);
+    EXPECT_EQ(obj.header.e_machine, EM_X86_64);
+    auto* text = obj.findSection(".text");
+    auto* bss = obj.findSection(".bss");
+    auto* rela = obj.findSection(".rela.text");
+    ASSERT_NE(text, nullptr);
+    ASSERT_NE(bss, nullptr);
+    ASSERT_NE(rela, nullptr);
+    EXPECT_NE(obj.findSection(".note.GNU-stack"), nullptr);
+    EXPECT_EQ(bss->sh_type, SHT_NOBITS);
+    EXPECT_EQ(bss->sh_size, x86_64::RUNTIME_DATA_SIZE);
+
+    auto factorial_sym = obj.findSymbol("factorial");
+    ASSERT_TRUE(factorial_sym.has_value());
+    EXPECT_EQ(ELF64_ST_BIND(factorial_sym->st_info), STB_GLOBAL);
+    EXPECT_EQ(ELF64_ST_TYPE(factorial_sym->st_info), STT_FUNC);
+    EXPECT_EQ(factorial_sym->st_value, 0U);
+    auto sum_sym = obj.findSymbol("sum");
+    ASSERT_TRUE(sum_sym.has_value());
+    auto sum_offset = sum_sym->st_value;
+    EXPECT_EQ(sum_offset, factorial_sym->st_size);
+    EXPECT_EQ(sum_offset + sum_sym->st_size, text->sh_size);
+    auto status_sym = obj.findSymbol(aot.getStatusSymbol());
+    ASSERT_TRUE(status_sym.has_value());
+    EXPECT_EQ(ELF64_ST_BIND(status_sym->st_info), STB_GLOBAL);
+    EXPECT_EQ(status_sym->st_value, x86_64::RUNTIME_STATUS_OFFSET);
+    auto depth_sym = obj.findSymbol(aot.getDepthSymbol());
+    ASSERT_TRUE(depth_sym.has_value());
+    EXPECT_EQ(depth_sym->st_value, x86_64::RUNTIME_DEPTH_OFFSET);
+
+    // link .text with .bss placed right after the code pages as in the JIT
+    std::vector<uint8_t> code(obj.bytes.begin() + text->sh_offset,
+                              obj.bytes.begin() + text->sh_offset + text->sh_size);
+    auto data_offset = CodeBuffer::getDataOffset(code.size());
+    auto relocations = obj.getEntries<Elf64_Rela>(*rela);
+    ASSERT_FALSE(relocations.empty());
+    for (auto& reloc : relocations)
+    {
+        ASSERT_EQ(ELF64_R_TYPE(reloc.r_info), R_X86_64_PC32);
+        auto value = static_cast<int32_t>(static_cast<int64_t>(data_offset) + reloc.r_addend -
+                                          static_cast<int64_t>(reloc.r_offset));
+        std::memcpy(code.data() + reloc.r_offset, &value, sizeof(value));
+    }
+    JitCode jit(code, data_offset, x86_64::RUNTIME_DATA_SIZE);
+
+    auto expected = buildFactorial();
+    Interpreter factorial_interp(expected.get());
+    for (uint64_t n : {0, 1, 5, 20})
+        EXPECT_EQ(jit.call<uint64_t>(n).value, factorial_interp.call(n).value);
+    auto* sum_func = reinterpret_cast<uint64_t (*)(uint64_t)>(
+        reinterpret_cast<uintptr_t>(jit.getFunction<void()>()) + sum_offset);
+    EXPECT_EQ(sum_func(100), 5050U);
+    EXPECT_EQ(jit.getStatus(), ExecStatus::Ok);
+    sum_func(INTERP_MAX_CALL_DEPTH);
+    EXPECT_EQ(jit.getStatus(), ExecStatus::StackOverflow);
+}
+
+TEST(AOT_TEST, ASSEMBLY)
+{
+    auto checks = allocate(buildChecks());
+    auto sum = allocate(buildSum());
+    AotCompiler aot("unit");
+    aot.addFunction(checks.get());
+    aot.addFunction(sum.get());
+    std::ostringstream out;
+    aot.writeAssembly(out);
+    auto text = out.str();
+
+    for (auto* name : {"checks", "sum"})
+    {
+        EXPECT_NE(text.find("\t.globl " + std::string(name) + "\n"), std::string::npos);
+        EXPECT_NE(text.find(std::string(name) + ":\n"), std::string::npos);
+    }
+    EXPECT_NE(text.find("\t.globl unit_status\n"), std::string::npos);
+    EXPECT_NE(text.find("\t.globl unit_depth\n"), std::string::npos);
+    EXPECT_NE(text.find("\t.long .Lunit_data"), std::string::npos);
+    EXPECT_NE(text.find(".note.GNU-stack"), std::string::npos);
+}
+
+#endif // __x86_64__ && __linux__
\ No newline at end of file
@@ -22,22 +22,22 @@ TEST(CHECKS_ELIMINATION_TEST, TEST1)
     */
     auto graph = std::make_shared<Graph>("checks_elimination_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
 
-    auto* v0 = new ParamInst{0, DataType::i64, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(25)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(25));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
 
-    auto* v2 = new UnaryInst{2, InstType::ZeroCheck, v0};
-    auto* v3 = new BinaryInst{3, InstType::Div, v1, v0};
-    auto* v4 = new UnaryInst{4, InstType::ZeroCheck, v0};
-    auto* v5 = new BinaryInst{5, InstType::Div, v3, v0};
-    auto* v6 = new UnaryInst{6, InstType::Return, v5};
+    auto* v2 = graph->create<UnaryInst>(2, InstType::ZeroCheck, v0);
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Div, v1, v0);
+    auto* v4 = graph->create<UnaryInst>(4, InstType::ZeroCheck, v0);
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Div, v3, v0);
+    auto* v6 = graph->create<UnaryInst>(6, InstType::Return, v5);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
     bb2->pushBackInst(v4);
@@ -94,10 +94,10 @@ TEST(CHECKS_ELIMINATION_TEST, TEST2)
     */
     auto graph = std::make_shared<Graph>("checks_elimination_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -105,19 +105,19 @@ TEST(CHECKS_ELIMINATION_TEST, TEST2)
     graph->insertBB(bb4);
     graph->addEdge(bb2, bb4);
 
-    auto* v0 = new ParamInst{0, DataType::i64, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v100 = new ConstInst{100, std::numeric_limits<uint64_t>::max()};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v100 = graph->create<ConstInst>(100, std::numeric_limits<uint64_t>::max());
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v100);
 
-    auto* v2 = new UnaryInst{2, InstType::ZeroCheck, v0};
-    auto* v3 = new BinaryInst{3, InstType::Div, v1, v0};
-    auto* v4 = new BinaryInst{4, InstType::BoundsCheck, v0, v100};
-    auto* v5 = new BinaryInst{5, InstType::Mul, v3, v0};
-    auto* v55 = new BinaryInst{55, InstType::Cmp, v5, v0};
-    auto* v6 = new JumpInst{6, InstType::Ja, bb4};
+    auto* v2 = graph->create<UnaryInst>(2, InstType::ZeroCheck, v0);
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Div, v1, v0);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::BoundsCheck, v0, v100);
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Mul, v3, v0);
+    auto* v55 = graph->create<BinaryInst>(55, InstType::Cmp, v5, v0);
+    auto* v6 = graph->create<JumpInst>(6, InstType::Ja, bb4);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
     bb2->pushBackInst(v4);
@@ -125,20 +125,20 @@ TEST(CHECKS_ELIMINATION_TEST, TEST2)
     bb2->pushBackInst(v55);
     bb2->pushBackInst(v6);
 
-    auto* v7 = new BinaryInst{7, InstType::BoundsCheck, v0, v100};
-    auto* v8 = new BinaryInst{8, InstType::Add, v5, v0};
-    auto* v9 = new UnaryInst{9, InstType::ZeroCheck, v8};
-    auto* v10 = new BinaryInst{10, InstType::Div, v0, v8};
+    auto* v7 = graph->create<BinaryInst>(7, InstType::BoundsCheck, v0, v100);
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Add, v5, v0);
+    auto* v9 = graph->create<UnaryInst>(9, InstType::ZeroCheck, v8);
+    auto* v10 = graph->create<BinaryInst>(10, InstType::Div, v0, v8);
     bb3->pushBackInst(v7);
     bb3->pushBackInst(v8);
     bb3->pushBackInst(v9);
     bb3->pushBackInst(v10);
 
-    auto* v11 = new UnaryInst{11, InstType::ZeroCheck, v8};
-    auto* v12 = new BinaryInst{12, InstType::Div, v0, v8};
-    auto* v13 = new UnaryInst{13, InstType::ZeroCheck, v0};
-    auto* v14 = new BinaryInst{14, InstType::Mod, v12, v0};
-    auto* v15 = new UnaryInst{15, InstType::Return, v14};
+    auto* v11 = graph->create<UnaryInst>(11, InstType::ZeroCheck, v8);
+    auto* v12 = graph->create<BinaryInst>(12, InstType::Div, v0, v8);
+    auto* v13 = graph->create<UnaryInst>(13, InstType::ZeroCheck, v0);
+    auto* v14 = graph->create<BinaryInst>(14, InstType::Mod, v12, v0);
+    auto* v15 = graph->create<UnaryInst>(15, InstType::Return, v14);
     bb4->pushBackInst(v11);
     bb4->pushBackInst(v12);
     bb4->pushBackInst(v13);
@@ -1,7 +1,10 @@
+#include "ir/evaluator.h"
 #include "ir/graph.h"
 #include "pass/const_folding.h"
 #include "pass/dce.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <limits>
 
 using namespace compiler;
 
@@ -44,10 +47,10 @@ TEST(CONST_FOLDING_TEST, TEST1)
     */
     auto graph = std::make_shared<Graph>("const_folding_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -55,12 +58,12 @@ TEST(CONST_FOLDING_TEST, TEST1)
     graph->insertBB(bb4);
     graph->addEdge(bb2, bb4);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v100 = new ConstInst{100, static_cast<uint64_t>(1)};
-    auto* v200 = new ConstInst{200, static_cast<uint64_t>(2)};
-    auto* v300 = new ConstInst{300, static_cast<uint64_t>(5)};
-    auto* v400 = new ConstInst{400, static_cast<uint64_t>(10)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v100 = graph->create<ConstInst>(100, static_cast<uint64_t>(1));
+    auto* v200 = graph->create<ConstInst>(200, static_cast<uint64_t>(2));
+    auto* v300 = graph->create<ConstInst>(300, static_cast<uint64_t>(5));
+    auto* v400 = graph->create<ConstInst>(400, static_cast<uint64_t>(10));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v100);
@@ -68,24 +71,24 @@ TEST(CONST_FOLDING_TEST, TEST1)
     bb1->pushBackInst(v300);
     bb1->pushBackInst(v400);
 
-    auto* v15 = new BinaryInst{15, InstType::Mul, v200, v300};
-    auto* v2 = new BinaryInst{2, InstType::Cmp, v0, v15};
-    auto* v3 = new JumpInst{3, InstType::Ja, bb4};
+    auto* v15 = graph->create<BinaryInst>(15, InstType::Mul, v200, v300);
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Cmp, v0, v15);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Ja, bb4);
     bb2->pushBackInst(v15);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
 
-    auto* v35 = new BinaryInst{35, InstType::Add, v100, v200};
-    auto* v4 = new BinaryInst{4, InstType::Add, v35, v0};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb4};
+    auto* v35 = graph->create<BinaryInst>(35, InstType::Add, v100, v200);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v35, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
     bb3->pushBackInst(v35);
     bb3->pushBackInst(v4);
     bb3->pushBackInst(v5);
 
-    auto* v6 = new PhiInst{6};
+    auto* v6 = graph->create<PhiInst>(6);
     v6->addInput(std::make_pair(v1, bb2));
     v6->addInput(std::make_pair(v4, bb3));
-    auto* v7 = new UnaryInst{7, InstType::Return, v6};
+    auto* v7 = graph->create<UnaryInst>(7, InstType::Return, v6);
     bb4->pushBackPhiInst(v6);
     bb4->pushBackInst(v7);
 
@@ -150,12 +153,12 @@ TEST(CONST_FOLDING_TEST, TEST2)
     */
     auto graph = std::make_shared<Graph>("const_folding_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -166,51 +169,51 @@ TEST(CONST_FOLDING_TEST, TEST2)
     graph->addEdge(bb4, bb5);
     graph->addEdge(bb6, bb2);
 
-    auto* v0 = new ParamInst{0, DataType::i64, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v2 = new ConstInst{2, static_cast<uint64_t>(10)};
-    auto* v100 = new ConstInst{100, static_cast<uint64_t>(1)};
-    auto* v200 = new ConstInst{200, static_cast<uint64_t>(2)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(10));
+    auto* v100 = graph->create<ConstInst>(100, static_cast<uint64_t>(1));
+    auto* v200 = graph->create<ConstInst>(200, static_cast<uint64_t>(2));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v2);
     bb1->pushBackInst(v100);
     bb1->pushBackInst(v200);
 
-    auto* v3 = new PhiInst{3};
-    auto* v4 = new BinaryInst{4, InstType::Sub, v3, v2};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb3};
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Sub, v3, v2);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb3);
     bb2->pushBackPhiInst(v3);
     bb2->pushBackInst(v4);
     bb2->pushBackInst(v5);
 
-    auto* v6 = new BinaryInst{6, InstType::Or, v100, v2};
-    auto* v7 = new BinaryInst{7, InstType::Mul, v6, v1};
-    auto* v75 = new BinaryInst{75, InstType::Cmp, v7, v2};
-    auto* v8 = new JumpInst{8, InstType::Jae, bb5};
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Or, v100, v2);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Mul, v6, v1);
+    auto* v75 = graph->create<BinaryInst>(75, InstType::Cmp, v7, v2);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jae, bb5);
     bb3->pushBackInst(v6);
     bb3->pushBackInst(v7);
     bb3->pushBackInst(v75);
     bb3->pushBackInst(v8);
 
-    auto* v9 = new BinaryInst{9, InstType::AShr, v2, v200};
-    auto* v95 = new BinaryInst{95, InstType::Cmp, v9, v1};
-    auto* v10 = new JumpInst{10, InstType::Jb, bb5};
+    auto* v9 = graph->create<BinaryInst>(9, InstType::AShr, v2, v200);
+    auto* v95 = graph->create<BinaryInst>(95, InstType::Cmp, v9, v1);
+    auto* v10 = graph->create<JumpInst>(10, InstType::Jb, bb5);
     bb4->pushBackInst(v9);
     bb4->pushBackInst(v95);
     bb4->pushBackInst(v10);
 
-    auto* v11 = new PhiInst{11};
+    auto* v11 = graph->create<PhiInst>(11);
     v11->addInput(std::make_pair(v6, bb3));
     v11->addInput(std::make_pair(v9, bb4));
-    auto* v12 = new BinaryInst{12, InstType::Sub, v11, v0};
-    auto* v13 = new UnaryInst{13, InstType::Return, v12};
+    auto* v12 = graph->create<BinaryInst>(12, InstType::Sub, v11, v0);
+    auto* v13 = graph->create<UnaryInst>(13, InstType::Return, v12);
     bb5->pushBackPhiInst(v11);
     bb5->pushBackInst(v12);
     bb5->pushBackInst(v13);
 
-    auto* v14 = new BinaryInst{14, InstType::Sub, v2, v100};
-    auto* v15 = new JumpInst{15, InstType::Jmp, bb2};
+    auto* v14 = graph->create<BinaryInst>(14, InstType::Sub, v2, v100);
+    auto* v15 = graph->create<JumpInst>(15, InstType::Jmp, bb2);
     bb6->pushBackInst(v14);
     bb6->pushBackInst(v15);
 
@@ -222,13 +225,104 @@ TEST(CONST_FOLDING_TEST, TEST2)
     graph->runPass<Dce>();
     // graph->dump();
 
-    ASSERT_EQ(bb2->getFirstInst(), v5);
-    ASSERT_EQ(static_cast<PhiInst*>(v3)->getInputs()[1].first, bb1->getLastInst());
-    ASSERT_EQ(static_cast<ConstInst*>(bb1->getLastInst())->getIntValue(), 9);
-    ASSERT_EQ(static_cast<ConstInst*>(bb1->getLastInst()->getPrev())->getIntValue(), 11);
-    ASSERT_EQ(bb3->getFirstInst(), v75);
-    ASSERT_EQ(static_cast<BinaryInst*>(v75)->getInput(0), v1);
-    ASSERT_EQ(static_cast<BinaryInst*>(v95)->getInput(0), v200);
-    ASSERT_EQ(static_cast<PhiInst*>(v11)->getInputs()[0].first, bb1->getLastInst()->getPrev());
-    ASSERT_EQ(static_cast<PhiInst*>(v11)->getInputs()[1].first, v200);
+    // 11 * 0 < 10 and 10 >> 2 >= 0 always go to the true successors, bb5 is never reached
+    ASSERT_EQ(graph->size(), 5U);
+    EXPECT_EQ(std::find(graph->getBBs().begin(), graph->getBBs().end(), bb5),
+              graph->getBBs().end());
+    EXPECT_EQ(bb3->size(), 1U);
+    EXPECT_EQ(bb3->getLastInst()->getInstType(), InstType::Jmp);
+    EXPECT_EQ(bb3->getTrueSucc(), bb4);
+    EXPECT_EQ(bb4->size(), 1U);
+    EXPECT_EQ(bb4->getTrueSucc(), bb6);
+
+    EXPECT_EQ(bb6->getFirstInst(), v15);
+    EXPECT_EQ(bb2->getFirstInst(), v5);
+    ASSERT_TRUE(v3->getInput(1)->isConstInst());
+    EXPECT_EQ(static_cast<ConstInst*>(v3->getInput(1))->getIntValue(), 9);
+}
+
+TEST(CONST_FOLDING_TEST, SEMANTICS)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/1]
+        v0.  Param i64 a0
+        v1.  Const i64 -8
+        v2.  Const i64 65
+        v3.  Const i64 0
+        v4.  Const i32 1
+        v5.  AShr  i64 v1, v2
+        v6.  Div   i64 v2, v3
+        v7.  Not   i32 v4
+        v8.  Cast  v7 to f64
+        v9.  ZeroCheck i64 v3
+        v10. Add   i64 v5, v0
+        v11. Add   i64 v6, v0
+        v12. Neg   f64 v8
+        v13. Add   i64 v9, v0
+        v14. Ret   f64 v12
+    end
+    */
+    auto graph = std::make_shared<Graph>("const_folding_semantics");
+    auto* bb1 = graph->createBB(1);
+    graph->insertBB(bb1);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(-8));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(65));
+    auto* v3 = graph->create<ConstInst>(3, static_cast<uint64_t>(0));
+    auto* v4 = graph->create<ConstInst>(4, static_cast<uint32_t>(1));
+    auto* v5 = graph->create<BinaryInst>(5, InstType::AShr, v1, v2);
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Div, v2, v3);
+    auto* v7 = graph->create<UnaryInst>(7, InstType::Not, v4);
+    auto* v8 = graph->create<CastInst>(8, v7, DataType::f64);
+    auto* v9 = graph->create<UnaryInst>(9, InstType::ZeroCheck, v3);
+    auto* v10 = graph->create<BinaryInst>(10, InstType::Add, v5, v0);
+    auto* v11 = graph->create<BinaryInst>(11, InstType::Add, v6, v0);
+    auto* v12 = graph->create<UnaryInst>(12, InstType::Neg, v8);
+    auto* v13 = graph->create<BinaryInst>(13, InstType::Add, v9, v0);
+    auto* v14 = graph->create<UnaryInst>(14, InstType::Return, v12);
+    for (Inst* inst : std::initializer_list<Inst*>{v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10,
+                                                    v11, v12, v13, v14})
+        bb1->pushBackInst(inst);
+
+    graph->runPass<ConstFolding>();
+
+    // the shift is arithmetic and its count is masked, Cast is signed
+    ASSERT_TRUE(v10->getInput(0)->isConstInst());
+    EXPECT_EQ(static_cast<ConstInst*>(v10->getInput(0))->getInt64Value(),
+              static_cast<uint64_t>(-4));
+    ASSERT_TRUE(v14->getInput(0)->isConstInst());
+    EXPECT_EQ(static_cast<ConstInst*>(v14->getInput(0))->getDoubleValue(), 2.0);
+    // division by zero and the failing check are left for the runtime
+    EXPECT_EQ(v11->getInput(0), v6);
+    EXPECT_EQ(v13->getInput(0), v9);
+}
+
+TEST(CONST_FOLDING_TEST, EVALUATOR)
+{
+    // the tables are usable at compile time and agree with the templates
+    static_assert(evaluateBinary(InstType::Sub, DataType::i32, 0, 1).bits == UINT32_MAX);
+    static_assert(evaluateBinary(InstType::Mod, DataType::i64, 7, 0).status ==
+                  EvalStatus::DivisionByZero);
+    static_assert(evaluateBinary(InstType::Shl, DataType::f32, 0, 0).status ==
+                  EvalStatus::Unsupported);
+    static_assert(evaluateUnary(InstType::Return, DataType::i32, 0).status ==
+                  EvalStatus::Unsupported);
+    static_assert(evaluateCast(DataType::f64, DataType::i32, toBits(-3.5)).bits ==
+                  static_cast<uint32_t>(-3));
+    static_assert(evaluateCondition(InstType::Jbe, CMP_EQUAL_FLAG));
+    static_assert(!evaluateCondition(InstType::Ja, CMP_BELOW_FLAG));
+
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    auto flags = evaluateBinary(InstType::Cmp, DataType::f64, toBits(1.0), toBits(nan)).bits;
+    EXPECT_EQ(flags, CMP_EQUAL_FLAG | CMP_BELOW_FLAG);
+    EXPECT_EQ(evaluateBinary(InstType::BoundsCheck, DataType::i64, 3, 3).status,
+              EvalStatus::BoundsCheckFailed);
+    EXPECT_EQ(evaluateUnary(InstType::ZeroCheck, DataType::f32, toBits(-0.0f)).status,
+              EvalStatus::ZeroCheckFailed);
+    EXPECT_EQ(fromBits<float>(evaluateBinary(InstType::Mod, DataType::f32, toBits(7.5f),
+                                             toBits(2.0f))
+                                  .bits),
+              1.5f);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "ir/graph.h"
 #include "pass/domtree.h"
 #include "gtest/gtest.h"
+#include <random>
 
 using namespace compiler;
 
@@ -38,12 +39,12 @@ TEST(DOMTREE_TEST, TEST1)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -92,12 +93,12 @@ TEST(DOMTREE_TEST, TEST2)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -155,15 +156,15 @@ TEST(DOMTREE_TEST, TEST3)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test3");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -223,13 +224,13 @@ TEST(DOMTREE_TEST, TEST4)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test4");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -293,17 +294,17 @@ TEST(DOMTREE_TEST, TEST5)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test5");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
-    auto* bb10 = new BasicBlock{10, graph};
-    auto* bb11 = new BasicBlock{11, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
+    auto* bb10 = graph->createBB(10);
+    auto* bb11 = graph->createBB(11);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -377,15 +378,15 @@ TEST(DOMTREE_TEST, TEST6)
 {
     auto graph = std::make_shared<Graph>("dom_tree_test6");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -427,4 +428,108 @@ TEST(DOMTREE_TEST, TEST6)
     ASSERT_EQ(bb7->getIdom()->getId(), 2);
     ASSERT_EQ(bb8->getIdom()->getId(), 6);
     ASSERT_EQ(bb9->getIdom()->getId(), 2);
+}
+
+/**
+ * Random graph: dominators are compared with the classic iterative dataflow solution
+ *     Dom(start) = {start}, Dom(bb) = {bb} + intersection of Dom(pred)
+ */
+TEST(DOMTREE_TEST, RANDOM)
+{
+    constexpr size_t BB_NUM = 200;
+    auto graph = std::make_shared<Graph>("dom_tree_random");
+    std::mt19937 gen(42);
+
+    std::vector<BasicBlock*> bbs;
+    for (size_t i = 0; i < BB_NUM; ++i)
+    {
+        bbs.push_back(graph->createBB(i));
+        graph->addBB(bbs.back());
+    }
+    for (size_t i = 0; i < BB_NUM; ++i)
+    {
+        // mostly forward edges to keep the graph reachable, some back edges
+        size_t succs_num = (i + 1 == BB_NUM) ? 0 : 1 + gen() % 2;
+        for (size_t j = 0; j < succs_num; ++j)
+        {
+            size_t succ = (gen() % 4 == 0) ? gen() % BB_NUM : i + 1 + gen() % 3;
+            succ = std::min(succ, BB_NUM - 1);
+            if (bbs[i]->getTrueSucc() != bbs[succ])
+                graph->addEdge(bbs[i], bbs[succ]);
+        }
+    }
+
+    graph->runPass<DomTree>();
+
+    std::vector<std::vector<bool>> doms(BB_NUM, std::vector<bool>(BB_NUM, true));
+    doms[0].assign(BB_NUM, false);
+    doms[0][0] = true;
+    auto& rpo = graph->getRpoBBs();
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (auto* bb : rpo)
+        {
+            if (bb == bbs[0])
+                continue;
+            std::vector<bool> new_doms(BB_NUM, true);
+            for (auto* pred : bb->getPreds())
+                for (size_t i = 0; i < BB_NUM; ++i)
+                    new_doms[i] = new_doms[i] && doms[pred->getId()][i];
+            new_doms[bb->getId()] = true;
+            if (new_doms != doms[bb->getId()])
+            {
+                doms[bb->getId()] = new_doms;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto* bb : rpo)
+    {
+        size_t doms_num = 0;
+        for (auto* dom : rpo)
+        {
+            ASSERT_EQ(dom->dominates(bb), doms[bb->getId()][dom->getId()]);
+            doms_num += doms[bb->getId()][dom->getId()];
+        }
+        ASSERT_EQ(bb->getDominators().size(), doms_num);
+        for (auto* child : bb->getDomChildren())
+            ASSERT_EQ(child->getIdom(), bb);
+    }
+}
+
+/**
+ * Dominance is recomputed after CFG changes:
+ *        [1]              [1]
+ *         |                | \
+ *         v       -->      v  |
+ *        [2]              [2] |
+ *         |                |  |
+ *         v                v  |
+ *        [3]              [3]<
+ */
+TEST(DOMTREE_TEST, INVALIDATION)
+{
+    auto graph = std::make_shared<Graph>("dom_tree_invalidation");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+
+    graph->runPass<DomTree>();
+    ASSERT_TRUE(graph->isAnalysisValid<DomTree>());
+    ASSERT_TRUE(bb2->dominates(bb3));
+    ASSERT_EQ(bb2->getDomChildren().size(), 1);
+
+    graph->addEdge(bb1, bb3);
+    ASSERT_FALSE(graph->isAnalysisValid<DomTree>());
+    ASSERT_FALSE(bb2->dominates(bb3));
+    ASSERT_TRUE(graph->isAnalysisValid<DomTree>());
+    ASSERT_TRUE(bb1->dominates(bb3));
+    ASSERT_EQ(bb3->getIdom(), bb1);
+    ASSERT_TRUE(bb2->getDomChildren().empty());
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "ir/graph.h"
+#include "pass/checks_elimination.h"
+#include "pass/gvn.h"
+#include "runtime/interpreter.h"
+#include "gtest/gtest.h"
+
+using namespace compiler;
+
+/**
+ * Branches graph:
+ *                 [1]
+ *                  |
+ *                  v
+ *             /---[2]---\
+ *             |         |
+ *             v         v
+ *            [3]       [4]
+ *             |         |
+ *             \-->[5]<--/
+ */
+TEST(GVN_TEST, BRANCHES)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/5]
+        v0. Param i64 a0
+        v1. Param i64 a1
+        v2. Const i64 3
+
+    BB [2/5]
+        v3. Add   i64 v0, v1
+        v4. Mul   i64 v3, v2
+        v5. Cmp   i64 v4, v2
+        v6. Jb    bb4
+
+    BB [3/5]
+        v7. Add   i64 v1, v0 -- dominated by v3
+        v8. Sub   i64 v0, v1
+        v9. Jmp   bb5
+
+    BB [4/5]
+        v10. Sub  i64 v0, v1 -- NOT dominated by v8
+        v11. Mul  i64 v2, v3 -- dominated by v4
+        v12. Jmp  bb5
+
+    BB [5/5]
+        v13. Phi  (v7, bb3) (v11, bb4)
+        v14. Phi  (v8, bb3) (v10, bb4)
+        v15. Sub  i64 v0, v1 -- NOT dominated by v8 and v10
+        v16. Add  i64 v13, v14
+        v17. Add  i64 v16, v15
+        v18. Ret  i64 v17
+    end
+    */
+    auto graph = std::make_shared<Graph>("gvn_branches");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    for (auto* bb : {bb1, bb2, bb3, bb4, bb5})
+        graph->addBB(bb);
+    graph->addEdge(bb1, bb2);
+    graph->addEdge(bb2, bb3);
+    graph->addEdge(bb2, bb4);
+    graph->addEdge(bb3, bb5);
+    graph->addEdge(bb4, bb5);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "a1");
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(3));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Add, v0, v1);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Mul, v3, v2);
+    bb2->pushBackInst(v3);
+    bb2->pushBackInst(v4);
+    bb2->pushBackInst(graph->create<BinaryInst>(5, InstType::Cmp, v4, v2));
+    bb2->pushBackInst(graph->create<JumpInst>(6, InstType::Jb, bb4));
+
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Add, v1, v0);
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Sub, v0, v1);
+    bb3->pushBackInst(v7);
+    bb3->pushBackInst(v8);
+    bb3->pushBackInst(graph->create<JumpInst>(9, InstType::Jmp, bb5));
+
+    auto* v10 = graph->create<BinaryInst>(10, InstType::Sub, v0, v1);
+    auto* v11 = graph->create<BinaryInst>(11, InstType::Mul, v2, v3);
+    bb4->pushBackInst(v10);
+    bb4->pushBackInst(v11);
+    bb4->pushBackInst(graph->create<JumpInst>(12, InstType::Jmp, bb5));
+
+    auto* v13 = graph->create<PhiInst>(13);
+    v13->addInput(v7, bb3);
+    v13->addInput(v11, bb4);
+    auto* v14 = graph->create<PhiInst>(14);
+    v14->addInput(v8, bb3);
+    v14->addInput(v10, bb4);
+    auto* v15 = graph->create<BinaryInst>(15, InstType::Sub, v0, v1);
+    auto* v16 = graph->create<BinaryInst>(16, InstType::Add, v13, v14);
+    auto* v17 = graph->create<BinaryInst>(17, InstType::Add, v16, v15);
+    auto* v18 = graph->create<UnaryInst>(18, InstType::Return, v17);
+    bb5->pushBackPhiInst(v13);
+    bb5->pushBackPhiInst(v14);
+    bb5->pushBackInst(v15);
+    bb5->pushBackInst(v16);
+    bb5->pushBackInst(v17);
+    bb5->pushBackInst(v18);
+
+    ASSERT_TRUE(graph->runPass<Gvn>());
+
+    // commutative duplicates are replaced with the dominating insts
+    EXPECT_EQ(v13->getInput(0), v3);
+    EXPECT_EQ(v13->getInput(1), v4);
+    EXPECT_EQ(bb3->getFirstInst(), v8);
+    EXPECT_EQ(v10->getNext()->getInstType(), InstType::Jmp);
+
+    // siblings and their common successor keep their own values
+    EXPECT_EQ(v14->getInput(0), v8);
+    EXPECT_EQ(v14->getInput(1), v10);
+    EXPECT_EQ(bb5->getFirstInst(), v15);
+    EXPECT_EQ(v17->getInput(1), v15);
+
+    // (5 + 2) * 3 >= 3 goes to bb3: 7 + 3 + 3
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(5, 2).getValue<uint64_t>(), 13U);
+}
+
+TEST(GVN_TEST, CHECKS)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/3]
+        v0. Param i64 a0
+        v1. Param i64 a1
+
+    BB [2/3]
+        v2. ZeroCheck i64 v0
+        v3. BoundsCheck i64 v0, v1
+        v4. Div   i64 v1, v2
+
+    BB [3/3]
+        v5. ZeroCheck i64 v0 -- dominated by v2
+        v6. BoundsCheck i64 v0, v1 -- dominated by v3
+        v7. ZeroCheck i64 v1
+        v8. Div   i64 v1, v2 -- dominated by v4
+        v9. Mod   i64 v8, v5
+        v10. Add  i64 v9, v4
+        v11. Ret  i64 v10
+    end
+    */
+    auto graph = std::make_shared<Graph>("gvn_checks");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "a1");
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+
+    auto* v2 = graph->create<UnaryInst>(2, InstType::ZeroCheck, v0);
+    auto* v3 = graph->create<BinaryInst>(3, InstType::BoundsCheck, v0, v1);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Div, v1, v2);
+    bb2->pushBackInst(v2);
+    bb2->pushBackInst(v3);
+    bb2->pushBackInst(v4);
+
+    auto* v5 = graph->create<UnaryInst>(5, InstType::ZeroCheck, v0);
+    auto* v6 = graph->create<BinaryInst>(6, InstType::BoundsCheck, v0, v1);
+    auto* v7 = graph->create<UnaryInst>(7, InstType::ZeroCheck, v1);
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Div, v1, v2);
+    auto* v9 = graph->create<BinaryInst>(9, InstType::Mod, v8, v5);
+    auto* v10 = graph->create<BinaryInst>(10, InstType::Add, v9, v4);
+    bb3->pushBackInst(v5);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(v7);
+    bb3->pushBackInst(v8);
+    bb3->pushBackInst(v9);
+    bb3->pushBackInst(v10);
+    bb3->pushBackInst(graph->create<UnaryInst>(11, InstType::Return, v10));
+
+    // checks only, users of the removed check take the dominating one
+    ASSERT_TRUE(graph->runPass<ChecksElimination>());
+    EXPECT_EQ(bb3->getFirstInst(), v7);
+    EXPECT_EQ(v7->getNext(), v8);
+    EXPECT_EQ(v9->getInput(1), v2);
+
+    ASSERT_TRUE(graph->runPass<Gvn>());
+    EXPECT_EQ(v7->getNext(), v9);
+    EXPECT_EQ(v9->getInput(0), v4);
+
+    // 9 / 4 % 4 + 9 / 4
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(4, 9).getValue<uint64_t>(), 4U);
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "ir/graph.h"
+#include "pass/domtree.h"
 #include "pass/inline.h"
+#include "runtime/interpreter.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <unordered_set>
 
 using namespace compiler;
 
@@ -61,14 +65,16 @@ TEST(INLINE_TEST, TEST1)
         empty
     end
     */
-    Graph* graph1_ptr = new Graph{"callee"};
+    // inlined blocks are moved to the caller, so both graphs use one arena
+    ArenaAllocator arena;
+    Graph* graph1_ptr = new Graph{"callee", &arena};
     std::shared_ptr<Graph> graph1(graph1_ptr);
 
-    auto* bb11 = new BasicBlock{1, graph1};
-    auto* bb12 = new BasicBlock{2, graph1};
-    auto* bb13 = new BasicBlock{3, graph1};
-    auto* bb14 = new BasicBlock{4, graph1};
-    auto* bb15 = new BasicBlock{5, graph1};
+    auto* bb11 = graph1->createBB(1);
+    auto* bb12 = graph1->createBB(2);
+    auto* bb13 = graph1->createBB(3);
+    auto* bb14 = graph1->createBB(4);
+    auto* bb15 = graph1->createBB(5);
 
     graph1->insertBB(bb11);
     graph1->insertBB(bb12);
@@ -77,50 +83,50 @@ TEST(INLINE_TEST, TEST1)
     graph1->insertBBAfter(bb13, bb15);
     graph1->addEdge(bb14, bb15);
 
-    auto* v10 = new ParamInst{0, DataType::i64, "x"};
-    auto* v11 = new ConstInst{1, static_cast<uint64_t>(0)};
+    auto* v10 = graph1->create<ParamInst>(0, DataType::i64, "x");
+    auto* v11 = graph1->create<ConstInst>(1, static_cast<uint64_t>(0));
     bb11->pushBackInst(v10);
     bb11->pushBackInst(v11);
 
-    auto* v12 = new BinaryInst{2, InstType::Cmp, v10, v11};
-    auto* v13 = new JumpInst{3, InstType::Ja, bb14};
+    auto* v12 = graph1->create<BinaryInst>(2, InstType::Cmp, v10, v11);
+    auto* v13 = graph1->create<JumpInst>(3, InstType::Ja, bb14);
     bb12->pushBackInst(v12);
     bb12->pushBackInst(v13);
 
-    auto* v14 = new BinaryInst{4, InstType::Add, v11, v10};
-    auto* v15 = new UnaryInst{5, InstType::Return, v14};
+    auto* v14 = graph1->create<BinaryInst>(4, InstType::Add, v11, v10);
+    auto* v15 = graph1->create<UnaryInst>(5, InstType::Return, v14);
     bb13->pushBackInst(v14);
     bb13->pushBackInst(v15);
 
-    auto* v16 = new BinaryInst{6, InstType::Sub, v11, v10};
-    auto* v17 = new UnaryInst{7, InstType::Return, v16};
+    auto* v16 = graph1->create<BinaryInst>(6, InstType::Sub, v11, v10);
+    auto* v17 = graph1->create<UnaryInst>(7, InstType::Return, v16);
     bb14->pushBackInst(v16);
     bb14->pushBackInst(v17);
     // graph1->dump();
 
     ////////////////////////////////////////////////////////////
 
-    auto graph2 = std::make_shared<Graph>("caller");
+    auto graph2 = std::make_shared<Graph>("caller", &arena);
 
-    auto* bb21 = new BasicBlock{1, graph2};
-    auto* bb22 = new BasicBlock{2, graph2};
-    auto* bb23 = new BasicBlock{3, graph2};
+    auto* bb21 = graph2->createBB(1);
+    auto* bb22 = graph2->createBB(2);
+    auto* bb23 = graph2->createBB(3);
 
     graph2->insertBB(bb21);
     graph2->insertBB(bb22);
     graph2->insertBB(bb23);
 
-    auto* v20 = new ParamInst{0, DataType::i64, "a"};
-    auto* v21 = new ConstInst{1, static_cast<uint64_t>(2)};
+    auto* v20 = graph2->create<ParamInst>(0, DataType::i64, "a");
+    auto* v21 = graph2->create<ConstInst>(1, static_cast<uint64_t>(2));
     bb21->pushBackInst(v20);
     bb21->pushBackInst(v21);
 
-    auto* v22 = new BinaryInst{2, InstType::Mul, v20, v21};
-    auto* v23 = new CallInst{3, graph1_ptr, {v22}};
+    auto* v22 = graph2->create<BinaryInst>(2, InstType::Mul, v20, v21);
+    auto* v23 = graph2->create<CallInst>(3, graph1_ptr, std::initializer_list<Inst*>{v22});
     bb22->pushBackInst(v22);
     bb22->pushBackInst(v23);
 
-    auto* v24 = new UnaryInst{4, InstType::Return, v23};
+    auto* v24 = graph2->create<UnaryInst>(4, InstType::Return, v23);
     bb23->pushBackInst(v24);
     // graph2->dump();
 
@@ -129,6 +135,259 @@ TEST(INLINE_TEST, TEST1)
     graph2->runPass<Inline>();
     // graph2->dump();
     ASSERT_EQ(graph2->size(), 8);
-    ASSERT_EQ(static_cast<ConstInst*>(bb21->getLastInst())->getIntValue(), 2);
+    // constants of the callee are merged into the caller pool
+    ASSERT_EQ(graph2->findConstant(static_cast<uint64_t>(2)), v21);
+    ASSERT_EQ(bb21->getLastInst(), graph2->findConstant(static_cast<uint64_t>(0)));
     ASSERT_EQ(static_cast<BinaryInst*>(bb12->getFirstInst())->getInput(0), v22);
 }
+
+
+/**
+ * Callee f(x, y) = (x + y) * 2:
+ *                 [1] -> [2]
+ */
+static std::shared_ptr<Graph> buildCallee(ArenaAllocator* arena)
+{
+    auto graph = std::make_shared<Graph>("callee", arena);
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "x");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "y");
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(2));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Add, v0, v1);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Mul, v3, v2);
+    bb2->pushBackInst(v3);
+    bb2->pushBackInst(v4);
+    bb2->pushBackInst(graph->create<UnaryInst>(5, InstType::Return, v4));
+    return graph;
+}
+
+/**
+ * Two calls in the middle of one block:
+ *                 [1] -> [2] -> [3]
+ */
+TEST(INLINE_TEST, TEST2)
+{
+    /*
+    Graph for proc caller
+    BB [1/3]
+        v0. Param i64 a
+        v1. Const i64 3
+    BB [2/3]
+        v2. Call callee v0, v1
+        v3. Call callee v2, v0
+        v4. Add  i64 v3, v2
+    BB [3/3]
+        v5. Ret  i64 v4
+    */
+    ArenaAllocator arena;
+    auto callee1 = buildCallee(&arena);
+    auto callee2 = buildCallee(&arena);
+    auto graph = std::make_shared<Graph>("caller", &arena);
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(3));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+
+    auto* v2 = graph->create<CallInst>(2, callee1.get(), std::initializer_list<Inst*>{v0, v1});
+    auto* v3 = graph->create<CallInst>(3, callee2.get(), std::initializer_list<Inst*>{v2, v0});
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v3, v2);
+    bb2->pushBackInst(v2);
+    bb2->pushBackInst(v3);
+    bb2->pushBackInst(v4);
+    bb3->pushBackInst(graph->create<UnaryInst>(5, InstType::Return, v4));
+
+    graph->runPass<Inline>();
+    // two continuation blocks and two callee bodies
+    ASSERT_EQ(graph->size(), 7);
+    for (auto* bb : graph->getBBs())
+    {
+        for (auto* succ : {bb->getTrueSucc(), bb->getFalseSucc()})
+        {
+            if (succ != nullptr)
+            {
+                ASSERT_EQ(std::count(succ->getPreds().begin(), succ->getPreds().end(), bb), 1);
+            }
+        }
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            ASSERT_NE(inst->getInstType(), InstType::Call);
+            ASSERT_EQ(inst->getBB(), bb);
+        }
+    }
+    ASSERT_EQ(bb2->getTrueSucc(), callee1->getBB(1));
+
+    // f(5, 3) = 16, f(16, 5) = 42
+    Interpreter interp(graph.get());
+    ASSERT_EQ(interp.call(static_cast<uint64_t>(5)).value, 58U);
+}
+
+/**
+ * Callee g(x) = x > 10 ? x - 10 : x + 1 with a return in each branch:
+ *                 [1]
+ *                  |
+ *                  v
+ *             /---[2]---\
+ *             |         |
+ *             v         v
+ *            [3]       [4]
+ */
+TEST(INLINE_TEST, TEST3)
+{
+    /*
+    Graph for proc caller
+    BB [1/3]
+        v0. Param i64 a
+    BB [2/3]
+        v1. Call callee v0
+        v2. Mul  i64 v1, v1
+    BB [3/3]
+        v3. Ret  i64 v2
+    */
+    ArenaAllocator arena;
+    auto callee = std::make_shared<Graph>("callee", &arena);
+    auto* bb11 = callee->createBB(1);
+    auto* bb12 = callee->createBB(2);
+    auto* bb13 = callee->createBB(3);
+    auto* bb14 = callee->createBB(4);
+    callee->insertBB(bb11);
+    callee->insertBB(bb12);
+    callee->insertBBAfter(bb12, bb13, true);
+    callee->insertBBAfter(bb12, bb14, false);
+
+    auto* v10 = callee->create<ParamInst>(0, DataType::i64, "x");
+    auto* v11 = callee->create<ConstInst>(1, static_cast<uint64_t>(10));
+    auto* v12 = callee->create<ConstInst>(2, static_cast<uint64_t>(1));
+    bb11->pushBackInst(v10);
+    bb11->pushBackInst(v11);
+    bb11->pushBackInst(v12);
+
+    bb12->pushBackInst(callee->create<BinaryInst>(3, InstType::Cmp, v10, v11));
+    bb12->pushBackInst(callee->create<JumpInst>(4, InstType::Ja, bb14));
+
+    auto* v15 = callee->create<BinaryInst>(5, InstType::Add, v10, v12);
+    bb13->pushBackInst(v15);
+    bb13->pushBackInst(callee->create<UnaryInst>(6, InstType::Return, v15));
+
+    auto* v17 = callee->create<BinaryInst>(7, InstType::Sub, v10, v11);
+    bb14->pushBackInst(v17);
+    bb14->pushBackInst(callee->create<UnaryInst>(8, InstType::Return, v17));
+
+    auto graph = std::make_shared<Graph>("caller", &arena);
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a");
+    bb1->pushBackInst(v0);
+    auto* v1 = graph->create<CallInst>(1, callee.get(), std::initializer_list<Inst*>{v0});
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Mul, v1, v1);
+    bb2->pushBackInst(v1);
+    bb2->pushBackInst(v2);
+    bb3->pushBackInst(graph->create<UnaryInst>(3, InstType::Return, v2));
+
+    graph->runPass<Inline>();
+    // both return blocks go to the exit block, which merges the values and goes on
+    ASSERT_EQ(bb13->getTrueSucc(), bb14->getTrueSucc());
+    auto* exit_bb = bb13->getTrueSucc();
+    ASSERT_NE(exit_bb, nullptr);
+    ASSERT_EQ(bb13->getFalseSucc(), nullptr);
+    ASSERT_EQ(exit_bb->getPreds(), (std::vector<BasicBlock*>{bb13, bb14}));
+    ASSERT_EQ(exit_bb->getGraph(), graph.get());
+    auto* phi = static_cast<PhiInst*>(exit_bb->getFirstPhi());
+    ASSERT_NE(phi, nullptr);
+    ASSERT_EQ(phi->getInputsNum(), 2U);
+    ASSERT_EQ(v2->getInput(0), phi);
+    ASSERT_EQ(v2->getBB()->getPreds(), std::vector<BasicBlock*>{exit_bb});
+    ASSERT_EQ(exit_bb->getTrueSucc(), v2->getBB());
+
+    // inlined insts and the merging phi get new ids of the caller
+    std::unordered_set<size_t> ids;
+    for (auto* bb : graph->getBBs())
+    {
+        for (auto* inst = bb->getFirstPhi(); inst != nullptr; inst = inst->getNext())
+            ASSERT_TRUE(ids.insert(inst->getId()).second);
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+            ASSERT_TRUE(ids.insert(inst->getId()).second);
+    }
+    ASSERT_LT(*std::max_element(ids.begin(), ids.end()), graph->getCurInstId());
+
+    Interpreter interp(graph.get());
+    ASSERT_EQ(interp.call(static_cast<uint64_t>(3)).value, 16U);
+    ASSERT_EQ(interp.call(static_cast<uint64_t>(15)).value, 25U);
+}
+TEST(INLINE_TEST, SPLIT_START_BLOCK)
+{
+    /*
+    Graph for proc caller
+    BB [1/2]
+        v0. Param i64 a
+        v1. Call callee v0
+        v2. Const i64 7
+        v3. Add  i64 v1, v2
+    BB [2/2]
+        v4. Ret  i64 v3
+    */
+    ArenaAllocator arena;
+    auto callee = std::make_shared<Graph>("callee", &arena);
+    auto* bb11 = callee->createBB(1);
+    auto* bb12 = callee->createBB(2);
+    callee->insertBB(bb11);
+    callee->insertBB(bb12);
+
+    auto* v10 = callee->create<ParamInst>(0, DataType::i64, "x");
+    auto* v11 = callee->create<ConstInst>(1, static_cast<uint64_t>(7));
+    bb11->pushBackInst(v10);
+    bb11->pushBackInst(v11);
+    auto* v12 = callee->create<BinaryInst>(2, InstType::Mul, v10, v11);
+    bb12->pushBackInst(v12);
+    bb12->pushBackInst(callee->create<UnaryInst>(3, InstType::Return, v12));
+
+    auto graph = std::make_shared<Graph>("caller", &arena);
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a");
+    auto* v1 = graph->create<CallInst>(1, callee.get(), std::initializer_list<Inst*>{v0});
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(7));
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Add, v1, v2);
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+    bb1->pushBackInst(v3);
+    bb2->pushBackInst(graph->create<UnaryInst>(4, InstType::Return, v3));
+
+    graph->runPass<Inline>();
+    // the constant after the call stays in the start block and is shared with the callee
+    ASSERT_EQ(v2->getBB(), bb1);
+    ASSERT_EQ(graph->findConstant(static_cast<uint64_t>(7)), v2);
+    ASSERT_EQ(v12->getInput(1), v2);
+    ASSERT_NE(v3->getBB(), bb1);
+
+    ASSERT_TRUE(graph->runPass<DomTree>());
+    ASSERT_TRUE(v2->dominates(v12));
+    ASSERT_TRUE(v2->dominates(v3));
+
+    Interpreter interp(graph.get());
+    ASSERT_EQ(interp.call(static_cast<uint64_t>(3)).value, 28U);
+}
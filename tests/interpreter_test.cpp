@@ -0,0 +1,114 @@
+#include "ir/graph.h"
+#include "pass/reg_alloc.h"
+#include "runtime/interpreter.h"
+#include "test_graphs.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <limits>
+
+using namespace compiler;
+
+TEST(INTERPRETER_TEST, LOOPS)
+{
+    auto factorial = buildFactorial();
+    Interpreter fact_interp(factorial.get());
+    EXPECT_EQ(fact_interp.call<uint64_t>(0).getValue<uint64_t>(), 1U);
+    EXPECT_EQ(fact_interp.call<uint64_t>(5).getValue<uint64_t>(), 120U);
+    EXPECT_EQ(fact_interp.call<uint64_t>(20).getValue<uint64_t>(), 2432902008176640000U);
+
+    // a phi takes the old value of the other phi on the back edge
+    auto fibonacci = buildFibonacci();
+    Interpreter fib_interp(fibonacci.get());
+    EXPECT_EQ(fib_interp.call<uint32_t>(1).getValue<uint32_t>(), 1U);
+    EXPECT_EQ(fib_interp.call<uint32_t>(10).getValue<uint32_t>(), 55U);
+    EXPECT_EQ(fib_interp.call<uint32_t>(47).getValue<uint32_t>(), 2971215073U);
+    // wraps around
+    EXPECT_EQ(fib_interp.call<uint32_t>(48).getValue<uint32_t>(), 512559680U);
+}
+
+TEST(INTERPRETER_TEST, CALLS)
+{
+    auto graph = buildSum();
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(0).getValue<uint64_t>(), 0U);
+    EXPECT_EQ(interp.call<uint64_t>(100).getValue<uint64_t>(), 5050U);
+    EXPECT_EQ(interp.call<uint64_t>(1000).getValue<uint64_t>(), 500500U);
+    EXPECT_EQ(interp.call<uint64_t>(INTERP_MAX_CALL_DEPTH).status, ExecStatus::StackOverflow);
+    // the interpreter is usable after a failure
+    EXPECT_EQ(interp.call<uint64_t>(3).getValue<uint64_t>(), 6U);
+
+    // a caller passes args to a cached callee
+    auto caller = std::make_shared<Graph>("caller");
+    auto* caller_bb = caller->createBB(1);
+    caller->insertBB(caller_bb);
+    auto* arg = caller->create<ParamInst>(0, DataType::i64, "n");
+    auto* call1 = caller->create<CallInst>(1, graph.get(), std::initializer_list<Inst*>{arg});
+    auto* call2 = caller->create<CallInst>(2, graph.get(), std::initializer_list<Inst*>{call1});
+    caller_bb->pushBackInst(arg);
+    caller_bb->pushBackInst(call1);
+    caller_bb->pushBackInst(call2);
+    caller_bb->pushBackInst(caller->create<UnaryInst>(3, InstType::Return, call2));
+
+    Interpreter caller_interp(caller.get());
+    // sum(sum(4)) = sum(10)
+    EXPECT_EQ(caller_interp.call<uint64_t>(4).getValue<uint64_t>(), 55U);
+}
+
+TEST(INTERPRETER_TEST, CHECKS)
+{
+    auto graph = buildChecks();
+    Interpreter interp(graph.get());
+    auto result = interp.call<uint64_t>(9, 10, 4);
+    EXPECT_TRUE(result.isOk());
+    EXPECT_EQ(result.getValue<uint64_t>(), 4U);
+    EXPECT_EQ(interp.call<uint64_t>(10, 10, 4).status, ExecStatus::BoundsCheckFailed);
+    // index is unsigned
+    EXPECT_EQ(interp.call<uint64_t>(-1, 10, 4).status, ExecStatus::BoundsCheckFailed);
+    EXPECT_EQ(interp.call<uint64_t>(1, 10, 0).status, ExecStatus::ZeroCheckFailed);
+    EXPECT_EQ(interp.call<uint64_t>(1, 10, 5).status, ExecStatus::DivisionByZero);
+}
+
+TEST(INTERPRETER_TEST, TYPES)
+{
+    auto graph = buildTypes();
+    Interpreter interp(graph.get());
+    // -8 is above 33 as unsigned, AShr masks the count to 1 and Cast sign extends
+    EXPECT_EQ(interp.call<int32_t>(-8, 33, 0.0).getValue<int64_t>(), -4);
+    // Neg(-100.75) truncates to 100, Shr by 34 & 31
+    EXPECT_EQ(interp.call<int32_t>(1, 34, -100.75).getValue<int64_t>(), 25);
+    // -100.75 truncates to -100, logical shift of it is positive
+    EXPECT_EQ(interp.call<int32_t>(1, 32, 100.75).getValue<int64_t>(), -100);
+    EXPECT_EQ(interp.call<int32_t>(1, 33, 100.75).getValue<int64_t>(), 0x7fffffce);
+    // NaN and out of range values give the minimal integer
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(interp.call<int32_t>(1, 32, nan).getValue<int64_t>(), INT32_MIN);
+    EXPECT_EQ(interp.call<int32_t>(1, 32, -1e20).getValue<int64_t>(), INT32_MIN);
+}
+
+TEST(INTERPRETER_TEST, REG_ALLOC)
+{
+    // the allocation adds moves and split blocks, but keeps the semantics
+    auto factorial = buildFactorial();
+    auto fibonacci = buildFibonacci();
+    std::vector<uint64_t> fact_expected;
+    std::vector<uint32_t> fib_expected;
+    {
+        Interpreter fact_interp(factorial.get());
+        Interpreter fib_interp(fibonacci.get());
+        for (uint32_t n = 0; n < 16; ++n)
+        {
+            fact_expected.push_back(fact_interp.call<uint64_t>(n).getValue<uint64_t>());
+            fib_expected.push_back(fib_interp.call(n).getValue<uint32_t>());
+        }
+    }
+
+    ASSERT_TRUE(factorial->runPass<RegisterAllocation>());
+    ASSERT_TRUE(fibonacci->runPass<RegisterAllocation>());
+    Interpreter fact_interp(factorial.get());
+    Interpreter fib_interp(fibonacci.get());
+    for (uint32_t n = 0; n < 16; ++n)
+    {
+        EXPECT_EQ(fact_interp.call<uint64_t>(n).getValue<uint64_t>(), fact_expected[n]);
+        EXPECT_EQ(fib_interp.call(n).getValue<uint32_t>(), fib_expected[n]);
+    }
+}
\ No newline at end of file
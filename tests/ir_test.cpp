@@ -1,5 +1,8 @@
+#include "bit_vector.h"
 #include "graph.h"
 #include "gtest/gtest.h"
+#include <cmath>
+#include <limits>
 
 using namespace compiler;
 
@@ -36,11 +39,11 @@ TEST(IR_TEST, FACT)
 
     auto graph = std::make_shared<Graph>("fact");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -49,9 +52,9 @@ TEST(IR_TEST, FACT)
     graph->insertBB(bb5);
 
     // Fill bb1
-    auto* v1 = new ParamInst{1, DataType::i32, "a0"};
-    auto* v2 = new ConstInst{2, static_cast<uint64_t>(1)};
-    auto* v3 = new ConstInst{3, static_cast<uint64_t>(2)};
+    auto* v1 = graph->create<ParamInst>(1, DataType::i32, "a0");
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(1));
+    auto* v3 = graph->create<ConstInst>(3, static_cast<uint64_t>(2));
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v2);
     bb1->pushBackInst(v3);
@@ -73,9 +76,9 @@ TEST(IR_TEST, FACT)
     }
 
     // Fill bb2
-    auto* v4 = new MovInst{4, 0, v2};
-    auto* v5 = new MovInst{5, 1, v3};
-    auto* v6 = new CastInst{6, v1, DataType::i64};
+    auto* v4 = graph->create<MovInst>(4, 0, v2);
+    auto* v5 = graph->create<MovInst>(5, 1, v3);
+    auto* v6 = graph->create<CastInst>(6, v1, DataType::i64);
 
     bb2->pushBackInst(v4);
     bb2->pushBackInst(v5);
@@ -98,10 +101,10 @@ TEST(IR_TEST, FACT)
     }
 
     // Fill bb3
-    auto* v7 = new PhiInst{7};
+    auto* v7 = graph->create<PhiInst>(7);
     v7->addInput(std::make_pair(v5, bb2));
-    auto* v8 = new BinaryInst{8, InstType::Cmp, v7, v6};
-    auto* v9 = new JumpInst{9, InstType::Ja, bb5};
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Cmp, v7, v6);
+    auto* v9 = graph->create<JumpInst>(9, InstType::Ja, bb5);
 
     bb3->pushBackPhiInst(v7);
     bb3->pushBackInst(v8);
@@ -124,13 +127,13 @@ TEST(IR_TEST, FACT)
     }
 
     // Fill bb4
-    auto* v10 = new PhiInst{10};
+    auto* v10 = graph->create<PhiInst>(10);
     v10->addInput(std::make_pair(v4, bb2));
-    auto* v11 = new PhiInst{11};
+    auto* v11 = graph->create<PhiInst>(11);
     v11->addInput(std::make_pair(v5, bb2));
-    auto* v12 = new BinaryInst{12, InstType::Mul, v10, v11};
-    auto* v13 = new BinaryInst{13, InstType::Add, v11, v2};
-    auto* v14 = new JumpInst{14, InstType::Jmp, bb3};
+    auto* v12 = graph->create<BinaryInst>(12, InstType::Mul, v10, v11);
+    auto* v13 = graph->create<BinaryInst>(13, InstType::Add, v11, v2);
+    auto* v14 = graph->create<JumpInst>(14, InstType::Jmp, bb3);
 
     v7->addInput(std::make_pair(v13, bb4));
     v10->addInput(std::make_pair(v12, bb4));
@@ -165,10 +168,10 @@ TEST(IR_TEST, FACT)
     }
 
     // Fill bb5
-    auto* v15 = new PhiInst{15};
+    auto* v15 = graph->create<PhiInst>(15);
     v15->addInput(std::make_pair(v4, bb2));
     v15->addInput(std::make_pair(v12, bb4));
-    auto* v16 = new UnaryInst{16, InstType::Return, v15};
+    auto* v16 = graph->create<UnaryInst>(16, InstType::Return, v15);
 
     bb5->pushBackPhiInst(v15);
     bb5->pushBackInst(v16);
@@ -208,6 +211,273 @@ TEST(IR_TEST, FACT)
         ASSERT_EQ(bb4->getPreds()[0]->getId(), 3);
         ASSERT_EQ(bb5->getPreds()[0]->getId(), 4);
 
-        ASSERT_EQ(bb5->getGraph(), graph);
+        ASSERT_EQ(bb5->getGraph(), graph.get());
     }
 }
+
+
+TEST(IR_TEST, ARENA)
+{
+    ArenaAllocator arena;
+    size_t chunks = 0;
+
+    // one arena reused by several compilations on the same thread
+    for (size_t iter = 0; iter < 3; ++iter)
+    {
+        {
+            Graph graph{"arena", &arena};
+            ASSERT_EQ(graph.getArena(), &arena);
+
+            auto* bb1 = graph.createBB(1);
+            auto* bb2 = graph.createBB(2);
+            graph.insertBB(bb1);
+            graph.insertBB(bb2);
+
+            auto* v0 = graph.create<ParamInst>(0, DataType::i64, "a0");
+            auto* v1 = graph.create<ConstInst>(1, static_cast<uint64_t>(1));
+            bb1->pushBackInst(v0);
+            bb1->pushBackInst(v1);
+
+            auto* v2 = graph.create<BinaryInst>(2, InstType::Add, v0, v1);
+            auto* v3 = graph.create<UnaryInst>(3, InstType::Return, v2);
+            bb2->pushBackInst(v2);
+            bb2->pushBackInst(v3);
+
+            ASSERT_EQ(bb1->getGraph(), &graph);
+            ASSERT_EQ(bb2->getTrueSucc(), nullptr);
+            ASSERT_FALSE(bb2->isMarked(graph.getNewMarker()));
+            ASSERT_EQ(v2->getInput(0), v0);
+            ASSERT_EQ(v0->getUsers().front(), v2);
+            ASSERT_GT(arena.getAllocatedSize(), 0);
+        }
+
+        // graph with external arena does not release it
+        ASSERT_GT(arena.getAllocatedSize(), 0);
+        arena.reset();
+        ASSERT_EQ(arena.getAllocatedSize(), 0);
+
+        // chunks are kept for the next compilation
+        if (iter == 0)
+            chunks = arena.getChunksNum();
+        ASSERT_EQ(arena.getChunksNum(), chunks);
+    }
+
+    // allocations bigger than a chunk get their own chunk
+    auto* big = arena.allocate(2 * ARENA_CHUNK_SIZE, alignof(uint64_t));
+    ASSERT_NE(big, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(big) % alignof(uint64_t), 0);
+    ASSERT_EQ(arena.getChunksNum(), chunks + 1);
+}
+
+TEST(IR_TEST, USERS)
+{
+    auto graph = std::make_shared<Graph>("users");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Add, v0, v0);
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Sub, v2, v1);
+    bb2->pushBackInst(v2);
+    bb2->pushBackInst(v3);
+
+    // every operand slot is a separate edge, the latest one goes first
+    ASSERT_EQ(v0->getUsersNum(), 2);
+    ASSERT_EQ(v1->getUsersNum(), 1);
+    ASSERT_EQ(v2->getUsers().front(), v3);
+
+    // phi inputs are relinked while the inputs vector grows
+    auto* v4 = graph->create<PhiInst>(4);
+    for (size_t i = 0; i < 20; ++i)
+        v4->addInput(v1, bb1);
+    bb2->pushFrontPhiInst(v4);
+    ASSERT_EQ(v1->getUsersNum(), 21);
+    for (auto* user : v1->getUsers())
+        ASSERT_TRUE(user == v3 || user == v4);
+
+    auto* v5 = graph->create<CallInst>(5, graph.get(), std::initializer_list<Inst*>{v0, v1});
+    v5->insertArg(v3);
+    bb2->pushBackInst(v5);
+    ASSERT_EQ(v5->getInputsNum(), 3);
+    ASSERT_EQ(v5->getArg(2), v3);
+
+    v1->replaceUsers(v0);
+    ASSERT_EQ(v1->getUsersNum(), 0);
+    ASSERT_EQ(v0->getUsersNum(), 25);
+    ASSERT_EQ(v3->getInput(1), v0);
+    ASSERT_EQ(v4->getInput(19), v0);
+    ASSERT_EQ(v5->getArg(1), v0);
+
+    v2->swapInputs();
+    ASSERT_EQ(v0->getUsersNum(), 25);
+
+    // removed inst does not use its inputs anymore
+    bb2->removeInst(v5);
+    ASSERT_EQ(v0->getUsersNum(), 23);
+    ASSERT_EQ(v3->getUsersNum(), 0);
+    bb2->removeInst(v3);
+    ASSERT_EQ(v2->getUsersNum(), 0);
+    ASSERT_EQ(v0->getUsersNum(), 22);
+}
+
+
+TEST(IR_TEST, DENSE_IDS)
+{
+    auto graph = std::make_shared<Graph>("dense");
+
+    auto* bb1 = graph->createBB(10);
+    auto* bb2 = graph->createBB(20);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    ASSERT_EQ(bb1->getDenseId(), 0);
+    ASSERT_EQ(bb2->getDenseId(), 1);
+
+    auto* v0 = graph->create<ParamInst>(100, DataType::i64, "a0");
+    auto* v1 = graph->create<BinaryInst>(200, InstType::Add, v0, v0);
+    auto* v2 = graph->create<BinaryInst>(300, InstType::Sub, v1, v0);
+    bb1->pushBackInst(v0);
+    bb2->pushBackInst(v1);
+    bb2->pushBackInst(v2);
+    ASSERT_EQ(v0->getDenseId(), 0);
+    ASSERT_EQ(v1->getDenseId(), 1);
+    ASSERT_EQ(v2->getDenseId(), 2);
+    ASSERT_EQ(graph->getInstsDenseNum(), 3);
+
+    IdVector<int> table(-1);
+    table[v2] = 2;
+    ASSERT_EQ(table.size(), 3);
+    ASSERT_EQ(table.get(v0), -1);
+    ASSERT_EQ(table.get(v2), 2);
+    ASSERT_EQ(table.get(100), -1);
+
+    bb2->removeInst(v1);
+    graph->renumberDenseIds();
+    ASSERT_EQ(v0->getDenseId(), 0);
+    ASSERT_EQ(v2->getDenseId(), 1);
+    ASSERT_EQ(graph->getInstsDenseNum(), 2);
+    ASSERT_EQ(graph->getBBsDenseNum(), 2);
+}
+
+TEST(IR_TEST, CONST_POOL)
+{
+    auto graph = std::make_shared<Graph>("consts");
+    auto* bb = graph->createBB(1);
+    graph->insertBB(bb);
+
+    auto* c1 = graph->findConstant(static_cast<uint64_t>(1));
+    ASSERT_EQ(graph->findConstant(static_cast<uint64_t>(1)), c1);
+    // same bits with other type is another constant
+    auto* c2 = graph->findConstant(static_cast<uint32_t>(1));
+    ASSERT_NE(c2, c1);
+    ASSERT_EQ(c2->getType(), DataType::i32);
+
+    auto* pos_zero = graph->findConstant(0.0);
+    auto* neg_zero = graph->findConstant(-0.0);
+    ASSERT_NE(pos_zero, neg_zero);
+    ASSERT_TRUE(std::signbit(neg_zero->getDoubleValue()));
+
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    auto* nan_const = graph->findConstant(nan);
+    ASSERT_EQ(graph->findConstant(nan), nan_const);
+    ASSERT_TRUE(std::isnan(nan_const->getFloatValue()));
+    ASSERT_EQ(graph->findConstant(1.5f)->getFloatValue(), 1.5f);
+    ASSERT_EQ(graph->getConstPool().size(), 6);
+    ASSERT_EQ(bb->size(), 6);
+
+    bb->removeInst(c1);
+    ASSERT_EQ(graph->getConstPool().size(), 5);
+    auto* c3 = graph->findConstant(static_cast<uint64_t>(1));
+    ASSERT_NE(c3, c1);
+    ASSERT_EQ(c3->getInt64Value(), 1);
+
+    // a constant pushed to the first block by hand is registered as well
+    bb->removeInst(c3);
+    auto* c4 = graph->create<ConstInst>(100, static_cast<uint64_t>(1));
+    bb->pushBackInst(c4);
+    ASSERT_EQ(graph->findConstant(static_cast<uint64_t>(1)), c4);
+    ASSERT_EQ(graph->getConstPool().size(), 6);
+    ASSERT_EQ(bb->size(), 6);
+
+    // constants of other blocks do not dominate all uses, so they are not pooled
+    auto* bb2 = graph->createBB(2);
+    graph->insertBB(bb2);
+    auto* local = graph->create<ConstInst>(101, static_cast<uint64_t>(7));
+    bb2->pushBackInst(local);
+    auto* c7 = graph->findConstant(static_cast<uint64_t>(7));
+    ASSERT_NE(c7, local);
+    ASSERT_EQ(c7->getBB(), bb);
+    bb2->removeInst(local);
+    ASSERT_EQ(graph->findConstant(static_cast<uint64_t>(7)), c7);
+}
+
+TEST(IR_TEST, INSTS_ORDER)
+{
+    auto graph = std::make_shared<Graph>("order");
+    auto* bb = graph->createBB(1);
+    graph->insertBB(bb);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "a1");
+    bb->pushBackInst(v0);
+    bb->pushBackInst(v1);
+
+    // repeated insertions to the same place exhaust the gap and force renumbering
+    std::vector<Inst*> insts{v0};
+    for (size_t i = 0; i < 20; ++i)
+    {
+        auto* inst = graph->create<BinaryInst>(i + 2, InstType::Add, v0, v1);
+        bb->insertAfter(v0, inst);
+        insts.insert(std::next(insts.begin()), inst);
+    }
+    insts.push_back(v1);
+    auto* phi = graph->create<PhiInst>(100);
+    bb->pushFrontPhiInst(phi);
+    insts.insert(insts.begin(), phi);
+
+    for (size_t i = 0; i < insts.size(); ++i)
+        for (size_t j = 0; j < insts.size(); ++j)
+            ASSERT_EQ(insts[i]->dominates(insts[j]), i <= j);
+}
+
+TEST(IR_TEST, BIT_VECTOR)
+{
+    BitVector a(130);
+    BitVector b(130);
+    ASSERT_TRUE(a.empty());
+    a.set(0);
+    a.set(64);
+    a.set(129);
+    b.set(64);
+    b.set(100);
+
+    ASSERT_TRUE(a.test(129));
+    ASSERT_FALSE(a.test(100));
+    ASSERT_TRUE(a.unite(b));
+    ASSERT_FALSE(a.unite(b));
+    ASSERT_EQ(a.count(), 4);
+
+    std::vector<size_t> bits;
+    a.forEach([&bits](size_t idx) { bits.push_back(idx); });
+    ASSERT_EQ(bits, (std::vector<size_t>{0, 64, 100, 129}));
+
+    a.subtract(b);
+    ASSERT_EQ(a.count(), 2);
+    ASSERT_FALSE(a.test(64));
+
+    // c = b + (a - kill)
+    BitVector kill(130);
+    kill.set(0);
+    BitVector c(130);
+    ASSERT_TRUE(c.transfer(b, kill, a));
+    ASSERT_FALSE(c.transfer(b, kill, a));
+    bits.clear();
+    c.forEach([&bits](size_t idx) { bits.push_back(idx); });
+    ASSERT_EQ(bits, (std::vector<size_t>{64, 100, 129}));
+}
\ No newline at end of file
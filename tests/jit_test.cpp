@@ -0,0 +1,252 @@
+#include "codegen/jit.h"
+#include "ir/graph.h"
+#include "pass/reg_alloc.h"
+#include "runtime/interpreter.h"
+#include "test_graphs.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#if defined(__x86_64__) && defined(__linux__)
+
+using namespace compiler;
+
+// few registers with a callee-saved one: values are spilled and live across calls
+static const Target SMALL_X86_TARGET("small_x86", {{"rax", "rcx", "rbx"}, 0b100, "r11"},
+                                     {{"xmm0", "xmm1", "xmm2"}, 0, "xmm15"});
+
+using graph_builder_t = std::function<std::shared_ptr<Graph>()>;
+
+/**
+ * Run check for the graph allocated by every allocator for every target,
+ * the interpreter of the graph before the allocation gives expected results
+ */
+static void checkAllocations(const graph_builder_t& builder,
+                             const std::function<void(Interpreter&, JitCode&)>& check,
+                             std::vector<const Target*> targets = {Target::getDefault(),
+                                                                   &SMALL_X86_TARGET})
+{
+    for (auto* target : targets)
+        for (auto kind : {RegAllocKind::LinearScan, RegAllocKind::GraphColoring})
+        {
+            auto expected = builder();
+            auto graph = builder();
+            graph->setTarget(target);
+            graph->setRegAllocKind(kind);
+            ASSERT_TRUE(graph->runPass<RegisterAllocation>());
+
+            Interpreter interp(expected.get());
+            auto code = JitCompiler::compile(graph.get());
+            check(interp, *code);
+        }
+}
+
+TEST(JIT_TEST, LOOPS)
+{
+    checkAllocations(buildFactorial, [](Interpreter& interp, JitCode& code) {
+        for (uint64_t n = 0; n <= 20; ++n)
+            EXPECT_EQ(code.call<uint64_t>(n).value, interp.call(n).value);
+        EXPECT_EQ(code.getFunction<uint64_t(uint64_t)>()(20), 2432902008176640000U);
+    });
+
+    checkAllocations(buildFibonacci, [](Interpreter& interp, JitCode& code) {
+        for (uint32_t n = 0; n <= 48; ++n)
+            EXPECT_EQ(code.call<uint32_t>(n).value, interp.call(n).value);
+    });
+}
+
+TEST(JIT_TEST, CALLS)
+{
+    checkAllocations(buildSum, [](Interpreter& interp, JitCode& code) {
+        for (uint64_t n : {0, 1, 100, 1000})
+            EXPECT_EQ(code.call<uint64_t>(n).value, interp.call(n).value);
+        // the depth is limited like in the interpreter
+        uint64_t deepest = INTERP_MAX_CALL_DEPTH - 1;
+        EXPECT_EQ(code.call<uint64_t>(deepest).value, interp.call(deepest).value);
+        EXPECT_EQ(code.call<uint64_t>(deepest + 1).status, ExecStatus::StackOverflow);
+        EXPECT_EQ(code.call<uint64_t>(uint64_t(3)).value, 6U);
+    });
+
+    /*
+    poly(a0, ..., a7, x) = (...(a0 * 3 + a1) * 3 + ... + a7) + Cast(x), two ints and the float
+    go on the stack, the caller passes its params in the reverse order:
+    BB [1/1]
+        v0-v7. Param i64 p0-p7
+        v8.    Param f64 q
+        v9.    Call  poly v7, v6, ..., v0, v8
+        v10.   Sub   i64 v9, v0
+        v11.   Ret   i64 v10
+    */
+    graph_builder_t build_caller = []() {
+        // callees of all built callers stay alive
+        static std::vector<std::shared_ptr<Graph>> callees;
+        auto poly = callees.emplace_back(std::make_shared<Graph>("poly"));
+        auto* poly_bb = poly->createBB(1);
+        poly->insertBB(poly_bb);
+        size_t id = 0;
+        std::vector<Inst*> params;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            params.push_back(poly->create<ParamInst>(id++, DataType::i64, "a"));
+            poly_bb->pushBackInst(params.back());
+        }
+        auto* x = poly->create<ParamInst>(id++, DataType::f64, "x");
+        auto* three = poly->create<ConstInst>(id++, static_cast<uint64_t>(3));
+        poly_bb->pushBackInst(x);
+        poly_bb->pushBackInst(three);
+        Inst* acc = params[0];
+        for (size_t i = 1; i < 8; ++i)
+        {
+            auto* mul = poly->create<BinaryInst>(id++, InstType::Mul, acc, three);
+            acc = poly->create<BinaryInst>(id++, InstType::Add, mul, params[i]);
+            poly_bb->pushBackInst(mul);
+            poly_bb->pushBackInst(acc);
+        }
+        auto* cast = poly->create<CastInst>(id++, x, DataType::i64);
+        auto* result = poly->create<BinaryInst>(id++, InstType::Add, acc, cast);
+        poly_bb->pushBackInst(cast);
+        poly_bb->pushBackInst(result);
+        poly_bb->pushBackInst(poly->create<UnaryInst>(id++, InstType::Return, result));
+        EXPECT_TRUE(poly->runPass<RegisterAllocation>());
+
+        auto graph = std::make_shared<Graph>("caller");
+        auto* bb = graph->createBB(1);
+        graph->insertBB(bb);
+        auto* call = graph->create<CallInst>(9, poly.get());
+        std::vector<Inst*> args;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            args.push_back(graph->create<ParamInst>(i, DataType::i64, "p"));
+            bb->pushBackInst(args.back());
+        }
+        auto* q = graph->create<ParamInst>(8, DataType::f64, "q");
+        bb->pushBackInst(q);
+        for (size_t i = 8; i > 0; --i)
+            call->insertArg(args[i - 1]);
+        call->insertArg(q);
+        auto* sub = graph->create<BinaryInst>(10, InstType::Sub, call, args[0]);
+        bb->pushBackInst(call);
+        bb->pushBackInst(sub);
+        bb->pushBackInst(graph->create<UnaryInst>(11, InstType::Return, sub));
+        return graph;
+    };
+    // all args of the call need registers at once
+    checkAllocations(build_caller, [](Interpreter& interp, JitCode& code) {
+        auto result = code.call<uint64_t>(uint64_t(1), uint64_t(2), uint64_t(3), uint64_t(4),
+                                          uint64_t(5), uint64_t(6), uint64_t(7), uint64_t(8),
+                                          -2.5);
+        auto expected = interp.call(uint64_t(1), uint64_t(2), uint64_t(3), uint64_t(4),
+                                    uint64_t(5), uint64_t(6), uint64_t(7), uint64_t(8), -2.5);
+        EXPECT_TRUE(result.isOk());
+        EXPECT_EQ(result.value, expected.value);
+        // 8 * 3^7 + 7 * 3^6 + ... + 1 - 2 - 1
+        EXPECT_EQ(result.getValue<int64_t>(), 24604 - 3);
+    }, {Target::getDefault()});
+}
+
+TEST(JIT_TEST, CHECKS)
+{
+    checkAllocations(buildChecks, [](Interpreter& interp, JitCode& code) {
+        for (auto [index, length, divisor] : std::vector<std::tuple<uint64_t, uint64_t, uint64_t>>{
+                 {9, 10, 4}, {10, 10, 4}, {-1, 10, 4}, {1, 10, 0}, {1, 10, 5}, {0, 1000, 7}})
+        {
+            auto result = code.call<uint64_t>(index, length, divisor);
+            auto expected = interp.call(index, length, divisor);
+            EXPECT_EQ(result.status, expected.status);
+            if (expected.isOk())
+            {
+                EXPECT_EQ(result.value, expected.value);
+            }
+        }
+    });
+}
+
+TEST(JIT_TEST, TYPES)
+{
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    checkAllocations(buildTypes, [nan](Interpreter& interp, JitCode& code) {
+        for (auto [a, b, x] : std::vector<std::tuple<int32_t, int32_t, double>>{
+                 {-8, 33, 0.0},
+                 {1, 34, -100.75},
+                 {1, 32, 100.75},
+                 {1, 33, 100.75},
+                 {1, 32, nan},
+                 {1, 32, -1e20},
+                 {7, 3, 1.5}})
+            EXPECT_EQ(code.call<int64_t>(a, b, x).value, interp.call(a, b, x).value);
+    });
+
+    /*
+    BB [1/4]
+        v0. Param f64 x
+        v1. Param f64 y
+        v2. Param f32 z
+
+    BB [2/4]
+        v3. Mod   f64 v0, v1
+        v4. Div   f64 v0, v1
+        v5. Sub   f64 v4, v3
+        v6. Cast  v2 to f64
+        v7. Mul   f64 v5, v6
+        v8. Cmp   f64 v7, v3
+        v9. Jbe   bb4
+
+    BB [3/4]
+        v10. Neg  f64 v7
+        v11. Ret  f64 v10
+
+    BB [4/4]
+        v12. Ret  f64 v7
+    */
+    graph_builder_t build_floats = []() {
+        auto graph = std::make_shared<Graph>("floats");
+        auto* bb1 = graph->createBB(1);
+        auto* bb2 = graph->createBB(2);
+        auto* bb3 = graph->createBB(3);
+        auto* bb4 = graph->createBB(4);
+        graph->insertBB(bb1);
+        graph->insertBB(bb2);
+        graph->insertBB(bb3);
+        graph->addBB(bb4);
+        graph->addEdge(bb2, bb4);
+
+        auto* v0 = graph->create<ParamInst>(0, DataType::f64, "x");
+        auto* v1 = graph->create<ParamInst>(1, DataType::f64, "y");
+        auto* v2 = graph->create<ParamInst>(2, DataType::f32, "z");
+        bb1->pushBackInst(v0);
+        bb1->pushBackInst(v1);
+        bb1->pushBackInst(v2);
+
+        auto* v3 = graph->create<BinaryInst>(3, InstType::Mod, v0, v1);
+        auto* v4 = graph->create<BinaryInst>(4, InstType::Div, v0, v1);
+        auto* v5 = graph->create<BinaryInst>(5, InstType::Sub, v4, v3);
+        auto* v6 = graph->create<CastInst>(6, v2, DataType::f64);
+        auto* v7 = graph->create<BinaryInst>(7, InstType::Mul, v5, v6);
+        bb2->pushBackInst(v3);
+        bb2->pushBackInst(v4);
+        bb2->pushBackInst(v5);
+        bb2->pushBackInst(v6);
+        bb2->pushBackInst(v7);
+        bb2->pushBackInst(graph->create<BinaryInst>(8, InstType::Cmp, v7, v3));
+        bb2->pushBackInst(graph->create<JumpInst>(9, InstType::Jbe, bb4));
+
+        auto* v10 = graph->create<UnaryInst>(10, InstType::Neg, v7);
+        bb3->pushBackInst(v10);
+        bb3->pushBackInst(graph->create<UnaryInst>(11, InstType::Return, v10));
+        bb4->pushBackInst(graph->create<UnaryInst>(12, InstType::Return, v7));
+        return graph;
+    };
+    checkAllocations(build_floats, [nan](Interpreter& interp, JitCode& code) {
+        for (auto [x, y, z] : std::vector<std::tuple<double, double, float>>{
+                 {7.5, 2.0, 1.0f},
+                 {-7.5, 2.0, 0.5f},
+                 {1e300, 3.0, -2.0f},
+                 {5.0, 0.0, 1.0f},
+                 {nan, 1.0, 1.0f},
+                 {1.0, 1e-300, 3.0f}})
+            EXPECT_EQ(code.call<double>(x, y, z).value, interp.call(x, y, z).value);
+    });
+}
+
+#endif
\ No newline at end of file
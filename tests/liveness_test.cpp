@@ -8,9 +8,11 @@ void checkLiveIntervals(std::shared_ptr<Graph> g,
                         std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> expected)
 {
     auto& live_intervals = g->getLiveIntervals();
-    for (auto [inst, interval] : live_intervals)
+    for (auto* interval : live_intervals)
     {
-        uint32_t id = inst->getId();
+        if (interval == nullptr)
+            continue;
+        uint32_t id = interval->getInst()->getId();
         auto elem = expected[id];
         ASSERT_EQ(interval->getIntervalStart(), elem.first);
         ASSERT_EQ(interval->getIntervalEnd(), elem.second);
@@ -50,10 +52,10 @@ TEST(LIVENESS_TEST, TEST1)
     */
     auto graph = std::make_shared<Graph>("liveness_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -61,25 +63,25 @@ TEST(LIVENESS_TEST, TEST1)
     graph->insertBB(bb4);
     graph->addEdge(bb2, bb4);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
 
-    auto* v2 = new BinaryInst{2, InstType::Cmp, v0, v1};
-    auto* v3 = new JumpInst{3, InstType::Ja, bb4};
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Cmp, v0, v1);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Ja, bb4);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
 
-    auto* v4 = new BinaryInst{4, InstType::Add, v1, v0};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb4};
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v1, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
     bb3->pushBackInst(v4);
     bb3->pushBackInst(v5);
 
-    auto* v6 = new PhiInst{6};
+    auto* v6 = graph->create<PhiInst>(6);
     v6->addInput(std::make_pair(v1, bb2));
     v6->addInput(std::make_pair(v4, bb3));
-    auto* v7 = new UnaryInst{7, InstType::Return, v6};
+    auto* v7 = graph->create<UnaryInst>(7, InstType::Return, v6);
     bb4->pushBackPhiInst(v6);
     bb4->pushBackInst(v7);
 
@@ -144,12 +146,12 @@ TEST(LIVENESS_TEST, TEST2)
     */
     auto graph = std::make_shared<Graph>("liveness_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -160,47 +162,47 @@ TEST(LIVENESS_TEST, TEST2)
     graph->addEdge(bb4, bb5);
     graph->addEdge(bb6, bb2);
 
-    auto* v0 = new ParamInst{0, DataType::i64, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v2 = new ConstInst{2, static_cast<uint64_t>(10)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(10));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v2);
 
-    auto* v3 = new PhiInst{3};
-    auto* v4 = new BinaryInst{4, InstType::Sub, v3, v2};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb3};
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Sub, v3, v2);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb3);
     bb2->pushBackPhiInst(v3);
     bb2->pushBackInst(v4);
     bb2->pushBackInst(v5);
 
-    auto* v6 = new BinaryInst{6, InstType::Add, v0, v1};
-    auto* v7 = new BinaryInst{7, InstType::Mul, v6, v1};
-    auto* v75 = new BinaryInst{75, InstType::Cmp, v7, v2};
-    auto* v8 = new JumpInst{8, InstType::Jae, bb5};
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Add, v0, v1);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Mul, v6, v1);
+    auto* v75 = graph->create<BinaryInst>(75, InstType::Cmp, v7, v2);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jae, bb5);
     bb3->pushBackInst(v6);
     bb3->pushBackInst(v7);
     bb3->pushBackInst(v75);
     bb3->pushBackInst(v8);
 
-    auto* v9 = new BinaryInst{9, InstType::Div, v7, v2};
-    auto* v95 = new BinaryInst{95, InstType::Cmp, v9, v1};
-    auto* v10 = new JumpInst{10, InstType::Jb, bb5};
+    auto* v9 = graph->create<BinaryInst>(9, InstType::Div, v7, v2);
+    auto* v95 = graph->create<BinaryInst>(95, InstType::Cmp, v9, v1);
+    auto* v10 = graph->create<JumpInst>(10, InstType::Jb, bb5);
     bb4->pushBackInst(v9);
     bb4->pushBackInst(v95);
     bb4->pushBackInst(v10);
 
-    auto* v11 = new PhiInst{11};
+    auto* v11 = graph->create<PhiInst>(11);
     v11->addInput(std::make_pair(v6, bb3));
     v11->addInput(std::make_pair(v9, bb4));
-    auto* v12 = new BinaryInst{12, InstType::Sub, v11, v0};
-    auto* v13 = new UnaryInst{13, InstType::Return, v12};
+    auto* v12 = graph->create<BinaryInst>(12, InstType::Sub, v11, v0);
+    auto* v13 = graph->create<UnaryInst>(13, InstType::Return, v12);
     bb5->pushBackPhiInst(v11);
     bb5->pushBackInst(v12);
     bb5->pushBackInst(v13);
 
-    auto* v14 = new BinaryInst{14, InstType::Sub, v9, v1};
-    auto* v15 = new JumpInst{15, InstType::Jmp, bb2};
+    auto* v14 = graph->create<BinaryInst>(14, InstType::Sub, v9, v1);
+    auto* v15 = graph->create<JumpInst>(15, InstType::Jmp, bb2);
     bb6->pushBackInst(v14);
     bb6->pushBackInst(v15);
 
@@ -225,6 +227,99 @@ TEST(LIVENESS_TEST, TEST2)
                                {11, {38, 40}},
                                {12, {40, 42}},
                                {13, {42, 44}},
-                               {14, {34, 36}},
+                               // phi input is live up to the end of the pred bb
+                               {14, {34, 38}},
                                {15, {0, 0}}});
+}
+
+/**
+ * Holes graph:
+ *             [1]
+ *            /   \
+ *           v     v
+ *          [2]   [3]
+ *           \     /
+ *            v   v
+ *             [4]
+ */
+TEST(LIVENESS_TEST, HOLES)
+{
+    auto graph = std::make_shared<Graph>("liveness_holes");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb4);
+    graph->addBB(bb3);
+    graph->addEdge(bb1, bb3);
+    graph->addEdge(bb3, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "a1");
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Cmp, v0, v1);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Ja, bb3);
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+    bb1->pushBackInst(v3);
+
+    // v0 is used only in bb2, v1 only in bb3
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v0, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
+    bb2->pushBackInst(v4);
+    bb2->pushBackInst(v5);
+
+    auto* v6 = graph->create<UnaryInst>(6, InstType::Neg, v1);
+    bb3->pushBackInst(v6);
+
+    auto* v7 = graph->create<PhiInst>(7);
+    v7->addInput(std::make_pair(v4, bb2));
+    v7->addInput(std::make_pair(v6, bb3));
+    auto* v8 = graph->create<UnaryInst>(8, InstType::Return, v7);
+    bb4->pushBackPhiInst(v7);
+    bb4->pushBackInst(v8);
+
+    graph->runPass<LivenessAnalysis>();
+    auto& intervals = graph->getLiveIntervals();
+    auto* live0 = intervals[v0];
+    auto* live1 = intervals[v1];
+    auto* live4 = intervals[v4];
+    auto* live6 = intervals[v6];
+
+    // the branch placed second in linear order makes a hole in its value interval
+    auto& linear_bbs = graph->getLinearOrderBBs();
+    ASSERT_EQ(linear_bbs.size(), 4);
+    auto* second = linear_bbs[1];
+    auto* third = linear_bbs[2];
+    ASSERT_TRUE(second == bb2 || second == bb3);
+    auto* holed = third == bb2 ? live0 : live1;
+    auto* solid = third == bb2 ? live1 : live0;
+    ASSERT_EQ(holed->getRanges().size(), 2);
+    ASSERT_EQ(solid->getRanges().size(), 1);
+
+    auto hole_start = second->getLiveInterval()->getIntervalStart();
+    auto hole_end = second->getLiveInterval()->getIntervalEnd();
+    ASSERT_FALSE(holed->covers(hole_start));
+    ASSERT_FALSE(holed->covers(hole_end - 1));
+    ASSERT_TRUE(holed->covers(hole_end + 1));
+    ASSERT_FALSE(holed->covers(holed->getIntervalEnd()));
+    ASSERT_TRUE(solid->covers(hole_start));
+
+    // both params are live at the compare, branch values never meet
+    ASSERT_TRUE(live0->intersects(live1));
+    ASSERT_EQ(live0->findIntersection(live1), v1->getLiveNum());
+    ASSERT_FALSE(live4->intersects(live6));
+    ASSERT_FALSE(holed->intersects(third == bb2 ? live6 : live4));
+
+    // uses by compare and add, both add inputs are one use position
+    ASSERT_EQ(live0->getUsePositions(),
+              (std::vector<size_t>{v2->getLiveNum(), v4->getLiveNum()}));
+    ASSERT_EQ(live0->getNextUse(v2->getLiveNum() + 1), v4->getLiveNum());
+    ASSERT_EQ(live0->getNextUse(v4->getLiveNum() + 1), INVALID_LIVE_POS);
+    // phi input is used at the end of the pred
+    ASSERT_EQ(live4->getUsePositions().back(), bb2->getLiveInterval()->getIntervalEnd());
 }
\ No newline at end of file
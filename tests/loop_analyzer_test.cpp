@@ -1,6 +1,8 @@
 #include "ir/graph.h"
+#include "pass/linear_order.h"
 #include "pass/loop_analysis.h"
 #include "gtest/gtest.h"
+#include <pthread.h>
 
 using namespace compiler;
 
@@ -38,12 +40,12 @@ TEST(LOOP_TEST, TEST1)
 {
     auto graph = std::make_shared<Graph>("loop_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -91,12 +93,12 @@ TEST(LOOP_TEST, TEST2)
 {
     auto graph = std::make_shared<Graph>("loop_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -152,15 +154,15 @@ TEST(LOOP_TEST, TEST3)
 {
     auto graph = std::make_shared<Graph>("loop_test3");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -220,13 +222,13 @@ TEST(LOOP_TEST, TEST4)
 {
     auto graph = std::make_shared<Graph>("loop_test4");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -280,17 +282,17 @@ TEST(LOOP_TEST, TEST5)
 {
     auto graph = std::make_shared<Graph>("loop_test5");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
-    auto* bb10 = new BasicBlock{10, graph};
-    auto* bb11 = new BasicBlock{11, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
+    auto* bb10 = graph->createBB(10);
+    auto* bb11 = graph->createBB(11);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -367,15 +369,15 @@ TEST(LOOP_TEST, TEST6)
 {
     auto graph = std::make_shared<Graph>("loop_test6");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -417,4 +419,48 @@ TEST(LOOP_TEST, TEST6)
     ASSERT_EQ(loop_7_3->getHeader()->getId(), 3);
     ASSERT_EQ(loop_7_3->getLatches()[0]->getId(), 7);
     checkLoopBlocks(loop_7_3, {3, 7});
+}
+
+/**
+ * Stress graph: chain of 1M blocks with a back edge from the last block to the second one.
+ *    [0] -> [1] -> [2] -> ... -> [N-1]
+ *            ^                     |
+ *            \---------------------/
+ * Traversals are run on a thread with a small stack, like compiler threads have.
+ */
+TEST(LOOP_TEST, CHAIN_1M)
+{
+    constexpr size_t BB_NUM = 1'000'000;
+    constexpr size_t THREAD_STACK_SIZE = 256 * 1024;
+
+    auto graph = std::make_shared<Graph>("loop_chain_1m");
+    for (size_t i = 0; i < BB_NUM; ++i)
+        graph->insertBB(graph->createBB(i));
+    graph->addEdge(graph->getLastBB(), graph->getBB(1));
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+    pthread_t thread;
+    auto run = [](void* arg) -> void* {
+        static_cast<Graph*>(arg)->runPass<LinearOrder>();
+        return nullptr;
+    };
+    ASSERT_EQ(pthread_create(&thread, &attr, run, graph.get()), 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    auto& rpo = graph->getRpoBBs();
+    ASSERT_EQ(rpo.size(), BB_NUM);
+    for (size_t i = 0; i < BB_NUM; ++i)
+        ASSERT_EQ(rpo[i]->getId(), i);
+    ASSERT_EQ(graph->getLinearOrderBBs().size(), BB_NUM);
+    ASSERT_EQ(graph->getLastBB()->getIdom(), graph->getBB(BB_NUM - 2));
+
+    auto* root = graph->getRootLoop();
+    checkLoopBlocks(root, {0});
+    ASSERT_EQ(root->getInnerLoops().size(), 1);
+    auto* loop = root->getInnerLoops()[0];
+    ASSERT_EQ(loop->getHeader(), graph->getBB(1));
+    ASSERT_EQ(loop->getBody().size(), BB_NUM - 1);
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "ir/graph.h"
+#include "pass/dce.h"
+#include "pass/domtree.h"
+#include "pass/linear_order.h"
+#include "pass/liveness.h"
+#include "pass/loop_analysis.h"
+#include "pass/rpo.h"
+#include "gtest/gtest.h"
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+using namespace compiler;
+
+/**
+ * Test graph:
+ *                 [1]
+ *                  |
+ *                  v
+ *             /---[2]---\
+ *             |         |
+ *             v         v
+ *            [3]------>[4]
+ */
+TEST(PASS_MANAGER_TEST, ANALYSES_CACHE)
+{
+    auto graph = std::make_shared<Graph>("pass_manager_test");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->insertBB(bb4);
+    graph->addEdge(bb2, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<BinaryInst>(1, InstType::Add, v0, v0);
+    auto* v2 = graph->create<UnaryInst>(2, InstType::Return, v0);
+    bb1->pushBackInst(v0);
+    bb3->pushBackInst(v1);
+    bb4->pushBackInst(v2);
+
+    // the whole chain of analyses is run once and cached
+    ASSERT_TRUE(graph->runPass<LivenessAnalysis>());
+    ASSERT_TRUE(graph->isAnalysisValid<Rpo>());
+    ASSERT_TRUE(graph->isAnalysisValid<DomTree>());
+    ASSERT_TRUE(graph->isAnalysisValid<LoopAnalysis>());
+    ASSERT_TRUE(graph->isAnalysisValid<LinearOrder>());
+    ASSERT_TRUE(graph->isAnalysisValid<LivenessAnalysis>());
+
+    auto* domtree = graph->getAnalysis<DomTree>();
+    ASSERT_NE(domtree, nullptr);
+    ASSERT_EQ(graph->getAnalysis<DomTree>(), domtree);
+    auto* live_int = graph->getLiveIntervals()[v0];
+    ASSERT_NE(live_int, nullptr);
+    ASSERT_TRUE(graph->runPass<LivenessAnalysis>());
+    ASSERT_EQ(graph->getLiveIntervals()[v0], live_int);
+
+    // DCE preserves CFG analyses only
+    ASSERT_TRUE(graph->runPass<Dce>());
+    ASSERT_EQ(bb3->size(), 0);
+    ASSERT_TRUE(graph->isAnalysisValid<DomTree>());
+    ASSERT_TRUE(graph->isAnalysisValid<LinearOrder>());
+    ASSERT_FALSE(graph->isAnalysisValid<LivenessAnalysis>());
+    ASSERT_TRUE(graph->runPass<LivenessAnalysis>());
+    ASSERT_NE(graph->getLiveIntervals()[v0], live_int);
+
+    // CFG change makes all analyses stale
+    graph->addEdge(bb1, bb4);
+    ASSERT_FALSE(graph->isAnalysisValid<Rpo>());
+    ASSERT_FALSE(graph->isAnalysisValid<DomTree>());
+    ASSERT_FALSE(graph->isAnalysisValid<LivenessAnalysis>());
+    ASSERT_EQ(graph->getAnalysis<DomTree>(), domtree);
+    ASSERT_EQ(bb4->getIdom(), bb1);
+    ASSERT_TRUE(graph->isAnalysisValid<DomTree>());
+
+    graph->invalidateAnalysis<DomTree>();
+    ASSERT_FALSE(graph->isAnalysisValid<DomTree>());
+    ASSERT_EQ(bb4->getIdom(), nullptr);
+}
+
+TEST(PASS_MANAGER_TEST, STATS)
+{
+    ThreadPassStats::get().reset();
+    ThreadPassStats::setEnabled(true);
+    auto graph = std::make_shared<Graph>("pass_stats_test");
+    ThreadPassStats::setEnabled(false);
+    ASSERT_EQ(std::make_shared<Graph>("no_stats")->getPassStats(), nullptr);
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addEdge(bb1, bb3);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<BinaryInst>(1, InstType::Add, v0, v0);
+    bb1->pushBackInst(v0);
+    bb2->pushBackInst(v1);
+    bb3->pushBackInst(graph->create<UnaryInst>(2, InstType::Return, v0));
+
+    ASSERT_TRUE(graph->runPass<LoopAnalysis>());
+    ASSERT_TRUE(graph->runPass<LoopAnalysis>());
+    ASSERT_TRUE(graph->runPass<Dce>());
+
+    // LoopAnalysis requests Rpo and DomTree, DomTree requests the cached Rpo
+    auto* stats = graph->getPassStats();
+    ASSERT_NE(stats, nullptr);
+    auto& records = stats->getRecords();
+    ASSERT_EQ(records.size(), 6U);
+    ASSERT_EQ(records[0].name, "LoopAnalysis");
+    ASSERT_EQ(records[0].parent, INVALID_PASS_RECORD);
+    ASSERT_FALSE(records[0].is_cached);
+    ASSERT_EQ(records[1].name, "RPO");
+    ASSERT_EQ(records[1].parent, 0U);
+    ASSERT_EQ(records[2].parent, 0U);
+    ASSERT_EQ(records[3].parent, 2U);
+    ASSERT_TRUE(records[3].is_cached);
+    ASSERT_GE(records[0].time_ns, records[0].nested_time_ns);
+    ASSERT_EQ(records[0].nested_time_ns, records[1].time_ns + records[2].time_ns);
+    ASSERT_GT(records[0].allocs_num, 0U);
+
+    ASSERT_TRUE(records[4].is_cached);
+    ASSERT_EQ(records[4].parent, INVALID_PASS_RECORD);
+    ASSERT_EQ(records[5].name, "Dce");
+    ASSERT_FALSE(records[5].is_analysis);
+    ASSERT_EQ(records[5].bbs_before, 3U);
+    ASSERT_EQ(records[5].insts_before, 3U);
+    ASSERT_EQ(records[5].insts_after, 2U);
+
+    std::ostringstream report;
+    stats->dumpJson(report);
+    ASSERT_EQ(report.str().find("{\"graph\": \"pass_stats_test\", \"passes\": "
+                                "[{\"name\": \"LoopAnalysis\""),
+              0U);
+    ASSERT_NE(report.str().find("\"nested\": [{\"name\": \"RPO\""), std::string::npos);
+
+    auto& thread_stats = ThreadPassStats::get();
+    ASSERT_EQ(thread_stats.getGraphsNum(), 1U);
+    auto& loops = thread_stats.getTotals().at("LoopAnalysis");
+    ASSERT_EQ(loops.runs_num, 2U);
+    ASSERT_EQ(loops.cached_num, 1U);
+    ASSERT_EQ(thread_stats.getTotals().at("RPO").runs_num, 2U);
+    std::ostringstream thread_report;
+    thread_stats.dumpJson(thread_report);
+    ASSERT_NE(thread_report.str().find("\"graphs\": 1"), std::string::npos);
+    thread_stats.reset();
+}
+
+/**
+ * Graph with the chain of analyses: [1] -> [2] -> [3], [1] -> [3]
+ */
+static std::shared_ptr<Graph> buildTraceGraph(const std::string& name)
+{
+    auto graph = std::make_shared<Graph>(name);
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addEdge(bb1, bb3);
+    return graph;
+}
+
+TEST(PASS_MANAGER_TEST, TRACE)
+{
+    auto path = testing::TempDir() + "pass_manager_trace.json";
+    ASSERT_TRUE(Tracer::start(path));
+    ASSERT_FALSE(Tracer::start(path));
+    ASSERT_TRUE(buildTraceGraph("main_graph")->runPass<LoopAnalysis>());
+    std::thread([]() { ASSERT_TRUE(buildTraceGraph("thread_graph")->runPass<DomTree>()); })
+        .join();
+    Tracer::flush();
+
+    // spans of a thread between flushes are limited by its buffer
+    auto graph = buildTraceGraph("overflow_graph");
+    auto dropped = Tracer::getDroppedNum();
+    for (size_t i = 0; i <= TRACE_BUFFER_SIZE; ++i)
+    {
+        graph->invalidateAnalysis<Rpo>();
+        ASSERT_TRUE(graph->runPass<Rpo>());
+    }
+    ASSERT_EQ(Tracer::getDroppedNum(), dropped + 1);
+    Tracer::stop();
+    ASSERT_FALSE(Tracer::isEnabled());
+    // no spans after the stop
+    graph = nullptr;
+
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    ASSERT_EQ(line, "[");
+    struct Span
+    {
+        std::string name;
+        double begin;
+        double end;
+        std::string tid;
+    };
+    std::vector<Span> spans;
+    size_t tracks_num = 0;
+    std::regex span_regex(
+        R"re(\{"name": "(\w+)", "cat": "\w+", "ph": "X", "ts": ([\d.]+), "dur": ([\d.]+), )re"
+        R"re("pid": \d+, "tid": (\d+)\},?)re");
+    while (std::getline(file, line) && line != "]")
+    {
+        std::smatch match;
+        if (std::regex_match(line, match, span_regex))
+            spans.push_back({match[1], std::stod(match[2]),
+                             std::stod(match[2]) + std::stod(match[3]), match[4]});
+        else
+        {
+            ASSERT_NE(line.find("\"thread_name\""), std::string::npos) << line;
+            ++tracks_num;
+        }
+    }
+    ASSERT_EQ(line, "]");
+    ASSERT_GE(tracks_num, 2U);
+    // main: LoopAnalysis, RPO, DomTree, graph; thread: DomTree, RPO, graph; then full buffer
+    ASSERT_EQ(spans.size(), 7 + TRACE_BUFFER_SIZE);
+
+    auto find_span = [&spans](const std::string& name, const std::string& tid) {
+        return *std::find_if(spans.begin(), spans.end(), [&](const Span& span) {
+            return span.name == name && (tid.empty() || span.tid == tid);
+        });
+    };
+    auto loops = find_span("LoopAnalysis", "");
+    auto main_graph = find_span("main_graph", loops.tid);
+    auto main_domtree = find_span("DomTree", loops.tid);
+    ASSERT_LE(main_graph.begin, loops.begin);
+    ASSERT_GE(main_graph.end, loops.end);
+    ASSERT_LE(loops.begin, main_domtree.begin);
+    ASSERT_GE(loops.end, main_domtree.end);
+    ASSERT_NE(find_span("thread_graph", "").tid, loops.tid);
+}
+
+TEST(PASS_MANAGER_TEST, TRACE_THREADS_CHURN)
+{
+    constexpr size_t THREADS_NUM = 4;
+    constexpr size_t ROUNDS_NUM = 16;
+    auto path = testing::TempDir() + "pass_manager_trace_churn.json";
+    ASSERT_TRUE(Tracer::start(path));
+    auto buffers_num = Tracer::getBuffersNum();
+
+    // buffers of joined threads are reused by the next ones
+    for (size_t round = 0; round < ROUNDS_NUM; ++round)
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < THREADS_NUM; ++i)
+            threads.emplace_back([]() { ASSERT_TRUE(buildTraceGraph("churn")->runPass<Rpo>()); });
+        for (auto& thread : threads)
+            thread.join();
+        ASSERT_LE(Tracer::getBuffersNum(), buffers_num + THREADS_NUM);
+    }
+    Tracer::stop();
+
+    // spans of exited threads are flushed before their buffers are reused
+    std::ifstream file(path);
+    std::string line;
+    size_t rpo_spans_num = 0;
+    while (std::getline(file, line))
+        if (line.find("\"name\": \"RPO\"") != std::string::npos)
+            ++rpo_spans_num;
+    ASSERT_EQ(rpo_spans_num, THREADS_NUM * ROUNDS_NUM);
+}
\ No newline at end of file
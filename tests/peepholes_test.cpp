@@ -38,11 +38,11 @@ TEST(PEEPHOLES_TEST, TEST_MUL)
     */
     auto graph = std::make_shared<Graph>("peepholes_test_mul");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -50,40 +50,40 @@ TEST(PEEPHOLES_TEST, TEST_MUL)
     graph->insertBB(bb4);
     graph->insertBB(bb5);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v100 = new ConstInst{100, static_cast<uint64_t>(1)};
-    auto* v200 = new ConstInst{200, static_cast<uint64_t>(-1)};
-    auto* v300 = new ConstInst{300, static_cast<uint64_t>(64)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v100 = graph->create<ConstInst>(100, static_cast<uint64_t>(1));
+    auto* v200 = graph->create<ConstInst>(200, static_cast<uint64_t>(-1));
+    auto* v300 = graph->create<ConstInst>(300, static_cast<uint64_t>(64));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v100);
     bb1->pushBackInst(v200);
     bb1->pushBackInst(v300);
 
-    auto* v15 = new BinaryInst{15, InstType::Mul, v0, v1};
-    auto* v2 = new BinaryInst{2, InstType::Sub, v0, v15};
-    auto* v3 = new JumpInst{3, InstType::Jmp, bb3};
+    auto* v15 = graph->create<BinaryInst>(15, InstType::Mul, v0, v1);
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Sub, v0, v15);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Jmp, bb3);
     bb2->pushBackInst(v15);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
 
-    auto* v35 = new BinaryInst{35, InstType::Mul, v2, v100};
-    auto* v4 = new BinaryInst{4, InstType::Add, v35, v0};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb4};
+    auto* v35 = graph->create<BinaryInst>(35, InstType::Mul, v2, v100);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v35, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
     bb3->pushBackInst(v35);
     bb3->pushBackInst(v4);
     bb3->pushBackInst(v5);
 
-    auto* v6 = new BinaryInst{6, InstType::Mul, v4, v200};
-    auto* v7 = new BinaryInst{7, InstType::Div, v35, v0};
-    auto* v8 = new JumpInst{8, InstType::Jmp, bb5};
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Mul, v4, v200);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Div, v35, v0);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jmp, bb5);
     bb4->pushBackInst(v6);
     bb4->pushBackInst(v7);
     bb4->pushBackInst(v8);
 
-    auto* v9 = new BinaryInst{35, InstType::Mul, v6, v300};
-    auto* v10 = new UnaryInst{13, InstType::Return, v9};
+    auto* v9 = graph->create<BinaryInst>(35, InstType::Mul, v6, v300);
+    auto* v10 = graph->create<UnaryInst>(13, InstType::Return, v9);
     bb5->pushBackInst(v9);
     bb5->pushBackInst(v10);
 
@@ -131,11 +131,11 @@ TEST(PEEPHOLES_TEST, TEST_OR)
     */
     auto graph = std::make_shared<Graph>("peepholes_test_or");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -143,38 +143,38 @@ TEST(PEEPHOLES_TEST, TEST_OR)
     graph->insertBB(bb4);
     graph->insertBB(bb5);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v100 = new ConstInst{100, std::numeric_limits<uint64_t>::max()};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v100 = graph->create<ConstInst>(100, std::numeric_limits<uint64_t>::max());
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v100);
 
-    auto* v15 = new BinaryInst{15, InstType::Or, v0, v0};
-    auto* v2 = new BinaryInst{2, InstType::Sub, v0, v15};
-    auto* v3 = new JumpInst{3, InstType::Jmp, bb3};
+    auto* v15 = graph->create<BinaryInst>(15, InstType::Or, v0, v0);
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Sub, v0, v15);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Jmp, bb3);
     bb2->pushBackInst(v15);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
 
-    auto* v35 = new BinaryInst{35, InstType::Or, v2, v1};
-    auto* v4 = new BinaryInst{4, InstType::Add, v35, v0};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb4};
+    auto* v35 = graph->create<BinaryInst>(35, InstType::Or, v2, v1);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v35, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
     bb3->pushBackInst(v35);
     bb3->pushBackInst(v4);
     bb3->pushBackInst(v5);
 
-    auto* v6 = new BinaryInst{6, InstType::Or, v4, v100};
-    auto* v7 = new BinaryInst{7, InstType::Div, v6, v0};
-    auto* v8 = new JumpInst{8, InstType::Jmp, bb5};
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Or, v4, v100);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Div, v6, v0);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jmp, bb5);
     bb4->pushBackInst(v6);
     bb4->pushBackInst(v7);
     bb4->pushBackInst(v8);
 
-    auto* v9 = new UnaryInst{9, InstType::Not, v4};
-    auto* v10 = new UnaryInst{10, InstType::Not, v7};
-    auto* v11 = new BinaryInst{11, InstType::Or, v9, v10};
-    auto* v12 = new UnaryInst{12, InstType::Return, v11};
+    auto* v9 = graph->create<UnaryInst>(9, InstType::Not, v4);
+    auto* v10 = graph->create<UnaryInst>(10, InstType::Not, v7);
+    auto* v11 = graph->create<BinaryInst>(11, InstType::Or, v9, v10);
+    auto* v12 = graph->create<UnaryInst>(12, InstType::Return, v11);
     bb5->pushBackInst(v9);
     bb5->pushBackInst(v10);
     bb5->pushBackInst(v11);
@@ -208,22 +208,22 @@ TEST(PEEPHOLES_TEST, TEST_ASHR)
     */
     auto graph = std::make_shared<Graph>("peepholes_test_ashr");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v100 = new ConstInst{100, static_cast<uint64_t>(2)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v100 = graph->create<ConstInst>(100, static_cast<uint64_t>(2));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v100);
 
-    auto* v15 = new BinaryInst{15, InstType::AShr, v0, v1};
-    auto* v2 = new BinaryInst{2, InstType::Sub, v0, v15};
-    auto* v3 = new UnaryInst{6, InstType::Return, v2};
+    auto* v15 = graph->create<BinaryInst>(15, InstType::AShr, v0, v1);
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Sub, v0, v15);
+    auto* v3 = graph->create<UnaryInst>(6, InstType::Return, v2);
     bb2->pushBackInst(v15);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
@@ -1,21 +1,166 @@
+#include "bench/cfg_generator.h"
 #include "ir/graph.h"
+#include "pass/parallel_move.h"
 #include "pass/reg_alloc.h"
 #include "gtest/gtest.h"
+#include <map>
+#include <random>
 
 using namespace compiler;
 
+static const Target TWO_REGS_TARGET("two_regs", {{"r0", "r1"}, 0, "r2"}, {{"f0", "f1"}, 0, "f2"});
+
+// locations of the split parts of a value in the order of their starts:
+// 'r' register, 's' stack slot, 'm' rematerialized
+using parts_locations_t = std::vector<std::pair<char, uint32_t>>;
+
+char getLocationChar(LiveInterval* interval)
+{
+    if (interval->isRealRegister())
+        return 'r';
+    return interval->isStackSlot() ? 's' : 'm';
+}
+
 void checkRegisters(std::shared_ptr<Graph> g,
-                    std::unordered_map<uint32_t, std::pair<char, uint32_t>> expected)
+                    std::unordered_map<uint32_t, parts_locations_t> expected)
 {
     auto& live_intervals = g->getLiveIntervals();
-    for (auto [inst, interval] : live_intervals)
+    for (auto* interval : live_intervals)
     {
-        if (inst->isJumpInst())
+        if (interval == nullptr)
             continue;
-        uint32_t id = inst->getId();
-        auto elem = expected[id];
-        ASSERT_EQ(interval->isRealRegister() ? 'r' : 's', elem.first);
-        ASSERT_EQ(interval->getLocation(), elem.second);
+        parts_locations_t parts;
+        for (auto* part : interval->getSplitChildren())
+            parts.emplace_back(getLocationChar(part), part->getLocation());
+        parts.emplace(parts.begin(), getLocationChar(interval), interval->getLocation());
+        ASSERT_EQ(parts, expected[interval->getInst()->getId()]);
+    }
+}
+
+/**
+ * Parts in the same register or stack slot never intersect, every use is in a register
+ */
+void checkAllocation(std::shared_ptr<Graph> g)
+{
+    std::vector<LiveInterval*> parts;
+    for (auto* interval : g->getLiveIntervals())
+    {
+        if (interval == nullptr)
+            continue;
+        parts.push_back(interval);
+        for (auto* child : interval->getSplitChildren())
+            parts.push_back(child);
+    }
+
+    for (auto* part : parts)
+    {
+        ASSERT_TRUE(part->hasLocation());
+        ASSERT_TRUE(part->getUsePositions().empty() || part->isRealRegister());
+        for (auto use : part->getUsePositions())
+            ASSERT_EQ(part->getSplitChild(use), part);
+        ASSERT_FALSE(part->isRematerialized() && !part->getInst()->isConstInst());
+        if (part->isStackSlot())
+        {
+            auto& slot = g->getStackSlots()[part->getLocation()];
+            ASSERT_EQ(slot.size, getDataTypeSize(part->getInst()->getType()));
+            ASSERT_EQ(slot.offset % slot.size, 0);
+            ASSERT_LE(slot.offset + slot.size, g->getFrameSize());
+        }
+
+        auto reg_class = Target::getRegClass(part->getInst()->getType());
+        for (auto* other : parts)
+        {
+            if (other == part || other->getLocationType() != part->getLocationType() ||
+                other->getLocation() != part->getLocation() || part->isRematerialized())
+                continue;
+            // registers are per class, a slot is shared by spilled parts of one value
+            bool shared = part->isRealRegister()
+                              ? Target::getRegClass(other->getInst()->getType()) == reg_class
+                              : other->getInst() != part->getInst();
+            ASSERT_FALSE(shared && part->intersects(other));
+        }
+    }
+}
+
+// registers of different classes with the same number are different locations
+using location_key_t = std::tuple<LocationType, RegClass, size_t>;
+using locations_state_t = std::map<location_key_t, Inst*>;
+
+location_key_t getLocationKey(Location loc, Inst* value)
+{
+    auto reg_class = loc.isRegister() ? Target::getRegClass(value->getType()) : RegClass::End;
+    return {loc.type, reg_class, loc.index};
+}
+
+void execMove(MovInst* mov, locations_state_t& state)
+{
+    auto* value = mov->getInput(0);
+    auto dst = getLocationKey(mov->getDst(), value);
+    if (mov->getSrc().type == LocationType::Remat)
+        state[dst] = value;
+    else if (mov->isSwap())
+        std::swap(state[getLocationKey(mov->getSrc(), value)], state[dst]);
+    else
+        state[dst] = state[getLocationKey(mov->getSrc(), value)];
+}
+
+/**
+ * Execute a random path over locations contents: moves copy them, insts write their results
+ * to their locations and have to find every input in the location of its part at the use.
+ * Phis take their inputs on the taken edge, the inputs are already moved to phis locations
+ */
+void checkResolution(std::shared_ptr<Graph> g, uint32_t seed, size_t steps = 200)
+{
+    auto& live_intervals = g->getLiveIntervals();
+    locations_state_t state;
+    std::unordered_map<Inst*, Inst*> phi_values;
+    auto get_value = [&phi_values](Inst* inst) {
+        auto it = phi_values.find(inst);
+        return it != phi_values.end() ? it->second : inst;
+    };
+
+    std::mt19937 gen(seed);
+    BasicBlock* pred = nullptr;
+    auto* bb = g->getFirstBB();
+    for (size_t step = 0; step < steps && bb != nullptr; ++step)
+    {
+        std::unordered_map<Inst*, Inst*> new_values;
+        for (auto* phi = bb->getFirstPhi(); phi != nullptr; phi = phi->getNext())
+        {
+            auto* phi_inst = static_cast<PhiInst*>(phi);
+            for (size_t i = 0; i < phi_inst->getInputsNum(); ++i)
+                if (phi_inst->getInputBB(i) == pred)
+                    new_values[phi] = get_value(phi_inst->getInput(i));
+        }
+        for (auto [phi, value] : new_values)
+            phi_values[phi] = value;
+
+        for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        {
+            // moves of the resolution have no live numbers, moves of the graph are values
+            if (inst->getInstType() == InstType::Mov && inst->getLiveNum() == 0)
+            {
+                execMove(static_cast<MovInst*>(inst), state);
+                continue;
+            }
+            auto pos = inst->getLiveNum();
+            for (size_t i = 0; i < inst->getInputsNum(); ++i)
+            {
+                auto* input = inst->getInput(i);
+                // a use stays in the part before a split at the use position
+                auto* part = live_intervals[input]->getSplitChild(pos - 1);
+                ASSERT_TRUE(part->isRealRegister());
+                ASSERT_EQ(state[getLocationKey(part->toLocation(), input)], get_value(input));
+            }
+            auto* live_int = live_intervals[inst];
+            if (live_int != nullptr && !live_int->isRematerialized())
+                state[getLocationKey(live_int->toLocation(), inst)] = inst;
+        }
+
+        pred = bb;
+        auto* true_succ = bb->getTrueSucc();
+        auto* false_succ = bb->getFalseSucc();
+        bb = false_succ != nullptr && gen() % 2 == 0 ? false_succ : true_succ;
     }
 }
 
@@ -52,10 +197,10 @@ TEST(REGALLOC_TEST, TEST1)
     */
     auto graph = std::make_shared<Graph>("regalloc_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -63,36 +208,43 @@ TEST(REGALLOC_TEST, TEST1)
     graph->insertBB(bb4);
     graph->addEdge(bb2, bb4);
 
-    auto* v0 = new ParamInst{0, DataType::i32, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
 
-    auto* v2 = new BinaryInst{2, InstType::Cmp, v0, v1};
-    auto* v3 = new JumpInst{3, InstType::Ja, bb4};
+    auto* v2 = graph->create<BinaryInst>(2, InstType::Cmp, v0, v1);
+    auto* v3 = graph->create<JumpInst>(3, InstType::Ja, bb4);
     bb2->pushBackInst(v2);
     bb2->pushBackInst(v3);
 
-    auto* v4 = new BinaryInst{4, InstType::Add, v1, v0};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb4};
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v1, v0);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb4);
     bb3->pushBackInst(v4);
     bb3->pushBackInst(v5);
 
-    auto* v6 = new PhiInst{6};
+    auto* v6 = graph->create<PhiInst>(6);
     v6->addInput(std::make_pair(v1, bb2));
     v6->addInput(std::make_pair(v4, bb3));
-    auto* v7 = new UnaryInst{7, InstType::Return, v6};
+    auto* v7 = graph->create<UnaryInst>(7, InstType::Return, v6);
     bb4->pushBackPhiInst(v6);
     bb4->pushBackInst(v7);
 
+    graph->setTarget(&TWO_REGS_TARGET);
     graph->runPass<RegisterAllocation>();
+    checkAllocation(graph);
+    for (uint32_t seed : {1, 2, 3, 4})
+        checkResolution(graph, seed);
     // clang-format off
-    checkRegisters(graph, {{0, {'s', 0}},
-                           {1, {'r', 1}},
-                           {2, {'r', 0}},
-                           {4, {'r', 0}},
-                           {6, {'r', 0}},
-                           {7, {'r', 0}}});
+    checkRegisters(graph, {{0, {{'r', 0}}},
+                           // constant gets a register right before its first use
+                           {1, {{'m', INVALID_REG}, {'r', 1}}},
+                           // unused value is spilled as soon as both registers are busy
+                           {2, {{'s', 0}}},
+                           {4, {{'r', 0}}},
+                           // phi is hinted to the register of its input from bb2
+                           {6, {{'r', 1}}},
+                           {7, {{'r', 0}}}});
     /* {{0, {2, 14}},
         {1, {4, 14}},
         {2, {8, 10}},
@@ -154,12 +306,12 @@ TEST(REGALLOC_TEST, TEST2)
     */
     auto graph = std::make_shared<Graph>("regalloc_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -170,47 +322,47 @@ TEST(REGALLOC_TEST, TEST2)
     graph->addEdge(bb4, bb5);
     graph->addEdge(bb6, bb2);
 
-    auto* v0 = new ParamInst{0, DataType::i64, "a0"};
-    auto* v1 = new ConstInst{1, static_cast<uint64_t>(0)};
-    auto* v2 = new ConstInst{2, static_cast<uint64_t>(10)};
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(10));
     bb1->pushBackInst(v0);
     bb1->pushBackInst(v1);
     bb1->pushBackInst(v2);
 
-    auto* v3 = new PhiInst{3};
-    auto* v4 = new BinaryInst{4, InstType::Sub, v3, v2};
-    auto* v5 = new JumpInst{5, InstType::Jmp, bb3};
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Sub, v3, v2);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jmp, bb3);
     bb2->pushBackPhiInst(v3);
     bb2->pushBackInst(v4);
     bb2->pushBackInst(v5);
 
-    auto* v6 = new BinaryInst{6, InstType::Add, v0, v1};
-    auto* v7 = new BinaryInst{7, InstType::Mul, v6, v1};
-    auto* v75 = new BinaryInst{75, InstType::Cmp, v7, v2};
-    auto* v8 = new JumpInst{8, InstType::Jae, bb5};
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Add, v0, v1);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Mul, v6, v1);
+    auto* v75 = graph->create<BinaryInst>(75, InstType::Cmp, v7, v2);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jae, bb5);
     bb3->pushBackInst(v6);
     bb3->pushBackInst(v7);
     bb3->pushBackInst(v75);
     bb3->pushBackInst(v8);
 
-    auto* v9 = new BinaryInst{9, InstType::Div, v7, v2};
-    auto* v95 = new BinaryInst{95, InstType::Cmp, v9, v1};
-    auto* v10 = new JumpInst{10, InstType::Jb, bb5};
+    auto* v9 = graph->create<BinaryInst>(9, InstType::Div, v7, v2);
+    auto* v95 = graph->create<BinaryInst>(95, InstType::Cmp, v9, v1);
+    auto* v10 = graph->create<JumpInst>(10, InstType::Jb, bb5);
     bb4->pushBackInst(v9);
     bb4->pushBackInst(v95);
     bb4->pushBackInst(v10);
 
-    auto* v11 = new PhiInst{11};
+    auto* v11 = graph->create<PhiInst>(11);
     v11->addInput(std::make_pair(v6, bb3));
     v11->addInput(std::make_pair(v9, bb4));
-    auto* v12 = new BinaryInst{12, InstType::Sub, v11, v0};
-    auto* v13 = new UnaryInst{13, InstType::Return, v12};
+    auto* v12 = graph->create<BinaryInst>(12, InstType::Sub, v11, v0);
+    auto* v13 = graph->create<UnaryInst>(13, InstType::Return, v12);
     bb5->pushBackPhiInst(v11);
     bb5->pushBackInst(v12);
     bb5->pushBackInst(v13);
 
-    auto* v14 = new BinaryInst{14, InstType::Sub, v9, v1};
-    auto* v15 = new JumpInst{15, InstType::Jmp, bb2};
+    auto* v14 = graph->create<BinaryInst>(14, InstType::Sub, v9, v1);
+    auto* v15 = graph->create<JumpInst>(15, InstType::Jmp, bb2);
     bb6->pushBackInst(v14);
     bb6->pushBackInst(v15);
 
@@ -218,21 +370,41 @@ TEST(REGALLOC_TEST, TEST2)
     v3->addInput(std::make_pair(v14, bb6));
     // graph->dump();
 
+    graph->setTarget(&TWO_REGS_TARGET);
     graph->runPass<RegisterAllocation>();
-    checkRegisters(graph, {{0, {'s', 0}},
-                           {1, {'s', 1}},
-                           {2, {'r', 0}},
-                           {3, {'r', 1}},
-                           {4, {'r', 1}},
-                           {6, {'s', 3}},
-                           {7, {'s', 2}},
-                           {75, {'r', 1}},
-                           {9, {'s', 4}},
-                           {95, {'r', 1}},
-                           {11, {'r', 1}},
-                           {12, {'r', 1}},
-                           {13, {'r', 1}},
-                           {14, {'r', 1}}});
+    checkAllocation(graph);
+    for (uint32_t seed : {1, 2, 3, 4})
+        checkResolution(graph, seed);
+    // values live through the loop are spilled between uses and share one slot per value,
+    // constants are recreated before uses instead
+    constexpr auto REMAT = std::make_pair('m', INVALID_REG);
+    checkRegisters(graph, {{0, {{'r', 0}, {'s', 0}, {'r', 0}, {'s', 0}, {'r', 0}}},
+                           {1, {REMAT, {'r', 1}, REMAT, {'r', 1}, REMAT, {'r', 1}}},
+                           {2, {REMAT, {'r', 1}, REMAT, {'r', 1}, REMAT, {'r', 1}, REMAT}},
+                           {3, {{'r', 0}}},
+                           {4, {{'r', 0}}},
+                           {6, {{'s', 1}, {'r', 0}, {'s', 1}, {'r', 1}}},
+                           {7, {{'s', 2}, {'r', 0}}},
+                           {75, {{'s', 3}}},
+                           {9, {{'r', 0}}},
+                           // shares the slot with v6, which is in a register here
+                           {95, {{'s', 1}}},
+                           // phi takes the register of v6 from the edge bb3 -> bb5
+                           {11, {{'r', 1}}},
+                           {12, {{'r', 0}}},
+                           {13, {{'r', 0}}},
+                           {14, {{'r', 0}}}});
+    ASSERT_EQ(graph->getStackSlots().size(), 4);
+    ASSERT_EQ(graph->getFrameSize(), 32);
+    // spilling constants took 7 spills and 10 fills
+    auto stats = graph->getRegAllocStats();
+    ASSERT_EQ(stats.spills, 5);
+    ASSERT_EQ(stats.fills, 5);
+    ASSERT_EQ(stats.remats, 4);
+    // moves on the critical edge bb3 -> bb5 need a new block
+    ASSERT_EQ(graph->size(), 7);
+    ASSERT_EQ(stats.moves, 16);
+    ASSERT_EQ(stats.swaps, 0);
     /*{{0, {2, 40}},
        {1, {4, 38}},
        {2, {6, 38}},
@@ -252,4 +424,217 @@ TEST(REGALLOC_TEST, TEST2)
        {14, {34, 36}},
        {15, {0, 0}}});*/
     // more representative pictures in directory 'pictures'
+}
+
+TEST(REGALLOC_TEST, GENERATED)
+{
+    static const Target four_regs("four_regs", {{"r0", "r1", "r2", "r3"}, 0b1100, "r4"},
+                                  {{"f0"}, 0, "f1"});
+
+    for (uint32_t seed : {1, 2, 3})
+    {
+        size_t prev_spilled = INVALID_REG;
+        for (auto* target : {&TWO_REGS_TARGET, &four_regs, Target::getDefault()})
+        {
+            auto graph = bench::generateFunction(24, 6, 8, seed, 4);
+            graph->setTarget(target);
+            ASSERT_TRUE(graph->runPass<RegisterAllocation>());
+            checkAllocation(graph);
+            checkResolution(graph, seed);
+
+            // parts of a value share a spill slot, bigger register file spills less
+            size_t spilled = 0;
+            for (auto* interval : graph->getLiveIntervals())
+            {
+                if (interval == nullptr)
+                    continue;
+                auto parts = interval->getSplitChildren();
+                parts.push_back(interval);
+                size_t slot = INVALID_REG;
+                for (auto* part : parts)
+                {
+                    if (!part->isStackSlot())
+                        continue;
+                    ++spilled;
+                    if (slot == INVALID_REG)
+                        slot = part->getLocation();
+                    ASSERT_EQ(part->getLocation(), slot);
+                }
+            }
+            ASSERT_LT(spilled, prev_spilled);
+            prev_spilled = spilled;
+        }
+    }
+}
+
+TEST(REGALLOC_TEST, PARALLEL_MOVE)
+{
+    auto graph = std::make_shared<Graph>("parallel_move");
+    graph->setTarget(&TWO_REGS_TARGET);
+    auto* bb = graph->createBB(0);
+    graph->insertBB(bb);
+
+    std::vector<Inst*> v;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        v.push_back(graph->create<ParamInst>(i, DataType::i64));
+        bb->pushBackInst(v.back());
+    }
+    auto* seven = graph->findConstant(static_cast<uint64_t>(7));
+    auto reg = [](size_t num) { return Location{LocationType::Register, num}; };
+    auto slot = [](size_t num) { return Location{LocationType::StackSlot, num}; };
+
+    ParallelMove resolver(graph.get());
+    // registers cycle
+    resolver.addMove(v[0], reg(0), reg(1));
+    resolver.addMove(v[1], reg(1), reg(0));
+    // stack cycle
+    resolver.addMove(v[2], slot(0), slot(1));
+    resolver.addMove(v[3], slot(1), slot(2));
+    resolver.addMove(v[4], slot(2), slot(0));
+    // one value to two locations
+    resolver.addMove(v[5], slot(3), slot(4));
+    resolver.addMove(v[5], slot(3), slot(6));
+    resolver.addMove(seven, Location{LocationType::Remat}, slot(5));
+    // dropped
+    resolver.addMove(v[0], reg(0), reg(0));
+    resolver.addMove(seven, Location{LocationType::Remat}, Location{LocationType::Remat});
+    resolver.emit(bb, nullptr);
+    ASSERT_TRUE(resolver.isEmpty());
+    // stack cycle needs one more move through the scratch register
+    ASSERT_EQ(resolver.getMovesNum(), 7);
+    ASSERT_EQ(resolver.getSwapsNum(), 1);
+
+    locations_state_t state;
+    for (size_t i = 0; i < 2; ++i)
+        state[getLocationKey(reg(i), v[i])] = v[i];
+    for (size_t i = 0; i < 4; ++i)
+        state[getLocationKey(slot(i), v[i + 2])] = v[i + 2];
+    size_t scratch_uses = 0;
+    for (auto* inst = bb->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        if (inst->getInstType() == InstType::Mov)
+        {
+            auto* mov = static_cast<MovInst*>(inst);
+            scratch_uses += mov->getDst() == reg(TWO_REGS_TARGET.getScratchReg(RegClass::Int));
+            execMove(mov, state);
+        }
+    ASSERT_EQ(scratch_uses, 1);
+
+    locations_state_t expected{{getLocationKey(reg(0), v[1]), v[1]},
+                               {getLocationKey(reg(1), v[0]), v[0]},
+                               {getLocationKey(slot(0), v[4]), v[4]},
+                               {getLocationKey(slot(1), v[2]), v[2]},
+                               {getLocationKey(slot(2), v[3]), v[3]},
+                               {getLocationKey(slot(3), v[5]), v[5]},
+                               {getLocationKey(slot(4), v[5]), v[5]},
+                               {getLocationKey(slot(5), seven), seven},
+                               {getLocationKey(slot(6), v[5]), v[5]}};
+    // scratch content is not checked
+    state.erase(getLocationKey(reg(2), v[0]));
+    ASSERT_EQ(state, expected);
+}
+
+/**
+ * Hints graph:
+ *        [1]
+ *         |
+ *         v
+ *        [2]<-->[3]
+ *         |
+ *         v
+ *        [4]
+ */
+void checkHints(RegAllocKind kind)
+{
+    auto graph = std::make_shared<Graph>("regalloc_hints");
+    auto* target = Target::getDefault();
+    graph->setTarget(target);
+    graph->setRegAllocKind(kind);
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBBAfter(bb2, bb3, true);
+    graph->insertBBAfter(bb2, bb4, false);
+    graph->addEdge(bb3, bb2);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "a1");
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Cmp, v3, v1);
+    auto* v5 = graph->create<JumpInst>(5, InstType::Jae, bb4);
+    bb2->pushBackPhiInst(v3);
+    bb2->pushBackInst(v4);
+    bb2->pushBackInst(v5);
+
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Add, v3, v2);
+    auto* v7 = graph->create<JumpInst>(7, InstType::Jmp, bb2);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(v7);
+    v3->addInput(std::make_pair(v0, bb1));
+    v3->addInput(std::make_pair(v6, bb3));
+
+    auto arg0 = target->getArgReg(RegClass::Int, 0);
+    auto* v8 = graph->create<MovInst>(8, arg0, v3);
+    auto* v9 = graph->create<BinaryInst>(9, InstType::Sub, v8, v1);
+    auto* v10 = graph->create<UnaryInst>(10, InstType::Return, v9);
+    bb4->pushBackInst(v8);
+    bb4->pushBackInst(v9);
+    bb4->pushBackInst(v10);
+
+    ASSERT_TRUE(graph->runPass<RegisterAllocation>());
+    checkAllocation(graph);
+    checkResolution(graph, 1);
+
+    auto& live_intervals = graph->getLiveIntervals();
+    // arguments and the returned value are in the registers of the calling convention
+    ASSERT_EQ(live_intervals[v0]->getLocation(), arg0);
+    ASSERT_EQ(live_intervals[v1]->getLocation(), target->getArgReg(RegClass::Int, 1));
+    ASSERT_EQ(live_intervals[v9]->getLocation(), target->getRetReg(RegClass::Int));
+    // the phi and its inputs share the register, the only move of the linear scan recreates
+    // the constant, the coloring keeps it in a register
+    ASSERT_EQ(live_intervals[v3]->getLocation(), arg0);
+    ASSERT_EQ(live_intervals[v6]->getLocation(), arg0);
+    auto stats = graph->getRegAllocStats();
+    ASSERT_EQ(stats.moves, kind == RegAllocKind::LinearScan ? 1 : 0);
+    // the mov to the register of the phi is deleted
+    ASSERT_EQ(stats.removed_moves, 1);
+    ASSERT_EQ(live_intervals[v8], nullptr);
+    ASSERT_EQ(v9->getInput(0), v3);
+    ASSERT_EQ(bb4->getFirstInst(), v9);
+}
+
+TEST(REGALLOC_TEST, HINTS)
+{
+    checkHints(RegAllocKind::LinearScan);
+}
+
+TEST(REGALLOC_TEST, GRAPH_COLORING)
+{
+    static const Target four_regs("four_regs", {{"r0", "r1", "r2", "r3"}, 0b1100, "r4"},
+                                  {{"f0"}, 0, "f1"});
+
+    // phis and movs are coalesced
+    checkHints(RegAllocKind::GraphColoring);
+    for (uint32_t seed : {1, 2, 3})
+    {
+        for (auto* target : {&TWO_REGS_TARGET, &four_regs, Target::getDefault()})
+        {
+            auto graph = bench::generateFunction(24, 6, 8, seed, 4);
+            graph->setTarget(target);
+            graph->setRegAllocKind(RegAllocKind::GraphColoring);
+            ASSERT_TRUE(graph->runPass<RegisterAllocation>());
+            checkAllocation(graph);
+            checkResolution(graph, seed);
+            ASSERT_GT(graph->getRegAllocStats().spills, 0);
+        }
+    }
 }
\ No newline at end of file
@@ -24,12 +24,12 @@ TEST(RPO_TEST, TEST1)
 {
     auto graph = std::make_shared<Graph>("rpo_test1");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -71,12 +71,12 @@ TEST(RPO_TEST, TEST2)
 {
     auto graph = std::make_shared<Graph>("rpo_test2");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -127,15 +127,15 @@ TEST(RPO_TEST, TEST3)
 {
     auto graph = std::make_shared<Graph>("rpo_test3");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -185,13 +185,13 @@ TEST(RPO_TEST, TEST4)
 {
     auto graph = std::make_shared<Graph>("rpo_test4");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -247,17 +247,17 @@ TEST(RPO_TEST, TEST5)
 {
     auto graph = std::make_shared<Graph>("rpo_test5");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
-    auto* bb10 = new BasicBlock{10, graph};
-    auto* bb11 = new BasicBlock{11, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
+    auto* bb10 = graph->createBB(10);
+    auto* bb11 = graph->createBB(11);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
@@ -319,15 +319,15 @@ TEST(RPO_TEST, TEST6)
 {
     auto graph = std::make_shared<Graph>("rpo_test6");
 
-    auto* bb1 = new BasicBlock{1, graph};
-    auto* bb2 = new BasicBlock{2, graph};
-    auto* bb3 = new BasicBlock{3, graph};
-    auto* bb4 = new BasicBlock{4, graph};
-    auto* bb5 = new BasicBlock{5, graph};
-    auto* bb6 = new BasicBlock{6, graph};
-    auto* bb7 = new BasicBlock{7, graph};
-    auto* bb8 = new BasicBlock{8, graph};
-    auto* bb9 = new BasicBlock{9, graph};
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    auto* bb6 = graph->createBB(6);
+    auto* bb7 = graph->createBB(7);
+    auto* bb8 = graph->createBB(8);
+    auto* bb9 = graph->createBB(9);
 
     graph->insertBB(bb1);
     graph->insertBB(bb2);
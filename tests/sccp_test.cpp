@@ -0,0 +1,330 @@
+#include "ir/graph.h"
+#include "pass/sccp.h"
+#include "runtime/interpreter.h"
+#include "test_graphs.h"
+#include "gtest/gtest.h"
+
+using namespace compiler;
+
+/**
+ * Branches graph:
+ *                 [1]
+ *                  |
+ *                  v
+ *             /---[2]---\
+ *             |         |
+ *             v         v
+ *            [3]       [4]
+ *             |         |
+ *             \-->[5]<--/
+ */
+TEST(SCCP_TEST, BRANCHES)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/5]
+        v0. Param i64 a0
+        v1. Const i64 1
+        v2. Const i64 5
+
+    BB [2/5]
+        v3. Add   i64 v1, v1
+        v4. Cmp   i64 v3, v2
+        v5. Jb    bb4
+
+    BB [3/5]
+        v6. Mul   i64 v0, v0
+        v7. Jmp   bb5
+
+    BB [4/5]
+        v8. Sub   i64 v2, v1
+        v9. Jmp   bb5
+
+    BB [5/5]
+        v10. Phi  (v6, bb3) (v8, bb4)
+        v11. Ret  i64 v10
+    end
+    */
+    auto graph = std::make_shared<Graph>("sccp_branches");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    auto* bb5 = graph->createBB(5);
+    for (auto* bb : {bb1, bb2, bb3, bb4, bb5})
+        graph->addBB(bb);
+    graph->addEdge(bb1, bb2);
+    graph->addEdge(bb2, bb3);
+    graph->addEdge(bb2, bb4);
+    graph->addEdge(bb3, bb5);
+    graph->addEdge(bb4, bb5);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(1));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(5));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<BinaryInst>(3, InstType::Add, v1, v1);
+    bb2->pushBackInst(v3);
+    bb2->pushBackInst(graph->create<BinaryInst>(4, InstType::Cmp, v3, v2));
+    bb2->pushBackInst(graph->create<JumpInst>(5, InstType::Jb, bb4));
+
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Mul, v0, v0);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(graph->create<JumpInst>(7, InstType::Jmp, bb5));
+
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Sub, v2, v1);
+    bb4->pushBackInst(v8);
+    bb4->pushBackInst(graph->create<JumpInst>(9, InstType::Jmp, bb5));
+
+    auto* v10 = graph->create<PhiInst>(10);
+    v10->addInput(v6, bb3);
+    v10->addInput(v8, bb4);
+    auto* v11 = graph->create<UnaryInst>(11, InstType::Return, v10);
+    bb5->pushBackPhiInst(v10);
+    bb5->pushBackInst(v11);
+
+    ASSERT_TRUE(graph->runPass<Sccp>());
+
+    // 2 < 5 always goes to bb4, bb3 is removed together with its phi input
+    ASSERT_EQ(graph->size(), 4U);
+    EXPECT_EQ(std::find(graph->getBBs().begin(), graph->getBBs().end(), bb3),
+              graph->getBBs().end());
+    EXPECT_EQ(bb2->size(), 1U);
+    EXPECT_EQ(bb2->getLastInst()->getInstType(), InstType::Jmp);
+    EXPECT_EQ(bb2->getTrueSucc(), bb4);
+    EXPECT_EQ(bb2->getFalseSucc(), nullptr);
+    EXPECT_EQ(bb5->getPreds(), std::vector<BasicBlock*>{bb4});
+    EXPECT_EQ(bb5->getFirstPhi(), nullptr);
+
+    // folded through the phi, the folded insts are removed
+    auto* ret_value = v11->getInput(0);
+    ASSERT_TRUE(ret_value->isConstInst());
+    EXPECT_EQ(static_cast<ConstInst*>(ret_value)->getInt64Value(), 4U);
+    EXPECT_TRUE(bb4->getFirstInst()->isJumpInst());
+
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(7).getValue<uint64_t>(), 4U);
+}
+
+/**
+ * Same successors graph:
+ *                 [1]
+ *                  |
+ *                  v
+ *                 [2]
+ *                 | |
+ *                 v v
+ *                 [3]
+ */
+TEST(SCCP_TEST, SAME_SUCCS)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/3]
+        v0. Param i64 a0
+        v1. Const i64 1
+        v2. Const i64 3
+
+    BB [2/3]
+        v3. Cmp   i64 v1, v2
+        v4. Jb    bb3 -- both successors are bb3
+
+    BB [3/3]
+        v5. Add   i64 v0, v2
+        v6. Ret   i64 v5
+    end
+    */
+    auto graph = std::make_shared<Graph>("sccp_same_succs");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    for (auto* bb : {bb1, bb2, bb3})
+        graph->addBB(bb);
+    graph->addEdge(bb1, bb2);
+    graph->addEdge(bb2, bb3);
+    bb2->setFalseSucc(bb3);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "a0");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(1));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(3));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    bb2->pushBackInst(graph->create<BinaryInst>(3, InstType::Cmp, v1, v2));
+    bb2->pushBackInst(graph->create<JumpInst>(4, InstType::Jb, bb3));
+
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Add, v0, v2);
+    bb3->pushBackInst(v5);
+    bb3->pushBackInst(graph->create<UnaryInst>(6, InstType::Return, v5));
+
+    ASSERT_TRUE(graph->runPass<Sccp>());
+
+    // 1 < 3 takes the false edge, which is the same edge as the true one
+    ASSERT_EQ(graph->size(), 3U);
+    EXPECT_EQ(bb2->size(), 1U);
+    EXPECT_EQ(bb2->getLastInst()->getInstType(), InstType::Jmp);
+    EXPECT_EQ(bb2->getTrueSucc(), bb3);
+    EXPECT_EQ(bb2->getFalseSucc(), nullptr);
+    EXPECT_EQ(bb3->getPreds(), std::vector<BasicBlock*>{bb2});
+    EXPECT_EQ(bb3->getFirstInst(), v5);
+
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(7).getValue<uint64_t>(), 10U);
+}
+
+/**
+ * Loop graph:
+ *                  [1]
+ *                   |
+ *                   v
+ *             /--->[2]----\
+ *             |     |     |
+ *             |     v     v
+ *             \----[3]   [4]
+ */
+TEST(SCCP_TEST, LOOP_PHI)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/4]
+        v0. Param i64 n
+        v1. Const i64 0
+        v2. Const i64 1
+
+    BB [2/4]
+        v3. Phi   (v2, bb1) (v6, bb3)
+        v4. Phi   (v1, bb1) (v7, bb3)
+        v5. Cmp   i64 v4, v0
+        v8. Jae   bb4
+
+    BB [3/4]
+        v6. Mul   i64 v3, v2
+        v7. Add   i64 v4, v2
+        v9. Jmp   bb2
+
+    BB [4/4]
+        v10. Ret  i64 v3
+    end
+    */
+    auto graph = std::make_shared<Graph>("sccp_loop");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+    for (auto* bb : {bb1, bb2, bb3, bb4})
+        graph->addBB(bb);
+    graph->addEdge(bb1, bb2);
+    graph->addEdge(bb2, bb3);
+    graph->addEdge(bb2, bb4);
+    graph->addEdge(bb3, bb2);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "n");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<PhiInst>(4);
+    bb2->pushBackPhiInst(v3);
+    bb2->pushBackPhiInst(v4);
+    bb2->pushBackInst(graph->create<BinaryInst>(5, InstType::Cmp, v4, v0));
+    bb2->pushBackInst(graph->create<JumpInst>(8, InstType::Jae, bb4));
+
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Mul, v3, v2);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Add, v4, v2);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(v7);
+    bb3->pushBackInst(graph->create<JumpInst>(9, InstType::Jmp, bb2));
+    v3->addInput(v2, bb1);
+    v3->addInput(v6, bb3);
+    v4->addInput(v1, bb1);
+    v4->addInput(v7, bb3);
+
+    auto* v10 = graph->create<UnaryInst>(10, InstType::Return, v3);
+    bb4->pushBackInst(v10);
+
+    // v3 = phi(1, v3 * 1) is 1 on every iteration, the counter is not a constant
+    ASSERT_TRUE(graph->runPass<Sccp>());
+    EXPECT_EQ(v10->getInput(0), v2);
+    EXPECT_EQ(bb2->getFirstPhi(), v4);
+    EXPECT_EQ(bb2->getLastPhi(), v4);
+    EXPECT_EQ(bb3->getFirstInst(), v7);
+    EXPECT_EQ(graph->size(), 4U);
+    EXPECT_EQ(bb2->getFalseSucc(), bb4);
+
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.call<uint64_t>(5).getValue<uint64_t>(), 1U);
+}
+
+TEST(SCCP_TEST, SEMANTICS)
+{
+    /*
+    Graph for proc (preds, succs omitted)
+    BB [1/1]
+        v0. Const i32 0xffffffff
+        v1. Const i32 1
+        v2. Const i32 33
+        v3. Const i32 0
+        v4. Add   i32 v0, v1
+        v5. Shl   i32 v1, v2
+        v6. ZeroCheck i32 v5
+        v7. Div   i32 v1, v4
+        v8. Add   i32 v6, v4
+        v9. Ret   i32 v8
+    end
+    */
+    auto graph = std::make_shared<Graph>("sccp_semantics");
+    auto* bb1 = graph->createBB(1);
+    graph->insertBB(bb1);
+
+    auto* v0 = graph->create<ConstInst>(0, UINT32_MAX);
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint32_t>(1));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint32_t>(33));
+    auto* v3 = graph->create<ConstInst>(3, static_cast<uint32_t>(0));
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Add, v0, v1);
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Shl, v1, v2);
+    auto* v6 = graph->create<UnaryInst>(6, InstType::ZeroCheck, v5);
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Div, v1, v4);
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Add, v6, v4);
+    auto* v9 = graph->create<UnaryInst>(9, InstType::Return, v8);
+    for (Inst* inst : std::initializer_list<Inst*>{v0, v1, v2, v3, v4, v5, v6, v7, v8, v9})
+        bb1->pushBackInst(inst);
+
+    ASSERT_TRUE(graph->runPass<Sccp>());
+
+    // i32 wraps around to 0, the shift count is masked to 1, the passed check is removed
+    EXPECT_EQ(v7->getInput(1), v3);
+    ASSERT_TRUE(v9->getInput(0)->isConstInst());
+    EXPECT_EQ(static_cast<ConstInst*>(v9->getInput(0))->getInt32Value(), 2U);
+    for (auto* inst = bb1->getFirstInst(); inst != nullptr; inst = inst->getNext())
+        EXPECT_NE(inst->getInstType(), InstType::ZeroCheck);
+    // division by zero is left for the runtime
+    EXPECT_EQ(v7->getBB(), bb1);
+
+    Interpreter interp(graph.get());
+    EXPECT_EQ(interp.run().status, ExecStatus::DivisionByZero);
+}
+
+TEST(SCCP_TEST, PROGRAMS)
+{
+    // nothing is constant in these programs, results are kept
+    auto factorial = buildFactorial();
+    auto sum = buildSum();
+    ASSERT_TRUE(factorial->runPass<Sccp>());
+    ASSERT_TRUE(sum->runPass<Sccp>());
+    EXPECT_EQ(factorial->size(), 4U);
+
+    Interpreter fact_interp(factorial.get());
+    Interpreter sum_interp(sum.get());
+    EXPECT_EQ(fact_interp.call<uint64_t>(5).getValue<uint64_t>(), 120U);
+    EXPECT_EQ(sum_interp.call<uint64_t>(100).getValue<uint64_t>(), 5050U);
+}
\ No newline at end of file
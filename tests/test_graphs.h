@@ -0,0 +1,332 @@
+#pragma once
+
+#include "ir/graph.h"
+#include <memory>
+
+namespace compiler
+{
+
+/**
+ * Factorial graph:
+ *                 [1]
+ *                  |
+ *                  v
+ *             /-->[2]---\
+ *             |    |    |
+ *             |    v    v
+ *             \---[3]  [4]
+ */
+inline std::shared_ptr<Graph> buildFactorial()
+{
+    /*
+    BB [1/4]
+        v0. Param i64 n
+        v1. Const i64 1
+
+    BB [2/4]
+        v2. Phi   (v1, bb1) (v6, bb3)
+        v3. Phi   (v1, bb1) (v5, bb3)
+        v4. Cmp   i64 v2, v0
+        v7. Ja    bb4
+
+    BB [3/4]
+        v5. Mul   i64 v3, v2
+        v6. Add   i64 v2, v1
+        v8. Jmp   bb2
+
+    BB [4/4]
+        v9. Ret   i64 v3
+    */
+    auto graph = std::make_shared<Graph>("factorial");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addBB(bb4);
+    graph->addEdge(bb3, bb2);
+    graph->addEdge(bb2, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "n");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+
+    auto* v2 = graph->create<PhiInst>(2);
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<BinaryInst>(4, InstType::Cmp, v2, v0);
+    auto* v7 = graph->create<JumpInst>(7, InstType::Ja, bb4);
+    bb2->pushBackPhiInst(v2);
+    bb2->pushBackPhiInst(v3);
+    bb2->pushBackInst(v4);
+    bb2->pushBackInst(v7);
+
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Mul, v3, v2);
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Add, v2, v1);
+    auto* v8 = graph->create<JumpInst>(8, InstType::Jmp, bb2);
+    bb3->pushBackInst(v5);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(v8);
+
+    v2->addInput(v1, bb1);
+    v2->addInput(v6, bb3);
+    v3->addInput(v1, bb1);
+    v3->addInput(v5, bb3);
+
+    auto* v9 = graph->create<UnaryInst>(9, InstType::Return, v3);
+    bb4->pushBackInst(v9);
+    return graph;
+}
+
+/**
+ * Fibonacci graph has the same shape as the factorial one,
+ * phis of the loop header are swapped on the back edge
+ */
+inline std::shared_ptr<Graph> buildFibonacci()
+{
+    /*
+    BB [1/4]
+        v0. Param i32 n
+        v1. Const i32 0
+        v2. Const i32 1
+
+    BB [2/4]
+        v3. Phi   (v1, bb1) (v4, bb3)
+        v4. Phi   (v2, bb1) (v7, bb3)
+        v5. Phi   (v1, bb1) (v8, bb3)
+        v6. Cmp   i32 v5, v0
+        v9. Jae   bb4
+
+    BB [3/4]
+        v7. Add   i32 v3, v4
+        v8. Add   i32 v5, v2
+        v10. Jmp  bb2
+
+    BB [4/4]
+        v11. Ret  i32 v3
+    */
+    auto graph = std::make_shared<Graph>("fibonacci");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addBB(bb4);
+    graph->addEdge(bb3, bb2);
+    graph->addEdge(bb2, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "n");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint32_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint32_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    auto* v3 = graph->create<PhiInst>(3);
+    auto* v4 = graph->create<PhiInst>(4);
+    auto* v5 = graph->create<PhiInst>(5);
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Cmp, v5, v0);
+    auto* v9 = graph->create<JumpInst>(9, InstType::Jae, bb4);
+    bb2->pushBackPhiInst(v3);
+    bb2->pushBackPhiInst(v4);
+    bb2->pushBackPhiInst(v5);
+    bb2->pushBackInst(v6);
+    bb2->pushBackInst(v9);
+
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Add, v3, v4);
+    auto* v8 = graph->create<BinaryInst>(8, InstType::Add, v5, v2);
+    auto* v10 = graph->create<JumpInst>(10, InstType::Jmp, bb2);
+    bb3->pushBackInst(v7);
+    bb3->pushBackInst(v8);
+    bb3->pushBackInst(v10);
+
+    v3->addInput(v1, bb1);
+    v3->addInput(v4, bb3);
+    v4->addInput(v2, bb1);
+    v4->addInput(v7, bb3);
+    v5->addInput(v1, bb1);
+    v5->addInput(v8, bb3);
+
+    auto* v11 = graph->create<UnaryInst>(11, InstType::Return, v3);
+    bb4->pushBackInst(v11);
+    return graph;
+}
+
+/**
+ * Recursive sum of numbers up to n
+ */
+inline std::shared_ptr<Graph> buildSum()
+{
+    /*
+    Recursive sum(n) = n == 0 ? 0 : n + sum(n - 1)
+    BB [1/4]
+        v0. Param i64 n
+        v1. Const i64 0
+        v2. Const i64 1
+
+    BB [2/4]
+        v3. Cmp   i64 v0, v1
+        v4. Je    bb4
+
+    BB [3/4]
+        v5. Sub   i64 v0, v2
+        v6. Call  sum v5
+        v7. Add   i64 v0, v6
+        v8. Ret   i64 v7
+
+    BB [4/4]
+        v9. Ret   i64 v1
+    */
+    auto graph = std::make_shared<Graph>("sum");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addBB(bb4);
+    graph->addEdge(bb2, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "n");
+    auto* v1 = graph->create<ConstInst>(1, static_cast<uint64_t>(0));
+    auto* v2 = graph->create<ConstInst>(2, static_cast<uint64_t>(1));
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    bb2->pushBackInst(graph->create<BinaryInst>(3, InstType::Cmp, v0, v1));
+    bb2->pushBackInst(graph->create<JumpInst>(4, InstType::Je, bb4));
+
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Sub, v0, v2);
+    auto* v6 = graph->create<CallInst>(6, graph.get(), std::initializer_list<Inst*>{v5});
+    auto* v7 = graph->create<BinaryInst>(7, InstType::Add, v0, v6);
+    bb3->pushBackInst(v5);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(v7);
+    bb3->pushBackInst(graph->create<UnaryInst>(8, InstType::Return, v7));
+    bb4->pushBackInst(graph->create<UnaryInst>(9, InstType::Return, v1));
+
+    return graph;
+}
+
+/**
+ * Bounds and zero checks guard unsigned division
+ */
+inline std::shared_ptr<Graph> buildChecks()
+{
+    /*
+    BB [1/1]
+        v0. Param i64 index
+        v1. Param i64 length
+        v2. Param i64 divisor
+        v3. BoundsCheck i64 v0, v1
+        v4. ZeroCheck   i64 v2
+        v5. Mod   i64 v1, v2
+        v6. Div   i64 v0, v5
+        v7. Ret   i64 v6
+    */
+    auto graph = std::make_shared<Graph>("checks");
+    auto* bb = graph->createBB(1);
+    graph->insertBB(bb);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i64, "index");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i64, "length");
+    auto* v2 = graph->create<ParamInst>(2, DataType::i64, "divisor");
+    auto* v5 = graph->create<BinaryInst>(5, InstType::Mod, v1, v2);
+    auto* v6 = graph->create<BinaryInst>(6, InstType::Div, v0, v5);
+    bb->pushBackInst(v0);
+    bb->pushBackInst(v1);
+    bb->pushBackInst(v2);
+    bb->pushBackInst(graph->create<BinaryInst>(3, InstType::BoundsCheck, v0, v1));
+    bb->pushBackInst(graph->create<UnaryInst>(4, InstType::ZeroCheck, v2));
+    bb->pushBackInst(v5);
+    bb->pushBackInst(v6);
+    bb->pushBackInst(graph->create<UnaryInst>(7, InstType::Return, v6));
+
+    return graph;
+}
+
+/**
+ * Integer and floating point ops connected by casts
+ */
+inline std::shared_ptr<Graph> buildTypes()
+{
+    /*
+    BB [1/4]
+        v0. Param i32 a
+        v1. Param i32 b
+        v2. Param f64 x
+
+    BB [2/4]
+        v3. Cmp   i32 v0, v1
+        v4. Jb    bb4
+
+    BB [3/4]
+        v5. AShr  i32 v0, v1
+        v6. Cast  v5 to i64
+        v7. Ret   i64 v6
+
+    BB [4/4]
+        v8.  Neg   f64 v2
+        v9.  Cast  v8 to f32
+        v10. Cast  v9 to i32
+        v11. Shr   i32 v10, v1
+        v12. Cast  v11 to i64
+        v13. Ret   i64 v12
+    */
+    auto graph = std::make_shared<Graph>("types");
+
+    auto* bb1 = graph->createBB(1);
+    auto* bb2 = graph->createBB(2);
+    auto* bb3 = graph->createBB(3);
+    auto* bb4 = graph->createBB(4);
+
+    graph->insertBB(bb1);
+    graph->insertBB(bb2);
+    graph->insertBB(bb3);
+    graph->addBB(bb4);
+    graph->addEdge(bb2, bb4);
+
+    auto* v0 = graph->create<ParamInst>(0, DataType::i32, "a");
+    auto* v1 = graph->create<ParamInst>(1, DataType::i32, "b");
+    auto* v2 = graph->create<ParamInst>(2, DataType::f64, "x");
+    bb1->pushBackInst(v0);
+    bb1->pushBackInst(v1);
+    bb1->pushBackInst(v2);
+
+    bb2->pushBackInst(graph->create<BinaryInst>(3, InstType::Cmp, v0, v1));
+    bb2->pushBackInst(graph->create<JumpInst>(4, InstType::Jb, bb4));
+
+    auto* v5 = graph->create<BinaryInst>(5, InstType::AShr, v0, v1);
+    auto* v6 = graph->create<CastInst>(6, v5, DataType::i64);
+    bb3->pushBackInst(v5);
+    bb3->pushBackInst(v6);
+    bb3->pushBackInst(graph->create<UnaryInst>(7, InstType::Return, v6));
+
+    auto* v8 = graph->create<UnaryInst>(8, InstType::Neg, v2);
+    auto* v9 = graph->create<CastInst>(9, v8, DataType::f32);
+    auto* v10 = graph->create<CastInst>(10, v9, DataType::i32);
+    auto* v11 = graph->create<BinaryInst>(11, InstType::Shr, v10, v1);
+    auto* v12 = graph->create<CastInst>(12, v11, DataType::i64);
+    bb4->pushBackInst(v8);
+    bb4->pushBackInst(v9);
+    bb4->pushBackInst(v10);
+    bb4->pushBackInst(v11);
+    bb4->pushBackInst(v12);
+    bb4->pushBackInst(graph->create<UnaryInst>(13, InstType::Return, v12));
+
+    return graph;
+}
+
+} // namespace compiler
\ No newline at end of file